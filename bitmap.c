@@ -0,0 +1,149 @@
+#include "bitmap.h"
+#include "trace.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define RADB_BITMAP_SIGNATURE 0x504D4252
+#define RADB_BITMAP_VERSION MAKE_VERSION(1, 0)
+
+// The summary words follow the bitmap words, so they are moved to the end of the file when the bitmap grows.
+static size_t radb_bitmap_size(size_t NumWords, size_t NumSummary) {
+	return sizeof(radb_bitmap_header_t) + (NumWords + NumSummary) * sizeof(uint64_t);
+}
+
+void radb_bitmap_create(radb_bitmap_t *Bitmap, const char *FileName, size_t NumBits) {
+	size_t NumWords = NumBits ? (NumBits + 63) / 64 : 1;
+	size_t NumSummary = (NumWords + 63) / 64;
+	Bitmap->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Bitmap->HeaderSize = radb_bitmap_size(NumWords, NumSummary);
+	ftruncate(Bitmap->HeaderFd, Bitmap->HeaderSize);
+	Bitmap->Header = mmap(NULL, Bitmap->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Bitmap->HeaderFd, 0);
+	Bitmap->Header->Signature = RADB_BITMAP_SIGNATURE;
+	Bitmap->Header->Version = RADB_BITMAP_VERSION;
+	Bitmap->Header->NumWords = NumWords;
+	Bitmap->Header->NumSummary = NumSummary;
+	Bitmap->Header->Count = 0;
+	Bitmap->Header->Hint = 0;
+}
+
+static void radb_bitmap_rebuild(radb_bitmap_t *Bitmap) {
+	radb_bitmap_header_t *Header = Bitmap->Header;
+	uint64_t *Words = Header->Words, *Summary = Words + Header->NumWords;
+	memset(Summary, 0, Header->NumSummary * sizeof(uint64_t));
+	Header->Count = 0;
+	Header->Hint = 0;
+	for (size_t I = 0; I < Header->NumWords; ++I) {
+		Header->Count += __builtin_popcountll(Words[I]);
+		if (Words[I] == ~(uint64_t)0) Summary[I / 64] |= (uint64_t)1 << (I % 64);
+	}
+}
+
+int radb_bitmap_open(radb_bitmap_t *Bitmap, radb_stats_t *Stats, const char *FileName, size_t NumBits) {
+	struct stat Stat[1];
+	Bitmap->Header = NULL;
+	if (stat(FileName, Stat)) return -1;
+	Bitmap->HeaderFd = open(FileName, O_RDWR, 0777);
+	Bitmap->HeaderSize = Stat->st_size;
+	Bitmap->Header = mmap(NULL, Bitmap->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Bitmap->HeaderFd, 0);
+	radb_bitmap_header_t *Header = Bitmap->Header;
+	if (Bitmap->HeaderSize < sizeof(radb_bitmap_header_t) || Header->Signature != RADB_BITMAP_SIGNATURE
+		|| Bitmap->HeaderSize < radb_bitmap_size(Header->NumWords, 0)) {
+		munmap(Bitmap->Header, Bitmap->HeaderSize);
+		close(Bitmap->HeaderFd);
+		Bitmap->Header = NULL;
+		return -1;
+	}
+	size_t HeaderSize = radb_bitmap_size(Header->NumWords, Header->NumSummary);
+	if (HeaderSize != Bitmap->HeaderSize) {
+		// The bitmap was not closed after it started growing, the summary may have been overwritten.
+		radb_truncate(Stats, Bitmap->HeaderFd, HeaderSize);
+		Bitmap->Header = radb_remap(Stats, Bitmap->HeaderFd, Bitmap->Header, Bitmap->HeaderSize, HeaderSize);
+		Bitmap->HeaderSize = HeaderSize;
+		radb_bitmap_rebuild(Bitmap);
+	}
+	radb_bitmap_grow(Bitmap, Stats, NumBits);
+	return 0;
+}
+
+void radb_bitmap_grow(radb_bitmap_t *Bitmap, radb_stats_t *Stats, size_t NumBits) {
+	size_t NumWords = Bitmap->Header->NumWords;
+	size_t NumSummary = Bitmap->Header->NumSummary;
+	if (NumBits <= NumWords * 64) return;
+	size_t NewWords = (NumBits + 63) / 64;
+	if (NewWords < 2 * NumWords) NewWords = 2 * NumWords;
+	size_t NewSummary = (NewWords + 63) / 64;
+	size_t HeaderSize = radb_bitmap_size(NewWords, NewSummary);
+	radb_truncate(Stats, Bitmap->HeaderFd, HeaderSize);
+	Bitmap->Header = radb_remap(Stats, Bitmap->HeaderFd, Bitmap->Header, Bitmap->HeaderSize, HeaderSize);
+	Bitmap->HeaderSize = HeaderSize;
+	// The new summary starts past the end of the old one and the space after the old file is zero.
+	uint64_t *Words = Bitmap->Header->Words;
+	memcpy(Words + NewWords, Words + NumWords, NumSummary * sizeof(uint64_t));
+	memset(Words + NumWords, 0, NumSummary * sizeof(uint64_t));
+	Bitmap->Header->NumWords = NewWords;
+	Bitmap->Header->NumSummary = NewSummary;
+}
+
+void radb_bitmap_close(radb_bitmap_t *Bitmap) {
+	radb_sync(Bitmap->Header, Bitmap->HeaderSize);
+	munmap(Bitmap->Header, Bitmap->HeaderSize);
+	close(Bitmap->HeaderFd);
+	Bitmap->Header = NULL;
+}
+
+// Returns the lowest clear bit from From, which may be past the end of the bitmap.
+size_t radb_bitmap_find(radb_bitmap_t *Bitmap, size_t From) {
+	radb_bitmap_header_t *Header = Bitmap->Header;
+	size_t NumWords = Header->NumWords;
+	uint64_t *Words = Header->Words, *Summary = Words + NumWords;
+	if (From < Header->Hint) From = Header->Hint;
+	size_t Word = From / 64;
+	if (Word >= NumWords) return From;
+	uint64_t Free = ~Words[Word] & (~(uint64_t)0 << (From % 64));
+	if (Free) return Word * 64 + __builtin_ctzll(Free);
+	for (++Word; Word < NumWords; Word = (Word | 63) + 1) {
+		uint64_t Full = Summary[Word / 64] | (((uint64_t)1 << (Word % 64)) - 1);
+		if (Full == ~(uint64_t)0) continue;
+		Word = (Word & ~(size_t)63) + __builtin_ctzll(~Full);
+		if (Word >= NumWords) break;
+		return Word * 64 + __builtin_ctzll(~Words[Word]);
+	}
+	return NumWords * 64;
+}
+
+// Returns the lowest set bit from From and before Limit, or Limit if there is none.
+size_t radb_bitmap_next(radb_bitmap_t *Bitmap, size_t From, size_t Limit) {
+	radb_bitmap_header_t *Header = Bitmap->Header;
+	size_t End = Header->NumWords * 64;
+	if (End > Limit) End = Limit;
+	if (From >= End) return Limit;
+	size_t Word = From / 64;
+	uint64_t Set = Header->Words[Word] & (~(uint64_t)0 << (From % 64));
+	for (;;) {
+		if (Set) {
+			size_t Index = Word * 64 + __builtin_ctzll(Set);
+			return Index < End ? Index : Limit;
+		}
+		if (++Word * 64 >= End) return Limit;
+		Set = Header->Words[Word];
+	}
+}
+
+// Returns the first of the lowest Count consecutive clear bits from From.
+size_t radb_bitmap_find_run(radb_bitmap_t *Bitmap, size_t From, size_t Count) {
+	for (;;) {
+		size_t Index = radb_bitmap_find(Bitmap, From);
+		From = radb_bitmap_next(Bitmap, Index, Index + Count);
+		if (From == Index + Count) return Index;
+	}
+}
+
+void radb_bitmap_set_run(radb_bitmap_t *Bitmap, size_t Index, size_t Count) {
+	for (size_t Limit = Index + Count; Index < Limit; ++Index) radb_bitmap_set(Bitmap, Index);
+}
@@ -0,0 +1,59 @@
+#ifndef RADB_BITMAP_H
+#define RADB_BITMAP_H
+
+#include "common.h"
+
+// A persistent bitmap of allocated entries, with a summary bit for each word of 64 entries which
+// is set when the word is full so that free entries can be found without scanning full words.
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumWords, NumSummary;
+	uint64_t Count, Hint;
+	uint64_t Words[];
+} radb_bitmap_header_t;
+
+typedef struct {
+	radb_bitmap_header_t *Header;
+	size_t HeaderSize;
+	int HeaderFd;
+} radb_bitmap_t;
+
+void radb_bitmap_create(radb_bitmap_t *Bitmap, const char *FileName, size_t NumBits);
+int radb_bitmap_open(radb_bitmap_t *Bitmap, radb_stats_t *Stats, const char *FileName, size_t NumBits);
+void radb_bitmap_grow(radb_bitmap_t *Bitmap, radb_stats_t *Stats, size_t NumBits);
+void radb_bitmap_close(radb_bitmap_t *Bitmap);
+
+size_t radb_bitmap_find(radb_bitmap_t *Bitmap, size_t From);
+size_t radb_bitmap_find_run(radb_bitmap_t *Bitmap, size_t From, size_t Count);
+size_t radb_bitmap_next(radb_bitmap_t *Bitmap, size_t From, size_t Limit);
+void radb_bitmap_set_run(radb_bitmap_t *Bitmap, size_t Index, size_t Count);
+
+static inline int radb_bitmap_test(radb_bitmap_t *Bitmap, size_t Index) {
+	if (Index / 64 >= Bitmap->Header->NumWords) return 0;
+	return (Bitmap->Header->Words[Index / 64] >> (Index % 64)) & 1;
+}
+
+// Hint is the lowest entry which may be free, all the entries before it are allocated.
+static inline void radb_bitmap_set(radb_bitmap_t *Bitmap, size_t Index) {
+	radb_bitmap_header_t *Header = Bitmap->Header;
+	uint64_t *Word = Header->Words + Index / 64;
+	uint64_t Bit = (uint64_t)1 << (Index % 64);
+	if (*Word & Bit) return;
+	*Word |= Bit;
+	++Header->Count;
+	if (*Word == ~(uint64_t)0) Header->Words[Header->NumWords + Index / 4096] |= (uint64_t)1 << ((Index / 64) % 64);
+	if (Index == Header->Hint) Header->Hint = Index + 1;
+}
+
+static inline void radb_bitmap_clear(radb_bitmap_t *Bitmap, size_t Index) {
+	radb_bitmap_header_t *Header = Bitmap->Header;
+	uint64_t *Word = Header->Words + Index / 64;
+	uint64_t Bit = (uint64_t)1 << (Index % 64);
+	if (!(*Word & Bit)) return;
+	if (*Word == ~(uint64_t)0) Header->Words[Header->NumWords + Index / 4096] &= ~((uint64_t)1 << ((Index / 64) % 64));
+	*Word &= ~Bit;
+	--Header->Count;
+	if (Index < Header->Hint) Header->Hint = Index;
+}
+
+#endif
@@ -0,0 +1,351 @@
+#include "column_store.h"
+#include "trace.h"
+#include "kernel.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define COLUMN_STORE_SIGNATURE 0x53434152
+#define COLUMN_STORE_VERSION MAKE_VERSION(1, 0)
+
+// The schema and row counts are kept in a *columns* file, the values of each column are kept
+// back to back in a separate *column<N>* file so that scans only read the columns they use.
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumColumns, ChunkSize;
+	uint64_t NumRows, Capacity;
+	uint32_t Types[];
+} column_store_header_t;
+
+typedef struct {
+	void *Values;
+	int Fd;
+	uint32_t Width;
+} column_file_t;
+
+struct column_store_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	column_store_header_t *Header;
+	size_t HeaderSize;
+	int HeaderFd;
+	radb_stats_t Stats[1];
+	column_file_t Columns[];
+};
+
+static const uint32_t ColumnWidths[] = {1, 2, 4, 8, 4, 8, 8};
+
+column_store_t *column_store_create(const char *Prefix, size_t NumColumns, const column_type_t *Types, size_t ChunkSize RADB_MEM_PARAMS) {
+	size_t StoreSize = sizeof(column_store_t) + NumColumns * sizeof(column_file_t);
+#if defined(RADB_MEM_MALLOC)
+	column_store_t *Store = malloc(StoreSize);
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	column_store_t *Store = GC_malloc(StoreSize);
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	column_store_t *Store = alloc(Allocator, StoreSize);
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	if (!ChunkSize) ChunkSize = 65536;
+	// Whole selection words per chunk keep the columns a multiple of 64 rows long.
+	ChunkSize = (ChunkSize + 63) & ~(size_t)63;
+	char FileName[strlen(Prefix) + 20];
+	sprintf(FileName, "%s.columns", Prefix);
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Store->HeaderSize = sizeof(column_store_header_t) + NumColumns * sizeof(uint32_t);
+	ftruncate(Store->HeaderFd, Store->HeaderSize);
+	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
+	Store->Header->Signature = COLUMN_STORE_SIGNATURE;
+	Store->Header->Version = COLUMN_STORE_VERSION;
+	Store->Header->NumColumns = NumColumns;
+	Store->Header->ChunkSize = ChunkSize;
+	Store->Header->NumRows = 0;
+	Store->Header->Capacity = ChunkSize;
+	for (size_t I = 0; I < NumColumns; ++I) {
+		column_file_t *Column = Store->Columns + I;
+		Store->Header->Types[I] = Types[I];
+		Column->Width = ColumnWidths[Types[I]];
+		sprintf(FileName, "%s.column%d", Prefix, (int)I);
+		Column->Fd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+		ftruncate(Column->Fd, ChunkSize * Column->Width);
+		Column->Values = mmap(NULL, ChunkSize * Column->Width, PROT_READ | PROT_WRITE, MAP_SHARED, Column->Fd, 0);
+	}
+	return Store;
+}
+
+column_store_open_t column_store_open2(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 20];
+	sprintf(FileName, "%s.columns", Prefix);
+	if (stat(FileName, Stat)) return (column_store_open_t){NULL, RADB_FILE_NOT_FOUND};
+	int HeaderFd = open(FileName, O_RDWR, 0777);
+	size_t HeaderSize = Stat->st_size;
+	column_store_header_t *Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, HeaderFd, 0);
+	if (HeaderSize < sizeof(column_store_header_t) || Header->Signature != COLUMN_STORE_SIGNATURE) {
+		munmap(Header, HeaderSize);
+		close(HeaderFd);
+		return (column_store_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+	size_t NumColumns = Header->NumColumns;
+	if (HeaderSize != sizeof(column_store_header_t) + NumColumns * sizeof(uint32_t)) {
+		munmap(Header, HeaderSize);
+		close(HeaderFd);
+		return (column_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+	size_t StoreSize = sizeof(column_store_t) + NumColumns * sizeof(column_file_t);
+#if defined(RADB_MEM_MALLOC)
+	column_store_t *Store = malloc(StoreSize);
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	column_store_t *Store = GC_malloc(StoreSize);
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	column_store_t *Store = alloc(Allocator, StoreSize);
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = HeaderFd;
+	Store->HeaderSize = HeaderSize;
+	Store->Header = Header;
+	// The columns are grown one after the other, so some may not have been grown before the store was last closed.
+	size_t Capacity = Header->Capacity;
+	int Opened = 0;
+	for (size_t I = 0; I < NumColumns; ++I) {
+		column_file_t *Column = Store->Columns + I;
+		sprintf(FileName, "%s.column%d", Prefix, (int)I);
+		if (Header->Types[I] > COLUMN_DOUBLE || stat(FileName, Stat)) break;
+		Column->Width = ColumnWidths[Header->Types[I]];
+		Column->Fd = open(FileName, O_RDWR, 0777);
+		size_t Rows = Stat->st_size / Column->Width;
+		if (Capacity > Rows) Capacity = Rows;
+		++Opened;
+	}
+	Capacity &= ~(size_t)63;
+	if (Opened < NumColumns || !Capacity) {
+		for (size_t I = 0; I < Opened; ++I) close(Store->Columns[I].Fd);
+		for (size_t I = 0; I < NumColumns; ++I) Store->Columns[I].Values = NULL;
+		column_store_close(Store);
+		return (column_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+	Header->Capacity = Capacity;
+	if (Header->NumRows > Capacity) Header->NumRows = Capacity;
+	for (size_t I = 0; I < NumColumns; ++I) {
+		column_file_t *Column = Store->Columns + I;
+		Column->Values = mmap(NULL, Capacity * Column->Width, PROT_READ | PROT_WRITE, MAP_SHARED, Column->Fd, 0);
+	}
+	return (column_store_open_t){Store, RADB_SUCCESS};
+}
+
+column_store_t *column_store_open(const char *Prefix RADB_MEM_PARAMS) {
+	return column_store_open2(Prefix RADB_MEM_ARGS).Store;
+}
+
+void column_store_close(column_store_t *Store) {
+	size_t Capacity = Store->Header->Capacity;
+	for (size_t I = 0; I < Store->Header->NumColumns; ++I) {
+		column_file_t *Column = Store->Columns + I;
+		if (!Column->Values) continue;
+		radb_sync(Column->Values, Capacity * Column->Width);
+		munmap(Column->Values, Capacity * Column->Width);
+		close(Column->Fd);
+	}
+	radb_sync(Store->Header, Store->HeaderSize);
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Store->Prefix);
+	free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+	Store->free(Store->Allocator, (void *)Store->Prefix);
+	Store->free(Store->Allocator, Store);
+#endif
+}
+
+size_t column_store_num_columns(column_store_t *Store) {
+	return Store->Header->NumColumns;
+}
+
+size_t column_store_num_rows(column_store_t *Store) {
+	return Store->Header->NumRows;
+}
+
+column_type_t column_store_type(column_store_t *Store, size_t Column) {
+	return Store->Header->Types[Column];
+}
+
+static void column_store_grow(column_store_t *Store, size_t Index) {
+	size_t ChunkSize = Store->Header->ChunkSize;
+	size_t Capacity = Store->Header->Capacity;
+	size_t NewCapacity = ((Index + ChunkSize) / ChunkSize) * ChunkSize;
+	for (size_t I = 0; I < Store->Header->NumColumns; ++I) {
+		column_file_t *Column = Store->Columns + I;
+		radb_truncate(Store->Stats, Column->Fd, NewCapacity * Column->Width);
+		Column->Values = radb_remap(Store->Stats, Column->Fd, Column->Values, Capacity * Column->Width, NewCapacity * Column->Width);
+	}
+	Store->Header->Capacity = NewCapacity;
+}
+
+void *column_store_get(column_store_t *Store, size_t Column, size_t Index) {
+	if (Index >= Store->Header->NumRows) {
+		if (Index >= Store->Header->Capacity) column_store_grow(Store, Index);
+		Store->Header->NumRows = Index + 1;
+	}
+	column_file_t *File = Store->Columns + Column;
+	return (char *)File->Values + Index * File->Width;
+}
+
+void *column_store_values(column_store_t *Store, size_t Column) {
+	return Store->Columns[Column].Values;
+}
+
+static inline column_value_t column_store_load(column_type_t Type, const void *Value) {
+	column_value_t Result;
+	switch (Type) {
+	case COLUMN_UINT8: Result.Uint = *(const uint8_t *)Value; break;
+	case COLUMN_UINT16: Result.Uint = *(const uint16_t *)Value; break;
+	case COLUMN_UINT32: Result.Uint = *(const uint32_t *)Value; break;
+	case COLUMN_INT32: Result.Int = *(const int32_t *)Value; break;
+	case COLUMN_DOUBLE: Result.Double = *(const double *)Value; break;
+	default: Result.Uint = *(const uint64_t *)Value; break;
+	}
+	return Result;
+}
+
+// Clamps Min and Max to the values of Type, returning 0 if no value can be in the range.
+static int column_store_range(column_type_t Type, column_value_t *Min, column_value_t *Max) {
+	switch (Type) {
+	case COLUMN_UINT8:
+	case COLUMN_UINT16:
+	case COLUMN_UINT32: {
+		uint64_t Limit = ((uint64_t)1 << (8 * ColumnWidths[Type])) - 1;
+		if (Min->Uint > Max->Uint || Min->Uint > Limit) return 0;
+		if (Max->Uint > Limit) Max->Uint = Limit;
+		return 1;
+	}
+	case COLUMN_INT32:
+		if (Min->Int > Max->Int || Min->Int > INT32_MAX || Max->Int < INT32_MIN) return 0;
+		if (Min->Int < INT32_MIN) Min->Int = INT32_MIN;
+		if (Max->Int > INT32_MAX) Max->Int = INT32_MAX;
+		return 1;
+	case COLUMN_INT64: return Min->Int <= Max->Int;
+	case COLUMN_DOUBLE: return Min->Double <= Max->Double;
+	default: return Min->Uint <= Max->Uint;
+	}
+}
+
+static inline int column_store_in_range(column_type_t Type, column_value_t Value, column_value_t Min, column_value_t Max) {
+	switch (Type) {
+	case COLUMN_INT32:
+	case COLUMN_INT64: return Value.Int >= Min.Int && Value.Int <= Max.Int;
+	case COLUMN_DOUBLE: return Value.Double >= Min.Double && Value.Double <= Max.Double;
+	default: return Value.Uint >= Min.Uint && Value.Uint <= Max.Uint;
+	}
+}
+
+void column_store_filter(column_store_t *Store, size_t Column, size_t Start, size_t Count, column_value_t Min, column_value_t Max, uint64_t *Selection, column_combine_t Combine) {
+	column_type_t Type = Store->Header->Types[Column];
+	column_file_t *File = Store->Columns + Column;
+	const char *Values = (const char *)File->Values + Start * File->Width;
+	if (!column_store_range(Type, &Min, &Max)) {
+		for (size_t I = 0; I < Count; I += 64) radb_combine(Selection + I / 64, 0, Combine);
+		return;
+	}
+	// The kernels handle whole words of 64 rows, the remaining rows are checked here.
+	size_t Full = Count & ~(size_t)63;
+	if (Full) {
+		if (Type == COLUMN_DOUBLE) {
+			RadbKernels->filter_double((const double *)Values, Full, Min.Double, Max.Double, Selection, Combine);
+		} else {
+			RadbKernels->filter[__builtin_ctz(File->Width)](Values, Full, Min.Uint, Max.Uint - Min.Uint, Selection, Combine);
+		}
+	}
+	if (Count > Full) {
+		uint64_t Word = 0;
+		for (size_t J = 0; J < Count - Full; ++J) {
+			column_value_t Value = column_store_load(Type, Values + (Full + J) * File->Width);
+			Word |= (uint64_t)column_store_in_range(Type, Value, Min, Max) << J;
+		}
+		radb_combine(Selection + Full / 64, Word, Combine);
+	}
+}
+
+column_value_t column_store_sum(column_store_t *Store, size_t Column, size_t Start, size_t Count, const uint64_t *Selection) {
+	column_type_t Type = Store->Header->Types[Column];
+	column_file_t *File = Store->Columns + Column;
+	const char *Values = (const char *)File->Values + Start * File->Width;
+	size_t Full = Count & ~(size_t)63;
+	column_value_t Sum = {0};
+	if (Type == COLUMN_DOUBLE) {
+		if (Full) Sum.Double = RadbKernels->sum_double((const double *)Values, Full, Selection);
+	} else if (Type == COLUMN_INT32) {
+		if (Full) Sum.Uint = RadbKernels->sum_int32((const int32_t *)Values, Full, Selection);
+	} else {
+		if (Full) Sum.Uint = RadbKernels->sum[__builtin_ctz(File->Width)](Values, Full, Selection);
+	}
+	if (Count > Full) {
+		uint64_t Word = Selection ? Selection[Full / 64] : ~(uint64_t)0;
+		for (size_t J = 0; J < Count - Full; ++J) {
+			if (!(Word & ((uint64_t)1 << J))) continue;
+			column_value_t Value = column_store_load(Type, Values + (Full + J) * File->Width);
+			if (Type == COLUMN_DOUBLE) {
+				Sum.Double += Value.Double;
+			} else {
+				Sum.Uint += Value.Uint;
+			}
+		}
+	}
+	return Sum;
+}
+
+size_t column_store_count(const uint64_t *Selection, size_t Count) {
+	size_t Total = 0;
+	for (size_t I = 0; I < Count / 64; ++I) Total += __builtin_popcountll(Selection[I]);
+	if (Count % 64) Total += __builtin_popcountll(Selection[Count / 64] & (((uint64_t)1 << (Count % 64)) - 1));
+	return Total;
+}
+
+size_t column_store_select(const uint64_t *Selection, size_t Start, size_t Count, uint32_t *Indices) {
+	uint32_t *Next = Indices;
+	for (size_t I = 0; I < Count; I += 64) {
+		uint64_t Word = Selection[I / 64];
+		if (Count - I < 64) Word &= ((uint64_t)1 << (Count - I)) - 1;
+		for (; Word; Word &= Word - 1) *Next++ = Start + I + __builtin_ctzll(Word);
+	}
+	return Next - Indices;
+}
@@ -0,0 +1,57 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include "config.h"
+#include "common.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+typedef struct column_store_t column_store_t;
+
+typedef enum {
+	COLUMN_UINT8,
+	COLUMN_UINT16,
+	COLUMN_UINT32,
+	COLUMN_UINT64,
+	COLUMN_INT32,
+	COLUMN_INT64,
+	COLUMN_DOUBLE
+} column_type_t;
+
+typedef union {
+	uint64_t Uint;
+	int64_t Int;
+	double Double;
+} column_value_t;
+
+typedef enum {
+	COLUMN_SET,
+	COLUMN_AND,
+	COLUMN_OR
+} column_combine_t;
+
+column_store_t *column_store_create(const char *Prefix, size_t NumColumns, const column_type_t *Types, size_t ChunkSize RADB_MEM_PARAMS);
+column_store_t *column_store_open(const char *Prefix RADB_MEM_PARAMS);
+void column_store_close(column_store_t *Store);
+
+typedef struct {
+	column_store_t *Store;
+	radb_error_t Error;
+} column_store_open_t;
+
+column_store_open_t column_store_open2(const char *Prefix RADB_MEM_PARAMS);
+
+size_t column_store_num_columns(column_store_t *Store);
+size_t column_store_num_rows(column_store_t *Store);
+column_type_t column_store_type(column_store_t *Store, size_t Column);
+
+void *column_store_get(column_store_t *Store, size_t Column, size_t Index);
+void *column_store_values(column_store_t *Store, size_t Column);
+
+void column_store_filter(column_store_t *Store, size_t Column, size_t Start, size_t Count, column_value_t Min, column_value_t Max, uint64_t *Selection, column_combine_t Combine);
+column_value_t column_store_sum(column_store_t *Store, size_t Column, size_t Start, size_t Count, const uint64_t *Selection);
+
+size_t column_store_count(const uint64_t *Selection, size_t Count);
+size_t column_store_select(const uint64_t *Selection, size_t Start, size_t Count, uint32_t *Indices);
+
+#endif
@@ -1,4 +1,14 @@
 #include "common.h"
+#include "trace.h"
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 const char *radb_error_string(radb_error_t Error) {
 	switch (Error) {
@@ -9,6 +19,191 @@ const char *radb_error_string(radb_error_t Error) {
 	case RADB_KEYS_FILE_NOT_FOUND: return "keys file not found";
 	case RADB_KEYS_HEADER_MISMATCH: return "keys header mismatch";
 	case RADB_KEYS_HEADER_CORRUPTED: return "keys header corrupted";
+	case RADB_LOCK_FAILED: return "lock failed";
+	case RADB_WRITE_FAILED: return "write failed";
 	default: return "invalid error";
 	}
 }
+
+static int NumThreads = 1;
+
+void radb_set_threads(int Value) {
+	NumThreads = Value > 0 ? Value : 1;
+}
+
+int radb_get_threads(void) {
+	return NumThreads;
+}
+
+static radb_progress_t ProgressCallback = NULL;
+static void *ProgressData = NULL;
+
+void radb_set_progress(radb_progress_t Callback, void *Data) {
+	ProgressCallback = Callback;
+	ProgressData = Data;
+}
+
+void radb_progress(const char *Prefix, size_t Done, size_t Total) {
+	if (ProgressCallback) ProgressCallback(ProgressData, Prefix, Done, Total);
+}
+
+typedef struct {
+	radb_task_t Task;
+	void *Data;
+	int Thread, NumThreads;
+} radb_worker_t;
+
+static void *radb_worker(radb_worker_t *Worker) {
+	Worker->Task(Worker->Data, Worker->Thread, Worker->NumThreads);
+	return NULL;
+}
+
+void radb_parallel(radb_task_t Task, void *Data, int NumThreads) {
+	if (NumThreads <= 1) {
+		Task(Data, 0, 1);
+		return;
+	}
+	pthread_t Threads[NumThreads];
+	radb_worker_t Workers[NumThreads];
+	for (int I = 1; I < NumThreads; ++I) {
+		Workers[I] = (radb_worker_t){Task, Data, I, NumThreads};
+		if (pthread_create(Threads + I, NULL, (void *)radb_worker, Workers + I)) {
+			// Run the task on this thread if a new thread cannot be created.
+			Threads[I] = 0;
+			Task(Data, I, NumThreads);
+		}
+	}
+	Task(Data, 0, NumThreads);
+	for (int I = 1; I < NumThreads; ++I) if (Threads[I]) pthread_join(Threads[I], NULL);
+}
+
+#define INVALID_INDEX 0xFFFFFFFF
+#define FOREACH_CHUNK_SIZE 4096
+
+typedef struct {
+	radb_cursor_t *Cursor;
+	void *Data;
+	radb_foreach_fn Callback;
+	size_t Next;
+	int Stop;
+} radb_foreach_t;
+
+static void radb_foreach_task(radb_foreach_t *Foreach, int Thread, int NumThreads) {
+	radb_cursor_t Cursor = Foreach->Cursor[0];
+	size_t Limit = Foreach->Cursor->Limit;
+	while (!__atomic_load_n(&Foreach->Stop, __ATOMIC_RELAXED)) {
+		size_t Start = __atomic_fetch_add(&Foreach->Next, FOREACH_CHUNK_SIZE, __ATOMIC_RELAXED);
+		if (Start >= Limit) return;
+		Cursor.Position = Start;
+		Cursor.Limit = Limit - Start > FOREACH_CHUNK_SIZE ? Start + FOREACH_CHUNK_SIZE : Limit;
+		for (size_t Index; (Index = Cursor.next(&Cursor)) != INVALID_INDEX;) {
+			if (Foreach->Callback(Index, Foreach->Data, Thread)) {
+				__atomic_store_n(&Foreach->Stop, 1, __ATOMIC_RELAXED);
+				return;
+			}
+		}
+	}
+}
+
+int radb_parallel_foreach(radb_cursor_t *Cursor, void *Data, radb_foreach_fn Callback) {
+	radb_foreach_t Foreach = {Cursor, Data, Callback, Cursor->Position, 0};
+	size_t NumChunks = Cursor->Limit > Cursor->Position ? (Cursor->Limit - Cursor->Position + FOREACH_CHUNK_SIZE - 1) / FOREACH_CHUNK_SIZE : 0;
+	int NumThreads = radb_get_threads();
+	if (NumThreads > NumChunks) NumThreads = NumChunks ? NumChunks : 1;
+	radb_parallel((radb_task_t)radb_foreach_task, &Foreach, NumThreads);
+	Cursor->Position = Cursor->Limit;
+	return Foreach.Stop;
+}
+
+static void radb_migration_hash(radb_migration_t *Migration, int Thread, int NumThreads) {
+	size_t Start = Migration->Count * Thread / NumThreads;
+	size_t End = Migration->Count * (Thread + 1) / NumThreads;
+	Migration->hash(Migration, Start, End);
+}
+
+void radb_migration_init(radb_migration_t *Migration, const char *Prefix, size_t Done, size_t Total) {
+	Migration->Prefix = Prefix;
+	Migration->Skip = Migration->Done = Done;
+	Migration->Total = Total;
+	Migration->Count = 0;
+}
+
+int radb_migration_add(size_t Index, radb_migration_t *Migration) {
+	if (Migration->Skip) {
+		--Migration->Skip;
+		return 0;
+	}
+	Migration->Indices[Migration->Count] = Index;
+	if (++Migration->Count == RADB_MIGRATION_BATCH_SIZE) radb_migration_flush(Migration);
+	return 0;
+}
+
+void radb_migration_flush(radb_migration_t *Migration) {
+	if (!Migration->Count) return;
+	radb_parallel((radb_task_t)radb_migration_hash, Migration, radb_get_threads());
+	Migration->insert(Migration, Migration->Count);
+	Migration->Done += Migration->Count;
+	Migration->Count = 0;
+	radb_progress(Migration->Prefix, Migration->Done, Migration->Total);
+}
+
+// Only one migration may write to <prefix>.migrate.index2 at a time, a waiting migration finds the index already renamed.
+radb_error_t radb_migrate_start(const char *Prefix, int *Lock) {
+	char FileName[strlen(Prefix) + 20];
+	sprintf(FileName, "%s.migrate.lock", Prefix);
+	*Lock = open(FileName, O_RDWR | O_CREAT, 0644);
+	if (*Lock < 0) return RADB_LOCK_FAILED;
+	if (flock(*Lock, LOCK_EX)) {
+		close(*Lock);
+		*Lock = -1;
+		return RADB_LOCK_FAILED;
+	}
+	struct stat Stat[1];
+	sprintf(FileName, "%s.index2", Prefix);
+	if (!stat(FileName, Stat)) {
+		close(*Lock);
+		*Lock = -1;
+	}
+	return RADB_SUCCESS;
+}
+
+radb_error_t radb_migrate_finish(const char *Prefix, int Lock, radb_error_t Error) {
+	char OldName[strlen(Prefix) + 20], NewName[strlen(Prefix) + 20];
+	if (Error == RADB_SUCCESS) {
+		sprintf(OldName, "%s.migrate.index2", Prefix);
+		sprintf(NewName, "%s.index2", Prefix);
+		rename(OldName, NewName);
+		sprintf(OldName, "%s.migrate.lock", Prefix);
+		unlink(OldName);
+	}
+	close(Lock);
+	return Error;
+}
+
+uint64_t radb_time(void) {
+	struct timespec Time[1];
+	clock_gettime(CLOCK_MONOTONIC, Time);
+	return Time->tv_sec * 1000000000ul + Time->tv_nsec;
+}
+
+void radb_truncate(radb_stats_t *Stats, int Fd, size_t Size) {
+	RADB_PROBE2(truncate, Fd, Size);
+	uint64_t Start = radb_time();
+	ftruncate(Fd, Size);
+	Stats->Truncates.Time += radb_time() - Start;
+	++Stats->Truncates.Count;
+}
+
+void *radb_remap(radb_stats_t *Stats, int Fd, void *Address, size_t OldSize, size_t NewSize) {
+	RADB_PROBE3(remap, Fd, OldSize, NewSize);
+	uint64_t Start = radb_time();
+#ifdef Linux
+	Address = mremap(Address, OldSize, NewSize, MREMAP_MAYMOVE);
+#else
+	munmap(Address, OldSize);
+	Address = mmap(NULL, NewSize, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+#endif
+	Stats->Remaps.Time += radb_time() - Start;
+	++Stats->Remaps.Count;
+	return Address;
+}
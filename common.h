@@ -11,7 +11,9 @@ typedef enum {
 	RADB_HEADER_CORRUPTED,
 	RADB_KEYS_FILE_NOT_FOUND,
 	RADB_KEYS_HEADER_MISMATCH,
-	RADB_KEYS_HEADER_CORRUPTED
+	RADB_KEYS_HEADER_CORRUPTED,
+	RADB_LOCK_FAILED,
+	RADB_WRITE_FAILED
 } radb_error_t;
 
 const char *radb_error_string(radb_error_t Error);
@@ -21,4 +23,76 @@ typedef struct {
 	int Created;
 } index_result_t;
 
+#define RADB_STATS_HISTOGRAM_SIZE 16
+
+typedef struct {
+	uint64_t Count, Time;
+} radb_event_stats_t;
+
+typedef struct {
+	radb_event_stats_t Truncates, Remaps, Rebuilds;
+} radb_stats_t;
+
+void radb_set_threads(int NumThreads);
+int radb_get_threads(void);
+
+int radb_set_kernels(const char *Name);
+const char *radb_get_kernels(void);
+
+typedef void (*radb_progress_t)(void *Data, const char *Prefix, size_t Done, size_t Total);
+void radb_set_progress(radb_progress_t Callback, void *Data);
+void radb_progress(const char *Prefix, size_t Done, size_t Total);
+
+typedef void (*radb_task_t)(void *Data, int Thread, int NumThreads);
+void radb_parallel(radb_task_t Task, void *Data, int NumThreads);
+
+#define RADB_MIGRATION_BATCH_SIZE 65536
+
+typedef struct radb_migration_t radb_migration_t;
+
+typedef void (*radb_migration_hash_t)(radb_migration_t *Migration, size_t Start, size_t End);
+typedef void (*radb_migration_insert_t)(radb_migration_t *Migration, size_t Count);
+
+// Keys are migrated in batches, each batch is hashed in parallel and then inserted in order.
+struct radb_migration_t {
+	radb_migration_hash_t hash;
+	radb_migration_insert_t insert;
+	const char *Prefix;
+	size_t Skip, Done, Total, Count;
+	uint32_t Indices[RADB_MIGRATION_BATCH_SIZE];
+	uint32_t Hashes[RADB_MIGRATION_BATCH_SIZE];
+};
+
+void radb_migration_init(radb_migration_t *Migration, const char *Prefix, size_t Done, size_t Total);
+int radb_migration_add(size_t Index, radb_migration_t *Migration);
+void radb_migration_flush(radb_migration_t *Migration);
+
+radb_error_t radb_migrate_start(const char *Prefix, int *Lock);
+radb_error_t radb_migrate_finish(const char *Prefix, int Lock, radb_error_t Error);
+
+typedef struct radb_cursor_t radb_cursor_t;
+
+struct radb_cursor_t {
+	void *Store;
+	size_t (*next)(radb_cursor_t *Cursor);
+	size_t Position, Limit;
+};
+
+static inline size_t radb_cursor_next(radb_cursor_t *Cursor) {
+	return Cursor->next(Cursor);
+}
+
+typedef int (*radb_foreach_fn)(size_t Index, void *Data, int Thread);
+int radb_parallel_foreach(radb_cursor_t *Cursor, void *Data, radb_foreach_fn Callback);
+
+uint64_t radb_time(void);
+void radb_truncate(radb_stats_t *Stats, int Fd, size_t Size);
+void *radb_remap(radb_stats_t *Stats, int Fd, void *Address, size_t OldSize, size_t NewSize);
+
+static inline void radb_stats_histogram(size_t *Histogram, size_t Value) {
+	int Bucket = Value ? 63 - __builtin_clzl(Value) : 0;
+	if (Bucket >= RADB_STATS_HISTOGRAM_SIZE) Bucket = RADB_STATS_HISTOGRAM_SIZE - 1;
+	++Histogram[Bucket];
+}
+
 #endif
@@ -0,0 +1,78 @@
+#include "filter.h"
+#include "trace.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define RADB_FILTER_SIGNATURE 0x464C4952
+#define RADB_FILTER_VERSION MAKE_VERSION(1, 0)
+
+#define MIN_CAPACITY 1024
+
+void radb_filter_create(radb_filter_t *Filter, const char *FileName, double Rate) {
+	Filter->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Filter->HeaderSize = sizeof(radb_filter_header_t);
+	ftruncate(Filter->HeaderFd, Filter->HeaderSize);
+	Filter->Header = mmap(NULL, Filter->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Filter->HeaderFd, 0);
+	Filter->Header->Signature = RADB_FILTER_SIGNATURE;
+	Filter->Header->Version = RADB_FILTER_VERSION;
+	Filter->Header->NumBlocks = 0;
+	Filter->Header->NumHashes = 0;
+	Filter->Header->Capacity = 0;
+	Filter->Header->Deleted = 0;
+	Filter->Header->Valid = 0;
+	Filter->Header->Rate = Rate;
+}
+
+int radb_filter_open(radb_filter_t *Filter, const char *FileName) {
+	struct stat Stat[1];
+	Filter->Header = NULL;
+	if (stat(FileName, Stat)) return -1;
+	Filter->HeaderFd = open(FileName, O_RDWR, 0777);
+	Filter->HeaderSize = Stat->st_size;
+	Filter->Header = mmap(NULL, Filter->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Filter->HeaderFd, 0);
+	if (Filter->HeaderSize < sizeof(radb_filter_header_t) || Filter->Header->Signature != RADB_FILTER_SIGNATURE) {
+		munmap(Filter->Header, Filter->HeaderSize);
+		close(Filter->HeaderFd);
+		Filter->Header = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+void radb_filter_resize(radb_filter_t *Filter, radb_stats_t *Stats, size_t Capacity) {
+	if (Capacity < MIN_CAPACITY) Capacity = MIN_CAPACITY;
+	// About 1.5 * log2(1 / Rate) bits per key, a little more than a plain Bloom filter to allow for
+	// uneven blocks. The logarithm is rounded up to avoid depending on libm.
+	double Log2 = 0;
+	for (double Rate = Filter->Header->Rate; Rate < 1; Rate *= 2) Log2 += 1;
+	size_t BitsPerKey = Log2 * 1.5 + 1;
+	size_t NumHashes = (BitsPerKey * 60 + 50) / 100;
+	if (NumHashes < 1) NumHashes = 1;
+	if (NumHashes > 16) NumHashes = 16;
+	size_t NumBlocks = (Capacity * BitsPerKey + RADB_FILTER_BLOCK_BITS - 1) / RADB_FILTER_BLOCK_BITS;
+	size_t HeaderSize = sizeof(radb_filter_header_t) + NumBlocks * (RADB_FILTER_BLOCK_BITS / 8);
+	Filter->Header->Valid = 0;
+	if (HeaderSize != Filter->HeaderSize) {
+		radb_truncate(Stats, Filter->HeaderFd, HeaderSize);
+		Filter->Header = radb_remap(Stats, Filter->HeaderFd, Filter->Header, Filter->HeaderSize, HeaderSize);
+		Filter->HeaderSize = HeaderSize;
+	}
+	memset(Filter->Header->Blocks, 0, NumBlocks * (RADB_FILTER_BLOCK_BITS / 8));
+	Filter->Header->NumBlocks = NumBlocks;
+	Filter->Header->NumHashes = NumHashes;
+	Filter->Header->Capacity = Capacity;
+	Filter->Header->Deleted = 0;
+}
+
+void radb_filter_close(radb_filter_t *Filter) {
+	radb_sync(Filter->Header, Filter->HeaderSize);
+	munmap(Filter->Header, Filter->HeaderSize);
+	close(Filter->HeaderFd);
+	Filter->Header = NULL;
+}
@@ -0,0 +1,58 @@
+#ifndef RADB_FILTER_H
+#define RADB_FILTER_H
+
+#include "common.h"
+
+#define RADB_FILTER_BLOCK_SHIFT 9
+#define RADB_FILTER_BLOCK_BITS (1 << RADB_FILTER_BLOCK_SHIFT)
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumBlocks, NumHashes;
+	uint32_t Capacity, Deleted;
+	uint32_t Valid, Reserved;
+	double Rate;
+	uint32_t Padding[6];
+	uint64_t Blocks[][RADB_FILTER_BLOCK_BITS / 64];
+} radb_filter_header_t;
+
+typedef struct {
+	radb_filter_header_t *Header;
+	size_t HeaderSize;
+	int HeaderFd;
+} radb_filter_t;
+
+void radb_filter_create(radb_filter_t *Filter, const char *FileName, double Rate);
+int radb_filter_open(radb_filter_t *Filter, const char *FileName);
+void radb_filter_resize(radb_filter_t *Filter, radb_stats_t *Stats, size_t Capacity);
+void radb_filter_close(radb_filter_t *Filter);
+
+static inline uint64_t radb_filter_mix(uint32_t Hash) {
+	uint64_t X = Hash + 0x9E3779B97F4A7C15;
+	X = (X ^ (X >> 30)) * 0xBF58476D1CE4E5B9;
+	X = (X ^ (X >> 27)) * 0x94D049BB133111EB;
+	return X ^ (X >> 31);
+}
+
+static inline void radb_filter_add(radb_filter_header_t *Header, uint32_t Hash) {
+	uint64_t Mix = radb_filter_mix(Hash);
+	uint64_t *Block = Header->Blocks[((Mix >> 32) * Header->NumBlocks) >> 32];
+	for (int I = Header->NumHashes; --I >= 0;) {
+		Mix = Mix * 0x5851F42D4C957F2D + 0x14057B7EF767814F;
+		uint32_t Bit = Mix >> (64 - RADB_FILTER_BLOCK_SHIFT);
+		Block[Bit / 64] |= 1ULL << (Bit % 64);
+	}
+}
+
+static inline int radb_filter_check(radb_filter_header_t *Header, uint32_t Hash) {
+	uint64_t Mix = radb_filter_mix(Hash);
+	uint64_t *Block = Header->Blocks[((Mix >> 32) * Header->NumBlocks) >> 32];
+	for (int I = Header->NumHashes; --I >= 0;) {
+		Mix = Mix * 0x5851F42D4C957F2D + 0x14057B7EF767814F;
+		uint32_t Bit = Mix >> (64 - RADB_FILTER_BLOCK_SHIFT);
+		if (!(Block[Bit / 64] & (1ULL << (Bit % 64)))) return 0;
+	}
+	return 1;
+}
+
+#endif
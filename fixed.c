@@ -1,5 +1,10 @@
 #include "fixed_store.h"
 #include "fixed_index.h"
+#include "trace.h"
+#include "kernel.h"
+#include "bitmap.h"
+#include "pages.h"
+#include "sort.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -25,8 +30,14 @@ static inline const char *radb_strdup(const char *String, void *Allocator, void
 #define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
 
 #define FIXED_STORE_SIGNATURE 0x53464152
+#define FIXED_STORE_BITMAP_SIGNATURE 0x42464152
+#define FIXED_STORE_PACKED_SIGNATURE 0x4B464152
+#define FIXED_STORE_SPARSE_SIGNATURE 0x50464152
 #define FIXED_STORE_VERSION MAKE_VERSION(1, 0)
 
+#define FIXED_SEARCH_SIGNATURE 0x48534652
+#define FIXED_SEARCH_VERSION MAKE_VERSION(1, 0)
+
 typedef struct {
 	uint32_t Signature, Version;
 	uint32_t NodeSize, ChunkSize;
@@ -34,6 +45,24 @@ typedef struct {
 	char Nodes[];
 } fixed_store_header_t;
 
+// A piecewise linear model of the position of the first entry with each key, which is within Error
+// entries of the prediction. Keys are projected to 64 bit integers, and the segment for a key is
+// found from the table Radix, which holds the first segment starting at or after each value of the
+// top RadixBits bits of Key - MinKey (after shifting right by RadixShift).
+typedef struct {
+	uint64_t Key, Position;
+	double Slope;
+} fixed_search_segment_t;
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t Offset, Size;
+	uint32_t Error, RadixBits, RadixShift, Reserved;
+	uint64_t Count, NumSegments;
+	uint64_t MinKey;
+	uint32_t Radix[];
+} fixed_search_header_t;
+
 struct fixed_store_t {
 #ifdef RADB_MEM_PER_STORE
 	void *Allocator;
@@ -43,11 +72,26 @@ struct fixed_store_t {
 #endif
 	const char *Prefix;
 	fixed_store_header_t *Header;
+	// Bitmap stores keep a bit for each allocated entry in a separate *bitmap* file instead of a free chain.
+	radb_bitmap_t Bitmap[1];
+	// Sparse stores map pages of entries through a *pages* file and keep only touched pages after the header.
+	radb_pages_t Pages[1];
+	// Search accelerator in a *search* file, built by fixed_store_search_build().
+	fixed_search_header_t *Search;
+	size_t SearchSize;
+	int SearchFd;
 	size_t HeaderSize;
 	int HeaderFd;
+	radb_stats_t Stats[1];
 };
 
-fixed_store_t *fixed_store_create(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+#define FIXED_STORE_BITMAP 1
+#define FIXED_STORE_PACKED 2
+#define FIXED_STORE_SPARSE 3
+
+static void *fixed_store_node(fixed_store_t *Store, size_t Index);
+
+static fixed_store_t *fixed_store_create_mode(const char *Prefix, size_t RequestedSize, size_t ChunkSize, int Mode RADB_MEM_PARAMS) {
 #if defined(RADB_MEM_MALLOC)
 	fixed_store_t *Store = malloc(sizeof(fixed_store_t));
 	Store->Prefix = strdup(Prefix);
@@ -63,30 +107,140 @@ fixed_store_t *fixed_store_create(const char *Prefix, size_t RequestedSize, size
 	Store->free = free;
 #endif
 	uint32_t NodeSize;
-	if (RequestedSize <= 4) {
+	if (Mode == FIXED_STORE_PACKED) {
+		NodeSize = RequestedSize ? RequestedSize : 1;
+	} else if (RequestedSize <= 4) {
 		NodeSize = 4;
 	} else {
 		NodeSize = ((RequestedSize + 7) / 8) * 8;
 	}
+	size_t PageShift = 0;
+	if (Mode == FIXED_STORE_SPARSE) {
+		if (!ChunkSize) ChunkSize = 4096;
+		while (((size_t)NodeSize << (PageShift + 1)) <= ChunkSize && PageShift < 20) ++PageShift;
+		ChunkSize = (size_t)NodeSize << PageShift;
+	}
 	if (!ChunkSize) ChunkSize = 512;
 	int NumEntries = (ChunkSize - sizeof(fixed_store_header_t) + NodeSize - 1) / NodeSize;
+	if (Mode == FIXED_STORE_SPARSE) NumEntries = 0;
 	char FileName[strlen(Prefix) + 10];
 	sprintf(FileName, "%s.entries", Prefix);
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
 	Store->HeaderSize = sizeof(fixed_store_header_t) + NumEntries * NodeSize;
 	ftruncate(Store->HeaderFd, Store->HeaderSize);
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-	Store->Header->Signature = FIXED_STORE_SIGNATURE;
+	switch (Mode) {
+	case FIXED_STORE_BITMAP: Store->Header->Signature = FIXED_STORE_BITMAP_SIGNATURE; break;
+	case FIXED_STORE_PACKED: Store->Header->Signature = FIXED_STORE_PACKED_SIGNATURE; break;
+	case FIXED_STORE_SPARSE: Store->Header->Signature = FIXED_STORE_SPARSE_SIGNATURE; break;
+	default: Store->Header->Signature = FIXED_STORE_SIGNATURE; break;
+	}
 	Store->Header->Version = FIXED_STORE_VERSION;
 	Store->Header->NodeSize = NodeSize;
 	Store->Header->ChunkSize = (ChunkSize + NodeSize - 1) / NodeSize;
 	Store->Header->NumEntries = NumEntries;
 	Store->Header->FreeEntry = 0;
-	*(uint32_t *)Store->Header->Nodes = INVALID_INDEX;
+	Store->Bitmap->Header = NULL;
+	Store->Pages->Header = NULL;
+	Store->Search = NULL;
+	if (Mode == FIXED_STORE_SPARSE) {
+		sprintf(FileName, "%s.pages", Prefix);
+		radb_pages_create(Store->Pages, FileName, PageShift);
+		Store->Header->NumEntries = (size_t)1 << PageShift;
+		*(uint32_t *)fixed_store_node(Store, 0) = INVALID_INDEX;
+	} else if (Mode) {
+		sprintf(FileName, "%s.bitmap", Prefix);
+		radb_bitmap_create(Store->Bitmap, FileName, NumEntries);
+	} else {
+		*(uint32_t *)Store->Header->Nodes = INVALID_INDEX;
+	}
 	//msync(Store->Header, Store->HeaderSize, MS_ASYNC);
 	return Store;
 }
 
+fixed_store_t *fixed_store_create(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return fixed_store_create_mode(Prefix, RequestedSize, ChunkSize, 0 RADB_MEM_ARGS);
+}
+
+fixed_store_t *fixed_store_create_bitmap(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return fixed_store_create_mode(Prefix, RequestedSize, ChunkSize, FIXED_STORE_BITMAP RADB_MEM_ARGS);
+}
+
+fixed_store_t *fixed_store_create_packed(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return fixed_store_create_mode(Prefix, RequestedSize, ChunkSize, FIXED_STORE_PACKED RADB_MEM_ARGS);
+}
+
+fixed_store_t *fixed_store_create_sparse(const char *Prefix, size_t RequestedSize, size_t PageSize RADB_MEM_PARAMS) {
+	return fixed_store_create_mode(Prefix, RequestedSize, PageSize, FIXED_STORE_SPARSE RADB_MEM_ARGS);
+}
+
+// Bitmap stores need no free chain recovery, the entries file may have grown without the header
+// being written and the bitmap is grown to match it.
+static fixed_store_open_t fixed_store_open_bitmap(fixed_store_t *Store) {
+	size_t NumEntries = (Store->HeaderSize - sizeof(fixed_store_header_t)) / Store->Header->NodeSize;
+	if (NumEntries < Store->Header->NumEntries) {
+		fixed_store_close(Store);
+		return (fixed_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+	Store->Header->NumEntries = NumEntries;
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.bitmap", Store->Prefix);
+	if (radb_bitmap_open(Store->Bitmap, Store->Stats, FileName, NumEntries)) {
+		fixed_store_close(Store);
+		return (fixed_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+	return (fixed_store_open_t){Store, RADB_SUCCESS};
+}
+
+// The entries file may not have been grown after a page was mapped, the missing pages are zero.
+static fixed_store_open_t fixed_store_open_sparse(fixed_store_t *Store) {
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.pages", Store->Prefix);
+	if (radb_pages_open(Store->Pages, FileName) || Store->Header->FreeEntry >= Store->Header->NumEntries) {
+		fixed_store_close(Store);
+		return (fixed_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+	size_t PageSize = (size_t)Store->Header->NodeSize << Store->Pages->Header->PageShift;
+	size_t HeaderSize = sizeof(fixed_store_header_t) + Store->Pages->Header->NumPages * PageSize;
+	if (HeaderSize > Store->HeaderSize) {
+		radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+		Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
+		Store->HeaderSize = HeaderSize;
+	}
+	return (fixed_store_open_t){Store, RADB_SUCCESS};
+}
+
+static size_t fixed_store_search_size(size_t RadixBits, size_t NumSegments) {
+	size_t RadixSize = (((size_t)1 << RadixBits) + 1) * sizeof(uint32_t);
+	return ((sizeof(fixed_search_header_t) + RadixSize + 7) & ~(size_t)7) + NumSegments * sizeof(fixed_search_segment_t);
+}
+
+static fixed_search_segment_t *fixed_store_search_segments(fixed_search_header_t *Search) {
+	size_t RadixSize = (((size_t)1 << Search->RadixBits) + 1) * sizeof(uint32_t);
+	return (fixed_search_segment_t *)((char *)Search + ((sizeof(fixed_search_header_t) + RadixSize + 7) & ~(size_t)7));
+}
+
+// A search file which no longer fits the store is ignored.
+static void fixed_store_open_search(fixed_store_t *Store) {
+	struct stat Stat[1];
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.search", Store->Prefix);
+	Store->Search = NULL;
+	if (stat(FileName, Stat) || Stat->st_size < sizeof(fixed_search_header_t)) return;
+	Store->SearchFd = open(FileName, O_RDWR, 0777);
+	Store->SearchSize = Stat->st_size;
+	Store->Search = mmap(NULL, Store->SearchSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->SearchFd, 0);
+	fixed_search_header_t *Search = Store->Search;
+	if (Search->Signature != FIXED_SEARCH_SIGNATURE || Search->RadixBits > 24 || !Search->Size
+		|| Store->SearchSize != fixed_store_search_size(Search->RadixBits, Search->NumSegments)
+		|| Search->Count > Store->Header->NumEntries || Search->Offset + Search->Size > Store->Header->NodeSize) {
+		munmap(Store->Search, Store->SearchSize);
+		close(Store->SearchFd);
+		Store->Search = NULL;
+	}
+}
+
 fixed_store_open_t fixed_store_open2(const char *Prefix RADB_MEM_PARAMS) {
 	struct stat Stat[1];
 	char FileName[strlen(Prefix) + 10];
@@ -106,10 +260,20 @@ fixed_store_open_t fixed_store_open2(const char *Prefix RADB_MEM_PARAMS) {
 	Store->alloc_atomic = alloc_atomic;
 	Store->free = free;
 #endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR, 0777);
 	Store->HeaderSize = Stat->st_size;
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-	if (Store->Header->Signature != FIXED_STORE_SIGNATURE) {
+	Store->Bitmap->Header = NULL;
+	Store->Pages->Header = NULL;
+	Store->Search = NULL;
+	uint32_t Signature = Store->Header->Signature;
+	if (Signature == FIXED_STORE_SIGNATURE || Signature == FIXED_STORE_BITMAP_SIGNATURE
+		|| Signature == FIXED_STORE_PACKED_SIGNATURE || Signature == FIXED_STORE_SPARSE_SIGNATURE) fixed_store_open_search(Store);
+	// Packed stores differ from bitmap stores only in their entry size, which is read from the header.
+	if (Signature == FIXED_STORE_BITMAP_SIGNATURE || Signature == FIXED_STORE_PACKED_SIGNATURE) return fixed_store_open_bitmap(Store);
+	if (Signature == FIXED_STORE_SPARSE_SIGNATURE) return fixed_store_open_sparse(Store);
+	if (Signature != FIXED_STORE_SIGNATURE) {
 		fixed_store_close(Store);
 		return (fixed_store_open_t){NULL, RADB_HEADER_MISMATCH};
 	}
@@ -145,7 +309,13 @@ fixed_store_t *fixed_store_open(const char *Prefix RADB_MEM_PARAMS) {
 }
 
 void fixed_store_close(fixed_store_t *Store) {
-	msync(Store->Header, Store->HeaderSize, MS_SYNC);
+	if (Store->Bitmap->Header) radb_bitmap_close(Store->Bitmap);
+	if (Store->Pages->Header) radb_pages_close(Store->Pages);
+	if (Store->Search) {
+		munmap(Store->Search, Store->SearchSize);
+		close(Store->SearchFd);
+	}
+	radb_sync(Store->Header, Store->HeaderSize);
 	munmap(Store->Header, Store->HeaderSize);
 	close(Store->HeaderFd);
 #if defined(RADB_MEM_MALLOC)
@@ -170,44 +340,58 @@ static void *fixed_store_get_unchecked(fixed_store_t *Store, size_t Index) {
 	return Store->Header->Nodes + Index * Store->Header->NodeSize;
 }
 
-void *fixed_store_get(fixed_store_t *Store, size_t Index) {
-	if (Index >= Store->Header->NumEntries) {
-		size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
-		NumEntries += Store->Header->ChunkSize - 1;
-		NumEntries /= Store->Header->ChunkSize;
-		NumEntries *= Store->Header->ChunkSize;
-		size_t HeaderSize = Store->HeaderSize + NumEntries * Store->Header->NodeSize;
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-		Store->Header->NumEntries += NumEntries;
+// Maps a page on first touch, the entries file grows by at least half so that remapping stays amortized and
+// the space past the touched pages is left as a hole.
+static void *fixed_store_touch(fixed_store_t *Store, size_t Index) {
+	size_t PageShift = Store->Pages->Header->PageShift;
+	size_t Page = radb_pages_map(Store->Pages, Store->Stats, Index >> PageShift);
+	size_t PageSize = (size_t)Store->Header->NodeSize << PageShift;
+	size_t HeaderSize = sizeof(fixed_store_header_t) + (Page + 1) * PageSize;
+	if (HeaderSize > Store->HeaderSize) {
+		size_t NumPages = (Store->HeaderSize - sizeof(fixed_store_header_t)) / PageSize;
+		if (Page + 1 < NumPages + NumPages / 2) HeaderSize = sizeof(fixed_store_header_t) + (NumPages + NumPages / 2) * PageSize;
+		radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+		Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
 		Store->HeaderSize = HeaderSize;
 	}
-	return Store->Header->Nodes + Index * Store->Header->NodeSize;
+	return Store->Header->Nodes + ((Page << PageShift) + (Index & (((size_t)1 << PageShift) - 1))) * Store->Header->NodeSize;
+}
+
+static void *fixed_store_node(fixed_store_t *Store, size_t Index) {
+	if (!Store->Pages->Header) return Store->Header->Nodes + Index * Store->Header->NodeSize;
+	size_t PageShift = Store->Pages->Header->PageShift;
+	size_t Page = radb_pages_find(Store->Pages, Index >> PageShift);
+	if (Page == INVALID_INDEX) return fixed_store_touch(Store, Index);
+	return Store->Header->Nodes + ((Page << PageShift) + (Index & (((size_t)1 << PageShift) - 1))) * Store->Header->NodeSize;
+}
+
+static void fixed_store_grow(fixed_store_t *Store, size_t Index) {
+	if (Store->Pages->Header) {
+		// Sparse stores only extend the index space, pages are mapped when they are touched.
+		size_t NumEntries = (((Index >> Store->Pages->Header->PageShift) + 1) << Store->Pages->Header->PageShift);
+		Store->Header->NumEntries = NumEntries < INVALID_INDEX ? NumEntries : INVALID_INDEX;
+		return;
+	}
+	size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
+	NumEntries += Store->Header->ChunkSize - 1;
+	NumEntries /= Store->Header->ChunkSize;
+	NumEntries *= Store->Header->ChunkSize;
+	size_t HeaderSize = Store->HeaderSize + NumEntries * Store->Header->NodeSize;
+	radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+	Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
+	Store->Header->NumEntries += NumEntries;
+	Store->HeaderSize = HeaderSize;
+	if (Store->Bitmap->Header) radb_bitmap_grow(Store->Bitmap, Store->Stats, Store->Header->NumEntries);
+}
+
+void *fixed_store_get(fixed_store_t *Store, size_t Index) {
+	if (Index >= Store->Header->NumEntries) fixed_store_grow(Store, Index);
+	return fixed_store_node(Store, Index);
 }
 
 void fixed_store_shift(fixed_store_t *Store, size_t Source, size_t Count, size_t Destination) {
 	size_t Index = (Source > Destination ? Source : Destination) + Count;
-	if (Index >= Store->Header->NumEntries) {
-		size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
-		NumEntries += Store->Header->ChunkSize - 1;
-		NumEntries /= Store->Header->ChunkSize;
-		NumEntries *= Store->Header->ChunkSize;
-		size_t HeaderSize = Store->HeaderSize + NumEntries * Store->Header->NodeSize;
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-		Store->Header->NumEntries += NumEntries;
-		Store->HeaderSize = HeaderSize;
-	}
+	if (Index >= Store->Header->NumEntries) fixed_store_grow(Store, Index);
 	size_t LargeSource, LargeDest, LargeCount;
 	size_t SmallSource, SmallDest, SmallCount;
 	if (Source < Destination) {
@@ -246,6 +430,19 @@ void fixed_store_shift(fixed_store_t *Store, size_t Source, size_t Count, size_t
 		return;
 	}
 	size_t NodeSize = Store->Header->NodeSize;
+	if (Store->Pages->Header) {
+		// Sparse pages are not contiguous, entries are moved one at a time in the direction of the move.
+		char *SmallSaved = malloc(SmallCount * NodeSize);
+		for (size_t I = 0; I < SmallCount; ++I) memcpy(SmallSaved + I * NodeSize, fixed_store_node(Store, SmallSource + I), NodeSize);
+		if (LargeDest < LargeSource) {
+			for (size_t I = 0; I < LargeCount; ++I) memcpy(fixed_store_node(Store, LargeDest + I), fixed_store_node(Store, LargeSource + I), NodeSize);
+		} else {
+			for (size_t I = LargeCount; I-- > 0;) memcpy(fixed_store_node(Store, LargeDest + I), fixed_store_node(Store, LargeSource + I), NodeSize);
+		}
+		for (size_t I = 0; I < SmallCount; ++I) memcpy(fixed_store_node(Store, SmallDest + I), SmallSaved + I * NodeSize, NodeSize);
+		free(SmallSaved);
+		return;
+	}
 	LargeSource *= NodeSize;
 	LargeDest *= NodeSize;
 	LargeCount *= NodeSize;
@@ -267,30 +464,23 @@ void fixed_store_shift(fixed_store_t *Store, size_t Source, size_t Count, size_t
 	}
 }
 
+static fixed_store_alloc_t fixed_store_alloc_bitmap(fixed_store_t *Store) {
+	size_t Index = radb_bitmap_find(Store->Bitmap, 0);
+	if (Index >= Store->Header->NumEntries) fixed_store_grow(Store, Index);
+	radb_bitmap_set(Store->Bitmap, Index);
+	return (fixed_store_alloc_t){Store->Header->Nodes + Index * Store->Header->NodeSize, Index};
+}
+
 fixed_store_alloc_t fixed_store_alloc2(fixed_store_t *Store) {
+	if (Store->Bitmap->Header) return fixed_store_alloc_bitmap(Store);
 	size_t FreeEntry = Store->Header->FreeEntry;
-	void *Value = Store->Header->Nodes + FreeEntry * Store->Header->NodeSize;
+	void *Value = fixed_store_node(Store, FreeEntry);
 	size_t Next = *(uint32_t *)Value;
 	if (Next == INVALID_INDEX) {
 		Next = FreeEntry + 1;
-		if (Next >= Store->Header->NumEntries) {
-			size_t NumEntries = (Next + 1) - Store->Header->NumEntries;
-			NumEntries += Store->Header->ChunkSize - 1;
-			NumEntries /= Store->Header->ChunkSize;
-			NumEntries *= Store->Header->ChunkSize;
-			size_t HeaderSize = Store->HeaderSize + NumEntries * Store->Header->NodeSize;
-			ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-			Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-			munmap(Store->Header, Store->HeaderSize);
-			Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-			Store->Header->NumEntries += NumEntries;
-			Store->HeaderSize = HeaderSize;
-			Value = Store->Header->Nodes + FreeEntry * Store->Header->NodeSize;
-		}
-		*(uint32_t *)(Store->Header->Nodes + Next * Store->Header->NodeSize) = INVALID_INDEX;
+		if (Next >= Store->Header->NumEntries) fixed_store_grow(Store, Next);
+		*(uint32_t *)fixed_store_node(Store, Next) = INVALID_INDEX;
+		Value = fixed_store_node(Store, FreeEntry);
 	}
 	Store->Header->FreeEntry = Next;
 	return (fixed_store_alloc_t){Value, FreeEntry};
@@ -301,17 +491,255 @@ size_t fixed_store_alloc(fixed_store_t *Store) {
 }
 
 void fixed_store_free(fixed_store_t *Store, size_t Index) {
-	*(uint32_t *)(Store->Header->Nodes + Index * Store->Header->NodeSize) =  Store->Header->FreeEntry;
+	if (Store->Bitmap->Header) {
+		radb_bitmap_clear(Store->Bitmap, Index);
+		return;
+	}
+	*(uint32_t *)fixed_store_node(Store, Index) = Store->Header->FreeEntry;
 	Store->Header->FreeEntry = Index;
 }
 
+size_t fixed_store_alloc_run(fixed_store_t *Store, size_t Count) {
+	if (!Store->Bitmap->Header || !Count) return INVALID_INDEX;
+	size_t Index = radb_bitmap_find_run(Store->Bitmap, 0, Count);
+	if (Index + Count > Store->Header->NumEntries) fixed_store_grow(Store, Index + Count - 1);
+	radb_bitmap_set_run(Store->Bitmap, Index, Count);
+	return Index;
+}
+
+static size_t fixed_store_cursor_next(radb_cursor_t *Cursor) {
+	fixed_store_t *Store = (fixed_store_t *)Cursor->Store;
+	size_t Index = radb_bitmap_next(Store->Bitmap, Cursor->Position, Cursor->Limit);
+	if (Index >= Cursor->Limit) {
+		Cursor->Position = Cursor->Limit;
+		return INVALID_INDEX;
+	}
+	Cursor->Position = Index + 1;
+	return Index;
+}
+
+void fixed_store_cursor_open(radb_cursor_t *Cursor, fixed_store_t *Store) {
+	Cursor->Store = Store;
+	Cursor->next = fixed_store_cursor_next;
+	Cursor->Position = 0;
+	Cursor->Limit = Store->Bitmap->Header ? Store->Header->NumEntries : 0;
+}
+
+void fixed_store_stats(fixed_store_t *Store, fixed_store_stats_t *Stats) {
+	memset(Stats, 0, sizeof(fixed_store_stats_t));
+	size_t NumEntries = Stats->NumEntries = Store->Header->NumEntries;
+	Stats->NodeSize = Store->Header->NodeSize;
+	Stats->MappingSize = Store->HeaderSize;
+	Stats->Events = Store->Stats[0];
+	if (Store->Pages->Header) Stats->MappingSize += Store->Pages->HeaderSize;
+	if (Store->Bitmap->Header) {
+		Stats->MappingSize += Store->Bitmap->HeaderSize;
+		Stats->NumFree = NumEntries - Store->Bitmap->Header->Count;
+		return;
+	}
+	size_t Free = Store->Header->FreeEntry;
+	while (Free < NumEntries && Stats->NumFree < NumEntries) {
+		size_t Next = *(uint32_t *)fixed_store_node(Store, Free);
+		if (Next == INVALID_INDEX) {
+			Stats->NumFree += NumEntries - Free;
+			break;
+		}
+		++Stats->NumFree;
+		Free = Next;
+	}
+}
+
+// Keys of 1, 2, 4 or 8 bytes are compared as unsigned integers, other keys as bytes.
+static inline int fixed_store_key_less(const void *Key1, const void *Key2, size_t Size) {
+	switch (Size) {
+	case 1: return *(const uint8_t *)Key1 < *(const uint8_t *)Key2;
+	case 2: {
+		uint16_t Value1, Value2;
+		memcpy(&Value1, Key1, 2);
+		memcpy(&Value2, Key2, 2);
+		return Value1 < Value2;
+	}
+	case 4: {
+		uint32_t Value1, Value2;
+		memcpy(&Value1, Key1, 4);
+		memcpy(&Value2, Key2, 4);
+		return Value1 < Value2;
+	}
+	case 8: {
+		uint64_t Value1, Value2;
+		memcpy(&Value1, Key1, 8);
+		memcpy(&Value2, Key2, 8);
+		return Value1 < Value2;
+	}
+	default: return memcmp(Key1, Key2, Size) < 0;
+	}
+}
+
+// Keys of other sizes are projected to their first 8 bytes in big endian order, so that the projection
+// never decreases in key order.
+static inline uint64_t fixed_store_key_project(const void *Key, size_t Size) {
+	switch (Size) {
+	case 1: return *(const uint8_t *)Key;
+	case 2: {
+		uint16_t Value;
+		memcpy(&Value, Key, 2);
+		return Value;
+	}
+	case 4: {
+		uint32_t Value;
+		memcpy(&Value, Key, 4);
+		return Value;
+	}
+	case 8: {
+		uint64_t Value;
+		memcpy(&Value, Key, 8);
+		return Value;
+	}
+	default: {
+		uint64_t Value = 0;
+		for (size_t I = 0; I < 8; ++I) Value = (Value << 8) | (I < Size ? ((const uint8_t *)Key)[I] : 0);
+		return Value;
+	}
+	}
+}
+
+// The segments are fitted in one pass by narrowing the range of slopes which keep every point of the
+// segment within Error, to the first entry with each projected key.
+void fixed_store_search_build(fixed_store_t *Store, size_t Count, size_t Offset, size_t Size) {
+	size_t NodeSize = Store->Header->NodeSize;
+	size_t Error = 64 / NodeSize;
+	if (Error < 4) Error = 4;
+	size_t Space = 64, NumSegments = 0;
+	fixed_search_segment_t *Segments = malloc(Space * sizeof(fixed_search_segment_t));
+	uint64_t Previous = 0;
+	double Low = 0, High = 0;
+	for (size_t I = 0; I < Count; ++I) {
+		uint64_t Key = fixed_store_key_project((char *)fixed_store_node(Store, I) + Offset, Size);
+		if (I && Key == Previous) continue;
+		Previous = Key;
+		if (NumSegments) {
+			fixed_search_segment_t *Segment = Segments + NumSegments - 1;
+			double Distance = (double)(Key - Segment->Key);
+			double Position = (double)(I - Segment->Position);
+			double SegmentLow = (Position - Error) / Distance, SegmentHigh = (Position + Error) / Distance;
+			if (SegmentLow <= High && SegmentHigh >= Low) {
+				if (SegmentLow > Low) Low = SegmentLow;
+				if (SegmentHigh < High) High = SegmentHigh;
+				Segment->Slope = (Low + High) / 2;
+				continue;
+			}
+		}
+		if (NumSegments == Space) Segments = realloc(Segments, (Space *= 2) * sizeof(fixed_search_segment_t));
+		Segments[NumSegments++] = (fixed_search_segment_t){Key, I, 0};
+		Low = 0;
+		High = 1e300;
+	}
+	uint64_t MinKey = NumSegments ? Segments[0].Key : 0;
+	uint64_t Range = NumSegments ? Previous - MinKey : 0;
+	size_t RadixBits = 1;
+	while (RadixBits < 20 && ((size_t)1 << RadixBits) < NumSegments * 2) ++RadixBits;
+	size_t RangeBits = Range ? 64 - __builtin_clzll(Range) : 1;
+	size_t RadixShift = RangeBits > RadixBits ? RangeBits - RadixBits : 0;
+
+	char FileName2[strlen(Store->Prefix) + 20];
+	sprintf(FileName2, "%s.search.temp", Store->Prefix);
+	int SearchFd = open(FileName2, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	size_t SearchSize = fixed_store_search_size(RadixBits, NumSegments);
+	ftruncate(SearchFd, SearchSize);
+	fixed_search_header_t *Search = mmap(NULL, SearchSize, PROT_READ | PROT_WRITE, MAP_SHARED, SearchFd, 0);
+	Search->Signature = FIXED_SEARCH_SIGNATURE;
+	Search->Version = FIXED_SEARCH_VERSION;
+	Search->Offset = Offset;
+	Search->Size = Size;
+	Search->Error = Error;
+	Search->RadixBits = RadixBits;
+	Search->RadixShift = RadixShift;
+	Search->Count = Count;
+	Search->NumSegments = NumSegments;
+	Search->MinKey = MinKey;
+	memcpy(fixed_store_search_segments(Search), Segments, NumSegments * sizeof(fixed_search_segment_t));
+	size_t Segment = 0;
+	for (size_t Prefix = 0; Prefix <= (size_t)1 << RadixBits; ++Prefix) {
+		while (Segment < NumSegments && ((Segments[Segment].Key - MinKey) >> RadixShift) < Prefix) ++Segment;
+		Search->Radix[Prefix] = Segment;
+	}
+	free(Segments);
+	radb_sync(Search, SearchSize);
+
+	if (Store->Search) {
+		munmap(Store->Search, Store->SearchSize);
+		close(Store->SearchFd);
+	}
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.search", Store->Prefix);
+	rename(FileName2, FileName);
+
+	Store->Search = Search;
+	Store->SearchSize = SearchSize;
+	Store->SearchFd = SearchFd;
+}
+
+static inline int fixed_store_entry_less(fixed_store_t *Store, size_t Index, const void *Key, size_t Offset, size_t Size) {
+	return fixed_store_key_less((char *)fixed_store_node(Store, Index) + Offset, Key, Size);
+}
+
+// The accelerator is only used if it was built for the same Count entries.
+size_t fixed_store_lower_bound(fixed_store_t *Store, size_t Count, const void *Key, size_t Offset, size_t Size) {
+	fixed_search_header_t *Search = Store->Search;
+	if (Count > Store->Header->NumEntries) Count = Store->Header->NumEntries;
+	size_t Low = 0, High = Count;
+	if (Search && Search->Offset == Offset && Search->Size == Size && Search->Count == Count) {
+		uint64_t Projected = fixed_store_key_project(Key, Size);
+		if (!Search->NumSegments || Projected < Search->MinKey) return 0;
+		// The last segment starting at or before the key is between the segments of the key's prefix and the one before.
+		uint64_t Prefix = (Projected - Search->MinKey) >> Search->RadixShift;
+		if (Prefix >= (uint64_t)1 << Search->RadixBits) Prefix = ((uint64_t)1 << Search->RadixBits) - 1;
+		fixed_search_segment_t *Segments = fixed_store_search_segments(Search);
+		size_t First = Search->Radix[Prefix], Last = Search->Radix[Prefix + 1];
+		if (First) --First;
+		while (First + 1 < Last) {
+			size_t Middle = (First + Last) / 2;
+			if (Segments[Middle].Key <= Projected) {
+				First = Middle;
+			} else {
+				Last = Middle;
+			}
+		}
+		fixed_search_segment_t *Segment = Segments + First;
+		size_t End = First + 1 < Search->NumSegments ? Segment[1].Position : Count;
+		double Predicted = Segment->Position + Segment->Slope * (double)(Projected - Segment->Key);
+		size_t Position = Predicted < End ? (size_t)Predicted : End;
+		// The prediction is within Error of the first entry with the projected key, gallop outwards if the
+		// key is not there because keys differ after their projection.
+		size_t Error = Search->Error, Step = Error + 1;
+		Low = Position > Error ? Position - Error : 0;
+		High = Position + Error + 1 < Count ? Position + Error + 1 : Count;
+		while (Low > 0 && !fixed_store_entry_less(Store, Low - 1, Key, Offset, Size)) {
+			High = Low - 1;
+			Low = Low > Step ? Low - Step : 0;
+			Step *= 2;
+		}
+		while (High < Count && fixed_store_entry_less(Store, High, Key, Offset, Size)) {
+			Low = High + 1;
+			High = High + Step < Count ? High + Step : Count;
+			Step *= 2;
+		}
+	}
+	while (Low < High) {
+		size_t Middle = (Low + High) / 2;
+		if (fixed_store_entry_less(Store, Middle, Key, Offset, Size)) {
+			Low = Middle + 1;
+		} else {
+			High = Middle;
+		}
+	}
+	return Low;
+}
+
 #define FIXED_INDEX_SIGNATURE 0x49464152
 #define FIXED_INDEX_VERSION MAKE_VERSION(1, 0)
 
-typedef struct {
-	uint32_t Hash;
-	uint32_t Link;
-} hash_t;
+typedef radb_hash_t hash_t;
 
 typedef struct {
 	uint32_t Signature, Version;
@@ -333,6 +761,7 @@ struct fixed_index_t {
 	size_t HeaderSize;
 	int HeaderFd;
 	int SyncCounter;
+	radb_stats_t Stats[1];
 };
 
 fixed_index_t *fixed_index_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
@@ -353,6 +782,7 @@ fixed_index_t *fixed_index_create(const char *Prefix, size_t KeySize, size_t Chu
 	if (!ChunkSize) ChunkSize = 512;
 	char FileName[strlen(Prefix) + 10];
 	Store->SyncCounter = 32;
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	sprintf(FileName, "%s.index", Prefix);
 	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
 	Store->HeaderSize = sizeof(fixed_index_header_t) + 64 * sizeof(hash_t);
@@ -391,6 +821,7 @@ fixed_index_open_t fixed_index_open2(const char *Prefix RADB_MEM_PARAMS) {
 	Store->alloc_atomic = alloc_atomic;
 	Store->free = free;
 #endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR, 0777);
 	Store->HeaderSize = Stat->st_size;
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
@@ -410,7 +841,7 @@ fixed_index_t *fixed_index_open(const char *Prefix RADB_MEM_PARAMS) {
 
 void fixed_index_close(fixed_index_t *Store) {
 	fixed_store_close(Store->Keys);
-	msync(Store->Header, Store->HeaderSize, MS_SYNC);
+	radb_sync(Store->Header, Store->HeaderSize);
 	munmap(Store->Header, Store->HeaderSize);
 	close(Store->HeaderFd);
 #if defined(RADB_MEM_MALLOC)
@@ -424,10 +855,7 @@ void fixed_index_close(fixed_index_t *Store) {
 }
 
 static uint32_t hash(const char *Key, int Length) {
-	uint32_t Hash = 5381;
-	unsigned char *P = (unsigned char *)(Key);
-	for (int I = Length; --I >= 0;) Hash = ((Hash << 5) + Hash) + P++[0];
-	return Hash;
+	return radb_hash(5381, Key, Length);
 }
 
 size_t fixed_index_num_entries(fixed_index_t *Store) {
@@ -442,46 +870,14 @@ const void *fixed_index_get(fixed_index_t *Store, size_t Index) {
 	return fixed_store_get(Store->Keys, Index);
 }
 
-static void sort_hashes(fixed_index_t *Store, hash_t *First, hash_t *Last) {
-	hash_t *A = First;
-	hash_t *B = Last;
-	hash_t T = *A;
-	hash_t P = *B;
-	while (P.Link >= DELETED_INDEX) {
-		--B;
-		--Last;
-		if (A == B) return;
-		P = *B;
-	}
-	while (A != B) {
-		int Cmp;
-		if (T.Link < DELETED_INDEX) {
-			if (T.Hash < P.Hash) {
-				Cmp = -1;
-			} else if (T.Hash > P.Hash) {
-				Cmp = 1;
-			} else {
-				const void *TKey = fixed_store_get_unchecked(Store->Keys, T.Link);
-				const void *PKey = fixed_store_get_unchecked(Store->Keys, P.Link);
-				Cmp = memcmp(TKey, PKey, Store->Header->KeySize);
-			}
-		} else {
-			Cmp = -1;
-		}
-		if (Cmp > 0) {
-			*A = T;
-			T = *++A;
-		} else {
-			*B = T;
-			T = *--B;
-		}
-	}
-	*A = P;
-	if (First < A - 1) sort_hashes(Store, First, A - 1);
-	if (A + 1 < Last) sort_hashes(Store, A + 1, Last);
+static int fixed_index_compare_links(fixed_index_t *Store, uint32_t Link1, uint32_t Link2) {
+	const void *Key1 = fixed_store_get_unchecked(Store->Keys, Link1);
+	const void *Key2 = fixed_store_get_unchecked(Store->Keys, Link2);
+	return radb_compare(Key1, Key2, Store->Header->KeySize);
 }
 
 index_result_t fixed_index_insert2(fixed_index_t *Store, const char *Key) {
+	RADB_LATENCY(RADB_OP_FIXED_INDEX_INSERT);
 	uint32_t Hash = hash(Key, Store->Header->KeySize);
 	unsigned int Mask = Store->Header->Size - 1;
 	for (;;) {
@@ -493,7 +889,7 @@ index_result_t fixed_index_insert2(fixed_index_t *Store, const char *Key) {
 			if (Hashes[Index].Hash < Hash) break;
 			if (Hashes[Index].Hash == Hash) {
 				const void *HKey = fixed_store_get_unchecked(Store->Keys, Hashes[Index].Link);
-				int Cmp = memcmp(Key, HKey, Store->Header->KeySize);
+				int Cmp = radb_compare(Key, HKey, Store->Header->KeySize);
 				if (Cmp > 0) break;
 				if (Cmp == 0) return (index_result_t){Hashes[Index].Link, 0};
 			}
@@ -525,7 +921,7 @@ index_result_t fixed_index_insert2(fixed_index_t *Store, const char *Key) {
 					} else if (Hashes[Index].Hash == Old.Hash) {
 						const void *HKey = fixed_store_get_unchecked(Store->Keys, Hashes[Index].Link);
 						const void *OKey = fixed_store_get_unchecked(Store->Keys, Old.Link);
-						int Cmp = memcmp(HKey, OKey, Store->Header->KeySize);
+						int Cmp = radb_compare(HKey, OKey, Store->Header->KeySize);
 						if (Cmp < 0) {
 							hash_t New = Hashes[Index];
 							Hashes[Index] = Old;
@@ -541,13 +937,16 @@ index_result_t fixed_index_insert2(fixed_index_t *Store, const char *Key) {
 		size_t HashSize = Store->Header->Size * 2;
 		if (Space + Store->Header->Deleted > Store->Header->Size >> 3) HashSize = Store->Header->Size;
 		Mask = HashSize - 1;
+		RADB_PROBE3(fixed_index_rebuild_start, Store->Prefix, Store->Header->Size, HashSize);
+		RADB_LATENCY(RADB_OP_FIXED_INDEX_REBUILD);
+		uint64_t Start = radb_time();
 
 		char FileName2[strlen(Store->Prefix) + 10];
 		sprintf(FileName2, "%s.temp", Store->Prefix);
 
 		size_t HeaderSize = sizeof(fixed_index_header_t) + HashSize * sizeof(hash_t);
 		int HeaderFd = open(FileName2, O_RDWR | O_CREAT | O_TRUNC, 0777);
-		ftruncate(HeaderFd, HeaderSize);
+		radb_truncate(Store->Stats, HeaderFd, HeaderSize);
 		fixed_index_header_t *Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, HeaderFd, 0);
 		Header->Signature = FIXED_INDEX_SIGNATURE;
 		Header->Version = FIXED_INDEX_VERSION;
@@ -557,8 +956,9 @@ index_result_t fixed_index_insert2(fixed_index_t *Store, const char *Key) {
 		Header->KeySize = Store->Header->KeySize;
 		for (int I = 0; I < HashSize; ++I) Header->Hashes[I].Link = INVALID_INDEX;
 
-		sort_hashes(Store, Hashes, Hashes + Store->Header->Size - 1);
-		for (hash_t *Old = Hashes; Old->Link < DELETED_INDEX; ++Old) {
+		size_t Count;
+		hash_t *Sorted = radb_sort_hashes(Hashes, Store->Header->Size, DELETED_INDEX, &Count, Store, (radb_hash_compare_t)fixed_index_compare_links);
+		for (hash_t *Old = Sorted, *Limit = Sorted + Count; Old < Limit; ++Old) {
 			unsigned long NewHash = Old->Hash;
 			unsigned int NewIncr = ((NewHash >> 8) | 1) & Mask;
 			unsigned int NewIndex = NewHash & Mask;
@@ -568,6 +968,7 @@ index_result_t fixed_index_insert2(fixed_index_t *Store, const char *Key) {
 			}
 			Header->Hashes[NewIndex] = Old[0];
 		}
+		free(Sorted);
 
 		munmap(Store->Header, Store->HeaderSize);
 		close(Store->HeaderFd);
@@ -580,6 +981,9 @@ index_result_t fixed_index_insert2(fixed_index_t *Store, const char *Key) {
 		Store->Header = Header;
 		Store->HeaderFd = HeaderFd;
 
+		Store->Stats->Rebuilds.Time += radb_time() - Start;
+		++Store->Stats->Rebuilds.Count;
+		RADB_PROBE3(fixed_index_rebuild_done, Store->Prefix, Store->Header->Size, Store->Header->Space);
 		//msync(Store->Header, Store->HeaderSize, MS_ASYNC);
 	}
 
@@ -591,6 +995,7 @@ size_t fixed_index_insert(fixed_index_t *Store, const char *Key) {
 }
 
 size_t fixed_index_search(fixed_index_t *Store, const char *Key) {
+	RADB_LATENCY(RADB_OP_FIXED_INDEX_SEARCH);
 	uint32_t Hash = hash(Key, Store->Header->KeySize);
 	unsigned int Mask = Store->Header->Size - 1;
 	unsigned int Incr = ((Hash >> 8) | 1) & Mask;
@@ -601,7 +1006,7 @@ size_t fixed_index_search(fixed_index_t *Store, const char *Key) {
 		if (Hashes[Index].Hash < Hash) break;
 		if (Hashes[Index].Hash == Hash && Hashes[Index].Link != DELETED_INDEX) {
 			const void *HKey = fixed_store_get_unchecked(Store->Keys, Hashes[Index].Link);
-			int Cmp = memcmp(Key, HKey, Store->Header->KeySize);
+			int Cmp = radb_compare(Key, HKey, Store->Header->KeySize);
 			if (Cmp > 0) break;
 			if (Cmp == 0) return Hashes[Index].Link;
 		}
@@ -612,6 +1017,7 @@ size_t fixed_index_search(fixed_index_t *Store, const char *Key) {
 }
 
 size_t fixed_index_delete(fixed_index_t *Store, const char *Key) {
+	RADB_LATENCY(RADB_OP_FIXED_INDEX_DELETE);
 	uint32_t Hash = hash(Key, Store->Header->KeySize);
 	unsigned int Mask = Store->Header->Size - 1;
 	unsigned int Incr = ((Hash >> 8) | 1) & Mask;
@@ -622,7 +1028,7 @@ size_t fixed_index_delete(fixed_index_t *Store, const char *Key) {
 		if (Hashes[Index].Hash < Hash) break;
 		if (Hashes[Index].Hash == Hash && Hashes[Index].Link != DELETED_INDEX) {
 			const void *HKey = fixed_store_get_unchecked(Store->Keys, Hashes[Index].Link);
-			int Cmp = memcmp(Key, HKey, Store->Header->KeySize);
+			int Cmp = radb_compare(Key, HKey, Store->Header->KeySize);
 			if (Cmp > 0) break;
 			if (Cmp == 0) {
 				uint32_t Link = Hashes[Index].Link;
@@ -646,8 +1052,57 @@ int fixed_index_foreach(fixed_index_t *Store, void *Data, fixed_index_foreach_fn
 	hash_t *Hash = Store->Header->Hashes;
 	hash_t *Limit = Hash + Store->Header->Size;
 	while (Hash < Limit) {
-		if (Hash->Link != INVALID_INDEX) if (Callback(Hash->Link, Data)) return 1;
+		if (Hash->Link < DELETED_INDEX) if (Callback(Hash->Link, Data)) return 1;
 		++Hash;
 	}
 	return 0;
 }
+
+static size_t fixed_index_cursor_next(radb_cursor_t *Cursor) {
+	fixed_index_t *Store = (fixed_index_t *)Cursor->Store;
+	hash_t *Hashes = Store->Header->Hashes;
+	size_t Limit = Cursor->Limit < Store->Header->Size ? Cursor->Limit : Store->Header->Size;
+	while (Cursor->Position < Limit) {
+		uint32_t Link = Hashes[Cursor->Position++].Link;
+		if (Link < DELETED_INDEX) return Link;
+	}
+	return INVALID_INDEX;
+}
+
+void fixed_index_cursor_open(radb_cursor_t *Cursor, fixed_index_t *Store) {
+	Cursor->Store = Store;
+	Cursor->next = fixed_index_cursor_next;
+	Cursor->Position = 0;
+	Cursor->Limit = Store->Header->Size;
+}
+
+void fixed_index_stats(fixed_index_t *Store, fixed_index_stats_t *Stats) {
+	memset(Stats, 0, sizeof(fixed_index_stats_t));
+	size_t Size = Stats->Size = Store->Header->Size;
+	Stats->NumEntries = fixed_index_num_entries(Store);
+	Stats->NumDeleted = Store->Header->Deleted;
+	Stats->TombstoneRatio = (double)Stats->NumDeleted / Size;
+	Stats->MappingSize = Store->HeaderSize;
+	Stats->Events = Store->Stats[0];
+	unsigned int Mask = Size - 1;
+	hash_t *Hashes = Store->Header->Hashes;
+	size_t Total = 0, Count = 0;
+	for (unsigned int I = 0; I < Size; ++I) {
+		if (Hashes[I].Link >= DELETED_INDEX) continue;
+		uint32_t Hash = Hashes[I].Hash;
+		unsigned int Incr = ((Hash >> 8) | 1) & Mask;
+		unsigned int Index = Hash & Mask;
+		size_t Probe = 1;
+		while (Index != I && Probe < Size) {
+			Index += Incr;
+			Index &= Mask;
+			++Probe;
+		}
+		radb_stats_histogram(Stats->ProbeLengths, Probe);
+		if (Stats->MaxProbe < Probe) Stats->MaxProbe = Probe;
+		Total += Probe;
+		++Count;
+	}
+	if (Count) Stats->AverageProbe = (double)Total / Count;
+	fixed_store_stats(Store->Keys, Stats->Keys);
+}
@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include "common.h"
+#include "fixed_store.h"
 
 #define INVALID_INDEX 0xFFFFFFFF
 #define DELETED_INDEX 0xFFFFFFFE
@@ -35,5 +36,18 @@ uint32_t fixed_index_key_size(fixed_index_t *Store);
 
 typedef int (*fixed_index_foreach_fn)(size_t Index, void *Data);
 int fixed_index_foreach(fixed_index_t *Store, void *Data, fixed_index_foreach_fn Callback);
+void fixed_index_cursor_open(radb_cursor_t *Cursor, fixed_index_t *Store);
+
+typedef struct {
+	size_t Size, NumEntries, NumDeleted;
+	double TombstoneRatio, AverageProbe;
+	size_t MaxProbe;
+	size_t ProbeLengths[RADB_STATS_HISTOGRAM_SIZE];
+	size_t MappingSize;
+	radb_stats_t Events;
+	fixed_store_stats_t Keys[1];
+} fixed_index_stats_t;
+
+void fixed_index_stats(fixed_index_t *Store, fixed_index_stats_t *Stats);
 
 #endif
@@ -1,7 +1,12 @@
 #include "fixed_index2.h"
 #include "fixed_index.h"
 #include "fixed_store.h"
+#include "linear_index_inline.h"
+#include "kernel.h"
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/stat.h>
 
 typedef struct {
 	const void *Value;
@@ -9,7 +14,7 @@ typedef struct {
 } fixed_key_t;
 
 static int linear_compare_fixed(fixed_store_t *Store, fixed_key_t *Full, uint32_t Index) {
-	return memcmp(Full->Value, fixed_store_get(Store, Index), Full->Size);
+	return radb_compare(Full->Value, fixed_store_get(Store, Index), Full->Size);
 }
 
 static int linear_compare_nop(fixed_store_t *Store, void *Full, uint32_t Index) {
@@ -28,9 +33,95 @@ static size_t linear_insert_fixed(fixed_store_t *Store, fixed_key_t *Full) {
 	return Alloc.Index;
 }
 
-fixed_index2_t *fixed_index2_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
+static inline uint32_t fixed_hash(const void *Value, size_t Length) {
+	return radb_hash(5381, Value, Length);
+}
+
+typedef struct {
+	size_t (*search)(fixed_index2_t *Store, const void *Value);
+	index_result_t (*insert2)(fixed_index2_t *Store, const void *Value);
+} fixed_methods_t;
+
+static size_t fixed_search_generic(fixed_index2_t *Store, const void *Value) {
+	size_t Length = linear_index_get_extra(Store);
+	uint32_t Hash = fixed_hash(Value, Length);
+	fixed_key_t Full = {Value, Length};
+	if (Length == sizeof(linear_key_t)) {
+		return linear_index_search(Store, Hash, Value, Value);
+	} else if (Length > sizeof(linear_key_t)) {
+		return linear_index_search(Store, Hash, Value, &Full);
+	} else {
+		linear_key_t Key = {0,};
+		memcpy(Key, Value, Length);
+		return linear_index_search(Store, Hash, Key, &Full);
+	}
+}
+
+static index_result_t fixed_insert2_generic(fixed_index2_t *Store, const void *Value) {
+	size_t Length = linear_index_get_extra(Store);
+	uint32_t Hash = fixed_hash(Value, Length);
+	fixed_key_t Full = {Value, Length};
+	if (Length == sizeof(linear_key_t)) {
+		return linear_index_insert2(Store, Hash, Value, Value);
+	} else if (Length > sizeof(linear_key_t)) {
+		return linear_index_insert2(Store, Hash, Value, &Full);
+	} else {
+		linear_key_t Key = {0,};
+		memcpy(Key, Value, Length);
+		return linear_index_insert2(Store, Hash, Key, &Full);
+	}
+}
+
+static const fixed_methods_t FixedMethodsGeneric = {fixed_search_generic, fixed_insert2_generic};
+
+// Specialized methods for common key sizes, with the hash, key copy and comparison inlined.
+#define FIXED_METHODS(SIZE) \
+\
+static int fixed_compare_ ## SIZE(void *Keys, const void *Value, uint32_t Index) { \
+	if (SIZE <= sizeof(linear_key_t)) return 0; \
+	return radb_compare(Value, fixed_store_get(Keys, Index), SIZE); \
+} \
+\
+static size_t fixed_insert_ ## SIZE(void *Keys, const void *Value) { \
+	fixed_store_alloc_t Alloc = fixed_store_alloc2(Keys); \
+	memcpy(Alloc.Value, Value, SIZE); \
+	return Alloc.Index; \
+} \
+\
+static size_t fixed_search_ ## SIZE(fixed_index2_t *Store, const void *Value) { \
+	linear_key_t Key = {0,}; \
+	memcpy(Key, Value, SIZE < sizeof(linear_key_t) ? SIZE : sizeof(linear_key_t)); \
+	return linear_index_search_inline(Store, fixed_hash(Value, SIZE), Key, Value, fixed_compare_ ## SIZE); \
+} \
+\
+static index_result_t fixed_insert2_ ## SIZE(fixed_index2_t *Store, const void *Value) { \
+	linear_key_t Key = {0,}; \
+	memcpy(Key, Value, SIZE < sizeof(linear_key_t) ? SIZE : sizeof(linear_key_t)); \
+	return linear_index_insert_inline(Store, fixed_hash(Value, SIZE), Key, Value, fixed_compare_ ## SIZE, fixed_insert_ ## SIZE); \
+} \
+\
+static const fixed_methods_t FixedMethods ## SIZE = {fixed_search_ ## SIZE, fixed_insert2_ ## SIZE};
+
+FIXED_METHODS(4)
+FIXED_METHODS(8)
+FIXED_METHODS(16)
+FIXED_METHODS(32)
+FIXED_METHODS(64)
+
+static void fixed_set_methods(fixed_index2_t *Store, size_t KeySize) {
+	switch (KeySize) {
+	case 4: Store->Methods = &FixedMethods4; break;
+	case 8: Store->Methods = &FixedMethods8; break;
+	case 16: Store->Methods = &FixedMethods16; break;
+	case 32: Store->Methods = &FixedMethods32; break;
+	case 64: Store->Methods = &FixedMethods64; break;
+	default: Store->Methods = &FixedMethodsGeneric; break;
+	}
+}
+
+fixed_index2_t *fixed_index2_create_engine(const char *Prefix, size_t KeySize, size_t ChunkSize, linear_index_engine_t Engine RADB_MEM_PARAMS) {
 	fixed_store_t *Keys = fixed_store_create(Prefix, KeySize, ChunkSize RADB_MEM_ARGS);
-	linear_index_t *Index = linear_index_create(Prefix, Keys RADB_MEM_ARGS);
+	linear_index_t *Index = linear_index_create_engine(Prefix, Keys, Engine RADB_MEM_ARGS);
 	if (KeySize == sizeof(linear_key_t)) {
 		linear_index_set_compare(Index, (linear_compare_t)linear_compare_nop);
 		linear_index_set_insert(Index, (linear_insert_t)linear_insert_exact);
@@ -42,11 +133,16 @@ fixed_index2_t *fixed_index2_create(const char *Prefix, size_t KeySize, size_t C
 		linear_index_set_insert(Index, (linear_insert_t)linear_insert_fixed);
 	}
 	linear_index_set_extra(Index, KeySize);
+	fixed_set_methods(Index, KeySize);
 	return Index;
 }
 
+fixed_index2_t *fixed_index2_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return fixed_index2_create_engine(Prefix, KeySize, ChunkSize, LINEAR_INDEX_LINEAR RADB_MEM_ARGS);
+}
+
 static int migrate_compare_fixed(fixed_store_t *Store, size_t *Original, uint32_t Index) {
-	return 1;
+	return *Original != Index;
 }
 
 static size_t migrate_insert_fixed(fixed_store_t *Store, size_t *Original) {
@@ -54,29 +150,80 @@ static size_t migrate_insert_fixed(fixed_store_t *Store, size_t *Original) {
 }
 
 typedef struct {
+	radb_migration_t Base[1];
 	linear_index_t *Index;
 	fixed_store_t *Store;
 	size_t Size;
+	linear_key_t Keys[RADB_MIGRATION_BATCH_SIZE];
 } migration_t;
 
-static uint32_t fixed_hash(const void *Value, size_t Length) {
-	const unsigned char *Bytes = (const unsigned char *)Value;
-	uint32_t Hash = 5381;
-	for (int I = 0; I < Length; ++I) Hash = ((Hash << 5) + Hash) + Bytes[I];
-	return Hash;
+static void migrate_hash(migration_t *Migration, size_t Start, size_t End) {
+	size_t Size = Migration->Size;
+	for (size_t I = Start; I < End; ++I) {
+		unsigned char *Value = fixed_store_get(Migration->Store, Migration->Base->Indices[I]);
+		Migration->Base->Hashes[I] = fixed_hash(Value, Size);
+		if (Size >= sizeof(linear_key_t)) {
+			memcpy(Migration->Keys[I], Value, sizeof(linear_key_t));
+		} else {
+			memset(Migration->Keys[I], 0, sizeof(linear_key_t));
+			memcpy(Migration->Keys[I], Value, Size);
+		}
+	}
 }
 
-static int migrate(size_t Index, migration_t *Migration) {
-	unsigned char *Value = fixed_store_get(Migration->Store, Index);
-	uint32_t Hash = fixed_hash(Value, Migration->Size);
-	if (Migration->Size >= sizeof(linear_key_t)) {
-		linear_index_insert(Migration->Index, Hash, Value, &Index);
-	} else {
-		linear_key_t Key = {0,};
-		memcpy(Key, Value, Migration->Size);
-		linear_index_insert(Migration->Index, Hash, Key, &Index);
+static void migrate_insert(migration_t *Migration, size_t Count) {
+	for (size_t I = 0; I < Count; ++I) {
+		size_t Index = Migration->Base->Indices[I];
+		linear_index_insert(Migration->Index, Migration->Base->Hashes[I], Migration->Keys[I], &Index);
 	}
-	return 0;
+}
+
+static void migrate_keys(linear_index_t *NewIndex, fixed_store_t *Keys, fixed_index_t *OldIndex, const char *Prefix) {
+	migration_t *Migration = malloc(sizeof(migration_t));
+	Migration->Base->hash = (radb_migration_hash_t)migrate_hash;
+	Migration->Base->insert = (radb_migration_insert_t)migrate_insert;
+	Migration->Index = NewIndex;
+	Migration->Store = Keys;
+	Migration->Size = fixed_index_key_size(OldIndex);
+	radb_migration_init(Migration->Base, Prefix, linear_index_count(NewIndex), fixed_index_count(OldIndex));
+	fixed_index_foreach(OldIndex, Migration->Base, (void *)radb_migration_add);
+	radb_migration_flush(Migration->Base);
+	free(Migration);
+}
+
+static radb_error_t migrate_index(const char *Prefix, fixed_store_t *Keys RADB_MEM_PARAMS) {
+	int Lock;
+	radb_error_t Error = radb_migrate_start(Prefix, &Lock);
+	if (Error != RADB_SUCCESS || Lock < 0) return Error;
+	fixed_index_open_t OldOpen = fixed_index_open2(Prefix RADB_MEM_ARGS);
+	if (OldOpen.Error != RADB_SUCCESS) return radb_migrate_finish(Prefix, Lock, OldOpen.Error);
+	RADB_PROBE1(migrate_start, Prefix);
+	RADB_LATENCY(RADB_OP_MIGRATE);
+	// Keys are inserted in the same order each time, an interrupted migration resumes after the last inserted key.
+	char TempPrefix[strlen(Prefix) + 10];
+	sprintf(TempPrefix, "%s.migrate", Prefix);
+	linear_index_t *NewIndex = linear_index_open(TempPrefix, Keys RADB_MEM_ARGS);
+	if (!NewIndex) NewIndex = linear_index_create(TempPrefix, Keys RADB_MEM_ARGS);
+	linear_index_set_compare(NewIndex, (linear_compare_t)migrate_compare_fixed);
+	linear_index_set_insert(NewIndex, (linear_insert_t)migrate_insert_fixed);
+	linear_index_set_extra(NewIndex, fixed_index_key_size(OldOpen.Index));
+	migrate_keys(NewIndex, Keys, OldOpen.Index, Prefix);
+	fixed_index_close(OldOpen.Index);
+	RADB_PROBE2(migrate_done, Prefix, linear_index_count(NewIndex));
+	linear_index_close(NewIndex);
+	return radb_migrate_finish(Prefix, Lock, RADB_SUCCESS);
+}
+
+radb_error_t fixed_index2_migrate(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.index2", Prefix);
+	if (!stat(FileName, Stat)) return RADB_SUCCESS;
+	fixed_store_open_t KeysOpen = fixed_store_open2(Prefix RADB_MEM_ARGS);
+	if (!KeysOpen.Store) return KeysOpen.Error + 3;
+	radb_error_t Error = migrate_index(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+	fixed_store_close(KeysOpen.Store);
+	return Error;
 }
 
 linear_index_open_t fixed_index2_open2(const char *Prefix RADB_MEM_PARAMS) {
@@ -84,23 +231,17 @@ linear_index_open_t fixed_index2_open2(const char *Prefix RADB_MEM_PARAMS) {
 	if (!KeysOpen.Store) return (linear_index_open_t){NULL, KeysOpen.Error + 3};
 	linear_index_open_t IndexOpen = linear_index_open2(Prefix, KeysOpen.Store RADB_MEM_ARGS);
 	if (IndexOpen.Error == RADB_FILE_NOT_FOUND) {
-		fixed_index_open_t OldOpen = fixed_index_open2(Prefix RADB_MEM_ARGS);
-		if (OldOpen.Error != RADB_SUCCESS) {
+		IndexOpen.Error = migrate_index(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+		if (IndexOpen.Error != RADB_SUCCESS) {
 			fixed_store_close(KeysOpen.Store);
 			return IndexOpen;
 		}
-		linear_index_t *NewIndex = linear_index_create(Prefix, KeysOpen.Store RADB_MEM_ARGS);
-		linear_index_set_compare(NewIndex, (linear_compare_t)migrate_compare_fixed);
-		linear_index_set_insert(NewIndex, (linear_insert_t)migrate_insert_fixed);
-		size_t Size = fixed_index_key_size(OldOpen.Index);
-		linear_index_set_extra(NewIndex, Size);
-		migration_t Migration = {NewIndex, KeysOpen.Store, Size};
-		fixed_index_foreach(OldOpen.Index, &Migration, (void *)migrate);
-		fixed_index_close(OldOpen.Index);
-		IndexOpen.Index = NewIndex;
-		IndexOpen.Error = RADB_SUCCESS;
+		IndexOpen = linear_index_open2(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+	}
+	if (IndexOpen.Error != RADB_SUCCESS) {
+		fixed_store_close(KeysOpen.Store);
+		return IndexOpen;
 	}
-	if (IndexOpen.Error != RADB_SUCCESS) fixed_store_close(KeysOpen.Store);
 	size_t KeySize = linear_index_get_extra(IndexOpen.Index);
 	if (KeySize == sizeof(linear_key_t)) {
 		linear_index_set_compare(IndexOpen.Index, (linear_compare_t)linear_compare_nop);
@@ -112,6 +253,7 @@ linear_index_open_t fixed_index2_open2(const char *Prefix RADB_MEM_PARAMS) {
 		linear_index_set_compare(IndexOpen.Index, (linear_compare_t)linear_compare_nop);
 		linear_index_set_insert(IndexOpen.Index, (linear_insert_t)linear_insert_fixed);
 	}
+	fixed_set_methods(IndexOpen.Index, KeySize);
 	return IndexOpen;
 }
 
@@ -129,48 +271,15 @@ void fixed_index2_close(fixed_index2_t *Store) {
 }
 
 size_t fixed_index2_insert(fixed_index2_t *Store, const void *Value) {
-	size_t Length = linear_index_get_extra(Store);
-	uint32_t Hash = fixed_hash(Value, Length);
-	fixed_key_t Full = {Value, Length};
-	if (Length == sizeof(linear_key_t)) {
-		return linear_index_insert(Store, Hash, Value, Value);
-	} else if (Length > sizeof(linear_key_t)) {
-		return linear_index_insert(Store, Hash, Value, &Full);
-	} else {
-		linear_key_t Key = {0,};
-		memcpy(Key, Value, Length);
-		return linear_index_insert(Store, Hash, Key, &Full);
-	}
+	return ((const fixed_methods_t *)Store->Methods)->insert2(Store, Value).Index;
 }
 
 size_t fixed_index2_search(fixed_index2_t *Store, const void *Value) {
-	size_t Length = linear_index_get_extra(Store);
-	uint32_t Hash = fixed_hash(Value, Length);
-	fixed_key_t Full = {Value, Length};
-	if (Length == sizeof(linear_key_t)) {
-		return linear_index_search(Store, Hash, Value, Value);
-	} else if (Length > sizeof(linear_key_t)) {
-		return linear_index_search(Store, Hash, Value, &Full);
-	} else {
-		linear_key_t Key = {0,};
-		memcpy(Key, Value, Length);
-		return linear_index_search(Store, Hash, Key, &Full);
-	}
+	return ((const fixed_methods_t *)Store->Methods)->search(Store, Value);
 }
 
 index_result_t fixed_index2_insert2(fixed_index2_t *Store, const void *Value) {
-	size_t Length = linear_index_get_extra(Store);
-	uint32_t Hash = fixed_hash(Value, Length);
-	fixed_key_t Full = {Value, Length};
-	if (Length == sizeof(linear_key_t)) {
-		return linear_index_insert2(Store, Hash, Value, Value);
-	} else if (Length > sizeof(linear_key_t)) {
-		return linear_index_insert2(Store, Hash, Value, &Full);
-	} else {
-		linear_key_t Key = {0,};
-		memcpy(Key, Value, Length);
-		return linear_index_insert2(Store, Hash, Key, &Full);
-	}
+	return ((const fixed_methods_t *)Store->Methods)->insert2(Store, Value);
 }
 
 const void *fixed_index2_get(fixed_index2_t *Store, size_t Index) {
@@ -6,13 +6,17 @@
 typedef struct linear_index_t fixed_index2_t;
 
 fixed_index2_t *fixed_index2_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS);
+fixed_index2_t *fixed_index2_create_engine(const char *Prefix, size_t KeySize, size_t ChunkSize, linear_index_engine_t Engine RADB_MEM_PARAMS);
 fixed_index2_t *fixed_index2_open(const char *Prefix RADB_MEM_PARAMS);
 size_t fixed_index2_num_entries(fixed_index2_t *Store);
 #define fixed_index2_count fixed_index2_num_entries
+#define fixed_index2_cursor_open linear_index_cursor_open
+#define fixed_index2_set_filter linear_index_set_filter
 size_t fixed_index2_num_deleted(fixed_index2_t *Store);
 void fixed_index2_close(fixed_index2_t *Store);
 
 linear_index_open_t fixed_index2_open2(const char *Prefix RADB_MEM_PARAMS);
+radb_error_t fixed_index2_migrate(const char *Prefix RADB_MEM_PARAMS);
 
 size_t fixed_index2_insert(fixed_index2_t *Store, const void *Key);
 size_t fixed_index2_search(fixed_index2_t *Store, const void *Key);
@@ -9,6 +9,9 @@
 typedef struct fixed_store_t fixed_store_t;
 
 fixed_store_t *fixed_store_create(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS);
+fixed_store_t *fixed_store_create_bitmap(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS);
+fixed_store_t *fixed_store_create_packed(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS);
+fixed_store_t *fixed_store_create_sparse(const char *Prefix, size_t RequestedSize, size_t PageSize RADB_MEM_PARAMS);
 fixed_store_t *fixed_store_open(const char *Prefix RADB_MEM_PARAMS);
 void fixed_store_close(fixed_store_t *Store);
 
@@ -36,4 +39,18 @@ typedef struct {
 
 fixed_store_alloc_t fixed_store_alloc2(fixed_store_t *Store);
 
+size_t fixed_store_alloc_run(fixed_store_t *Store, size_t Count);
+void fixed_store_cursor_open(radb_cursor_t *Cursor, fixed_store_t *Store);
+
+void fixed_store_search_build(fixed_store_t *Store, size_t Count, size_t Offset, size_t Size);
+size_t fixed_store_lower_bound(fixed_store_t *Store, size_t Count, const void *Key, size_t Offset, size_t Size);
+
+typedef struct {
+	size_t NumEntries, NumFree, NodeSize;
+	size_t MappingSize;
+	radb_stats_t Events;
+} fixed_store_stats_t;
+
+void fixed_store_stats(fixed_store_t *Store, fixed_store_stats_t *Stats);
+
 #endif
@@ -0,0 +1,358 @@
+#include "frozen_index.h"
+#include "string_store.h"
+#include "fixed_store.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t Type, KeySize;
+	uint32_t NumKeys, NumSlots;
+	uint32_t NumBuckets, NumDense;
+	uint64_t Seed;
+} frozen_header_t;
+
+struct frozen_index_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	frozen_header_t *Header;
+	const uint16_t *Pilots;
+	const uint32_t *Remap;
+	const uint32_t *Values;
+	const uint8_t *Fingerprints;
+	void *Keys;
+	size_t HeaderSize;
+	int HeaderFd;
+};
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define FROZEN_INDEX_SIGNATURE 0x5A465241
+#define FROZEN_INDEX_VERSION MAKE_VERSION(1, 0)
+
+#define FROZEN_STRING 0
+#define FROZEN_FIXED 1
+
+// Average number of keys per bucket, each bucket stores a 16-bit pilot.
+#define BUCKET_SIZE 6
+#define MAX_PILOT 65536
+#define MAX_ATTEMPTS 16
+
+static inline uint64_t frozen_mix(uint64_t X) {
+	X = (X ^ (X >> 30)) * 0xBF58476D1CE4E5B9;
+	X = (X ^ (X >> 27)) * 0x94D049BB133111EB;
+	return X ^ (X >> 31);
+}
+
+static uint64_t frozen_hash(const void *Key, size_t Length) {
+	const unsigned char *Bytes = (const unsigned char *)Key;
+	uint64_t Hash = 0x9E3779B97F4A7C15 ^ Length;
+	while (Length >= 8) {
+		uint64_t Word;
+		memcpy(&Word, Bytes, 8);
+		Hash = frozen_mix(Hash ^ Word);
+		Bytes += 8;
+		Length -= 8;
+	}
+	uint64_t Word = 0;
+	memcpy(&Word, Bytes, Length);
+	return frozen_mix(Hash ^ Word);
+}
+
+// Skewed bucket assignment, 60% of the keys go into the first 30% of the buckets.
+static inline uint32_t frozen_bucket(frozen_header_t *Header, uint64_t Hash) {
+	uint64_t High = Hash >> 32;
+	if ((uint32_t)Hash < 0x99999999) return (High * Header->NumDense) >> 32;
+	return Header->NumDense + ((High * (Header->NumBuckets - Header->NumDense)) >> 32);
+}
+
+static inline uint32_t frozen_slot(frozen_header_t *Header, uint64_t Hash, uint32_t Pilot) {
+	return (Hash ^ frozen_mix(Pilot + 1)) % Header->NumSlots;
+}
+
+static inline uint8_t frozen_fingerprint(uint64_t Hash) {
+	return frozen_mix(~Hash);
+}
+
+typedef struct {
+	uint64_t Hash;
+	uint32_t Value, Bucket;
+} frozen_key_t;
+
+static int frozen_place(frozen_header_t *Header, frozen_key_t *Keys, uint16_t *Pilots, uint32_t *Slots) {
+	size_t NumKeys = Header->NumKeys, NumBuckets = Header->NumBuckets, NumSlots = Header->NumSlots;
+	for (size_t I = 0; I < NumKeys; ++I) {
+		Keys[I].Hash = frozen_mix(Keys[I].Hash ^ Header->Seed);
+		Keys[I].Bucket = frozen_bucket(Header, Keys[I].Hash);
+	}
+	// Group the keys by bucket, then order the buckets by decreasing size.
+	uint32_t *Starts = calloc(NumBuckets + 1, sizeof(uint32_t));
+	for (size_t I = 0; I < NumKeys; ++I) ++Starts[Keys[I].Bucket + 1];
+	size_t MaxSize = 0;
+	for (size_t I = 1; I <= NumBuckets; ++I) if (MaxSize < Starts[I]) MaxSize = Starts[I];
+	uint32_t *BySize = calloc(MaxSize + 2, sizeof(uint32_t));
+	for (size_t I = 1; I <= NumBuckets; ++I) ++BySize[MaxSize - Starts[I] + 1];
+	for (size_t I = 1; I <= MaxSize + 1; ++I) BySize[I] += BySize[I - 1];
+	uint32_t *Order = malloc(NumBuckets * sizeof(uint32_t));
+	for (size_t I = 0; I < NumBuckets; ++I) Order[BySize[MaxSize - Starts[I + 1]]++] = I;
+	for (size_t I = 1; I <= NumBuckets; ++I) Starts[I] += Starts[I - 1];
+	uint32_t *Members = malloc(NumKeys * sizeof(uint32_t));
+	uint32_t *Next = malloc(NumBuckets * sizeof(uint32_t));
+	memcpy(Next, Starts, NumBuckets * sizeof(uint32_t));
+	for (size_t I = 0; I < NumKeys; ++I) Members[Next[Keys[I].Bucket]++] = I;
+	uint64_t *Taken = calloc((NumSlots + 63) / 64, sizeof(uint64_t));
+	uint32_t *Trial = malloc((MaxSize + 1) * sizeof(uint32_t));
+	int Success = 1;
+	for (size_t I = 0; I < NumBuckets && Success; ++I) {
+		uint32_t Bucket = Order[I];
+		uint32_t *First = Members + Starts[Bucket];
+		size_t Size = Starts[Bucket + 1] - Starts[Bucket];
+		Pilots[Bucket] = 0;
+		if (!Size) continue;
+		Success = 0;
+		for (uint32_t Pilot = 0; Pilot < MAX_PILOT; ++Pilot) {
+			size_t J = 0;
+			for (; J < Size; ++J) {
+				uint32_t Slot = frozen_slot(Header, Keys[First[J]].Hash, Pilot);
+				if (Taken[Slot / 64] & (1ULL << (Slot % 64))) break;
+				size_t K = 0;
+				while (K < J && Trial[K] != Slot) ++K;
+				if (K < J) break;
+				Trial[J] = Slot;
+			}
+			if (J == Size) {
+				for (J = 0; J < Size; ++J) {
+					Taken[Trial[J] / 64] |= 1ULL << (Trial[J] % 64);
+					Slots[First[J]] = Trial[J];
+				}
+				Pilots[Bucket] = Pilot;
+				Success = 1;
+				break;
+			}
+		}
+	}
+	free(Trial);
+	free(Taken);
+	free(Next);
+	free(Members);
+	free(Order);
+	free(BySize);
+	free(Starts);
+	return Success;
+}
+
+static int frozen_build(const char *Prefix, frozen_key_t *Keys, size_t NumKeys, uint32_t Type, uint32_t KeySize) {
+	frozen_header_t Header[1] = {{FROZEN_INDEX_SIGNATURE, FROZEN_INDEX_VERSION, Type, KeySize}};
+	Header->NumKeys = NumKeys;
+	Header->NumSlots = NumKeys + (NumKeys + 99) / 100;
+	Header->NumBuckets = (NumKeys + BUCKET_SIZE - 1) / BUCKET_SIZE + 1;
+	Header->NumDense = (Header->NumBuckets * 3 + 9) / 10;
+	uint16_t *Pilots = malloc(Header->NumBuckets * sizeof(uint16_t));
+	uint32_t *Slots = malloc(NumKeys * sizeof(uint32_t) + 1);
+	uint64_t *Hashes = malloc(NumKeys * sizeof(uint64_t) + 1);
+	for (size_t I = 0; I < NumKeys; ++I) Hashes[I] = Keys[I].Hash;
+	int Attempt = 0;
+	for (;;) {
+		Header->Seed = frozen_mix(Attempt);
+		if (frozen_place(Header, Keys, Pilots, Slots)) break;
+		if (++Attempt == MAX_ATTEMPTS) {
+			free(Hashes);
+			free(Slots);
+			free(Pilots);
+			return -1;
+		}
+		for (size_t I = 0; I < NumKeys; ++I) Keys[I].Hash = Hashes[I];
+	}
+	free(Hashes);
+	size_t NumRemap = Header->NumSlots - NumKeys;
+	size_t PilotsSize = (Header->NumBuckets * sizeof(uint16_t) + 3) & ~3;
+	size_t HeaderSize = sizeof(frozen_header_t) + PilotsSize + (NumRemap + NumKeys) * sizeof(uint32_t) + NumKeys;
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.frozen", Prefix);
+	int HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	ftruncate(HeaderFd, HeaderSize);
+	void *Data = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, HeaderFd, 0);
+	memcpy(Data, Header, sizeof(frozen_header_t));
+	memcpy(Data + sizeof(frozen_header_t), Pilots, Header->NumBuckets * sizeof(uint16_t));
+	uint32_t *Remap = Data + sizeof(frozen_header_t) + PilotsSize;
+	uint32_t *Values = Remap + NumRemap;
+	uint8_t *Fingerprints = (uint8_t *)(Values + NumKeys);
+	// Slots past the number of keys are remapped to the unused slots in order.
+	uint8_t *Used = calloc(Header->NumSlots, 1);
+	for (size_t I = 0; I < NumKeys; ++I) Used[Slots[I]] = 1;
+	for (size_t Slot = NumKeys, Free = 0; Slot < Header->NumSlots; ++Slot) {
+		if (!Used[Slot]) continue;
+		while (Used[Free]) ++Free;
+		Remap[Slot - NumKeys] = Free++;
+	}
+	free(Used);
+	for (size_t I = 0; I < NumKeys; ++I) {
+		uint32_t Slot = Slots[I];
+		if (Slot >= NumKeys) Slot = Remap[Slot - NumKeys];
+		Values[Slot] = Keys[I].Value;
+		Fingerprints[Slot] = frozen_fingerprint(Keys[I].Hash);
+	}
+	free(Slots);
+	free(Pilots);
+	msync(Data, HeaderSize, MS_SYNC);
+	munmap(Data, HeaderSize);
+	close(HeaderFd);
+	return 0;
+}
+
+static int frozen_build_string(const char *Prefix, string_index2_t *Source) {
+	string_store_t *Store = (string_store_t *)linear_index_keys(Source);
+	size_t NumKeys = linear_index_count(Source);
+	frozen_key_t *Keys = malloc(NumKeys * sizeof(frozen_key_t) + 1);
+	size_t Space = 256;
+	char *Buffer = malloc(Space);
+	radb_cursor_t Cursor[1];
+	linear_index_cursor_open(Cursor, Source);
+	size_t Count = 0;
+	for (size_t Index; Count < NumKeys && (Index = radb_cursor_next(Cursor)) != INVALID_INDEX; ++Count) {
+		size_t Length = string_store_size(Store, Index);
+		if (Length > Space) {
+			Space = Length;
+			Buffer = realloc(Buffer, Space);
+		}
+		string_store_get(Store, Index, Buffer, Length);
+		Keys[Count].Hash = frozen_hash(Buffer, Length);
+		Keys[Count].Value = Index;
+	}
+	free(Buffer);
+	int Result = frozen_build(Prefix, Keys, Count, FROZEN_STRING, 0);
+	free(Keys);
+	return Result;
+}
+
+static int frozen_build_fixed(const char *Prefix, fixed_index2_t *Source) {
+	fixed_store_t *Store = (fixed_store_t *)linear_index_keys(Source);
+	size_t KeySize = linear_index_get_extra(Source);
+	size_t NumKeys = linear_index_count(Source);
+	frozen_key_t *Keys = malloc(NumKeys * sizeof(frozen_key_t) + 1);
+	radb_cursor_t Cursor[1];
+	linear_index_cursor_open(Cursor, Source);
+	size_t Count = 0;
+	for (size_t Index; Count < NumKeys && (Index = radb_cursor_next(Cursor)) != INVALID_INDEX; ++Count) {
+		Keys[Count].Hash = frozen_hash(fixed_store_get(Store, Index), KeySize);
+		Keys[Count].Value = Index;
+	}
+	int Result = frozen_build(Prefix, Keys, Count, FROZEN_FIXED, KeySize);
+	free(Keys);
+	return Result;
+}
+
+frozen_index_t *frozen_index_create_string(const char *Prefix, string_index2_t *Source RADB_MEM_PARAMS) {
+	if (frozen_build_string(Prefix, Source)) return NULL;
+	return frozen_index_open2(Prefix, linear_index_keys(Source) RADB_MEM_ARGS).Index;
+}
+
+frozen_index_t *frozen_index_create_fixed(const char *Prefix, fixed_index2_t *Source RADB_MEM_PARAMS) {
+	if (frozen_build_fixed(Prefix, Source)) return NULL;
+	return frozen_index_open2(Prefix, linear_index_keys(Source) RADB_MEM_ARGS).Index;
+}
+
+// The key store belongs to the caller, as with linear_index_open(), and must stay open while the frozen index is used.
+frozen_index_open_t frozen_index_open2(const char *Prefix, void *Keys RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.frozen", Prefix);
+	if (stat(FileName, Stat)) return (frozen_index_open_t){NULL, RADB_FILE_NOT_FOUND};
+	int HeaderFd = open(FileName, O_RDONLY, 0777);
+	size_t HeaderSize = Stat->st_size;
+	frozen_header_t *Header = mmap(NULL, HeaderSize, PROT_READ, MAP_SHARED, HeaderFd, 0);
+	if (HeaderSize < sizeof(frozen_header_t) || Header->Signature != FROZEN_INDEX_SIGNATURE) {
+		munmap(Header, HeaderSize);
+		close(HeaderFd);
+		return (frozen_index_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+#if defined(RADB_MEM_MALLOC)
+	frozen_index_t *Store = malloc(sizeof(frozen_index_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	frozen_index_t *Store = GC_malloc(sizeof(frozen_index_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	frozen_index_t *Store = alloc(Allocator, sizeof(frozen_index_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	Store->HeaderFd = HeaderFd;
+	Store->HeaderSize = HeaderSize;
+	Store->Header = Header;
+	Store->Pilots = (const uint16_t *)(Header + 1);
+	Store->Remap = (const uint32_t *)((const void *)Store->Pilots + ((Header->NumBuckets * sizeof(uint16_t) + 3) & ~3));
+	Store->Values = Store->Remap + (Header->NumSlots - Header->NumKeys);
+	Store->Fingerprints = (const uint8_t *)(Store->Values + Header->NumKeys);
+	Store->Keys = Keys;
+	return (frozen_index_open_t){Store, RADB_SUCCESS};
+}
+
+frozen_index_t *frozen_index_open(const char *Prefix, void *Keys RADB_MEM_PARAMS) {
+	return frozen_index_open2(Prefix, Keys RADB_MEM_ARGS).Index;
+}
+
+size_t frozen_index_num_entries(frozen_index_t *Store) {
+	return Store->Header->NumKeys;
+}
+
+void frozen_index_close(frozen_index_t *Store) {
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Store->Prefix);
+	free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+	Store->free(Store->Allocator, (void *)Store->Prefix);
+	Store->free(Store->Allocator, Store);
+#endif
+}
+
+size_t frozen_index_search(frozen_index_t *Store, const void *Key, size_t Length) {
+	frozen_header_t *Header = Store->Header;
+	if (!Header->NumKeys) return INVALID_INDEX;
+	if (Header->Type == FROZEN_FIXED) {
+		Length = Header->KeySize;
+	} else if (!Length) {
+		Length = strlen(Key);
+	}
+	uint64_t Hash = frozen_mix(frozen_hash(Key, Length) ^ Header->Seed);
+	uint32_t Slot = frozen_slot(Header, Hash, Store->Pilots[frozen_bucket(Header, Hash)]);
+	if (Slot >= Header->NumKeys) Slot = Store->Remap[Slot - Header->NumKeys];
+	if (Store->Fingerprints[Slot] != frozen_fingerprint(Hash)) return INVALID_INDEX;
+	uint32_t Index = Store->Values[Slot];
+	if (Header->Type == FROZEN_FIXED) {
+		if (memcmp(fixed_store_get(Store->Keys, Index), Key, Length)) return INVALID_INDEX;
+	} else {
+		if (string_store_compare(Store->Keys, Key, Length, Index)) return INVALID_INDEX;
+	}
+	return Index;
+}
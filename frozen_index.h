@@ -0,0 +1,25 @@
+#ifndef FROZEN_INDEX_H
+#define FROZEN_INDEX_H
+
+#include "string_index2.h"
+#include "fixed_index2.h"
+
+typedef struct frozen_index_t frozen_index_t;
+
+frozen_index_t *frozen_index_create_string(const char *Prefix, string_index2_t *Source RADB_MEM_PARAMS);
+frozen_index_t *frozen_index_create_fixed(const char *Prefix, fixed_index2_t *Source RADB_MEM_PARAMS);
+frozen_index_t *frozen_index_open(const char *Prefix, void *Keys RADB_MEM_PARAMS);
+size_t frozen_index_num_entries(frozen_index_t *Store);
+#define frozen_index_count frozen_index_num_entries
+void frozen_index_close(frozen_index_t *Store);
+
+typedef struct {
+	frozen_index_t *Index;
+	radb_error_t Error;
+} frozen_index_open_t;
+
+frozen_index_open_t frozen_index_open2(const char *Prefix, void *Keys RADB_MEM_PARAMS);
+
+size_t frozen_index_search(frozen_index_t *Store, const void *Key, size_t Length);
+
+#endif
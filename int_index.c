@@ -0,0 +1,341 @@
+#include "int_index.h"
+#include "trace.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Keys are stored in the slots with their values, empty slots have the value INVALID_INDEX.
+typedef struct {
+	uint32_t Key, Value;
+} int_slot32_t;
+
+typedef struct {
+	uint64_t Key;
+	uint32_t Value, Reserved;
+} int_slot64_t;
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t Size, Space;
+	uint32_t KeySize, Deleted;
+	uint32_t NextIndex, Reserved;
+	uint64_t Slots[];
+} int_index_header_t;
+
+struct int_index_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	int_index_header_t *Header;
+	size_t HeaderSize;
+	int HeaderFd;
+	radb_stats_t Stats[1];
+};
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define INT_INDEX_SIGNATURE 0x49494152
+#define INT_INDEX_VERSION MAKE_VERSION(1, 0)
+
+static inline size_t int_index_slot_size(size_t KeySize) {
+	return KeySize == 4 ? sizeof(int_slot32_t) : sizeof(int_slot64_t);
+}
+
+static int_index_header_t *int_index_header_create(int_index_t *Store, int Fd, size_t Size, size_t KeySize, size_t *HeaderSize) {
+	*HeaderSize = sizeof(int_index_header_t) + Size * int_index_slot_size(KeySize);
+	radb_truncate(Store->Stats, Fd, *HeaderSize);
+	int_index_header_t *Header = mmap(NULL, *HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	Header->Signature = INT_INDEX_SIGNATURE;
+	Header->Version = INT_INDEX_VERSION;
+	Header->Size = Header->Space = Size;
+	Header->KeySize = KeySize;
+	Header->Deleted = 0;
+	Header->NextIndex = 0;
+	if (KeySize == 4) {
+		int_slot32_t *Slots = (int_slot32_t *)Header->Slots;
+		for (size_t I = 0; I < Size; ++I) Slots[I].Value = INVALID_INDEX;
+	} else {
+		int_slot64_t *Slots = (int_slot64_t *)Header->Slots;
+		for (size_t I = 0; I < Size; ++I) Slots[I].Value = INVALID_INDEX;
+	}
+	return Header;
+}
+
+int_index_t *int_index_create(const char *Prefix, size_t KeySize RADB_MEM_PARAMS) {
+#if defined(RADB_MEM_MALLOC)
+	int_index_t *Store = malloc(sizeof(int_index_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	int_index_t *Store = GC_malloc(sizeof(int_index_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	int_index_t *Store = alloc(Allocator, sizeof(int_index_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.int", Prefix);
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Store->Header = int_index_header_create(Store, Store->HeaderFd, 64, KeySize <= 4 ? 4 : 8, &Store->HeaderSize);
+	return Store;
+}
+
+int_index_open_t int_index_open2(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.int", Prefix);
+	if (stat(FileName, Stat)) return (int_index_open_t){NULL, RADB_FILE_NOT_FOUND};
+#if defined(RADB_MEM_MALLOC)
+	int_index_t *Store = malloc(sizeof(int_index_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	int_index_t *Store = GC_malloc(sizeof(int_index_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	int_index_t *Store = alloc(Allocator, sizeof(int_index_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = open(FileName, O_RDWR, 0777);
+	Store->HeaderSize = Stat->st_size;
+	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
+	if (Store->Header->Signature != INT_INDEX_SIGNATURE) {
+		munmap(Store->Header, Store->HeaderSize);
+		close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+		free((void *)Store->Prefix);
+		free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+		Store->free(Store->Allocator, (void *)Store->Prefix);
+		Store->free(Store->Allocator, Store);
+#endif
+		return (int_index_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+	return (int_index_open_t){Store, RADB_SUCCESS};
+}
+
+int_index_t *int_index_open(const char *Prefix RADB_MEM_PARAMS) {
+	return int_index_open2(Prefix RADB_MEM_ARGS).Index;
+}
+
+void int_index_close(int_index_t *Store) {
+	radb_sync(Store->Header, Store->HeaderSize);
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Store->Prefix);
+	free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+	Store->free(Store->Allocator, (void *)Store->Prefix);
+	Store->free(Store->Allocator, Store);
+#endif
+}
+
+size_t int_index_num_entries(int_index_t *Store) {
+	return Store->Header->Size - (Store->Header->Space + Store->Header->Deleted);
+}
+
+size_t int_index_num_deleted(int_index_t *Store) {
+	return Store->Header->Deleted;
+}
+
+uint32_t int_index_key_size(int_index_t *Store) {
+	return Store->Header->KeySize;
+}
+
+// Multiplicative hashing, the top bits of the product select the slot.
+static inline size_t int_index_home(uint64_t Key, size_t Size) {
+	return (Key * 0x9E3779B97F4A7C15) >> (64 - __builtin_ctzl(Size));
+}
+
+static void int_index_rebuild(int_index_t *Store);
+
+// Probing stays scalar: at the highest load (3/4) a lookup reads about 2.5 slots for a hit and 9 for a
+// miss, one or two cache lines, and the slots interleave keys with values, so there is no control byte
+// array for radb_probe16() and a call through RadbKernels would cost more than the comparisons it saves.
+
+#define INT_INDEX_METHODS(BITS) \
+\
+static size_t int_index_search ## BITS(int_index_t *Store, uint64_t Key) { \
+	int_slot ## BITS ## _t *Slots = (int_slot ## BITS ## _t *)Store->Header->Slots; \
+	size_t Mask = Store->Header->Size - 1; \
+	size_t Index = int_index_home(Key, Store->Header->Size); \
+	for (;;) { \
+		uint32_t Value = Slots[Index].Value; \
+		if (Value == INVALID_INDEX) return INVALID_INDEX; \
+		if (Slots[Index].Key == Key && Value != DELETED_INDEX) return Value; \
+		Index = (Index + 1) & Mask; \
+	} \
+} \
+\
+static index_result_t int_index_insert ## BITS(int_index_t *Store, uint64_t Key) { \
+	for (;;) { \
+		int_slot ## BITS ## _t *Slots = (int_slot ## BITS ## _t *)Store->Header->Slots; \
+		size_t Mask = Store->Header->Size - 1; \
+		size_t Index = int_index_home(Key, Store->Header->Size); \
+		int_slot ## BITS ## _t *Deleted = NULL; \
+		for (;;) { \
+			uint32_t Value = Slots[Index].Value; \
+			if (Value == INVALID_INDEX) break; \
+			if (Value == DELETED_INDEX) { \
+				if (!Deleted) Deleted = Slots + Index; \
+			} else if (Slots[Index].Key == Key) { \
+				return (index_result_t){Value, 0}; \
+			} \
+			Index = (Index + 1) & Mask; \
+		} \
+		int_slot ## BITS ## _t *Slot; \
+		if (Deleted) { \
+			--Store->Header->Deleted; \
+			Slot = Deleted; \
+		} else if (Store->Header->Space - 1 > Store->Header->Size >> 2) { \
+			--Store->Header->Space; \
+			Slot = Slots + Index; \
+		} else { \
+			int_index_rebuild(Store); \
+			continue; \
+		} \
+		uint32_t Value = Store->Header->NextIndex++; \
+		Slot->Key = Key; \
+		Slot->Value = Value; \
+		return (index_result_t){Value, 1}; \
+	} \
+} \
+\
+static size_t int_index_delete ## BITS(int_index_t *Store, uint64_t Key) { \
+	int_slot ## BITS ## _t *Slots = (int_slot ## BITS ## _t *)Store->Header->Slots; \
+	size_t Mask = Store->Header->Size - 1; \
+	size_t Index = int_index_home(Key, Store->Header->Size); \
+	for (;;) { \
+		uint32_t Value = Slots[Index].Value; \
+		if (Value == INVALID_INDEX) return INVALID_INDEX; \
+		if (Slots[Index].Key == Key && Value != DELETED_INDEX) { \
+			Slots[Index].Value = DELETED_INDEX; \
+			++Store->Header->Deleted; \
+			return Value; \
+		} \
+		Index = (Index + 1) & Mask; \
+	} \
+} \
+\
+static void int_index_copy ## BITS(int_index_header_t *Target, int_index_header_t *Source) { \
+	int_slot ## BITS ## _t *Old = (int_slot ## BITS ## _t *)Source->Slots; \
+	int_slot ## BITS ## _t *New = (int_slot ## BITS ## _t *)Target->Slots; \
+	size_t Mask = Target->Size - 1; \
+	for (size_t I = 0; I < Source->Size; ++I) { \
+		if (Old[I].Value >= DELETED_INDEX) continue; \
+		size_t Index = int_index_home(Old[I].Key, Target->Size); \
+		while (New[Index].Value != INVALID_INDEX) Index = (Index + 1) & Mask; \
+		New[Index] = Old[I]; \
+		--Target->Space; \
+	} \
+}
+
+INT_INDEX_METHODS(32)
+INT_INDEX_METHODS(64)
+
+static void int_index_rebuild(int_index_t *Store) {
+	size_t Size = Store->Header->Size;
+	size_t NewSize = Size * 2;
+	if (Store->Header->Space + Store->Header->Deleted > Size >> 1) NewSize = Size;
+	uint64_t Start = radb_time();
+
+	char FileName2[strlen(Store->Prefix) + 20];
+	sprintf(FileName2, "%s.int.temp", Store->Prefix);
+	int HeaderFd = open(FileName2, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	size_t HeaderSize;
+	int_index_header_t *Header = int_index_header_create(Store, HeaderFd, NewSize, Store->Header->KeySize, &HeaderSize);
+	Header->NextIndex = Store->Header->NextIndex;
+	if (Header->KeySize == 4) {
+		int_index_copy32(Header, Store->Header);
+	} else {
+		int_index_copy64(Header, Store->Header);
+	}
+
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.int", Store->Prefix);
+	rename(FileName2, FileName);
+
+	Store->HeaderSize = HeaderSize;
+	Store->Header = Header;
+	Store->HeaderFd = HeaderFd;
+
+	Store->Stats->Rebuilds.Time += radb_time() - Start;
+	++Store->Stats->Rebuilds.Count;
+}
+
+// Keys in indices with 4 byte keys are truncated to 32 bits.
+
+size_t int_index_search(int_index_t *Store, uint64_t Key) {
+	if (Store->Header->KeySize == 4) return int_index_search32(Store, (uint32_t)Key);
+	return int_index_search64(Store, Key);
+}
+
+index_result_t int_index_insert2(int_index_t *Store, uint64_t Key) {
+	if (Store->Header->KeySize == 4) return int_index_insert32(Store, (uint32_t)Key);
+	return int_index_insert64(Store, Key);
+}
+
+size_t int_index_insert(int_index_t *Store, uint64_t Key) {
+	return int_index_insert2(Store, Key).Index;
+}
+
+size_t int_index_delete(int_index_t *Store, uint64_t Key) {
+	if (Store->Header->KeySize == 4) return int_index_delete32(Store, (uint32_t)Key);
+	return int_index_delete64(Store, Key);
+}
+
+static size_t int_index_cursor_next(radb_cursor_t *Cursor) {
+	int_index_t *Store = (int_index_t *)Cursor->Store;
+	size_t Limit = Cursor->Limit < Store->Header->Size ? Cursor->Limit : Store->Header->Size;
+	size_t SlotSize = int_index_slot_size(Store->Header->KeySize);
+	// The value follows the key in both slot layouts.
+	const char *Values = (const char *)Store->Header->Slots + SlotSize - (SlotSize == sizeof(int_slot32_t) ? 4 : 8);
+	while (Cursor->Position < Limit) {
+		uint32_t Value = *(const uint32_t *)(Values + SlotSize * Cursor->Position++);
+		if (Value < DELETED_INDEX) return Value;
+	}
+	return INVALID_INDEX;
+}
+
+void int_index_cursor_open(radb_cursor_t *Cursor, int_index_t *Store) {
+	Cursor->Store = Store;
+	Cursor->next = int_index_cursor_next;
+	Cursor->Position = 0;
+	Cursor->Limit = Store->Header->Size;
+}
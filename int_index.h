@@ -0,0 +1,36 @@
+#ifndef INT_INDEX_H
+#define INT_INDEX_H
+
+#include "config.h"
+#include "common.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+#define DELETED_INDEX 0xFFFFFFFE
+
+typedef struct int_index_t int_index_t;
+
+int_index_t *int_index_create(const char *Prefix, size_t KeySize RADB_MEM_PARAMS);
+int_index_t *int_index_open(const char *Prefix RADB_MEM_PARAMS);
+size_t int_index_num_entries(int_index_t *Store);
+#define int_index_count int_index_num_entries
+size_t int_index_num_deleted(int_index_t *Store);
+void int_index_close(int_index_t *Store);
+
+typedef struct {
+	int_index_t *Index;
+	radb_error_t Error;
+} int_index_open_t;
+
+int_index_open_t int_index_open2(const char *Prefix RADB_MEM_PARAMS);
+
+size_t int_index_insert(int_index_t *Store, uint64_t Key);
+size_t int_index_search(int_index_t *Store, uint64_t Key);
+size_t int_index_delete(int_index_t *Store, uint64_t Key);
+
+index_result_t int_index_insert2(int_index_t *Store, uint64_t Key);
+
+uint32_t int_index_key_size(int_index_t *Store);
+
+void int_index_cursor_open(radb_cursor_t *Cursor, int_index_t *Store);
+
+#endif
@@ -0,0 +1,518 @@
+#include "kernel.h"
+#include <string.h>
+
+static int radb_compare_scalar(const void *A, const void *B, size_t Length) {
+	return radb_compare_words(A, B, Length);
+}
+
+static uint32_t radb_hash_scalar(uint32_t Hash, const void *Key, size_t Length) {
+	return radb_hash_bytes(Hash, Key, Length);
+}
+
+static size_t radb_find16_scalar(const uint8_t *Keys, size_t Count, uint8_t Key) {
+	for (size_t I = 0; I < Count; ++I) if (Keys[I] == Key) return I;
+	return Count;
+}
+
+static uint64_t radb_probe16_scalar(const uint8_t *Control, uint8_t Fingerprint) {
+	uint64_t Mask = 0;
+	for (int I = 0; I < 16; ++I) {
+		uint8_t Byte = Control[I];
+		if (Byte == Fingerprint) Mask |= (uint64_t)1 << I;
+		if (Byte == 0x80) Mask |= (uint64_t)1 << (I + 16);
+		if (Byte & 0x80) Mask |= (uint64_t)1 << (I + 32);
+	}
+	return Mask;
+}
+
+static void radb_copy_scalar(void *Target, const void *Source, size_t Length) {
+	memcpy(Target, Source, Length);
+}
+
+// Range checks use Min <= Value <= Max as (Value - Min) <= (Max - Min) in unsigned arithmetic,
+// which holds for signed values as well, so there is one filter for each width.
+#define RADB_FILTER_SCALAR(NAME, TYPE) \
+static void NAME(const void *Values, size_t Count, uint64_t Min, uint64_t Range, uint64_t *Selection, int Combine) { \
+	const TYPE *V = Values; \
+	for (size_t I = 0; I < Count; I += 64, ++Selection) { \
+		uint64_t Word = 0; \
+		for (int J = 0; J < 64; ++J) Word |= (uint64_t)((TYPE)(V[I + J] - Min) <= (TYPE)Range) << J; \
+		radb_combine(Selection, Word, Combine); \
+	} \
+}
+
+RADB_FILTER_SCALAR(radb_filter8_scalar, uint8_t)
+RADB_FILTER_SCALAR(radb_filter16_scalar, uint16_t)
+RADB_FILTER_SCALAR(radb_filter32_scalar, uint32_t)
+RADB_FILTER_SCALAR(radb_filter64_scalar, uint64_t)
+
+static void radb_filter_double_scalar(const double *Values, size_t Count, double Min, double Max, uint64_t *Selection, int Combine) {
+	for (size_t I = 0; I < Count; I += 64, ++Selection) {
+		uint64_t Word = 0;
+		for (int J = 0; J < 64; ++J) Word |= (uint64_t)(Values[I + J] >= Min && Values[I + J] <= Max) << J;
+		radb_combine(Selection, Word, Combine);
+	}
+}
+
+// Sums skip words with no rows selected and only visit the selected rows of partial words.
+#define RADB_SUM_SCALAR(NAME, VALUES, TYPE, RESULT) \
+static RESULT NAME(const VALUES *Values, size_t Count, const uint64_t *Selection) { \
+	const TYPE *V = Values; \
+	RESULT Sum = 0; \
+	for (size_t I = 0; I < Count; I += 64) { \
+		uint64_t Word = Selection ? Selection[I / 64] : ~(uint64_t)0; \
+		if (Word == ~(uint64_t)0) { \
+			for (int J = 0; J < 64; ++J) Sum += V[I + J]; \
+		} else { \
+			for (; Word; Word &= Word - 1) Sum += V[I + __builtin_ctzll(Word)]; \
+		} \
+	} \
+	return Sum; \
+}
+
+RADB_SUM_SCALAR(radb_sum8_scalar, void, uint8_t, uint64_t)
+RADB_SUM_SCALAR(radb_sum16_scalar, void, uint16_t, uint64_t)
+RADB_SUM_SCALAR(radb_sum32_scalar, void, uint32_t, uint64_t)
+RADB_SUM_SCALAR(radb_sum64_scalar, void, uint64_t, uint64_t)
+RADB_SUM_SCALAR(radb_sum_int32_scalar, int32_t, int32_t, uint64_t)
+RADB_SUM_SCALAR(radb_sum_double_scalar, double, double, double)
+
+#define RADB_COLUMN_KERNELS(SUFFIX) \
+	{radb_filter8_##SUFFIX, radb_filter16_##SUFFIX, radb_filter32_##SUFFIX, radb_filter64_##SUFFIX}, radb_filter_double_##SUFFIX, \
+	{radb_sum8_##SUFFIX, radb_sum16_##SUFFIX, radb_sum32_##SUFFIX, radb_sum64_##SUFFIX}, radb_sum_int32_##SUFFIX, radb_sum_double_##SUFFIX
+
+static const radb_kernels_t KernelsScalar[1] = {{
+	"scalar", radb_compare_scalar, radb_hash_scalar, radb_find16_scalar, radb_probe16_scalar, radb_copy_scalar,
+	RADB_COLUMN_KERNELS(scalar)
+}};
+
+const radb_kernels_t *RadbKernels = KernelsScalar;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#include <immintrin.h>
+
+// 33^N modulo 2^32, the DJB2 hash of N more bytes multiplies the previous hash by this.
+static inline uint32_t radb_hash_scale(size_t N) {
+	uint32_t Scale = 1, Base = 33;
+	for (; N; N >>= 1, Base *= Base) if (N & 1) Scale *= Base;
+	return Scale;
+}
+
+// 33^(15 - J), the last W entries weight the lanes of a block of W bytes.
+static const uint32_t HashPowers[16] __attribute__((aligned(64))) = {
+	0x0C3525E1, 0xA3476DC1, 0x3B4039A1, 0x4F5F0981, 0x30F35D61, 0x855CB541, 0x040A9121, 0x747C7101,
+	0xEC41D4E1, 0x4CFA3CC1, 0x025528A1, 0x00121881, 0x00008C61, 0x00000441, 0x00000021, 0x00000001
+};
+
+// The hashes are vectorized by splitting the input into blocks of W bytes, with lane J of Acc
+// accumulating byte J of each block (scaled by 33^W per block), so that the hash of the blocks is
+// the sum of Acc[J] * 33^(W - 1 - J). Two blocks are handled per iteration to shorten the dependency chain.
+
+#define RADB_KERNEL_SSE __attribute__((target("sse4.2")))
+
+RADB_KERNEL_SSE static int radb_compare_sse42(const void *A, const void *B, size_t Length) {
+	const uint8_t *P = A, *Q = B;
+	for (; Length >= 16; P += 16, Q += 16, Length -= 16) {
+		__m128i X = _mm_loadu_si128((const __m128i *)P);
+		__m128i Y = _mm_loadu_si128((const __m128i *)Q);
+		uint32_t Mask = _mm_movemask_epi8(_mm_cmpeq_epi8(X, Y)) ^ 0xFFFF;
+		if (Mask) {
+			size_t I = __builtin_ctz(Mask);
+			return P[I] - Q[I];
+		}
+	}
+	return radb_compare_words(P, Q, Length);
+}
+
+RADB_KERNEL_SSE static uint32_t radb_hash_sse42(uint32_t Hash, const void *Key, size_t Length) {
+	const uint8_t *P = Key;
+	size_t Pairs = Length / 8;
+	if (Pairs) {
+		__m128i Acc = _mm_setzero_si128();
+		__m128i Scale = _mm_set1_epi32(HashPowers[11]);
+		__m128i Scale2 = _mm_set1_epi32(HashPowers[7]);
+		for (size_t I = 0; I < Pairs; ++I, P += 8) {
+			uint32_t W0, W1;
+			memcpy(&W0, P, 4);
+			memcpy(&W1, P + 4, 4);
+			__m128i X = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(W0));
+			__m128i Y = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(W1));
+			Acc = _mm_add_epi32(_mm_mullo_epi32(Acc, Scale2), _mm_add_epi32(_mm_mullo_epi32(X, Scale), Y));
+		}
+		Acc = _mm_mullo_epi32(Acc, _mm_load_si128((const __m128i *)(HashPowers + 12)));
+		Acc = _mm_add_epi32(Acc, _mm_shuffle_epi32(Acc, 0x4E));
+		Acc = _mm_add_epi32(Acc, _mm_shuffle_epi32(Acc, 0xB1));
+		Hash = Hash * radb_hash_scale(Pairs * 8) + (uint32_t)_mm_cvtsi128_si32(Acc);
+		Length -= Pairs * 8;
+	}
+	return radb_hash_bytes(Hash, P, Length);
+}
+
+RADB_KERNEL_SSE static size_t radb_find16_sse42(const uint8_t *Keys, size_t Count, uint8_t Key) {
+	__m128i X = _mm_loadu_si128((const __m128i *)Keys);
+	uint32_t Mask = _mm_movemask_epi8(_mm_cmpeq_epi8(X, _mm_set1_epi8(Key))) & ((1 << Count) - 1);
+	return Mask ? __builtin_ctz(Mask) : Count;
+}
+
+RADB_KERNEL_SSE static uint64_t radb_probe16_sse42(const uint8_t *Control, uint8_t Fingerprint) {
+	__m128i X = _mm_loadu_si128((const __m128i *)Control);
+	uint64_t Match = _mm_movemask_epi8(_mm_cmpeq_epi8(X, _mm_set1_epi8(Fingerprint)));
+	uint64_t Empty = _mm_movemask_epi8(_mm_cmpeq_epi8(X, _mm_set1_epi8((char)0x80)));
+	uint64_t Free = _mm_movemask_epi8(X);
+	return Match | (Empty << 16) | (Free << 32);
+}
+
+RADB_KERNEL_SSE static void radb_copy_sse42(void *Target, const void *Source, size_t Length) {
+	uint8_t *P = Target;
+	const uint8_t *Q = Source;
+	// Length is at least 16, so the last block can overlap the previous one.
+	__m128i Last = _mm_loadu_si128((const __m128i *)(Q + Length - 16));
+	for (size_t I = 16; I < Length; I += 16, P += 16, Q += 16) {
+		_mm_storeu_si128((__m128i *)P, _mm_loadu_si128((const __m128i *)Q));
+	}
+	_mm_storeu_si128((__m128i *)((uint8_t *)Target + Length - 16), Last);
+}
+
+// The column kernels need unsigned and 64-bit compares, which SSE4.2 mostly lacks.
+static const radb_kernels_t KernelsSSE42[1] = {{
+	"sse4.2", radb_compare_sse42, radb_hash_sse42, radb_find16_sse42, radb_probe16_sse42, radb_copy_sse42,
+	RADB_COLUMN_KERNELS(scalar)
+}};
+
+#define RADB_KERNEL_AVX2 __attribute__((target("avx2")))
+
+RADB_KERNEL_AVX2 static int radb_compare_avx2(const void *A, const void *B, size_t Length) {
+	const uint8_t *P = A, *Q = B;
+	for (; Length >= 32; P += 32, Q += 32, Length -= 32) {
+		__m256i X = _mm256_loadu_si256((const __m256i *)P);
+		__m256i Y = _mm256_loadu_si256((const __m256i *)Q);
+		uint32_t Mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(X, Y));
+		if (Mask) {
+			size_t I = __builtin_ctz(Mask);
+			return P[I] - Q[I];
+		}
+	}
+	return radb_compare_words(P, Q, Length);
+}
+
+RADB_KERNEL_AVX2 static uint32_t radb_hash_avx2(uint32_t Hash, const void *Key, size_t Length) {
+	const uint8_t *P = Key;
+	size_t Pairs = Length / 16;
+	if (Pairs) {
+		__m256i Acc = _mm256_setzero_si256();
+		__m256i Scale = _mm256_set1_epi32(HashPowers[7]);
+		__m256i Scale2 = _mm256_set1_epi32(HashPowers[0] * 33);
+		for (size_t I = 0; I < Pairs; ++I, P += 16) {
+			__m256i X = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)P));
+			__m256i Y = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(P + 8)));
+			Acc = _mm256_add_epi32(_mm256_mullo_epi32(Acc, Scale2), _mm256_add_epi32(_mm256_mullo_epi32(X, Scale), Y));
+		}
+		Acc = _mm256_mullo_epi32(Acc, _mm256_load_si256((const __m256i *)(HashPowers + 8)));
+		__m128i Sum = _mm_add_epi32(_mm256_castsi256_si128(Acc), _mm256_extracti128_si256(Acc, 1));
+		Sum = _mm_add_epi32(Sum, _mm_shuffle_epi32(Sum, 0x4E));
+		Sum = _mm_add_epi32(Sum, _mm_shuffle_epi32(Sum, 0xB1));
+		Hash = Hash * radb_hash_scale(Pairs * 16) + (uint32_t)_mm_cvtsi128_si32(Sum);
+		Length -= Pairs * 16;
+	}
+	return radb_hash_bytes(Hash, P, Length);
+}
+
+RADB_KERNEL_AVX2 static size_t radb_find16_avx2(const uint8_t *Keys, size_t Count, uint8_t Key) {
+	__m128i X = _mm_loadu_si128((const __m128i *)Keys);
+	uint32_t Mask = _mm_movemask_epi8(_mm_cmpeq_epi8(X, _mm_set1_epi8(Key))) & ((1 << Count) - 1);
+	return Mask ? __builtin_ctz(Mask) : Count;
+}
+
+RADB_KERNEL_AVX2 static uint64_t radb_probe16_avx2(const uint8_t *Control, uint8_t Fingerprint) {
+	__m128i X = _mm_loadu_si128((const __m128i *)Control);
+	uint64_t Match = _mm_movemask_epi8(_mm_cmpeq_epi8(X, _mm_set1_epi8(Fingerprint)));
+	uint64_t Empty = _mm_movemask_epi8(_mm_cmpeq_epi8(X, _mm_set1_epi8((char)0x80)));
+	uint64_t Free = _mm_movemask_epi8(X);
+	return Match | (Empty << 16) | (Free << 32);
+}
+
+RADB_KERNEL_AVX2 static void radb_copy_avx2(void *Target, const void *Source, size_t Length) {
+	uint8_t *P = Target;
+	const uint8_t *Q = Source;
+	// Length is at least 32, so the last block can overlap the previous one.
+	__m256i Last = _mm256_loadu_si256((const __m256i *)(Q + Length - 32));
+	for (size_t I = 32; I < Length; I += 32, P += 32, Q += 32) {
+		_mm256_storeu_si256((__m256i *)P, _mm256_loadu_si256((const __m256i *)Q));
+	}
+	_mm256_storeu_si256((__m256i *)((uint8_t *)Target + Length - 32), Last);
+}
+
+// Compares 64 rows at a time, Lanes rows per vector, with ROWS(P) returning the bits for the rows at P.
+#define RADB_FILTER_AVX2(NAME, TYPE, LANES, SETUP, ROWS) \
+RADB_KERNEL_AVX2 static void NAME(const void *Values, size_t Count, uint64_t Min, uint64_t Range, uint64_t *Selection, int Combine) { \
+	const TYPE *V = Values; \
+	SETUP; \
+	for (size_t I = 0; I < Count; I += 64, ++Selection) { \
+		uint64_t Word = 0; \
+		for (int J = 0; J < 64; J += LANES) Word |= (uint64_t)(ROWS(V + I + J)) << J; \
+		radb_combine(Selection, Word, Combine); \
+	} \
+}
+
+RADB_KERNEL_AVX2 static inline __m256i radb_in_range_avx2(__m256i D, __m256i Range, int Width) {
+	switch (Width) {
+	case 1: return _mm256_cmpeq_epi8(_mm256_max_epu8(D, Range), Range);
+	case 2: return _mm256_cmpeq_epi16(_mm256_max_epu16(D, Range), Range);
+	default: return _mm256_cmpeq_epi32(_mm256_max_epu32(D, Range), Range);
+	}
+}
+
+#define RADB_ROWS8_AVX2(P) (uint32_t)_mm256_movemask_epi8(radb_in_range_avx2(_mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(P)), MinV), RangeV, 1))
+
+// Two vectors of 16-bit results are packed into bytes, the pack works within 128-bit lanes.
+#define RADB_ROWS16_AVX2(P) (uint32_t)_mm256_movemask_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16( \
+	radb_in_range_avx2(_mm256_sub_epi16(_mm256_loadu_si256((const __m256i *)(P)), MinV), RangeV, 2), \
+	radb_in_range_avx2(_mm256_sub_epi16(_mm256_loadu_si256((const __m256i *)(P) + 1), MinV), RangeV, 2)), 0xD8))
+
+#define RADB_ROWS32_AVX2(P) _mm256_movemask_ps(_mm256_castsi256_ps(radb_in_range_avx2(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(P)), MinV), RangeV, 4)))
+
+// There is no unsigned 64-bit compare, flipping the sign bits allows a signed one.
+#define RADB_ROWS64_AVX2(P) (~_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64( \
+	_mm256_xor_si256(_mm256_sub_epi64(_mm256_loadu_si256((const __m256i *)(P)), MinV), SignV), RangeV))) & 0xF)
+
+RADB_FILTER_AVX2(radb_filter8_avx2, uint8_t, 32, __m256i MinV = _mm256_set1_epi8(Min); __m256i RangeV = _mm256_set1_epi8(Range), RADB_ROWS8_AVX2)
+RADB_FILTER_AVX2(radb_filter16_avx2, uint16_t, 32, __m256i MinV = _mm256_set1_epi16(Min); __m256i RangeV = _mm256_set1_epi16(Range), RADB_ROWS16_AVX2)
+RADB_FILTER_AVX2(radb_filter32_avx2, uint32_t, 8, __m256i MinV = _mm256_set1_epi32(Min); __m256i RangeV = _mm256_set1_epi32(Range), RADB_ROWS32_AVX2)
+RADB_FILTER_AVX2(radb_filter64_avx2, uint64_t, 4, __m256i MinV = _mm256_set1_epi64x(Min); __m256i SignV = _mm256_set1_epi64x(INT64_MIN); __m256i RangeV = _mm256_set1_epi64x(Range ^ INT64_MIN), RADB_ROWS64_AVX2)
+
+RADB_KERNEL_AVX2 static void radb_filter_double_avx2(const double *Values, size_t Count, double Min, double Max, uint64_t *Selection, int Combine) {
+	__m256d MinV = _mm256_set1_pd(Min), MaxV = _mm256_set1_pd(Max);
+	for (size_t I = 0; I < Count; I += 64, ++Selection) {
+		uint64_t Word = 0;
+		for (int J = 0; J < 64; J += 4) {
+			__m256d X = _mm256_loadu_pd(Values + I + J);
+			__m256d In = _mm256_and_pd(_mm256_cmp_pd(X, MinV, _CMP_GE_OQ), _mm256_cmp_pd(X, MaxV, _CMP_LE_OQ));
+			Word |= (uint64_t)_mm256_movemask_pd(In) << J;
+		}
+		radb_combine(Selection, Word, Combine);
+	}
+}
+
+// Sums widen 4 rows at a time to 64-bit lanes, partial words mask the lanes of unselected rows.
+RADB_KERNEL_AVX2 static inline __m256i radb_lanes_avx2(uint64_t Bits) {
+	__m256i Lanes = _mm256_set_epi64x(8, 4, 2, 1);
+	return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(Bits), Lanes), Lanes);
+}
+
+#define RADB_SUM_AVX2(NAME, VALUES, TYPE, LOAD) \
+RADB_KERNEL_AVX2 static uint64_t NAME(const VALUES *Values, size_t Count, const uint64_t *Selection) { \
+	const TYPE *V = Values; \
+	__m256i Acc = _mm256_setzero_si256(); \
+	for (size_t I = 0; I < Count; I += 64) { \
+		uint64_t Word = Selection ? Selection[I / 64] : ~(uint64_t)0; \
+		if (Word == ~(uint64_t)0) { \
+			for (int J = 0; J < 64; J += 4) Acc = _mm256_add_epi64(Acc, LOAD(V + I + J)); \
+		} else if (Word) { \
+			for (int J = 0; J < 64; J += 4) Acc = _mm256_add_epi64(Acc, _mm256_and_si256(LOAD(V + I + J), radb_lanes_avx2(Word >> J))); \
+		} \
+	} \
+	__m128i Sum = _mm_add_epi64(_mm256_castsi256_si128(Acc), _mm256_extracti128_si256(Acc, 1)); \
+	return (uint64_t)_mm_cvtsi128_si64(Sum) + (uint64_t)_mm_extract_epi64(Sum, 1); \
+}
+
+#define RADB_LOAD8_AVX2(P) _mm256_cvtepu8_epi64(_mm_loadu_si32(P))
+#define RADB_LOAD16_AVX2(P) _mm256_cvtepu16_epi64(_mm_loadl_epi64((const __m128i *)(P)))
+#define RADB_LOAD32_AVX2(P) _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(P)))
+#define RADB_LOAD64_AVX2(P) _mm256_loadu_si256((const __m256i *)(P))
+#define RADB_LOAD_INT32_AVX2(P) _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(P)))
+
+RADB_SUM_AVX2(radb_sum8_avx2, void, uint8_t, RADB_LOAD8_AVX2)
+RADB_SUM_AVX2(radb_sum16_avx2, void, uint16_t, RADB_LOAD16_AVX2)
+RADB_SUM_AVX2(radb_sum32_avx2, void, uint32_t, RADB_LOAD32_AVX2)
+RADB_SUM_AVX2(radb_sum64_avx2, void, uint64_t, RADB_LOAD64_AVX2)
+RADB_SUM_AVX2(radb_sum_int32_avx2, int32_t, int32_t, RADB_LOAD_INT32_AVX2)
+
+RADB_KERNEL_AVX2 static double radb_sum_double_avx2(const double *Values, size_t Count, const uint64_t *Selection) {
+	__m256d Acc = _mm256_setzero_pd();
+	for (size_t I = 0; I < Count; I += 64) {
+		uint64_t Word = Selection ? Selection[I / 64] : ~(uint64_t)0;
+		if (Word == ~(uint64_t)0) {
+			for (int J = 0; J < 64; J += 4) Acc = _mm256_add_pd(Acc, _mm256_loadu_pd(Values + I + J));
+		} else if (Word) {
+			for (int J = 0; J < 64; J += 4) {
+				__m256d X = _mm256_and_pd(_mm256_loadu_pd(Values + I + J), _mm256_castsi256_pd(radb_lanes_avx2(Word >> J)));
+				Acc = _mm256_add_pd(Acc, X);
+			}
+		}
+	}
+	__m128d Sum = _mm_add_pd(_mm256_castpd256_pd128(Acc), _mm256_extractf128_pd(Acc, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(Sum, _mm_unpackhi_pd(Sum, Sum)));
+}
+
+static const radb_kernels_t KernelsAVX2[1] = {{
+	"avx2", radb_compare_avx2, radb_hash_avx2, radb_find16_avx2, radb_probe16_avx2, radb_copy_avx2,
+	RADB_COLUMN_KERNELS(avx2)
+}};
+
+#define RADB_KERNEL_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+// Tails are handled with masked loads, which do not fault on the bytes which are not loaded.
+RADB_KERNEL_AVX512 static int radb_compare_avx512(const void *A, const void *B, size_t Length) {
+	const uint8_t *P = A, *Q = B;
+	while (Length) {
+		__mmask64 Load = Length >= 64 ? ~(__mmask64)0 : ((__mmask64)1 << Length) - 1;
+		__m512i X = _mm512_maskz_loadu_epi8(Load, P);
+		__m512i Y = _mm512_maskz_loadu_epi8(Load, Q);
+		uint64_t Mask = _mm512_cmpneq_epi8_mask(X, Y);
+		if (Mask) {
+			size_t I = __builtin_ctzll(Mask);
+			return P[I] - Q[I];
+		}
+		if (Length <= 64) break;
+		P += 64;
+		Q += 64;
+		Length -= 64;
+	}
+	return 0;
+}
+
+RADB_KERNEL_AVX512 static uint32_t radb_hash_avx512(uint32_t Hash, const void *Key, size_t Length) {
+	const uint8_t *P = Key;
+	size_t Pairs = Length / 32;
+	if (Pairs) {
+		__m512i Acc = _mm512_setzero_si512();
+		__m512i Scale = _mm512_set1_epi32(HashPowers[0] * 33);
+		__m512i Scale2 = _mm512_set1_epi32(radb_hash_scale(32));
+		for (size_t I = 0; I < Pairs; ++I, P += 32) {
+			__m512i X = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)P));
+			__m512i Y = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(P + 16)));
+			Acc = _mm512_add_epi32(_mm512_mullo_epi32(Acc, Scale2), _mm512_add_epi32(_mm512_mullo_epi32(X, Scale), Y));
+		}
+		Acc = _mm512_mullo_epi32(Acc, _mm512_load_si512(HashPowers));
+		Hash = Hash * radb_hash_scale(Pairs * 32) + (uint32_t)_mm512_reduce_add_epi32(Acc);
+		Length -= Pairs * 32;
+	}
+	return radb_hash_bytes(Hash, P, Length);
+}
+
+RADB_KERNEL_AVX512 static void radb_copy_avx512(void *Target, const void *Source, size_t Length) {
+	uint8_t *P = Target;
+	const uint8_t *Q = Source;
+	for (; Length >= 64; P += 64, Q += 64, Length -= 64) {
+		_mm512_storeu_si512(P, _mm512_loadu_si512(Q));
+	}
+	if (Length) {
+		__mmask64 Mask = ((__mmask64)1 << Length) - 1;
+		_mm512_mask_storeu_epi8(P, Mask, _mm512_maskz_loadu_epi8(Mask, Q));
+	}
+}
+
+#define RADB_FILTER_AVX512(NAME, TYPE, LANES, SETUP, ROWS) \
+RADB_KERNEL_AVX512 static void NAME(const void *Values, size_t Count, uint64_t Min, uint64_t Range, uint64_t *Selection, int Combine) { \
+	const TYPE *V = Values; \
+	SETUP; \
+	for (size_t I = 0; I < Count; I += 64, ++Selection) { \
+		uint64_t Word = 0; \
+		for (int J = 0; J < 64; J += LANES) Word |= (uint64_t)(ROWS(V + I + J)) << J; \
+		radb_combine(Selection, Word, Combine); \
+	} \
+}
+
+#define RADB_ROWS8_AVX512(P) _mm512_cmple_epu8_mask(_mm512_sub_epi8(_mm512_loadu_si512(P), MinV), RangeV)
+#define RADB_ROWS16_AVX512(P) _mm512_cmple_epu16_mask(_mm512_sub_epi16(_mm512_loadu_si512(P), MinV), RangeV)
+#define RADB_ROWS32_AVX512(P) _mm512_cmple_epu32_mask(_mm512_sub_epi32(_mm512_loadu_si512(P), MinV), RangeV)
+#define RADB_ROWS64_AVX512(P) _mm512_cmple_epu64_mask(_mm512_sub_epi64(_mm512_loadu_si512(P), MinV), RangeV)
+
+RADB_FILTER_AVX512(radb_filter8_avx512, uint8_t, 64, __m512i MinV = _mm512_set1_epi8(Min); __m512i RangeV = _mm512_set1_epi8(Range), RADB_ROWS8_AVX512)
+RADB_FILTER_AVX512(radb_filter16_avx512, uint16_t, 32, __m512i MinV = _mm512_set1_epi16(Min); __m512i RangeV = _mm512_set1_epi16(Range), RADB_ROWS16_AVX512)
+RADB_FILTER_AVX512(radb_filter32_avx512, uint32_t, 16, __m512i MinV = _mm512_set1_epi32(Min); __m512i RangeV = _mm512_set1_epi32(Range), RADB_ROWS32_AVX512)
+RADB_FILTER_AVX512(radb_filter64_avx512, uint64_t, 8, __m512i MinV = _mm512_set1_epi64(Min); __m512i RangeV = _mm512_set1_epi64(Range), RADB_ROWS64_AVX512)
+
+RADB_KERNEL_AVX512 static void radb_filter_double_avx512(const double *Values, size_t Count, double Min, double Max, uint64_t *Selection, int Combine) {
+	__m512d MinV = _mm512_set1_pd(Min), MaxV = _mm512_set1_pd(Max);
+	for (size_t I = 0; I < Count; I += 64, ++Selection) {
+		uint64_t Word = 0;
+		for (int J = 0; J < 64; J += 8) {
+			__m512d X = _mm512_loadu_pd(Values + I + J);
+			Word |= (uint64_t)_mm512_mask_cmp_pd_mask(_mm512_cmp_pd_mask(X, MinV, _CMP_GE_OQ), X, MaxV, _CMP_LE_OQ) << J;
+		}
+		radb_combine(Selection, Word, Combine);
+	}
+}
+
+// Selection words are used directly as lane masks, 8 rows at a time.
+#define RADB_SUM_AVX512(NAME, VALUES, TYPE, LOAD) \
+RADB_KERNEL_AVX512 static uint64_t NAME(const VALUES *Values, size_t Count, const uint64_t *Selection) { \
+	const TYPE *V = Values; \
+	__m512i Acc = _mm512_setzero_si512(); \
+	for (size_t I = 0; I < Count; I += 64) { \
+		uint64_t Word = Selection ? Selection[I / 64] : ~(uint64_t)0; \
+		if (!Word) continue; \
+		for (int J = 0; J < 64; J += 8) Acc = _mm512_mask_add_epi64(Acc, (__mmask8)(Word >> J), Acc, LOAD(V + I + J)); \
+	} \
+	return _mm512_reduce_add_epi64(Acc); \
+}
+
+#define RADB_LOAD8_AVX512(P) _mm512_cvtepu8_epi64(_mm_loadl_epi64((const __m128i *)(P)))
+#define RADB_LOAD16_AVX512(P) _mm512_cvtepu16_epi64(_mm_loadu_si128((const __m128i *)(P)))
+#define RADB_LOAD32_AVX512(P) _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(P)))
+#define RADB_LOAD64_AVX512(P) _mm512_loadu_si512(P)
+#define RADB_LOAD_INT32_AVX512(P) _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i *)(P)))
+
+RADB_SUM_AVX512(radb_sum8_avx512, void, uint8_t, RADB_LOAD8_AVX512)
+RADB_SUM_AVX512(radb_sum16_avx512, void, uint16_t, RADB_LOAD16_AVX512)
+RADB_SUM_AVX512(radb_sum32_avx512, void, uint32_t, RADB_LOAD32_AVX512)
+RADB_SUM_AVX512(radb_sum64_avx512, void, uint64_t, RADB_LOAD64_AVX512)
+RADB_SUM_AVX512(radb_sum_int32_avx512, int32_t, int32_t, RADB_LOAD_INT32_AVX512)
+
+RADB_KERNEL_AVX512 static double radb_sum_double_avx512(const double *Values, size_t Count, const uint64_t *Selection) {
+	__m512d Acc = _mm512_setzero_pd();
+	for (size_t I = 0; I < Count; I += 64) {
+		uint64_t Word = Selection ? Selection[I / 64] : ~(uint64_t)0;
+		if (!Word) continue;
+		for (int J = 0; J < 64; J += 8) Acc = _mm512_mask_add_pd(Acc, (__mmask8)(Word >> J), Acc, _mm512_loadu_pd(Values + I + J));
+	}
+	return _mm512_reduce_add_pd(Acc);
+}
+
+static const radb_kernels_t KernelsAVX512[1] = {{
+	"avx512", radb_compare_avx512, radb_hash_avx512, radb_find16_avx2, radb_probe16_avx2, radb_copy_avx512,
+	RADB_COLUMN_KERNELS(avx512)
+}};
+
+static const radb_kernels_t *radb_kernels_best(void) {
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return KernelsAVX512;
+	if (__builtin_cpu_supports("avx2")) return KernelsAVX2;
+	if (__builtin_cpu_supports("sse4.2")) return KernelsSSE42;
+	return KernelsScalar;
+}
+
+static const radb_kernels_t *const KernelsAll[] = {KernelsScalar, KernelsSSE42, KernelsAVX2, KernelsAVX512, NULL};
+
+#else
+
+static const radb_kernels_t *radb_kernels_best(void) {
+	return KernelsScalar;
+}
+
+static const radb_kernels_t *const KernelsAll[] = {KernelsScalar, NULL};
+
+#endif
+
+__attribute__((constructor)) static void radb_kernels_init(void) {
+	RadbKernels = radb_kernels_best();
+}
+
+const char *radb_get_kernels(void) {
+	return RadbKernels->Name;
+}
+
+int radb_set_kernels(const char *Name) {
+	const radb_kernels_t *Best = radb_kernels_best();
+	// The kernels are listed in order of preference, any up to the best supported one can be used.
+	for (const radb_kernels_t *const *Kernels = KernelsAll; *Kernels; ++Kernels) {
+		if (!strcmp((*Kernels)->Name, Name)) {
+			RadbKernels = *Kernels;
+			return 0;
+		}
+		if (*Kernels == Best) break;
+	}
+	return -1;
+}
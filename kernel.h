@@ -0,0 +1,98 @@
+#ifndef RADB_KERNEL_H
+#define RADB_KERNEL_H
+
+#include "common.h"
+#include <string.h>
+
+// Internal kernels for comparing, hashing, scanning and copying keys.
+// The library is built without SSE2, so vector versions are compiled separately for each
+// instruction set and the best one supported by the CPU is selected at startup.
+
+typedef struct {
+	const char *Name;
+	int (*compare)(const void *A, const void *B, size_t Length);
+	uint32_t (*hash)(uint32_t Hash, const void *Key, size_t Length);
+	size_t (*find16)(const uint8_t *Keys, size_t Count, uint8_t Key);
+	uint64_t (*probe16)(const uint8_t *Control, uint8_t Fingerprint);
+	void (*copy)(void *Target, const void *Source, size_t Length);
+	// Column kernels, indexed by the log2 of the value width. Count is a multiple of 64.
+	void (*filter[4])(const void *Values, size_t Count, uint64_t Min, uint64_t Range, uint64_t *Selection, int Combine);
+	void (*filter_double)(const double *Values, size_t Count, double Min, double Max, uint64_t *Selection, int Combine);
+	uint64_t (*sum[4])(const void *Values, size_t Count, const uint64_t *Selection);
+	uint64_t (*sum_int32)(const int32_t *Values, size_t Count, const uint64_t *Selection);
+	double (*sum_double)(const double *Values, size_t Count, const uint64_t *Selection);
+} radb_kernels_t;
+
+extern const radb_kernels_t *RadbKernels;
+
+// Shorter inputs are handled inline, the call through RadbKernels costs more than it saves.
+#define RADB_KERNEL_THRESHOLD 32
+
+// Compares 8 bytes at a time, returning the same sign as memcmp().
+static inline int radb_compare_words(const uint8_t *A, const uint8_t *B, size_t Length) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	while (Length >= 8) {
+		uint64_t X, Y;
+		memcpy(&X, A, sizeof(uint64_t));
+		memcpy(&Y, B, sizeof(uint64_t));
+		if (X != Y) return __builtin_bswap64(X) < __builtin_bswap64(Y) ? -1 : 1;
+		A += 8;
+		B += 8;
+		Length -= 8;
+	}
+#endif
+	for (; Length; --Length, ++A, ++B) if (*A != *B) return *A - *B;
+	return 0;
+}
+
+static inline uint32_t radb_hash_bytes(uint32_t Hash, const uint8_t *Bytes, size_t Length) {
+	for (size_t I = 0; I < Length; ++I) Hash = ((Hash << 5) + Hash) + Bytes[I];
+	return Hash;
+}
+
+static inline int radb_compare(const void *A, const void *B, size_t Length) {
+	if (Length < RADB_KERNEL_THRESHOLD) return radb_compare_words(A, B, Length);
+	return RadbKernels->compare(A, B, Length);
+}
+
+// Continues a DJB2 hash (starting from 5381) over Length more bytes.
+static inline uint32_t radb_hash(uint32_t Hash, const void *Key, size_t Length) {
+	if (Length < RADB_KERNEL_THRESHOLD) return radb_hash_bytes(Hash, Key, Length);
+	return RadbKernels->hash(Hash, Key, Length);
+}
+
+// Returns the position of Key within the first Count (at most 16) bytes of Keys or Count if not found.
+// All 16 bytes of Keys must be readable.
+static inline size_t radb_find16(const uint8_t *Keys, size_t Count, uint8_t Key) {
+	return RadbKernels->find16(Keys, Count, Key);
+}
+
+// Scans a group of 16 control bytes of a swiss table, returning bit masks of the bytes equal to
+// Fingerprint (bits 0-15), equal to 0x80 (bits 16-31) and with their top bit set (bits 32-47).
+static inline uint64_t radb_probe16(const uint8_t *Control, uint8_t Fingerprint) {
+	return RadbKernels->probe16(Control, Fingerprint);
+}
+
+static inline void radb_copy(void *Target, const void *Source, size_t Length) {
+	if (Length < RADB_KERNEL_THRESHOLD) {
+		memcpy(Target, Source, Length);
+	} else {
+		RadbKernels->copy(Target, Source, Length);
+	}
+}
+
+// Selection bitmaps have one bit per row, 64 rows per word. New words are combined with the
+// existing ones as with column_combine_t.
+#define RADB_COMBINE_SET 0
+#define RADB_COMBINE_AND 1
+#define RADB_COMBINE_OR 2
+
+static inline void radb_combine(uint64_t *Selection, uint64_t Word, int Combine) {
+	switch (Combine) {
+	case RADB_COMBINE_AND: *Selection &= Word; break;
+	case RADB_COMBINE_OR: *Selection |= Word; break;
+	default: *Selection = Word; break;
+	}
+}
+
+#endif
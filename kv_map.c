@@ -0,0 +1,285 @@
+#include "kv_map.h"
+#include "string_store.h"
+#include "linear_index_inline.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// A linear hash table with the same bucket layout and splitting as linear_index_t,
+// except that each node is followed by its value so that a lookup touches a single node.
+// The node's Value is the index of the key and its Key is the signature.
+
+#define KV_VALUE(NODE) ((void *)((NODE) + 1))
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumOffsets, NumEntries;
+	uint32_t NumNodes, NextFree;
+	uint32_t Count, NodeSize;
+	uint32_t ValueSize, Reserved;
+	// Nodes are NodeSize bytes apart, see kv_map_node().
+	linear_node_t Nodes[];
+} kv_header_t;
+
+struct kv_map_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	kv_header_t *Header;
+	string_store_t *Keys;
+	size_t NodeSize;
+	size_t HeaderSize;
+	int HeaderFd;
+	radb_stats_t Stats[1];
+};
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define KV_MAP_SIGNATURE 0x504D564B
+#define KV_MAP_VERSION MAKE_VERSION(1, 0)
+
+#define PAGE_SIZE 4096
+
+kv_map_t *kv_map_create(const char *Prefix, size_t ValueSize, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
+#if defined(RADB_MEM_MALLOC)
+	kv_map_t *Map = malloc(sizeof(kv_map_t));
+	Map->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	kv_map_t *Map = GC_malloc(sizeof(kv_map_t));
+	Map->Prefix = GC_strdup(Prefix);
+#else
+	kv_map_t *Map = alloc(Allocator, sizeof(kv_map_t));
+	Map->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Map->Allocator = Allocator;
+	Map->alloc = alloc;
+	Map->alloc_atomic = alloc_atomic;
+	Map->free = free;
+#endif
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.kv", Prefix);
+	memset(Map->Stats, 0, sizeof(radb_stats_t));
+	Map->NodeSize = sizeof(linear_node_t) + ((ValueSize + 7) & ~7);
+	Map->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Map->HeaderSize = ((sizeof(kv_header_t) + Map->NodeSize + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+	ftruncate(Map->HeaderFd, Map->HeaderSize);
+	Map->Header = mmap(NULL, Map->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Map->HeaderFd, 0);
+	Map->Header->Signature = KV_MAP_SIGNATURE;
+	Map->Header->Version = KV_MAP_VERSION;
+	Map->Header->NumNodes = (Map->HeaderSize - sizeof(kv_header_t)) / Map->NodeSize;
+	Map->Header->NumOffsets = 1;
+	Map->Header->NumEntries = 0;
+	Map->Header->NextFree = INVALID_INDEX;
+	Map->Header->Count = 0;
+	Map->Header->NodeSize = Map->NodeSize;
+	Map->Header->ValueSize = ValueSize;
+	Map->Header->Nodes[0].Offset = INVALID_INDEX;
+	Map->Keys = string_store_create(Prefix, KeySize, ChunkSize RADB_MEM_ARGS);
+	return Map;
+}
+
+kv_map_open_t kv_map_open2(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.kv", Prefix);
+	if (stat(FileName, Stat)) return (kv_map_open_t){NULL, RADB_FILE_NOT_FOUND};
+	if (Stat->st_size < sizeof(kv_header_t)) return (kv_map_open_t){NULL, RADB_HEADER_CORRUPTED};
+	string_store_open_t KeysOpen = string_store_open2(Prefix RADB_MEM_ARGS);
+	if (!KeysOpen.Store) return (kv_map_open_t){NULL, KeysOpen.Error + 3};
+#if defined(RADB_MEM_MALLOC)
+	kv_map_t *Map = malloc(sizeof(kv_map_t));
+	Map->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	kv_map_t *Map = GC_malloc(sizeof(kv_map_t));
+	Map->Prefix = GC_strdup(Prefix);
+#else
+	kv_map_t *Map = alloc(Allocator, sizeof(kv_map_t));
+	Map->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Map->Allocator = Allocator;
+	Map->alloc = alloc;
+	Map->alloc_atomic = alloc_atomic;
+	Map->free = free;
+#endif
+	memset(Map->Stats, 0, sizeof(radb_stats_t));
+	Map->HeaderFd = open(FileName, O_RDWR, 0777);
+	Map->HeaderSize = Stat->st_size;
+	Map->Header = mmap(NULL, Map->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Map->HeaderFd, 0);
+	Map->Keys = KeysOpen.Store;
+	Map->NodeSize = Map->Header->NodeSize;
+	if (Map->Header->Signature != KV_MAP_SIGNATURE) {
+		kv_map_close(Map);
+		return (kv_map_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+	return (kv_map_open_t){Map, RADB_SUCCESS};
+}
+
+kv_map_t *kv_map_open(const char *Prefix RADB_MEM_PARAMS) {
+	return kv_map_open2(Prefix RADB_MEM_ARGS).Map;
+}
+
+void kv_map_close(kv_map_t *Map) {
+	string_store_close(Map->Keys);
+	radb_sync(Map->Header, Map->HeaderSize);
+	munmap(Map->Header, Map->HeaderSize);
+	close(Map->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Map->Prefix);
+	free(Map);
+#elif defined(RADB_MEM_GC)
+#else
+	Map->free(Map->Allocator, (void *)Map->Prefix);
+	Map->free(Map->Allocator, Map);
+#endif
+}
+
+size_t kv_map_num_entries(kv_map_t *Map) {
+	return Map->Header->Count;
+}
+
+size_t kv_map_value_size(kv_map_t *Map) {
+	return Map->Header->ValueSize;
+}
+
+size_t kv_map_key_size(kv_map_t *Map, size_t Index) {
+	return string_store_size(Map->Keys, Index);
+}
+
+size_t kv_map_key_get(kv_map_t *Map, size_t Index, void *Buffer, size_t Space) {
+	return string_store_get(Map->Keys, Index, Buffer, Space);
+}
+
+// Short keys are stored in full in the signature with their length in the last byte,
+// longer keys store their first 15 bytes and are compared against the key store.
+static inline uint32_t kv_map_signature(const char *String, size_t Length, linear_key_t Signature) {
+	const unsigned char *Bytes = (const unsigned char *)String;
+	uint32_t Hash = radb_hash(5381, Bytes, Length);
+	memset(Signature, 0, LINEAR_KEY_SIZE);
+	if (Length >= LINEAR_KEY_SIZE) {
+		memcpy(Signature, Bytes, LINEAR_KEY_SIZE - 1);
+		Signature[LINEAR_KEY_SIZE - 1] = 0xFF;
+	} else {
+		memcpy(Signature, Bytes, Length);
+		Signature[LINEAR_KEY_SIZE - 1] = Length;
+	}
+	return Hash;
+}
+
+static inline size_t kv_map_bucket(kv_header_t *Header, uint32_t Hash) {
+	size_t NumOffsets = Header->NumOffsets;
+	size_t Scale = NumOffsets > 1 ? 1 << (64 - __builtin_clzl(NumOffsets - 1)) : 1;
+	size_t Index = Hash & (Scale - 1);
+	if (Index >= NumOffsets) Index -= (Scale >> 1);
+	return Index;
+}
+
+static inline int kv_map_match(kv_map_t *Map, linear_node_t *Entry, uint32_t Hash, const linear_key_t Signature, const char *String, size_t Length) {
+	if (Entry->Hash != Hash || memcmp(Entry->Key, Signature, LINEAR_KEY_SIZE)) return 0;
+	if (Length < LINEAR_KEY_SIZE) return 1;
+	return !string_store_compare(Map->Keys, String, Length, Entry->Value);
+}
+
+static void kv_map_grow_nodes(kv_map_t *Map, size_t Target) {
+	if (Target > Map->Header->NumNodes) {
+		size_t Required = Target - Map->Header->NumNodes;
+		size_t Allocation = ((Required * Map->NodeSize + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+		size_t HeaderSize = Map->HeaderSize + Allocation;
+		radb_truncate(Map->Stats, Map->HeaderFd, HeaderSize);
+		Map->Header = radb_remap(Map->Stats, Map->HeaderFd, Map->Header, Map->HeaderSize, HeaderSize);
+		Map->Header->NumNodes = (HeaderSize - sizeof(kv_header_t)) / Map->NodeSize;
+		Map->HeaderSize = HeaderSize;
+	}
+}
+
+LINEAR_TABLE_METHODS(kv_map, kv_map_t, Store->NodeSize, kv_map_grow_nodes)
+
+static void kv_map_add_offset(kv_map_t *Map) {
+	if (Map->Header->NumOffsets < Map->Header->Count) kv_map_split(Map);
+}
+
+static linear_node_t *kv_map_find(kv_map_t *Map, uint32_t Hash, const linear_key_t Signature, const char *String, size_t Length) {
+	size_t Index = kv_map_bucket(Map->Header, Hash);
+	size_t Offset = kv_map_node(Map, Index)->Offset;
+	if (Offset == INVALID_INDEX) return NULL;
+	linear_node_t *Last = kv_map_node(Map, Map->Header->NumEntries);
+	for (linear_node_t *Entry = kv_map_node(Map, Offset); Entry < Last; Entry = (linear_node_t *)((char *)Entry + Map->NodeSize)) {
+		if (Entry->Index != Index) return NULL;
+		if (kv_map_match(Map, Entry, Hash, Signature, String, Length)) return Entry;
+	}
+	return NULL;
+}
+
+// Returns the node for the key, adding it with a zeroed value if required.
+// The node is only valid until the next insertion.
+static linear_node_t *kv_map_insert(kv_map_t *Map, const char *String, size_t Length, int *Created) {
+	linear_key_t Signature;
+	uint32_t Hash = kv_map_signature(String, Length, Signature);
+	size_t Index = kv_map_bucket(Map->Header, Hash);
+	size_t Offset = kv_map_node(Map, Index)->Offset;
+	size_t Stop = Offset;
+	if (Offset != INVALID_INDEX) {
+		size_t Last = Map->Header->NumEntries;
+		for (Stop = Offset; Stop < Last; ++Stop) {
+			linear_node_t *Entry = kv_map_node(Map, Stop);
+			if (Entry->Index != Index) break;
+			if (kv_map_match(Map, Entry, Hash, Signature, String, Length)) {
+				*Created = 0;
+				return Entry;
+			}
+		}
+	}
+	linear_node_t *Entry = kv_map_add_node(Map, Index, Hash, Signature, Stop);
+	size_t Key = string_store_alloc(Map->Keys);
+	string_store_set(Map->Keys, Key, String, Length);
+	Entry->Value = Key;
+	memset(KV_VALUE(Entry), 0, Map->NodeSize - sizeof(linear_node_t));
+	// Splitting may move the new node, so it is found again afterwards.
+	size_t Position = ((char *)Entry - (char *)Map->Header->Nodes) / Map->NodeSize;
+	size_t NumOffsets = Map->Header->NumOffsets;
+	kv_map_add_offset(Map);
+	*Created = 1;
+	if (Map->Header->NumOffsets == NumOffsets) return kv_map_node(Map, Position);
+	return kv_map_find(Map, Hash, Signature, String, Length);
+}
+
+const void *kv_map_get(kv_map_t *Map, const char *Key, size_t Length) {
+	if (!Length) Length = strlen(Key);
+	linear_key_t Signature;
+	uint32_t Hash = kv_map_signature(Key, Length, Signature);
+	linear_node_t *Entry = kv_map_find(Map, Hash, Signature, Key, Length);
+	return Entry ? KV_VALUE(Entry) : NULL;
+}
+
+index_result_t kv_map_put(kv_map_t *Map, const char *Key, size_t Length, const void *Value) {
+	if (!Length) Length = strlen(Key);
+	int Created;
+	linear_node_t *Entry = kv_map_insert(Map, Key, Length, &Created);
+	memcpy(KV_VALUE(Entry), Value, Map->Header->ValueSize);
+	return (index_result_t){Entry->Value, Created};
+}
+
+void *kv_map_update_inplace(kv_map_t *Map, const char *Key, size_t Length) {
+	if (!Length) Length = strlen(Key);
+	int Created;
+	return KV_VALUE(kv_map_insert(Map, Key, Length, &Created));
+}
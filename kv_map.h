@@ -0,0 +1,32 @@
+#ifndef KV_MAP_H
+#define KV_MAP_H
+
+#include "config.h"
+#include "common.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+typedef struct kv_map_t kv_map_t;
+
+kv_map_t *kv_map_create(const char *Prefix, size_t ValueSize, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS);
+kv_map_t *kv_map_open(const char *Prefix RADB_MEM_PARAMS);
+size_t kv_map_num_entries(kv_map_t *Map);
+#define kv_map_count kv_map_num_entries
+size_t kv_map_value_size(kv_map_t *Map);
+void kv_map_close(kv_map_t *Map);
+
+typedef struct {
+	kv_map_t *Map;
+	radb_error_t Error;
+} kv_map_open_t;
+
+kv_map_open_t kv_map_open2(const char *Prefix RADB_MEM_PARAMS);
+
+const void *kv_map_get(kv_map_t *Map, const char *Key, size_t Length);
+index_result_t kv_map_put(kv_map_t *Map, const char *Key, size_t Length, const void *Value);
+void *kv_map_update_inplace(kv_map_t *Map, const char *Key, size_t Length);
+
+size_t kv_map_key_size(kv_map_t *Map, size_t Index);
+size_t kv_map_key_get(kv_map_t *Map, size_t Index, void *Buffer, size_t Space);
+
+#endif
@@ -1,4 +1,4 @@
-#include "linear_index.h"
+#include "linear_index_inline.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -8,38 +8,6 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
-typedef struct {
-	uint32_t Offset;
-	uint32_t Index;
-	uint32_t Hash;
-	uint32_t Value;
-	linear_key_t Key;
-} linear_node_t;
-
-typedef struct {
-	uint32_t Signature, Version;
-	uint32_t NumOffsets, NumEntries;
-	uint32_t NumNodes, NextFree;
-	uint32_t Count, Extra;
-	linear_node_t Nodes[];
-} linear_header_t;
-
-struct linear_index_t {
-#ifdef RADB_MEM_PER_STORE
-	void *Allocator;
-	void *(*alloc)(void *, size_t);
-	void *(*alloc_atomic)(void *, size_t);
-	void (*free)(void *, void *);
-#endif
-	const char *Prefix;
-	linear_header_t *Header;
-	void *Keys;
-	linear_compare_t Compare;
-	linear_insert_t Insert;
-	size_t HeaderSize;
-	int HeaderFd;
-};
-
 #ifdef RADB_MEM_GC
 #include <gc/gc.h>
 #endif
@@ -58,9 +26,45 @@ static inline const char *radb_strdup(const char *String, void *Allocator, void
 #define LINEAR_INDEX_SIGNATURE 0x494C4152
 #define LINEAR_INDEX_VERSION MAKE_VERSION(1, 0)
 
+#define LINEAR_SWISS_SIGNATURE 0x53494C52
+#define LINEAR_SWISS_VERSION MAKE_VERSION(1, 0)
+
 #define PAGE_SIZE 4096
 
-linear_index_t *linear_index_create(const char *Prefix, void *Keys RADB_MEM_PARAMS) {
+static void linear_index_filter_rebuild(linear_index_t *Store, size_t Capacity) {
+	radb_filter_resize(Store->Filter, Store->Stats, Capacity);
+	radb_filter_header_t *Filter = Store->Filter->Header;
+	if (Store->Swiss) {
+		linear_swiss_t *Header = Store->Swiss;
+		linear_slot_t *Slots = LINEAR_SWISS_SLOTS(Header);
+		for (size_t I = 0; I < Header->Size; ++I) {
+			if (Header->Control[I] < LINEAR_SWISS_EMPTY) radb_filter_add(Filter, Slots[I].Hash);
+		}
+		Filter->Valid = 1;
+		return;
+	}
+	linear_node_t *Nodes = Store->Header->Nodes;
+	for (size_t I = 0; I < Store->Header->NumEntries; ++I) {
+		if (Nodes[I].Index != INVALID_INDEX) radb_filter_add(Filter, Nodes[I].Hash);
+	}
+	Filter->Valid = 1;
+}
+
+static linear_swiss_t *linear_swiss_create(linear_index_t *Store, int Fd, size_t Size, size_t *HeaderSize) {
+	*HeaderSize = sizeof(linear_swiss_t) + Size * (1 + sizeof(linear_slot_t));
+	radb_truncate(Store->Stats, Fd, *HeaderSize);
+	linear_swiss_t *Header = mmap(NULL, *HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	Header->Signature = LINEAR_SWISS_SIGNATURE;
+	Header->Version = LINEAR_SWISS_VERSION;
+	Header->Size = Header->Space = Size;
+	Header->Deleted = 0;
+	Header->Count = 0;
+	Header->Extra = 0;
+	memset(Header->Control, LINEAR_SWISS_EMPTY, Size);
+	return Header;
+}
+
+linear_index_t *linear_index_create_engine(const char *Prefix, void *Keys, linear_index_engine_t Engine RADB_MEM_PARAMS) {
 #if defined(RADB_MEM_MALLOC)
 	linear_index_t *Store = malloc(sizeof(linear_index_t));
 	Store->Prefix = strdup(Prefix);
@@ -77,7 +81,19 @@ linear_index_t *linear_index_create(const char *Prefix, void *Keys RADB_MEM_PARA
 #endif
 	char FileName[strlen(Prefix) + 10];
 	sprintf(FileName, "%s.index2", Prefix);
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Store->Filter->Header = NULL;
+	sprintf(FileName, "%s.filter", Prefix);
+	unlink(FileName);
+	Store->Keys = Keys;
+	Store->Methods = NULL;
+	if (Engine == LINEAR_INDEX_SWISS) {
+		Store->Header = NULL;
+		Store->Swiss = linear_swiss_create(Store, Store->HeaderFd, 4 * LINEAR_SWISS_GROUP, &Store->HeaderSize);
+		return Store;
+	}
+	Store->Swiss = NULL;
 	Store->HeaderSize = PAGE_SIZE;
 	ftruncate(Store->HeaderFd, Store->HeaderSize);
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
@@ -89,10 +105,13 @@ linear_index_t *linear_index_create(const char *Prefix, void *Keys RADB_MEM_PARA
 	Store->Header->NextFree = INVALID_INDEX;
 	Store->Header->Count = 0;
 	Store->Header->Nodes[0].Index = INVALID_INDEX;
-	Store->Keys = Keys;
 	return Store;
 }
 
+linear_index_t *linear_index_create(const char *Prefix, void *Keys RADB_MEM_PARAMS) {
+	return linear_index_create_engine(Prefix, Keys, LINEAR_INDEX_LINEAR RADB_MEM_ARGS);
+}
+
 linear_index_open_t linear_index_open2(const char *Prefix, void *Keys RADB_MEM_PARAMS) {
 	struct stat Stat[1];
 	char FileName[strlen(Prefix) + 10];
@@ -112,15 +131,25 @@ linear_index_open_t linear_index_open2(const char *Prefix, void *Keys RADB_MEM_P
 	Store->alloc_atomic = alloc_atomic;
 	Store->free = free;
 #endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR, 0777);
 	Store->HeaderSize = Stat->st_size;
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-	if (Store->Header->Signature != LINEAR_INDEX_SIGNATURE) {
+	Store->Swiss = NULL;
+	if (Store->Header->Signature == LINEAR_SWISS_SIGNATURE) {
+		Store->Swiss = (linear_swiss_t *)Store->Header;
+		Store->Header = NULL;
+	} else if (Store->Header->Signature != LINEAR_INDEX_SIGNATURE) {
 		munmap(Store->Header, Store->HeaderSize);
 		close(Store->HeaderFd);
 		return (linear_index_open_t){NULL, RADB_HEADER_MISMATCH};
 	}
 	Store->Keys = Keys;
+	Store->Methods = NULL;
+	sprintf(FileName, "%s.filter", Prefix);
+	if (!radb_filter_open(Store->Filter, FileName) && !Store->Filter->Header->Valid) {
+		linear_index_filter_rebuild(Store, Store->Filter->Header->Capacity);
+	}
 	return (linear_index_open_t){Store, RADB_SUCCESS};
 }
 
@@ -129,8 +158,10 @@ linear_index_t *linear_index_open(const char *Prefix, void *Keys RADB_MEM_PARAMS
 }
 
 void linear_index_close(linear_index_t *Store) {
-	msync(Store->Header, Store->HeaderSize, MS_SYNC);
-	munmap(Store->Header, Store->HeaderSize);
+	if (Store->Filter->Header) radb_filter_close(Store->Filter);
+	void *Mapping = Store->Swiss ? (void *)Store->Swiss : (void *)Store->Header;
+	radb_sync(Mapping, Store->HeaderSize);
+	munmap(Mapping, Store->HeaderSize);
 	close(Store->HeaderFd);
 #if defined(RADB_MEM_MALLOC)
 	free((void *)Store->Prefix);
@@ -150,12 +181,32 @@ void linear_index_set_insert(linear_index_t *Store, linear_insert_t Insert) {
 	Store->Insert = Insert;
 }
 
+void linear_index_set_filter(linear_index_t *Store, double Rate) {
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.filter", Store->Prefix);
+	if (Store->Filter->Header) radb_filter_close(Store->Filter);
+	if (Rate <= 0 || Rate >= 1) {
+		unlink(FileName);
+		return;
+	}
+	radb_filter_create(Store->Filter, FileName, Rate);
+	linear_index_filter_rebuild(Store, 2 * linear_index_count(Store));
+}
+
 void linear_index_set_extra(linear_index_t *Store, uint32_t Value) {
-	Store->Header->Extra = Value;
+	if (Store->Swiss) {
+		Store->Swiss->Extra = Value;
+	} else {
+		Store->Header->Extra = Value;
+	}
 }
 
 uint32_t linear_index_get_extra(linear_index_t *Store) {
-	return Store->Header->Extra;
+	return Store->Swiss ? Store->Swiss->Extra : Store->Header->Extra;
+}
+
+linear_index_engine_t linear_index_engine(linear_index_t *Store) {
+	return Store->Swiss ? LINEAR_INDEX_SWISS : LINEAR_INDEX_LINEAR;
 }
 
 void *linear_index_keys(linear_index_t *Store) {
@@ -163,189 +214,138 @@ void *linear_index_keys(linear_index_t *Store) {
 }
 
 size_t linear_index_count(linear_index_t *Store) {
-	return Store->Header->Count;
+	return Store->Swiss ? Store->Swiss->Count : Store->Header->Count;
 }
 
 size_t linear_index_search(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full) {
-	size_t NumOffset = Store->Header->NumOffsets;
-	size_t Scale = NumOffset > 1 ? 1 << (64 - __builtin_clzl(NumOffset - 1)) : 1;
-	size_t Index = Hash & (Scale - 1);
-	if (Index >= NumOffset) Index -= (Scale >> 1);
-	linear_node_t *Nodes = Store->Header->Nodes;
-	size_t Offset = Nodes[Index].Offset;
-	if (Offset == INVALID_INDEX) return INVALID_INDEX;
-	linear_node_t *Last = Nodes + Store->Header->NumEntries;
-	for (linear_node_t *Entry = Nodes + Offset; Entry < Last; ++Entry) {
-		if (Entry->Index == INVALID_INDEX) {
-			return INVALID_INDEX;
-		} else if (Entry->Index != Index) {
-			return INVALID_INDEX;
-		} else if (Entry->Hash == Hash && !memcmp(Entry->Key, Key, sizeof(linear_key_t)) && !Store->Compare(Store->Keys, Full, Entry->Value)) {
-			return Entry->Value;
-		}
-	}
-	return INVALID_INDEX;
+	return linear_index_search_inline(Store, Hash, Key, Full, Store->Compare);
 }
 
-static linear_node_t *linear_index_grow_nodes(linear_index_t *Store, size_t Target) {
+static void linear_index_grow_nodes(linear_index_t *Store, size_t Target) {
 	if (Target > Store->Header->NumNodes) {
 		size_t Required = Target - Store->Header->NumNodes;
 		size_t Allocation = ((Required * sizeof(linear_node_t) + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
 		size_t HeaderSize = Store->HeaderSize + Allocation;
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
+		radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+		Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
 		Store->Header->NumNodes = (HeaderSize - sizeof(linear_header_t)) / sizeof(linear_node_t);
 		Store->HeaderSize = HeaderSize;
 	}
-	return Store->Header->Nodes;
 }
 
-static void linear_index_add_offset(linear_index_t *Store) {
-	size_t NumOffsets = Store->Header->NumOffsets;
-	if (NumOffsets >= Store->Header->Count) return;
-	size_t Scale = 1 << (64 - __builtin_clzl(NumOffsets));
-	size_t Shift = Scale >> 1;
-	size_t Index = Scale > NumOffsets ? NumOffsets - Shift : NumOffsets & (Scale - 1);
-	linear_node_t *Nodes = linear_index_grow_nodes(Store, NumOffsets + 1);
-	size_t Offset = Nodes[Index].Offset;
-	if (Offset == INVALID_INDEX) {
-		Nodes[Store->Header->NumOffsets++].Offset = INVALID_INDEX;
-		return;
-	}
-	linear_node_t *First = Nodes + Offset, *Last = First, *A = First;
-	linear_node_t *Limit = Nodes + Store->Header->NumEntries;
-	while (Last < Limit) {
-		if (Last->Index != Index) break;
-		++Last;
-	}
-	linear_node_t *B = Last;
-	Store->Header->NumOffsets = ++NumOffsets;
-	while (A < B) {
-		size_t NewIndex = A->Hash & (Scale - 1);
-		if (NewIndex >= NumOffsets) NewIndex -= Shift;
-		if (NewIndex == Index) {
-			++A;
-		} else {
-			--B;
-			uint32_t TempHash = A->Hash;
-			A->Hash = B->Hash;
-			B->Hash = TempHash;
-			uint32_t TempValue = A->Value;
-			A->Value = B->Value;
-			B->Value = TempValue;
-			linear_key_t TempKey;
-			memcpy(TempKey, A->Key, sizeof(linear_key_t));
-			memcpy(A->Key, B->Key, sizeof(linear_key_t));
-			memcpy(B->Key, TempKey, sizeof(linear_key_t));
-			B->Index = NewIndex;
-		}
-	}
-	if (B == Last) {
-		Nodes[NumOffsets - 1].Offset = INVALID_INDEX;
-	} else {
-		if (B == First) Nodes[Index].Offset = INVALID_INDEX;
-		Nodes[NumOffsets - 1].Offset = B - Nodes;
+LINEAR_TABLE_METHODS(linear_table, linear_index_t, sizeof(linear_node_t), linear_index_grow_nodes)
+
+void linear_index_add_offset(linear_index_t *Store) {
+	if (Store->Header->NumOffsets >= Store->Header->Count) return;
+	RADB_PROBE1(linear_index_split, Store->Header->NumOffsets);
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_SPLIT);
+	linear_table_split(Store);
+}
+
+void linear_index_filter_add(linear_index_t *Store, uint32_t Hash) {
+	radb_filter_header_t *Filter = Store->Filter->Header;
+	if (linear_index_count(Store) >= Filter->Capacity) {
+		linear_index_filter_rebuild(Store, 2 * Filter->Capacity);
+		Filter = Store->Filter->Header;
 	}
+	radb_filter_add(Filter, Hash);
 }
 
-static index_result_t linear_index_add_entry(linear_index_t *Store, uint32_t Index, uint32_t Hash, const linear_key_t Key, const void *Full) {
-	linear_node_t *Nodes = linear_index_grow_nodes(Store, Store->Header->NumEntries + 1);
-	size_t Offset = Store->Header->NumEntries++;
-	linear_node_t *Entry = Nodes + Offset;
-	Entry->Index = Index;
-	Entry->Hash = Hash;
-	memcpy(Entry->Key, Key, sizeof(linear_key_t));
-	uint32_t Insert = Entry->Value = Store->Insert(Store->Keys, Full);
-	linear_index_add_offset(Store);
-	return (index_result_t){Insert, 1};
+// The caller sets the node's value and then calls linear_index_add_offset().
+linear_node_t *linear_index_add_node(linear_index_t *Store, uint32_t Index, uint32_t Hash, const linear_key_t Key, size_t Stop) {
+	return linear_table_add_node(Store, Index, Hash, Key, Stop);
 }
 
 index_result_t linear_index_insert2(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full) {
-	size_t NumOffsets = Store->Header->NumOffsets;
-	size_t Scale = NumOffsets > 1 ? 1 << (64 - __builtin_clzl(NumOffsets - 1)) : 1;
-	size_t Index = Hash & (Scale - 1);
-	if (Index >= NumOffsets) Index -= (Scale >> 1);
-	linear_node_t *Nodes = Store->Header->Nodes;
-	size_t Offset = Nodes[Index].Offset;
-	if (Offset == INVALID_INDEX) {
-		++Store->Header->Count;
-		size_t Free = Store->Header->NextFree;
-		if (Free != INVALID_INDEX && Nodes[Free].Index == INVALID_INDEX) {
-			Store->Header->NextFree = Nodes[Free].Value;
-			Nodes[Index].Offset = Free;
-			Nodes[Free].Index = Index;
-			Nodes[Free].Hash = Hash;
-			memcpy(Nodes[Free].Key, Key, sizeof(linear_key_t));
-			uint32_t Insert = Nodes[Free].Value = Store->Insert(Store->Keys, Full);
-			linear_index_add_offset(Store);
-			return (index_result_t){Insert, 1};
-		} else {
-			Nodes[Index].Offset = Store->Header->NumEntries;
-			return linear_index_add_entry(Store, Index, Hash, Key, Full);
+	return linear_index_insert_inline(Store, Hash, Key, Full, Store->Compare, Store->Insert);
+}
+
+size_t linear_index_insert(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full) {
+	return linear_index_insert2(Store, Hash, Key, Full).Index;
+}
+
+static void linear_index_filter_delete(linear_index_t *Store) {
+	radb_filter_header_t *Filter = Store->Filter->Header;
+	if (++Filter->Deleted > Filter->Capacity / 4) linear_index_filter_rebuild(Store, Filter->Capacity);
+}
+
+void linear_swiss_rebuild(linear_index_t *Store) {
+	linear_swiss_t *Old = Store->Swiss;
+	size_t Size = Old->Size;
+	// Tables with many deleted slots are rebuilt at the same size.
+	if (Old->Deleted < Size >> 2) Size *= 2;
+	uint64_t Start = radb_time();
+	char FileName[strlen(Store->Prefix) + 20];
+	sprintf(FileName, "%s.swiss.temp", Store->Prefix);
+	int HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	size_t HeaderSize;
+	linear_swiss_t *New = linear_swiss_create(Store, HeaderFd, Size, &HeaderSize);
+	New->Count = Old->Count;
+	New->Extra = Old->Extra;
+	linear_slot_t *OldSlots = LINEAR_SWISS_SLOTS(Old);
+	linear_slot_t *NewSlots = LINEAR_SWISS_SLOTS(New);
+	size_t Mask = Size / LINEAR_SWISS_GROUP - 1;
+	for (size_t I = 0; I < Old->Size; ++I) {
+		if (Old->Control[I] >= LINEAR_SWISS_EMPTY) continue;
+		size_t Group = (linear_swiss_mix(OldSlots[I].Hash) >> 32) & Mask;
+		for (size_t Step = 1;; ++Step) {
+			uint32_t Free = radb_probe16(New->Control + Group * LINEAR_SWISS_GROUP, 0) >> 32;
+			if (Free) {
+				size_t Index = Group * LINEAR_SWISS_GROUP + __builtin_ctz(Free);
+				New->Control[Index] = Old->Control[I];
+				NewSlots[Index] = OldSlots[I];
+				--New->Space;
+				break;
+			}
+			Group = (Group + Step) & Mask;
 		}
 	}
-	linear_node_t *Last = Nodes + Store->Header->NumEntries;
-	for (linear_node_t *Entry = Nodes + Offset; Entry < Last; ++Entry) {
-		if (Entry->Index == INVALID_INDEX) {
-			++Store->Header->Count;
-			Entry->Index = Index;
-			Entry->Hash = Hash;
-			memcpy(Entry->Key, Key, sizeof(linear_key_t));
-			uint32_t Insert = Entry->Value = Store->Insert(Store->Keys, Full);
-			linear_index_add_offset(Store);
-			return (index_result_t){Insert, 1};
-		} else if (Entry->Index != Index) {
-			++Store->Header->Count;
-			if (Offset > 0 && Nodes[Offset - 1].Index == INVALID_INDEX) {
-				Nodes[Index].Offset = Offset - 1;
-				linear_node_t *Entry2 = Nodes + (Offset - 1);
-				Entry2->Index = Index;
-				Entry2->Hash = Hash;
-				memcpy(Entry2->Key, Key, sizeof(linear_key_t));
-				uint32_t Insert = Entry2->Value = Store->Insert(Store->Keys, Full);
-				linear_index_add_offset(Store);
-				return (index_result_t){Insert, 1};
-			} else {
-				size_t Count = (Entry - Nodes) - Offset;
-				Nodes = linear_index_grow_nodes(Store, Store->Header->NumEntries + Count + 1);
-				Nodes[Index].Offset = Store->Header->NumEntries;
-				linear_node_t *Source = Nodes + Offset;
-				linear_node_t *Target = Nodes + Store->Header->NumEntries;
-				Store->Header->NumEntries += (Count + 1);
-				for (int I = 0; I < Count; ++I, ++Source, ++Target) {
-					Target->Index = Index;
-					Target->Hash = Source->Hash;
-					memcpy(Target->Key, Source->Key, sizeof(linear_key_t));
-					Target->Value = Source->Value;
-					Source->Index = INVALID_INDEX;
+	munmap(Old, Store->HeaderSize);
+	close(Store->HeaderFd);
+	char FileName2[strlen(Store->Prefix) + 10];
+	sprintf(FileName2, "%s.index2", Store->Prefix);
+	rename(FileName, FileName2);
+	Store->Swiss = New;
+	Store->HeaderSize = HeaderSize;
+	Store->HeaderFd = HeaderFd;
+	Store->Stats->Rebuilds.Time += radb_time() - Start;
+	++Store->Stats->Rebuilds.Count;
+}
+
+static index_result_t linear_swiss_delete(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full) {
+	linear_swiss_t *Header = Store->Swiss;
+	linear_slot_t *Slots = LINEAR_SWISS_SLOTS(Header);
+	uint64_t Mixed = linear_swiss_mix(Hash);
+	uint8_t Fingerprint = Mixed >> 57;
+	size_t Mask = Header->Size / LINEAR_SWISS_GROUP - 1;
+	size_t Group = (Mixed >> 32) & Mask;
+	for (size_t Step = 1;; ++Step) {
+		uint64_t Probe = radb_probe16(Header->Control + Group * LINEAR_SWISS_GROUP, Fingerprint);
+		for (uint32_t Match = Probe & 0xFFFF; Match; Match &= Match - 1) {
+			size_t Index = Group * LINEAR_SWISS_GROUP + __builtin_ctz(Match);
+			linear_slot_t *Slot = Slots + Index;
+			if (Slot->Hash == Hash && !memcmp(Slot->Key, Key, sizeof(linear_key_t)) && !Store->Compare(Store->Keys, Full, Slot->Value)) {
+				// No probe continues past a group with an empty slot, so the slot can be emptied instead of marked as deleted.
+				if (Probe & 0xFFFF0000) {
+					Header->Control[Index] = LINEAR_SWISS_EMPTY;
+					++Header->Space;
+				} else {
+					Header->Control[Index] = LINEAR_SWISS_DELETED;
+					++Header->Deleted;
 				}
-				Nodes[Offset].Value = Store->Header->NextFree;
-				Store->Header->NextFree = Offset;
-				Target->Index = Index;
-				Target->Hash = Hash;
-				memcpy(Target->Key, Key, sizeof(linear_key_t));
-				uint32_t Insert = Target->Value = Store->Insert(Store->Keys, Full);
-				linear_index_add_offset(Store);
-				return (index_result_t){Insert, 1};
+				--Header->Count;
+				if (Store->Filter->Header) linear_index_filter_delete(Store);
+				return (index_result_t){Slot->Value, 1};
 			}
-		} else if (Entry->Hash == Hash && !memcmp(Entry->Key, Key, sizeof(linear_key_t)) && !Store->Compare(Store->Keys, Full, Entry->Value)) {
-			return (index_result_t){Entry->Value, 0};
 		}
+		if (Probe & 0xFFFF0000) return (index_result_t){INVALID_INDEX, 0};
+		Group = (Group + Step) & Mask;
 	}
-	++Store->Header->Count;
-	return linear_index_add_entry(Store, Index, Hash, Key, Full);
-}
-
-size_t linear_index_insert(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full) {
-	return linear_index_insert2(Store, Hash, Key, Full).Index;
 }
 
 index_result_t linear_index_delete2(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full) {
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_DELETE);
+	if (Store->Swiss) return linear_swiss_delete(Store, Hash, Key, Full);
 	size_t NumOffsets = Store->Header->NumOffsets;
 	size_t Scale = NumOffsets > 1 ? 1 << (64 - __builtin_clzl(NumOffsets - 1)) : 1;
 	size_t Index = Hash & (Scale - 1);
@@ -380,6 +380,7 @@ index_result_t linear_index_delete2(linear_index_t *Store, uint32_t Hash, const
 				Entry->Index = INVALID_INDEX;
 				Nodes[Index].Offset = Offset + 1;
 			}
+			if (Store->Filter->Header) linear_index_filter_delete(Store);
 			return (index_result_t){Value, 1};
 		}
 	}
@@ -389,3 +390,97 @@ index_result_t linear_index_delete2(linear_index_t *Store, uint32_t Hash, const
 size_t linear_index_delete(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full) {
 	return linear_index_delete2(Store, Hash, Key, Full).Index;
 }
+
+static size_t linear_swiss_cursor_next(radb_cursor_t *Cursor) {
+	linear_index_t *Store = (linear_index_t *)Cursor->Store;
+	linear_swiss_t *Header = Store->Swiss;
+	size_t Limit = Cursor->Limit < Header->Size ? Cursor->Limit : Header->Size;
+	while (Cursor->Position < Limit) {
+		size_t Index = Cursor->Position++;
+		if (Header->Control[Index] < LINEAR_SWISS_EMPTY) return LINEAR_SWISS_SLOTS(Header)[Index].Value;
+	}
+	return INVALID_INDEX;
+}
+
+static size_t linear_index_cursor_next(radb_cursor_t *Cursor) {
+	linear_index_t *Store = (linear_index_t *)Cursor->Store;
+	linear_node_t *Nodes = Store->Header->Nodes;
+	size_t Limit = Cursor->Limit < Store->Header->NumEntries ? Cursor->Limit : Store->Header->NumEntries;
+	while (Cursor->Position < Limit) {
+		linear_node_t *Node = Nodes + Cursor->Position++;
+		if (Node->Index != INVALID_INDEX) return Node->Value;
+	}
+	return INVALID_INDEX;
+}
+
+void linear_index_cursor_open(radb_cursor_t *Cursor, linear_index_t *Store) {
+	Cursor->Store = Store;
+	if (Store->Swiss) {
+		Cursor->next = linear_swiss_cursor_next;
+		Cursor->Position = 0;
+		Cursor->Limit = Store->Swiss->Size;
+		return;
+	}
+	Cursor->next = linear_index_cursor_next;
+	Cursor->Position = 0;
+	Cursor->Limit = Store->Header->NumEntries;
+}
+
+// For the swiss engine, buckets are groups of slots and runs are the number of groups probed to find each entry.
+static void linear_swiss_stats(linear_index_t *Store, linear_index_stats_t *Stats) {
+	linear_swiss_t *Header = Store->Swiss;
+	linear_slot_t *Slots = LINEAR_SWISS_SLOTS(Header);
+	size_t NumGroups = Stats->NumBuckets = Header->Size / LINEAR_SWISS_GROUP;
+	Stats->NumSlots = Stats->NumNodes = Header->Size;
+	Stats->NumEntries = Header->Count;
+	Stats->NumHoles = Header->Deleted;
+	Stats->MappingSize = Store->HeaderSize;
+	Stats->Events = Store->Stats[0];
+	if (Header->Count + Header->Deleted) Stats->TombstoneRatio = (double)Header->Deleted / (Header->Count + Header->Deleted);
+	for (size_t I = 0; I < NumGroups; ++I) {
+		if (((radb_probe16(Header->Control + I * LINEAR_SWISS_GROUP, 0) >> 16) & 0xFFFF) == 0xFFFF) ++Stats->NumEmptyBuckets;
+	}
+	size_t Total = 0;
+	for (size_t I = 0; I < Header->Size; ++I) {
+		if (Header->Control[I] >= LINEAR_SWISS_EMPTY) continue;
+		size_t Group = (linear_swiss_mix(Slots[I].Hash) >> 32) & (NumGroups - 1);
+		size_t Run = 1;
+		for (size_t Step = 1; Group != I / LINEAR_SWISS_GROUP; ++Step, ++Run) Group = (Group + Step) & (NumGroups - 1);
+		radb_stats_histogram(Stats->RunLengths, Run);
+		if (Stats->MaxRun < Run) Stats->MaxRun = Run;
+		Total += Run;
+	}
+	if (Header->Count) Stats->AverageRun = (double)Total / Header->Count;
+}
+
+void linear_index_stats(linear_index_t *Store, linear_index_stats_t *Stats) {
+	memset(Stats, 0, sizeof(linear_index_stats_t));
+	if (Store->Swiss) {
+		linear_swiss_stats(Store, Stats);
+		return;
+	}
+	size_t NumOffsets = Stats->NumBuckets = Store->Header->NumOffsets;
+	size_t NumEntries = Stats->NumSlots = Store->Header->NumEntries;
+	Stats->NumEntries = Store->Header->Count;
+	Stats->NumNodes = Store->Header->NumNodes;
+	Stats->NumSplits = NumOffsets - 1;
+	Stats->MappingSize = Store->HeaderSize;
+	Stats->Events = Store->Stats[0];
+	linear_node_t *Nodes = Store->Header->Nodes;
+	for (size_t I = 0; I < NumEntries; ++I) if (Nodes[I].Index == INVALID_INDEX) ++Stats->NumHoles;
+	if (NumEntries) Stats->TombstoneRatio = (double)Stats->NumHoles / NumEntries;
+	size_t Total = 0;
+	for (size_t I = 0; I < NumOffsets; ++I) {
+		size_t Offset = Nodes[I].Offset;
+		if (Offset == INVALID_INDEX) {
+			++Stats->NumEmptyBuckets;
+			continue;
+		}
+		size_t Run = 0;
+		while (Offset + Run < NumEntries && Nodes[Offset + Run].Index == I) ++Run;
+		radb_stats_histogram(Stats->RunLengths, Run);
+		if (Stats->MaxRun < Run) Stats->MaxRun = Run;
+		Total += Run;
+	}
+	if (NumOffsets > Stats->NumEmptyBuckets) Stats->AverageRun = (double)Total / (NumOffsets - Stats->NumEmptyBuckets);
+}
@@ -12,8 +12,17 @@ typedef size_t (*linear_insert_t)(void *Keys, const void *Full);
 
 linear_index_t *linear_index_open(const char *Prefix, void *Keys RADB_MEM_PARAMS);
 linear_index_t *linear_index_create(const char *Prefix, void *Keys RADB_MEM_PARAMS);
+
+typedef enum {
+	LINEAR_INDEX_LINEAR,
+	LINEAR_INDEX_SWISS
+} linear_index_engine_t;
+
+linear_index_t *linear_index_create_engine(const char *Prefix, void *Keys, linear_index_engine_t Engine RADB_MEM_PARAMS);
+linear_index_engine_t linear_index_engine(linear_index_t *Store);
 void linear_index_set_compare(linear_index_t *Store, linear_compare_t Compare);
 void linear_index_set_insert(linear_index_t *Store, linear_insert_t Insert);
+void linear_index_set_filter(linear_index_t *Store, double Rate);
 void *linear_index_keys(linear_index_t *Store);
 size_t linear_index_count(linear_index_t *Store);
 void linear_index_close(linear_index_t *Store);
@@ -39,4 +48,18 @@ size_t linear_index_delete(linear_index_t *Store, uint32_t Hash, const linear_ke
 index_result_t linear_index_insert2(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full);
 index_result_t linear_index_delete2(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full);
 
+void linear_index_cursor_open(radb_cursor_t *Cursor, linear_index_t *Store);
+
+typedef struct {
+	size_t NumBuckets, NumEmptyBuckets, NumEntries;
+	size_t NumSlots, NumHoles, NumNodes, NumSplits;
+	double TombstoneRatio, AverageRun;
+	size_t MaxRun;
+	size_t RunLengths[RADB_STATS_HISTOGRAM_SIZE];
+	size_t MappingSize;
+	radb_stats_t Events;
+} linear_index_stats_t;
+
+void linear_index_stats(linear_index_t *Store, linear_index_stats_t *Stats);
+
 #endif
@@ -1,4 +1,6 @@
 #include "linear_index0.h"
+#include "trace.h"
+#include "filter.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -37,6 +39,8 @@ struct linear_index0_t {
 	linear_insert_t Insert;
 	size_t HeaderSize;
 	int HeaderFd;
+	radb_filter_t Filter[1];
+	radb_stats_t Stats[1];
 };
 
 #ifdef RADB_MEM_GC
@@ -59,6 +63,16 @@ static inline const char *radb_strdup(const char *String, void *Allocator, void
 
 #define PAGE_SIZE 4096
 
+static void linear_index0_filter_rebuild(linear_index0_t *Store, size_t Capacity) {
+	radb_filter_resize(Store->Filter, Store->Stats, Capacity);
+	radb_filter_header_t *Filter = Store->Filter->Header;
+	linear_node0_t *Nodes = Store->Header->Nodes;
+	for (size_t I = 0; I < Store->Header->NumEntries; ++I) {
+		if (Nodes[I].Index != INVALID_INDEX) radb_filter_add(Filter, Nodes[I].Hash);
+	}
+	Filter->Valid = 1;
+}
+
 linear_index0_t *linear_index0_create(const char *Prefix, void *Keys RADB_MEM_PARAMS) {
 #if defined(RADB_MEM_MALLOC)
 	linear_index0_t *Store = malloc(sizeof(linear_index0_t));
@@ -76,6 +90,7 @@ linear_index0_t *linear_index0_create(const char *Prefix, void *Keys RADB_MEM_PA
 #endif
 	char FileName[strlen(Prefix) + 10];
 	sprintf(FileName, "%s.index2", Prefix);
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
 	Store->HeaderSize = PAGE_SIZE;
 	ftruncate(Store->HeaderFd, Store->HeaderSize);
@@ -88,6 +103,9 @@ linear_index0_t *linear_index0_create(const char *Prefix, void *Keys RADB_MEM_PA
 	Store->Header->NextFree = INVALID_INDEX;
 	Store->Header->Count = 0;
 	Store->Header->Nodes[0].Index = INVALID_INDEX;
+	Store->Filter->Header = NULL;
+	sprintf(FileName, "%s.filter", Prefix);
+	unlink(FileName);
 	Store->Keys = Keys;
 	return Store;
 }
@@ -111,6 +129,7 @@ linear_index0_open_t linear_index0_open2(const char *Prefix, void *Keys RADB_MEM
 	Store->alloc_atomic = alloc_atomic;
 	Store->free = free;
 #endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR, 0777);
 	Store->HeaderSize = Stat->st_size;
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
@@ -120,6 +139,10 @@ linear_index0_open_t linear_index0_open2(const char *Prefix, void *Keys RADB_MEM
 		return (linear_index0_open_t){NULL, RADB_HEADER_MISMATCH};
 	}
 	Store->Keys = Keys;
+	sprintf(FileName, "%s.filter", Prefix);
+	if (!radb_filter_open(Store->Filter, FileName) && !Store->Filter->Header->Valid) {
+		linear_index0_filter_rebuild(Store, Store->Filter->Header->Capacity);
+	}
 	return (linear_index0_open_t){Store, RADB_SUCCESS};
 }
 
@@ -128,7 +151,8 @@ linear_index0_t *linear_index0_open(const char *Prefix, void *Keys RADB_MEM_PARA
 }
 
 void linear_index0_close(linear_index0_t *Store) {
-	msync(Store->Header, Store->HeaderSize, MS_SYNC);
+	if (Store->Filter->Header) radb_filter_close(Store->Filter);
+	radb_sync(Store->Header, Store->HeaderSize);
 	munmap(Store->Header, Store->HeaderSize);
 	close(Store->HeaderFd);
 #if defined(RADB_MEM_MALLOC)
@@ -149,6 +173,18 @@ void linear_index0_set_insert(linear_index0_t *Store, linear_insert_t Insert) {
 	Store->Insert = Insert;
 }
 
+void linear_index0_set_filter(linear_index0_t *Store, double Rate) {
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.filter", Store->Prefix);
+	if (Store->Filter->Header) radb_filter_close(Store->Filter);
+	if (Rate <= 0 || Rate >= 1) {
+		unlink(FileName);
+		return;
+	}
+	radb_filter_create(Store->Filter, FileName, Rate);
+	linear_index0_filter_rebuild(Store, 2 * Store->Header->Count);
+}
+
 void linear_index0_set_extra(linear_index0_t *Store, uint32_t Value) {
 	Store->Header->Extra = Value;
 }
@@ -166,6 +202,8 @@ size_t linear_index0_count(linear_index0_t *Store) {
 }
 
 size_t linear_index0_search(linear_index0_t *Store, uint32_t Hash, const void *Full) {
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_SEARCH);
+	if (Store->Filter->Header && !radb_filter_check(Store->Filter->Header, Hash)) return INVALID_INDEX;
 	size_t NumOffset = Store->Header->NumOffsets;
 	size_t Scale = NumOffset > 1 ? 1 << (64 - __builtin_clzl(NumOffset - 1)) : 1;
 	size_t Index = Hash & (Scale - 1);
@@ -191,13 +229,8 @@ static linear_node0_t *linear_index0_grow_nodes(linear_index0_t *Store, size_t T
 		size_t Required = Target - Store->Header->NumNodes;
 		size_t Allocation = ((Required * sizeof(linear_node0_t) + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
 		size_t HeaderSize = Store->HeaderSize + Allocation;
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
+		radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+		Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
 		Store->Header->NumNodes = (HeaderSize - sizeof(linear_header0_t)) / sizeof(linear_node0_t);
 		Store->HeaderSize = HeaderSize;
 	}
@@ -207,6 +240,8 @@ static linear_node0_t *linear_index0_grow_nodes(linear_index0_t *Store, size_t T
 static void linear_index0_add_offset(linear_index0_t *Store) {
 	size_t NumOffsets = Store->Header->NumOffsets;
 	if (NumOffsets >= Store->Header->Count) return;
+	RADB_PROBE1(linear_index_split, NumOffsets);
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_SPLIT);
 	size_t Scale = 1 << (64 - __builtin_clzl(NumOffsets));
 	size_t Shift = Scale >> 1;
 	size_t Index = Scale > NumOffsets ? NumOffsets - Shift : NumOffsets & (Scale - 1);
@@ -259,7 +294,18 @@ static index_result_t linear_index0_add_entry(linear_index0_t *Store, uint32_t I
 	return (index_result_t){Insert, 1};
 }
 
+static void linear_index0_filter_add(linear_index0_t *Store, uint32_t Hash) {
+	radb_filter_header_t *Filter = Store->Filter->Header;
+	if (Store->Header->Count >= Filter->Capacity) {
+		linear_index0_filter_rebuild(Store, 2 * Filter->Capacity);
+		Filter = Store->Filter->Header;
+	}
+	radb_filter_add(Filter, Hash);
+}
+
 index_result_t linear_index0_insert2(linear_index0_t *Store, uint32_t Hash, const void *Full) {
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_INSERT);
+	if (Store->Filter->Header) linear_index0_filter_add(Store, Hash);
 	size_t NumOffsets = Store->Header->NumOffsets;
 	size_t Scale = NumOffsets > 1 ? 1 << (64 - __builtin_clzl(NumOffsets - 1)) : 1;
 	size_t Index = Hash & (Scale - 1);
@@ -334,6 +380,7 @@ size_t linear_index0_insert(linear_index0_t *Store, uint32_t Hash, const void *F
 	return linear_index0_insert2(Store, Hash, Full).Index;
 }
 index_result_t linear_index0_delete2(linear_index0_t *Store, uint32_t Hash, const void *Full) {
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_DELETE);
 	size_t NumOffsets = Store->Header->NumOffsets;
 	size_t Scale = NumOffsets > 1 ? 1 << (64 - __builtin_clzl(NumOffsets - 1)) : 1;
 	size_t Index = Hash & (Scale - 1);
@@ -367,6 +414,10 @@ index_result_t linear_index0_delete2(linear_index0_t *Store, uint32_t Hash, cons
 				Entry->Index = INVALID_INDEX;
 				Nodes[Index].Offset = Offset + 1;
 			}
+			if (Store->Filter->Header) {
+				radb_filter_header_t *Filter = Store->Filter->Header;
+				if (++Filter->Deleted > Filter->Capacity / 4) linear_index0_filter_rebuild(Store, Filter->Capacity);
+			}
 			return (index_result_t){Value, 1};
 		}
 	}
@@ -376,3 +427,49 @@ index_result_t linear_index0_delete2(linear_index0_t *Store, uint32_t Hash, cons
 size_t linear_index0_delete(linear_index0_t *Store, uint32_t Hash, const void *Full) {
 	return linear_index0_delete2(Store, Hash, Full).Index;
 }
+
+static size_t linear_index0_cursor_next(radb_cursor_t *Cursor) {
+	linear_index0_t *Store = (linear_index0_t *)Cursor->Store;
+	linear_node0_t *Nodes = Store->Header->Nodes;
+	size_t Limit = Cursor->Limit < Store->Header->NumEntries ? Cursor->Limit : Store->Header->NumEntries;
+	while (Cursor->Position < Limit) {
+		linear_node0_t *Node = Nodes + Cursor->Position++;
+		if (Node->Index != INVALID_INDEX) return Node->Value;
+	}
+	return INVALID_INDEX;
+}
+
+void linear_index0_cursor_open(radb_cursor_t *Cursor, linear_index0_t *Store) {
+	Cursor->Store = Store;
+	Cursor->next = linear_index0_cursor_next;
+	Cursor->Position = 0;
+	Cursor->Limit = Store->Header->NumEntries;
+}
+
+void linear_index0_stats(linear_index0_t *Store, linear_index0_stats_t *Stats) {
+	memset(Stats, 0, sizeof(linear_index0_stats_t));
+	size_t NumOffsets = Stats->NumBuckets = Store->Header->NumOffsets;
+	size_t NumEntries = Stats->NumSlots = Store->Header->NumEntries;
+	Stats->NumEntries = Store->Header->Count;
+	Stats->NumNodes = Store->Header->NumNodes;
+	Stats->NumSplits = NumOffsets - 1;
+	Stats->MappingSize = Store->HeaderSize;
+	Stats->Events = Store->Stats[0];
+	linear_node0_t *Nodes = Store->Header->Nodes;
+	for (size_t I = 0; I < NumEntries; ++I) if (Nodes[I].Index == INVALID_INDEX) ++Stats->NumHoles;
+	if (NumEntries) Stats->TombstoneRatio = (double)Stats->NumHoles / NumEntries;
+	size_t Total = 0;
+	for (size_t I = 0; I < NumOffsets; ++I) {
+		size_t Offset = Nodes[I].Offset;
+		if (Offset == INVALID_INDEX) {
+			++Stats->NumEmptyBuckets;
+			continue;
+		}
+		size_t Run = 0;
+		while (Offset + Run < NumEntries && Nodes[Offset + Run].Index == I) ++Run;
+		radb_stats_histogram(Stats->RunLengths, Run);
+		if (Stats->MaxRun < Run) Stats->MaxRun = Run;
+		Total += Run;
+	}
+	if (NumOffsets > Stats->NumEmptyBuckets) Stats->AverageRun = (double)Total / (NumOffsets - Stats->NumEmptyBuckets);
+}
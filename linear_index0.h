@@ -14,6 +14,7 @@ linear_index0_t *linear_index0_open(const char *Prefix, void *Keys RADB_MEM_PARA
 linear_index0_t *linear_index0_create(const char *Prefix, void *Keys RADB_MEM_PARAMS);
 void linear_index0_set_compare(linear_index0_t *Store, linear_compare_t Compare);
 void linear_index0_set_insert(linear_index0_t *Store, linear_insert_t Insert);
+void linear_index0_set_filter(linear_index0_t *Store, double Rate);
 void *linear_index0_keys(linear_index0_t *Store);
 size_t linear_index0_count(linear_index0_t *Store);
 void linear_index0_close(linear_index0_t *Store);
@@ -36,4 +37,18 @@ size_t linear_index0_delete(linear_index0_t *Store, uint32_t Hash, const void *F
 index_result_t linear_index0_insert2(linear_index0_t *Store, uint32_t Hash, const void *Full);
 index_result_t linear_index0_insert2(linear_index0_t *Store, uint32_t Hash, const void *Full);
 
+void linear_index0_cursor_open(radb_cursor_t *Cursor, linear_index0_t *Store);
+
+typedef struct {
+	size_t NumBuckets, NumEmptyBuckets, NumEntries;
+	size_t NumSlots, NumHoles, NumNodes, NumSplits;
+	double TombstoneRatio, AverageRun;
+	size_t MaxRun;
+	size_t RunLengths[RADB_STATS_HISTOGRAM_SIZE];
+	size_t MappingSize;
+	radb_stats_t Events;
+} linear_index0_stats_t;
+
+void linear_index0_stats(linear_index0_t *Store, linear_index0_stats_t *Stats);
+
 #endif
@@ -0,0 +1,308 @@
+#ifndef LINEAR_INDEX_INLINE_H
+#define LINEAR_INDEX_INLINE_H
+
+#include "linear_index.h"
+#include "filter.h"
+#include "trace.h"
+#include "kernel.h"
+#include <stddef.h>
+#include <string.h>
+
+// Internal layout of linear indices, shared with the key specific indices so that
+// their search and insert functions can be specialized with inlined key functions.
+
+typedef struct {
+	uint32_t Offset;
+	uint32_t Index;
+	uint32_t Hash;
+	uint32_t Value;
+	linear_key_t Key;
+} linear_node_t;
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumOffsets, NumEntries;
+	uint32_t NumNodes, NextFree;
+	uint32_t Count, Extra;
+	linear_node_t Nodes[];
+} linear_header_t;
+
+// The swiss engine keeps one control byte per slot, either a 7 bit fingerprint of the hash,
+// LINEAR_SWISS_EMPTY or LINEAR_SWISS_DELETED. Slots are probed in aligned groups of 16.
+#define LINEAR_SWISS_GROUP 16
+#define LINEAR_SWISS_EMPTY 0x80
+#define LINEAR_SWISS_DELETED 0xFE
+
+typedef struct {
+	uint32_t Hash;
+	uint32_t Value;
+	linear_key_t Key;
+} linear_slot_t;
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t Size, Space;
+	uint32_t Deleted, Reserved;
+	uint32_t Count, Extra;
+	uint8_t Control[];
+} linear_swiss_t;
+
+#define LINEAR_SWISS_SLOTS(HEADER) ((linear_slot_t *)((HEADER)->Control + (HEADER)->Size))
+
+struct linear_index_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	linear_header_t *Header;
+	linear_swiss_t *Swiss;
+	void *Keys;
+	linear_compare_t Compare;
+	linear_insert_t Insert;
+	const void *Methods;
+	size_t HeaderSize;
+	int HeaderFd;
+	radb_filter_t Filter[1];
+	radb_stats_t Stats[1];
+};
+
+void linear_index_filter_add(linear_index_t *Store, uint32_t Hash);
+linear_node_t *linear_index_add_node(linear_index_t *Store, uint32_t Index, uint32_t Hash, const linear_key_t Key, size_t Stop);
+void linear_index_add_offset(linear_index_t *Store);
+void linear_swiss_rebuild(linear_index_t *Store);
+
+#define LINEAR_INDEX_INLINE static inline __attribute__((always_inline))
+
+// Bucket splitting and node allocation for linear hash tables whose nodes are a linear_node_t followed by
+// NODE_SIZE - sizeof(linear_node_t) bytes, shared by linear_index_t and kv_map_t. The header of STORE_T has
+// the same counters as a linear_header_t and GROW(Store, Target) makes room for at least Target nodes.
+#define LINEAR_TABLE_METHODS(NAME, STORE_T, NODE_SIZE, GROW) \
+\
+static inline linear_node_t *NAME ## _node(STORE_T *Store, size_t Index) { \
+	return (linear_node_t *)((char *)Store->Header->Nodes + Index * (NODE_SIZE)); \
+} \
+\
+/* Splits the next bucket, the caller checks that the table is full enough. */ \
+static void NAME ## _split(STORE_T *Store) { \
+	size_t NodeSize = NODE_SIZE; \
+	size_t NumOffsets = Store->Header->NumOffsets; \
+	size_t Scale = 1 << (64 - __builtin_clzl(NumOffsets)); \
+	size_t Shift = Scale >> 1; \
+	size_t Index = Scale > NumOffsets ? NumOffsets - Shift : NumOffsets & (Scale - 1); \
+	GROW(Store, NumOffsets + 1); \
+	size_t Offset = NAME ## _node(Store, Index)->Offset; \
+	if (Offset == INVALID_INDEX) { \
+		NAME ## _node(Store, Store->Header->NumOffsets++)->Offset = INVALID_INDEX; \
+		return; \
+	} \
+	size_t First = Offset, Last = First, A = First; \
+	size_t Limit = Store->Header->NumEntries; \
+	while (Last < Limit) { \
+		if (NAME ## _node(Store, Last)->Index != Index) break; \
+		++Last; \
+	} \
+	size_t B = Last; \
+	Store->Header->NumOffsets = ++NumOffsets; \
+	/* Everything after Offset and Index is swapped. */ \
+	size_t Skip = offsetof(linear_node_t, Hash); \
+	char Temp[NodeSize]; \
+	while (A < B) { \
+		linear_node_t *NodeA = NAME ## _node(Store, A); \
+		size_t NewIndex = NodeA->Hash & (Scale - 1); \
+		if (NewIndex >= NumOffsets) NewIndex -= Shift; \
+		if (NewIndex == Index) { \
+			++A; \
+		} else { \
+			linear_node_t *NodeB = NAME ## _node(Store, --B); \
+			memcpy(Temp, (char *)NodeA + Skip, NodeSize - Skip); \
+			memcpy((char *)NodeA + Skip, (char *)NodeB + Skip, NodeSize - Skip); \
+			memcpy((char *)NodeB + Skip, Temp, NodeSize - Skip); \
+			NodeB->Index = NewIndex; \
+		} \
+	} \
+	if (B == Last) { \
+		NAME ## _node(Store, NumOffsets - 1)->Offset = INVALID_INDEX; \
+	} else { \
+		if (B == First) NAME ## _node(Store, Index)->Offset = INVALID_INDEX; \
+		NAME ## _node(Store, NumOffsets - 1)->Offset = B; \
+	} \
+} \
+\
+static linear_node_t *NAME ## _append_node(STORE_T *Store) { \
+	GROW(Store, Store->Header->NumEntries + 1); \
+	return NAME ## _node(Store, Store->Header->NumEntries++); \
+} \
+\
+/* Finds a free node for a new entry in bucket Index, Stop is the end of the bucket's run (or INVALID_INDEX if the bucket is empty). */ \
+/* Everything after the key is left to the caller, which then splits a bucket if required. */ \
+static linear_node_t *NAME ## _add_node(STORE_T *Store, uint32_t Index, uint32_t Hash, const linear_key_t Key, size_t Stop) { \
+	size_t NodeSize = NODE_SIZE; \
+	size_t Offset = NAME ## _node(Store, Index)->Offset; \
+	linear_node_t *Entry; \
+	++Store->Header->Count; \
+	if (Offset == INVALID_INDEX) { \
+		size_t Free = Store->Header->NextFree; \
+		if (Free < Store->Header->NumEntries && NAME ## _node(Store, Free)->Index == INVALID_INDEX) { \
+			Store->Header->NextFree = NAME ## _node(Store, Free)->Value; \
+			NAME ## _node(Store, Index)->Offset = Free; \
+			Entry = NAME ## _node(Store, Free); \
+		} else { \
+			NAME ## _node(Store, Index)->Offset = Store->Header->NumEntries; \
+			Entry = NAME ## _append_node(Store); \
+		} \
+	} else if (Stop == Store->Header->NumEntries) { \
+		Entry = NAME ## _append_node(Store); \
+	} else if (NAME ## _node(Store, Stop)->Index == INVALID_INDEX) { \
+		Entry = NAME ## _node(Store, Stop); \
+	} else if (Offset > 0 && NAME ## _node(Store, Offset - 1)->Index == INVALID_INDEX) { \
+		NAME ## _node(Store, Index)->Offset = Offset - 1; \
+		Entry = NAME ## _node(Store, Offset - 1); \
+	} else { \
+		/* The run is followed by another bucket, so it is moved to the end of the nodes. */ \
+		size_t Count = Stop - Offset; \
+		size_t Skip = offsetof(linear_node_t, Hash); \
+		GROW(Store, Store->Header->NumEntries + Count + 1); \
+		NAME ## _node(Store, Index)->Offset = Store->Header->NumEntries; \
+		size_t Target = Store->Header->NumEntries; \
+		Store->Header->NumEntries += (Count + 1); \
+		for (size_t I = 0; I < Count; ++I, ++Target) { \
+			linear_node_t *Source = NAME ## _node(Store, Offset + I); \
+			linear_node_t *Destination = NAME ## _node(Store, Target); \
+			Destination->Index = Index; \
+			memcpy((char *)Destination + Skip, (char *)Source + Skip, NodeSize - Skip); \
+			Source->Index = INVALID_INDEX; \
+		} \
+		NAME ## _node(Store, Offset)->Value = Store->Header->NextFree; \
+		Store->Header->NextFree = Offset; \
+		Entry = NAME ## _node(Store, Target); \
+	} \
+	Entry->Index = Index; \
+	Entry->Hash = Hash; \
+	memcpy(Entry->Key, Key, sizeof(linear_key_t)); \
+	return Entry; \
+}
+
+LINEAR_INDEX_INLINE size_t linear_index_bucket(linear_header_t *Header, uint32_t Hash) {
+	size_t NumOffsets = Header->NumOffsets;
+	size_t Scale = NumOffsets > 1 ? 1 << (64 - __builtin_clzl(NumOffsets - 1)) : 1;
+	size_t Index = Hash & (Scale - 1);
+	if (Index >= NumOffsets) Index -= (Scale >> 1);
+	return Index;
+}
+
+// The group and fingerprint are taken from different bits of the mixed hash.
+LINEAR_INDEX_INLINE uint64_t linear_swiss_mix(uint32_t Hash) {
+	return Hash * 0x9E3779B97F4A7C15;
+}
+
+LINEAR_INDEX_INLINE size_t linear_swiss_search(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full, linear_compare_t Compare) {
+	linear_swiss_t *Header = Store->Swiss;
+	linear_slot_t *Slots = LINEAR_SWISS_SLOTS(Header);
+	uint64_t Mixed = linear_swiss_mix(Hash);
+	uint8_t Fingerprint = Mixed >> 57;
+	size_t Mask = Header->Size / LINEAR_SWISS_GROUP - 1;
+	size_t Group = (Mixed >> 32) & Mask;
+	for (size_t Step = 1;; ++Step) {
+		uint64_t Probe = radb_probe16(Header->Control + Group * LINEAR_SWISS_GROUP, Fingerprint);
+		for (uint32_t Match = Probe & 0xFFFF; Match; Match &= Match - 1) {
+			linear_slot_t *Slot = Slots + Group * LINEAR_SWISS_GROUP + __builtin_ctz(Match);
+			if (Slot->Hash == Hash && !memcmp(Slot->Key, Key, sizeof(linear_key_t)) && !Compare(Store->Keys, Full, Slot->Value)) {
+				return Slot->Value;
+			}
+		}
+		if (Probe & 0xFFFF0000) return INVALID_INDEX;
+		Group = (Group + Step) & Mask;
+	}
+}
+
+LINEAR_INDEX_INLINE index_result_t linear_swiss_insert(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full, linear_compare_t Compare, linear_insert_t Insert) {
+	uint64_t Mixed = linear_swiss_mix(Hash);
+	uint8_t Fingerprint = Mixed >> 57;
+	for (;;) {
+		linear_swiss_t *Header = Store->Swiss;
+		linear_slot_t *Slots = LINEAR_SWISS_SLOTS(Header);
+		size_t Mask = Header->Size / LINEAR_SWISS_GROUP - 1;
+		size_t Group = (Mixed >> 32) & Mask;
+		size_t Free = INVALID_INDEX;
+		for (size_t Step = 1;; ++Step) {
+			uint64_t Probe = radb_probe16(Header->Control + Group * LINEAR_SWISS_GROUP, Fingerprint);
+			for (uint32_t Match = Probe & 0xFFFF; Match; Match &= Match - 1) {
+				linear_slot_t *Slot = Slots + Group * LINEAR_SWISS_GROUP + __builtin_ctz(Match);
+				if (Slot->Hash == Hash && !memcmp(Slot->Key, Key, sizeof(linear_key_t)) && !Compare(Store->Keys, Full, Slot->Value)) {
+					return (index_result_t){Slot->Value, 0};
+				}
+			}
+			if (Free == INVALID_INDEX && (Probe >> 32)) Free = Group * LINEAR_SWISS_GROUP + __builtin_ctzll(Probe >> 32);
+			if (Probe & 0xFFFF0000) break;
+			Group = (Group + Step) & Mask;
+		}
+		// Reusing a deleted slot does not reduce the number of empty slots, which must stay above 1/8 for probing to end quickly.
+		if (Header->Control[Free] == LINEAR_SWISS_DELETED) {
+			--Header->Deleted;
+		} else if (Header->Space - 1 > Header->Size >> 3) {
+			--Header->Space;
+		} else {
+			linear_swiss_rebuild(Store);
+			continue;
+		}
+		++Header->Count;
+		Header->Control[Free] = Fingerprint;
+		linear_slot_t *Slot = Slots + Free;
+		Slot->Hash = Hash;
+		memcpy(Slot->Key, Key, sizeof(linear_key_t));
+		uint32_t Value = Slot->Value = Insert(Store->Keys, Full);
+		return (index_result_t){Value, 1};
+	}
+}
+
+// Compare and Insert are usually constant, in which case they are inlined into the caller.
+
+LINEAR_INDEX_INLINE size_t linear_index_search_inline(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full, linear_compare_t Compare) {
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_SEARCH);
+	if (Store->Filter->Header && !radb_filter_check(Store->Filter->Header, Hash)) return INVALID_INDEX;
+	if (Store->Swiss) return linear_swiss_search(Store, Hash, Key, Full, Compare);
+	size_t Index = linear_index_bucket(Store->Header, Hash);
+	linear_node_t *Nodes = Store->Header->Nodes;
+	size_t Offset = Nodes[Index].Offset;
+	if (Offset == INVALID_INDEX) return INVALID_INDEX;
+	linear_node_t *Last = Nodes + Store->Header->NumEntries;
+	for (linear_node_t *Entry = Nodes + Offset; Entry < Last; ++Entry) {
+		if (Entry->Index != Index) {
+			return INVALID_INDEX;
+		} else if (Entry->Hash == Hash && !memcmp(Entry->Key, Key, sizeof(linear_key_t)) && !Compare(Store->Keys, Full, Entry->Value)) {
+			return Entry->Value;
+		}
+	}
+	return INVALID_INDEX;
+}
+
+LINEAR_INDEX_INLINE index_result_t linear_index_insert_inline(linear_index_t *Store, uint32_t Hash, const linear_key_t Key, const void *Full, linear_compare_t Compare, linear_insert_t Insert) {
+	RADB_LATENCY(RADB_OP_LINEAR_INDEX_INSERT);
+	if (Store->Filter->Header) linear_index_filter_add(Store, Hash);
+	if (Store->Swiss) return linear_swiss_insert(Store, Hash, Key, Full, Compare, Insert);
+	size_t Index = linear_index_bucket(Store->Header, Hash);
+	linear_node_t *Nodes = Store->Header->Nodes;
+	size_t Offset = Nodes[Index].Offset;
+	size_t Stop = Offset;
+	if (Offset != INVALID_INDEX) {
+		linear_node_t *Last = Nodes + Store->Header->NumEntries;
+		linear_node_t *Entry = Nodes + Offset;
+		for (; Entry < Last; ++Entry) {
+			if (Entry->Index != Index) {
+				break;
+			} else if (Entry->Hash == Hash && !memcmp(Entry->Key, Key, sizeof(linear_key_t)) && !Compare(Store->Keys, Full, Entry->Value)) {
+				return (index_result_t){Entry->Value, 0};
+			}
+		}
+		Stop = Entry - Nodes;
+	}
+	linear_node_t *Entry = linear_index_add_node(Store, Index, Hash, Key, Stop);
+	uint32_t Value = Entry->Value = Insert(Store->Keys, Full);
+	linear_index_add_offset(Store);
+	return (index_result_t){Value, 1};
+}
+
+#endif
@@ -0,0 +1,498 @@
+#include "ordered_index.h"
+#include "trace.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define PAGE_SIZE 4096
+#define PREFIX_SIZE 64
+#define INLINE_SIZE 14
+#define MAX_HEIGHT 32
+
+// Each slot holds the bytes of its key following the node prefix, up to INLINE_SIZE bytes.
+// Long is set if the key has more bytes, in which case it is compared using the key store.
+// In branch nodes, Child is the page for keys greater than or equal to the slot key. The first slot of
+// a branch node holds the page for all keys below the second slot, its key is empty and never compared.
+typedef struct {
+	uint32_t Index, Child;
+	uint8_t Length, Long;
+	unsigned char Suffix[INLINE_SIZE];
+} ordered_slot_t;
+
+typedef struct {
+	uint16_t Leaf, Count;
+	uint16_t PrefixLength, Reserved;
+	uint32_t Prev, Next;
+	unsigned char Prefix[PREFIX_SIZE];
+	ordered_slot_t Slots[];
+} ordered_node_t;
+
+#define MAX_SLOTS ((PAGE_SIZE - sizeof(ordered_node_t)) / sizeof(ordered_slot_t))
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumPages, Root;
+	uint32_t Height, Count;
+	uint32_t First, Last;
+} ordered_header_t;
+
+struct ordered_index_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	ordered_header_t *Header;
+	string_store_t *Keys;
+	size_t HeaderSize;
+	int HeaderFd;
+	radb_stats_t Stats[1];
+};
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define ORDERED_INDEX_SIGNATURE 0x4F494152
+#define ORDERED_INDEX_VERSION MAKE_VERSION(1, 0)
+
+static inline ordered_node_t *ordered_page(ordered_index_t *Store, uint32_t Page) {
+	return (ordered_node_t *)((char *)Store->Header + (size_t)Page * PAGE_SIZE);
+}
+
+static uint32_t ordered_page_alloc(ordered_index_t *Store, int Leaf) {
+	uint32_t Page = Store->Header->NumPages;
+	size_t Required = (size_t)(Page + 1) * PAGE_SIZE;
+	if (Required > Store->HeaderSize) {
+		size_t HeaderSize = Store->HeaderSize + (Store->HeaderSize >> 1);
+		if (HeaderSize < Required) HeaderSize = Required;
+		HeaderSize = (HeaderSize + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+		radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+		Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
+		Store->HeaderSize = HeaderSize;
+	}
+	Store->Header->NumPages = Page + 1;
+	ordered_node_t *Node = ordered_page(Store, Page);
+	Node->Leaf = Leaf;
+	Node->Count = 0;
+	Node->PrefixLength = 0;
+	Node->Prev = Node->Next = 0;
+	return Page;
+}
+
+ordered_index_t *ordered_index_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
+#if defined(RADB_MEM_MALLOC)
+	ordered_index_t *Store = malloc(sizeof(ordered_index_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	ordered_index_t *Store = GC_malloc(sizeof(ordered_index_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	ordered_index_t *Store = alloc(Allocator, sizeof(ordered_index_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.ordered", Prefix);
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Store->HeaderSize = 16 * PAGE_SIZE;
+	ftruncate(Store->HeaderFd, Store->HeaderSize);
+	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
+	Store->Header->Signature = ORDERED_INDEX_SIGNATURE;
+	Store->Header->Version = ORDERED_INDEX_VERSION;
+	Store->Header->NumPages = 1;
+	Store->Header->Height = 1;
+	Store->Header->Count = 0;
+	Store->Header->Root = Store->Header->First = Store->Header->Last = ordered_page_alloc(Store, 1);
+	Store->Keys = string_store_create(Prefix, KeySize, ChunkSize RADB_MEM_ARGS);
+	return Store;
+}
+
+ordered_index_open_t ordered_index_open2(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.ordered", Prefix);
+	if (stat(FileName, Stat)) return (ordered_index_open_t){NULL, RADB_FILE_NOT_FOUND};
+	string_store_open_t KeysOpen = string_store_open2(Prefix RADB_MEM_ARGS);
+	if (!KeysOpen.Store) return (ordered_index_open_t){NULL, KeysOpen.Error + 3};
+#if defined(RADB_MEM_MALLOC)
+	ordered_index_t *Store = malloc(sizeof(ordered_index_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	ordered_index_t *Store = GC_malloc(sizeof(ordered_index_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	ordered_index_t *Store = alloc(Allocator, sizeof(ordered_index_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = open(FileName, O_RDWR, 0777);
+	Store->HeaderSize = Stat->st_size;
+	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
+	if (Store->Header->Signature != ORDERED_INDEX_SIGNATURE) {
+		munmap(Store->Header, Store->HeaderSize);
+		close(Store->HeaderFd);
+		string_store_close(KeysOpen.Store);
+		return (ordered_index_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+	if ((size_t)Store->Header->NumPages * PAGE_SIZE > Store->HeaderSize) {
+		munmap(Store->Header, Store->HeaderSize);
+		close(Store->HeaderFd);
+		string_store_close(KeysOpen.Store);
+		return (ordered_index_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+	Store->Keys = KeysOpen.Store;
+	return (ordered_index_open_t){Store, RADB_SUCCESS};
+}
+
+ordered_index_t *ordered_index_open(const char *Prefix RADB_MEM_PARAMS) {
+	return ordered_index_open2(Prefix RADB_MEM_ARGS).Index;
+}
+
+size_t ordered_index_num_entries(ordered_index_t *Store) {
+	return Store->Header->Count;
+}
+
+void ordered_index_close(ordered_index_t *Store) {
+	string_store_close(Store->Keys);
+	radb_sync(Store->Header, Store->HeaderSize);
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Store->Prefix);
+	free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+	Store->free(Store->Allocator, (void *)Store->Prefix);
+	Store->free(Store->Allocator, Store);
+#endif
+}
+
+size_t ordered_index_size(ordered_index_t *Store, size_t Index) {
+	return string_store_size(Store->Keys, Index);
+}
+
+size_t ordered_index_get(ordered_index_t *Store, size_t Index, void *Buffer, size_t Space) {
+	return string_store_get(Store->Keys, Index, Buffer, Space);
+}
+
+static int ordered_compare_prefix(ordered_node_t *Node, const unsigned char *Key, size_t Length) {
+	size_t Common = Length < Node->PrefixLength ? Length : Node->PrefixLength;
+	int Cmp = memcmp(Key, Node->Prefix, Common);
+	if (Cmp) return Cmp;
+	return Length < Node->PrefixLength ? -1 : 0;
+}
+
+static int ordered_compare_slot(ordered_index_t *Store, ordered_node_t *Node, size_t Slot, const unsigned char *Key, size_t Length) {
+	ordered_slot_t *Entry = Node->Slots + Slot;
+	const unsigned char *Suffix = Key + Node->PrefixLength;
+	size_t Remain = Length - Node->PrefixLength;
+	int Cmp = memcmp(Suffix, Entry->Suffix, Remain < Entry->Length ? Remain : Entry->Length);
+	if (Cmp) return Cmp;
+	if (Remain < Entry->Length) return -1;
+	if (Entry->Long) return string_store_compare(Store->Keys, Key, Length, Entry->Index);
+	return Remain > Entry->Length;
+}
+
+// Returns the first slot which is not less than Key, setting Found if it is equal to Key.
+static size_t ordered_lower_bound(ordered_index_t *Store, ordered_node_t *Node, const unsigned char *Key, size_t Length, int *Found) {
+	*Found = 0;
+	int Cmp = ordered_compare_prefix(Node, Key, Length);
+	if (Cmp < 0) return 0;
+	if (Cmp > 0) return Node->Count;
+	size_t Lo = 0, Hi = Node->Count;
+	while (Lo < Hi) {
+		size_t Mid = (Lo + Hi) / 2;
+		Cmp = ordered_compare_slot(Store, Node, Mid, Key, Length);
+		if (Cmp > 0) {
+			Lo = Mid + 1;
+		} else {
+			Hi = Mid;
+			*Found = !Cmp;
+		}
+	}
+	return Lo;
+}
+
+// Returns the last slot of a branch node which is not greater than Key, the first slot acts as negative infinity.
+static size_t ordered_branch_slot(ordered_index_t *Store, ordered_node_t *Node, const unsigned char *Key, size_t Length) {
+	int Cmp = ordered_compare_prefix(Node, Key, Length);
+	if (Cmp < 0) return 0;
+	if (Cmp > 0) return Node->Count - 1;
+	size_t Lo = 1, Hi = Node->Count;
+	while (Lo < Hi) {
+		size_t Mid = (Lo + Hi) / 2;
+		if (ordered_compare_slot(Store, Node, Mid, Key, Length) >= 0) {
+			Lo = Mid + 1;
+		} else {
+			Hi = Mid;
+		}
+	}
+	return Lo - 1;
+}
+
+typedef struct {
+	unsigned char Bytes[PREFIX_SIZE + INLINE_SIZE];
+	size_t Length;
+	uint32_t Index, Child;
+	int Long;
+} ordered_entry_t;
+
+static void ordered_slot_entry(ordered_node_t *Node, size_t Slot, ordered_entry_t *Entry) {
+	ordered_slot_t *Source = Node->Slots + Slot;
+	memcpy(Entry->Bytes, Node->Prefix, Node->PrefixLength);
+	memcpy(Entry->Bytes + Node->PrefixLength, Source->Suffix, Source->Length);
+	Entry->Length = Node->PrefixLength + Source->Length;
+	Entry->Long = Source->Long;
+	Entry->Index = Source->Index;
+	Entry->Child = Source->Child;
+}
+
+static void ordered_key_entry(ordered_entry_t *Entry, const unsigned char *Key, size_t Length, uint32_t Index, uint32_t Child) {
+	Entry->Long = Length > sizeof(Entry->Bytes);
+	Entry->Length = Entry->Long ? sizeof(Entry->Bytes) : Length;
+	memcpy(Entry->Bytes, Key, Entry->Length);
+	Entry->Index = Index;
+	Entry->Child = Child;
+}
+
+static void ordered_entry_slot(ordered_node_t *Node, size_t Slot, ordered_entry_t *Entry) {
+	ordered_slot_t *Target = Node->Slots + Slot;
+	if (!Slot && !Node->Leaf) {
+		Target->Length = Target->Long = 0;
+		Target->Index = Entry->Index;
+		Target->Child = Entry->Child;
+		return;
+	}
+	size_t Remain = Entry->Length - Node->PrefixLength;
+	Target->Length = Remain > INLINE_SIZE ? INLINE_SIZE : Remain;
+	Target->Long = Entry->Long || Remain > INLINE_SIZE;
+	memcpy(Target->Suffix, Entry->Bytes + Node->PrefixLength, Target->Length);
+	Target->Index = Entry->Index;
+	Target->Child = Entry->Child;
+}
+
+// Rewrites a node from a sorted array of entries, using their longest common prefix as the node prefix.
+// The key of the first entry of a branch node is left out.
+static void ordered_node_fill(ordered_node_t *Node, ordered_entry_t *Entries, size_t Count) {
+	size_t First = !Node->Leaf;
+	size_t Common = Count > First ? Entries[First].Length : 0;
+	if (Common > PREFIX_SIZE) Common = PREFIX_SIZE;
+	for (size_t I = First + 1; I < Count && Common; ++I) {
+		size_t J = 0;
+		while (J < Common && J < Entries[I].Length && Entries[I].Bytes[J] == Entries[First].Bytes[J]) ++J;
+		Common = J;
+	}
+	Node->PrefixLength = Common;
+	if (Count > First) memcpy(Node->Prefix, Entries[First].Bytes, Common);
+	for (size_t I = 0; I < Count; ++I) ordered_entry_slot(Node, I, Entries + I);
+	Node->Count = Count;
+}
+
+static void ordered_node_place(ordered_node_t *Node, size_t Position, ordered_entry_t *Entry) {
+	size_t Common = 0;
+	while (Common < Node->PrefixLength && Common < Entry->Length && Entry->Bytes[Common] == Node->Prefix[Common]) ++Common;
+	if (Common < Node->PrefixLength) {
+		ordered_entry_t Entries[Node->Count];
+		size_t First = !Node->Leaf;
+		for (size_t I = First; I < Node->Count; ++I) ordered_slot_entry(Node, I, Entries + I);
+		Node->PrefixLength = Common;
+		for (size_t I = First; I < Node->Count; ++I) ordered_entry_slot(Node, I, Entries + I);
+	}
+	memmove(Node->Slots + Position + 1, Node->Slots + Position, (Node->Count - Position) * sizeof(ordered_slot_t));
+	ordered_entry_slot(Node, Position, Entry);
+	++Node->Count;
+}
+
+typedef struct {
+	uint32_t Pages[MAX_HEIGHT];
+	uint32_t Slots[MAX_HEIGHT];
+} ordered_path_t;
+
+static void ordered_insert_entry(ordered_index_t *Store, ordered_path_t *Path, int Level, size_t Position, ordered_entry_t *Entry, int Append) {
+	for (;;) {
+		uint32_t Page = Path->Pages[Level];
+		ordered_node_t *Node = ordered_page(Store, Page);
+		if (Node->Count < MAX_SLOTS) {
+			ordered_node_place(Node, Position, Entry);
+			return;
+		}
+		size_t Count = Node->Count;
+		ordered_entry_t *Entries = malloc((Count + 1) * sizeof(ordered_entry_t));
+		for (size_t I = 0; I < Position; ++I) ordered_slot_entry(Node, I, Entries + I);
+		Entries[Position] = *Entry;
+		for (size_t I = Position; I < Count; ++I) ordered_slot_entry(Node, I, Entries + I + 1);
+		// Sequential appends leave the left node full instead of splitting it in half.
+		size_t Split = (Append && Position == Count) ? Count : (Count + 1) / 2;
+		int Leaf = Node->Leaf;
+		uint32_t NewPage = ordered_page_alloc(Store, Leaf);
+		Node = ordered_page(Store, Page);
+		ordered_node_t *NewNode = ordered_page(Store, NewPage);
+		ordered_node_fill(Node, Entries, Split);
+		ordered_node_fill(NewNode, Entries + Split, Count + 1 - Split);
+		if (Leaf) {
+			NewNode->Next = Node->Next;
+			NewNode->Prev = Page;
+			if (Node->Next) ordered_page(Store, Node->Next)->Prev = NewPage;
+			Node->Next = NewPage;
+			if (Store->Header->Last == Page) Store->Header->Last = NewPage;
+		}
+		ordered_entry_t Separator = Entries[Split];
+		Separator.Child = NewPage;
+		if (!Level) {
+			uint32_t Root = ordered_page_alloc(Store, 0);
+			ordered_node_t *RootNode = ordered_page(Store, Root);
+			Entries[0].Child = Page;
+			Entries[1] = Separator;
+			ordered_node_fill(RootNode, Entries, 2);
+			Store->Header->Root = Root;
+			++Store->Header->Height;
+			free(Entries);
+			return;
+		}
+		free(Entries);
+		*Entry = Separator;
+		--Level;
+		Position = Path->Slots[Level] + 1;
+	}
+}
+
+static size_t ordered_descend(ordered_index_t *Store, ordered_path_t *Path, const unsigned char *Key, size_t Length, int *Found) {
+	uint32_t Page = Store->Header->Root;
+	int Level = 0;
+	for (;;) {
+		ordered_node_t *Node = ordered_page(Store, Page);
+		Path->Pages[Level] = Page;
+		if (Node->Leaf) return ordered_lower_bound(Store, Node, Key, Length, Found);
+		size_t Slot = ordered_branch_slot(Store, Node, Key, Length);
+		Path->Slots[Level++] = Slot;
+		Page = Node->Slots[Slot].Child;
+	}
+}
+
+index_result_t ordered_index_insert2(ordered_index_t *Store, const char *Key, size_t Length) {
+	if (!Length) Length = strlen(Key);
+	ordered_path_t Path[1];
+	int Found;
+	size_t Position = ordered_descend(Store, Path, (const unsigned char *)Key, Length, &Found);
+	ordered_node_t *Node = ordered_page(Store, Path->Pages[Store->Header->Height - 1]);
+	if (Found) return (index_result_t){Node->Slots[Position].Index, 0};
+	size_t Index = string_store_alloc(Store->Keys);
+	string_store_set(Store->Keys, Index, Key, Length);
+	ordered_entry_t Entry[1];
+	ordered_key_entry(Entry, (const unsigned char *)Key, Length, Index, 0);
+	ordered_insert_entry(Store, Path, Store->Header->Height - 1, Position, Entry, 0);
+	++Store->Header->Count;
+	return (index_result_t){Index, 1};
+}
+
+size_t ordered_index_insert(ordered_index_t *Store, const char *Key, size_t Length) {
+	return ordered_index_insert2(Store, Key, Length).Index;
+}
+
+size_t ordered_index_search(ordered_index_t *Store, const char *Key, size_t Length) {
+	if (!Length) Length = strlen(Key);
+	ordered_path_t Path[1];
+	int Found;
+	size_t Position = ordered_descend(Store, Path, (const unsigned char *)Key, Length, &Found);
+	if (!Found) return INVALID_INDEX;
+	return ordered_page(Store, Path->Pages[Store->Header->Height - 1])->Slots[Position].Index;
+}
+
+size_t ordered_index_append(ordered_index_t *Store, const char *Key, size_t Length) {
+	if (!Length) Length = strlen(Key);
+	ordered_path_t Path[1];
+	uint32_t Page = Store->Header->Root;
+	int Level = 0;
+	for (;;) {
+		ordered_node_t *Node = ordered_page(Store, Page);
+		Path->Pages[Level] = Page;
+		if (Node->Leaf) break;
+		Path->Slots[Level++] = Node->Count - 1;
+		Page = Node->Slots[Node->Count - 1].Child;
+	}
+	ordered_node_t *Node = ordered_page(Store, Page);
+	if (Node->Count) {
+		const unsigned char *Bytes = (const unsigned char *)Key;
+		int Cmp = ordered_compare_prefix(Node, Bytes, Length);
+		if (!Cmp) Cmp = ordered_compare_slot(Store, Node, Node->Count - 1, Bytes, Length);
+		if (Cmp <= 0) return INVALID_INDEX;
+	}
+	size_t Index = string_store_alloc(Store->Keys);
+	string_store_set(Store->Keys, Index, Key, Length);
+	ordered_entry_t Entry[1];
+	ordered_key_entry(Entry, (const unsigned char *)Key, Length, Index, 0);
+	ordered_insert_entry(Store, Path, Level, Node->Count, Entry, 1);
+	++Store->Header->Count;
+	return Index;
+}
+
+size_t ordered_index_seek(ordered_index_cursor_t *Cursor, ordered_index_t *Store, const char *Key, size_t Length) {
+	if (!Length) Length = strlen(Key);
+	ordered_path_t Path[1];
+	int Found;
+	size_t Position = ordered_descend(Store, Path, (const unsigned char *)Key, Length, &Found);
+	uint32_t Page = Path->Pages[Store->Header->Height - 1];
+	ordered_node_t *Node = ordered_page(Store, Page);
+	Cursor->Store = Store;
+	if (Position == Node->Count && Node->Next) {
+		Page = Node->Next;
+		Node = ordered_page(Store, Page);
+		Position = 0;
+	}
+	Cursor->Page = Page;
+	Cursor->Slot = Position;
+	if (Position == Node->Count) return INVALID_INDEX;
+	return Node->Slots[Position].Index;
+}
+
+size_t ordered_index_next(ordered_index_cursor_t *Cursor) {
+	ordered_index_t *Store = Cursor->Store;
+	ordered_node_t *Node = ordered_page(Store, Cursor->Page);
+	if (Cursor->Slot >= Node->Count) return INVALID_INDEX;
+	if (++Cursor->Slot == Node->Count) {
+		if (!Node->Next) return INVALID_INDEX;
+		Cursor->Page = Node->Next;
+		Cursor->Slot = 0;
+		Node = ordered_page(Store, Cursor->Page);
+	}
+	return Node->Slots[Cursor->Slot].Index;
+}
+
+size_t ordered_index_prev(ordered_index_cursor_t *Cursor) {
+	ordered_index_t *Store = Cursor->Store;
+	ordered_node_t *Node = ordered_page(Store, Cursor->Page);
+	if (!Cursor->Slot) {
+		if (!Node->Prev) return INVALID_INDEX;
+		Cursor->Page = Node->Prev;
+		Node = ordered_page(Store, Cursor->Page);
+		Cursor->Slot = Node->Count;
+	}
+	return Node->Slots[--Cursor->Slot].Index;
+}
@@ -0,0 +1,43 @@
+#ifndef ORDERED_INDEX_H
+#define ORDERED_INDEX_H
+
+#include "config.h"
+#include "common.h"
+#include "string_store.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+typedef struct ordered_index_t ordered_index_t;
+
+ordered_index_t *ordered_index_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS);
+ordered_index_t *ordered_index_open(const char *Prefix RADB_MEM_PARAMS);
+size_t ordered_index_num_entries(ordered_index_t *Store);
+#define ordered_index_count ordered_index_num_entries
+void ordered_index_close(ordered_index_t *Store);
+
+typedef struct {
+	ordered_index_t *Index;
+	radb_error_t Error;
+} ordered_index_open_t;
+
+ordered_index_open_t ordered_index_open2(const char *Prefix RADB_MEM_PARAMS);
+
+size_t ordered_index_insert(ordered_index_t *Store, const char *Key, size_t Length);
+size_t ordered_index_search(ordered_index_t *Store, const char *Key, size_t Length);
+size_t ordered_index_append(ordered_index_t *Store, const char *Key, size_t Length);
+
+index_result_t ordered_index_insert2(ordered_index_t *Store, const char *Key, size_t Length);
+
+size_t ordered_index_size(ordered_index_t *Store, size_t Index);
+size_t ordered_index_get(ordered_index_t *Store, size_t Index, void *Buffer, size_t Space);
+
+typedef struct {
+	ordered_index_t *Store;
+	uint32_t Page, Slot;
+} ordered_index_cursor_t;
+
+size_t ordered_index_seek(ordered_index_cursor_t *Cursor, ordered_index_t *Store, const char *Key, size_t Length);
+size_t ordered_index_next(ordered_index_cursor_t *Cursor);
+size_t ordered_index_prev(ordered_index_cursor_t *Cursor);
+
+#endif
@@ -0,0 +1,357 @@
+#include "ordered_store.h"
+#include "trace.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define ORDERED_STORE_SIGNATURE 0x4D504152
+#define ORDERED_STORE_VERSION MAKE_VERSION(1, 0)
+
+// Values are kept in order in a packed memory array: NumSegments segments of SegmentSize slots, with the
+// values of each segment at its start and gaps after them. Tree is an implicit binary tree of value counts
+// with the root at 1 and the count of segment S at NumSegments + S, each node counting the values of the
+// segments below it, which is the window of segments rebalanced together.
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t ValueSize, SegmentSize;
+	uint32_t NumSegments, Height;
+	uint32_t Tree[];
+} ordered_store_header_t;
+
+struct ordered_store_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	ordered_store_header_t *Header;
+	char *Values;
+	size_t HeaderSize;
+	int HeaderFd;
+	radb_stats_t Stats[1];
+};
+
+// The values start on a cache line after the tree.
+static size_t ordered_store_values_offset(size_t NumSegments) {
+	return (sizeof(ordered_store_header_t) + 2 * NumSegments * sizeof(uint32_t) + 63) & ~(size_t)63;
+}
+
+static ordered_store_header_t *ordered_store_header_create(int Fd, size_t ValueSize, size_t SegmentSize, size_t Height, size_t *HeaderSize) {
+	size_t NumSegments = (size_t)1 << Height;
+	*HeaderSize = ordered_store_values_offset(NumSegments) + NumSegments * SegmentSize * ValueSize;
+	ftruncate(Fd, *HeaderSize);
+	ordered_store_header_t *Header = mmap(NULL, *HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	Header->Signature = ORDERED_STORE_SIGNATURE;
+	Header->Version = ORDERED_STORE_VERSION;
+	Header->ValueSize = ValueSize;
+	Header->SegmentSize = SegmentSize;
+	Header->NumSegments = NumSegments;
+	Header->Height = Height;
+	return Header;
+}
+
+ordered_store_t *ordered_store_create(const char *Prefix, size_t ValueSize, size_t SegmentBytes RADB_MEM_PARAMS) {
+#if defined(RADB_MEM_MALLOC)
+	ordered_store_t *Store = malloc(sizeof(ordered_store_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	ordered_store_t *Store = GC_malloc(sizeof(ordered_store_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	ordered_store_t *Store = alloc(Allocator, sizeof(ordered_store_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	if (!ValueSize) ValueSize = 1;
+	if (!SegmentBytes) SegmentBytes = 1024;
+	// Segments hold a power of two values, at least 8.
+	size_t Slots = 8;
+	while (Slots * 2 * ValueSize <= SegmentBytes) Slots *= 2;
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.pma", Prefix);
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Store->Header = ordered_store_header_create(Store->HeaderFd, ValueSize, Slots, 0, &Store->HeaderSize);
+	Store->Values = (char *)Store->Header + ordered_store_values_offset(1);
+	return Store;
+}
+
+ordered_store_open_t ordered_store_open2(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.pma", Prefix);
+	if (stat(FileName, Stat)) return (ordered_store_open_t){NULL, RADB_FILE_NOT_FOUND};
+	int HeaderFd = open(FileName, O_RDWR, 0777);
+	size_t HeaderSize = Stat->st_size;
+	ordered_store_header_t *Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, HeaderFd, 0);
+	if (HeaderSize < sizeof(ordered_store_header_t) || Header->Signature != ORDERED_STORE_SIGNATURE) {
+		munmap(Header, HeaderSize);
+		close(HeaderFd);
+		return (ordered_store_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+	size_t NumSegments = Header->NumSegments;
+	if (Header->Height > 31 || NumSegments != (size_t)1 << Header->Height
+		|| HeaderSize != ordered_store_values_offset(NumSegments) + NumSegments * Header->SegmentSize * Header->ValueSize) {
+		munmap(Header, HeaderSize);
+		close(HeaderFd);
+		return (ordered_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+#if defined(RADB_MEM_MALLOC)
+	ordered_store_t *Store = malloc(sizeof(ordered_store_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	ordered_store_t *Store = GC_malloc(sizeof(ordered_store_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	ordered_store_t *Store = alloc(Allocator, sizeof(ordered_store_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
+	Store->HeaderFd = HeaderFd;
+	Store->HeaderSize = HeaderSize;
+	Store->Header = Header;
+	Store->Values = (char *)Header + ordered_store_values_offset(NumSegments);
+	// The segment counts are written before the counts above them, which are recomputed in case the store was not closed.
+	for (size_t Node = NumSegments; --Node > 0;) Header->Tree[Node] = Header->Tree[2 * Node] + Header->Tree[2 * Node + 1];
+	return (ordered_store_open_t){Store, RADB_SUCCESS};
+}
+
+ordered_store_t *ordered_store_open(const char *Prefix RADB_MEM_PARAMS) {
+	return ordered_store_open2(Prefix RADB_MEM_ARGS).Store;
+}
+
+void ordered_store_close(ordered_store_t *Store) {
+	radb_sync(Store->Header, Store->HeaderSize);
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Store->Prefix);
+	free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+	Store->free(Store->Allocator, (void *)Store->Prefix);
+	Store->free(Store->Allocator, Store);
+#endif
+}
+
+size_t ordered_store_count(ordered_store_t *Store) {
+	return Store->Header->Tree[1];
+}
+
+size_t ordered_store_value_size(ordered_store_t *Store) {
+	return Store->Header->ValueSize;
+}
+
+// Finds the segment holding Rank by walking down the tree, Rank becomes the offset in the segment.
+static size_t ordered_store_locate(ordered_store_header_t *Header, size_t *Rank) {
+	size_t Node = 1;
+	while (Node < Header->NumSegments) {
+		Node *= 2;
+		if (*Rank >= Header->Tree[Node]) *Rank -= Header->Tree[Node++];
+	}
+	return Node - Header->NumSegments;
+}
+
+static void ordered_store_update(ordered_store_header_t *Header, size_t Segment, int Delta) {
+	for (size_t Node = Header->NumSegments + Segment; Node; Node /= 2) Header->Tree[Node] += Delta;
+}
+
+// Copies the values of the window of NumSegments segments from First to Buffer, with Value inserted at Position.
+static void ordered_store_gather(ordered_store_header_t *Header, const char *Values, size_t First, size_t NumSegments, char *Buffer, size_t Position, const void *Value) {
+	size_t ValueSize = Header->ValueSize, SegmentBytes = Header->SegmentSize * ValueSize;
+	size_t Done = 0;
+	for (size_t Segment = First; Segment < First + NumSegments; ++Segment) {
+		size_t Count = Header->Tree[Header->NumSegments + Segment];
+		const char *Source = Values + Segment * SegmentBytes;
+		if (Position >= Done && Position <= Done + Count) {
+			size_t Before = Position - Done;
+			memcpy(Buffer, Source, Before * ValueSize);
+			memcpy(Buffer + Before * ValueSize, Value, ValueSize);
+			memcpy(Buffer + (Before + 1) * ValueSize, Source + Before * ValueSize, (Count - Before) * ValueSize);
+			Buffer += (Count + 1) * ValueSize;
+			Position = INVALID_INDEX;
+		} else {
+			memcpy(Buffer, Source, Count * ValueSize);
+			Buffer += Count * ValueSize;
+		}
+		Done += Count;
+	}
+}
+
+// Spreads Count values from Buffer evenly over the window starting at segment First and recounts the window.
+static void ordered_store_spread(ordered_store_header_t *Header, char *Values, size_t First, size_t NumSegments, const char *Buffer, size_t Count) {
+	size_t ValueSize = Header->ValueSize, SegmentBytes = Header->SegmentSize * ValueSize;
+	for (size_t I = 0; I < NumSegments; ++I) {
+		size_t SegmentCount = Count * (I + 1) / NumSegments - Count * I / NumSegments;
+		memcpy(Values + (First + I) * SegmentBytes, Buffer, SegmentCount * ValueSize);
+		Buffer += SegmentCount * ValueSize;
+		Header->Tree[Header->NumSegments + First + I] = SegmentCount;
+	}
+	size_t Begin = Header->NumSegments + First, End = Begin + NumSegments;
+	while (Begin > 1) {
+		Begin /= 2;
+		End = (End - 1) / 2 + 1;
+		for (size_t Node = Begin; Node < End; ++Node) Header->Tree[Node] = Header->Tree[2 * Node] + Header->Tree[2 * Node + 1];
+	}
+}
+
+// Doubles the number of segments, writing the values evenly spread with Value inserted at Rank to a new file.
+static void ordered_store_grow(ordered_store_t *Store, size_t Rank, const void *Value) {
+	uint64_t Start = radb_time();
+	ordered_store_header_t *Old = Store->Header;
+	size_t Count = Old->Tree[1];
+	char *Buffer = malloc((Count + 1) * Old->ValueSize);
+	ordered_store_gather(Old, Store->Values, 0, Old->NumSegments, Buffer, Rank, Value);
+
+	char FileName2[strlen(Store->Prefix) + 20];
+	sprintf(FileName2, "%s.pma.temp", Store->Prefix);
+	int HeaderFd = open(FileName2, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	size_t HeaderSize;
+	ordered_store_header_t *Header = ordered_store_header_create(HeaderFd, Old->ValueSize, Old->SegmentSize, Old->Height + 1, &HeaderSize);
+	char *Values = (char *)Header + ordered_store_values_offset(Header->NumSegments);
+	ordered_store_spread(Header, Values, 0, Header->NumSegments, Buffer, Count + 1);
+	free(Buffer);
+
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.pma", Store->Prefix);
+	rename(FileName2, FileName);
+
+	Store->HeaderSize = HeaderSize;
+	Store->Header = Header;
+	Store->HeaderFd = HeaderFd;
+	Store->Values = Values;
+
+	Store->Stats->Rebuilds.Time += radb_time() - Start;
+	++Store->Stats->Rebuilds.Count;
+}
+
+// A window of segments at Level above the segments may be filled up to its capacity times
+// 1 - Level / (4 * Height), from full segments down to three quarters for the whole store.
+static int ordered_store_fits(ordered_store_header_t *Header, size_t Node, size_t Level) {
+	uint64_t Capacity = ((uint64_t)Header->SegmentSize << Level);
+	uint64_t Limit = Header->Height ? Capacity * (4 * Header->Height - Level) / (4 * Header->Height) : Capacity;
+	return Header->Tree[Node] + 1 <= Limit;
+}
+
+void ordered_store_insert_at(ordered_store_t *Store, size_t Rank, const void *Value) {
+	ordered_store_header_t *Header = Store->Header;
+	if (Rank > Header->Tree[1]) Rank = Header->Tree[1];
+	size_t Offset = Rank;
+	size_t Segment = ordered_store_locate(Header, &Offset);
+	size_t ValueSize = Header->ValueSize, Count = Header->Tree[Header->NumSegments + Segment];
+	if (Count < Header->SegmentSize) {
+		char *Slot = Store->Values + (Segment * Header->SegmentSize + Offset) * ValueSize;
+		memmove(Slot + ValueSize, Slot, (Count - Offset) * ValueSize);
+		memcpy(Slot, Value, ValueSize);
+		ordered_store_update(Header, Segment, 1);
+		return;
+	}
+	// The segment is full, rebalance the smallest window around it which stays under its density limit.
+	size_t Node = Header->NumSegments + Segment, Level = 0;
+	while (Node > 1 && !ordered_store_fits(Header, Node, Level)) {
+		Node /= 2;
+		++Level;
+	}
+	if (!ordered_store_fits(Header, Node, Level)) {
+		ordered_store_grow(Store, Rank, Value);
+		return;
+	}
+	size_t First = (Node << Level) - Header->NumSegments, NumSegments = (size_t)1 << Level;
+	size_t Position = Offset;
+	for (size_t I = First; I < Segment; ++I) Position += Header->Tree[Header->NumSegments + I];
+	size_t Total = Header->Tree[Node] + 1;
+	char *Buffer = malloc(Total * ValueSize);
+	ordered_store_gather(Header, Store->Values, First, NumSegments, Buffer, Position, Value);
+	ordered_store_spread(Header, Store->Values, First, NumSegments, Buffer, Total);
+	free(Buffer);
+}
+
+void ordered_store_remove_at(ordered_store_t *Store, size_t Rank) {
+	ordered_store_header_t *Header = Store->Header;
+	if (Rank >= Header->Tree[1]) return;
+	size_t Segment = ordered_store_locate(Header, &Rank);
+	size_t ValueSize = Header->ValueSize, Count = Header->Tree[Header->NumSegments + Segment];
+	char *Slot = Store->Values + (Segment * Header->SegmentSize + Rank) * ValueSize;
+	memmove(Slot, Slot + ValueSize, (Count - Rank - 1) * ValueSize);
+	ordered_store_update(Header, Segment, -1);
+}
+
+void *ordered_store_select(ordered_store_t *Store, size_t Rank) {
+	ordered_store_header_t *Header = Store->Header;
+	if (Rank >= Header->Tree[1]) return NULL;
+	size_t Segment = ordered_store_locate(Header, &Rank);
+	return Store->Values + (Segment * Header->SegmentSize + Rank) * Header->ValueSize;
+}
+
+// Returns the number of values less than Key, by a binary search over the ranks.
+size_t ordered_store_rank(ordered_store_t *Store, const void *Key, ordered_store_compare_t Compare, void *Data) {
+	size_t Low = 0, High = Store->Header->Tree[1];
+	while (Low < High) {
+		size_t Middle = (Low + High) / 2;
+		if (Compare(Data, Key, ordered_store_select(Store, Middle)) > 0) {
+			Low = Middle + 1;
+		} else {
+			High = Middle;
+		}
+	}
+	return Low;
+}
+
+void *ordered_store_seek(ordered_store_iterator_t *Iterator, ordered_store_t *Store, size_t Rank) {
+	ordered_store_header_t *Header = Store->Header;
+	Iterator->Store = Store;
+	if (Rank >= Header->Tree[1]) {
+		Iterator->Segment = Header->NumSegments;
+		Iterator->Offset = 0;
+		return NULL;
+	}
+	Iterator->Segment = ordered_store_locate(Header, &Rank);
+	Iterator->Offset = Rank;
+	return Store->Values + (Iterator->Segment * Header->SegmentSize + Rank) * Header->ValueSize;
+}
+
+void *ordered_store_next(ordered_store_iterator_t *Iterator) {
+	ordered_store_t *Store = Iterator->Store;
+	ordered_store_header_t *Header = Store->Header;
+	size_t Segment = Iterator->Segment, Offset = Iterator->Offset + 1;
+	while (Segment < Header->NumSegments && Offset >= Header->Tree[Header->NumSegments + Segment]) {
+		++Segment;
+		Offset = 0;
+	}
+	Iterator->Segment = Segment;
+	Iterator->Offset = Offset;
+	if (Segment >= Header->NumSegments) return NULL;
+	return Store->Values + (Segment * Header->SegmentSize + Offset) * Header->ValueSize;
+}
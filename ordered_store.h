@@ -0,0 +1,42 @@
+#ifndef ORDERED_STORE_H
+#define ORDERED_STORE_H
+
+#include "config.h"
+#include "common.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+typedef struct ordered_store_t ordered_store_t;
+
+// SegmentBytes is rounded down to a power of two number of values, at least 8, the store keeps the segment size in values.
+ordered_store_t *ordered_store_create(const char *Prefix, size_t ValueSize, size_t SegmentBytes RADB_MEM_PARAMS);
+ordered_store_t *ordered_store_open(const char *Prefix RADB_MEM_PARAMS);
+void ordered_store_close(ordered_store_t *Store);
+
+typedef struct {
+	ordered_store_t *Store;
+	radb_error_t Error;
+} ordered_store_open_t;
+
+ordered_store_open_t ordered_store_open2(const char *Prefix RADB_MEM_PARAMS);
+
+size_t ordered_store_count(ordered_store_t *Store);
+size_t ordered_store_value_size(ordered_store_t *Store);
+
+void ordered_store_insert_at(ordered_store_t *Store, size_t Rank, const void *Value);
+void ordered_store_remove_at(ordered_store_t *Store, size_t Rank);
+void *ordered_store_select(ordered_store_t *Store, size_t Rank);
+
+typedef int (*ordered_store_compare_t)(void *Data, const void *Key, const void *Value);
+
+size_t ordered_store_rank(ordered_store_t *Store, const void *Key, ordered_store_compare_t Compare, void *Data);
+
+typedef struct {
+	ordered_store_t *Store;
+	size_t Segment, Offset;
+} ordered_store_iterator_t;
+
+void *ordered_store_seek(ordered_store_iterator_t *Iterator, ordered_store_t *Store, size_t Rank);
+void *ordered_store_next(ordered_store_iterator_t *Iterator);
+
+#endif
@@ -0,0 +1,184 @@
+#include "packed_store.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumEntries, Width;
+	uint64_t DataOffset, DataSize;
+} packed_header_t;
+
+struct packed_store_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	packed_header_t *Header;
+	const unsigned char *Offsets;
+	const unsigned char *Data;
+	uint64_t Mask;
+	size_t HeaderSize;
+	int HeaderFd;
+};
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define PACKED_STORE_SIGNATURE 0x50534152
+#define PACKED_STORE_VERSION MAKE_VERSION(1, 0)
+
+// Offsets are read with a single unaligned 64-bit load, which limits the width to 56 bits.
+static inline uint64_t packed_offset(const unsigned char *Offsets, size_t Width, uint64_t Mask, size_t Index) {
+	size_t Bit = Index * Width;
+	uint64_t Word;
+	memcpy(&Word, Offsets + Bit / 8, sizeof(uint64_t));
+	return (Word >> (Bit % 8)) & Mask;
+}
+
+// Entries after the last non-empty value are left out, freed entries have no value and are stored empty.
+radb_error_t packed_store_build(string_store_t *Source, const char *Prefix) {
+	size_t NumEntries = string_store_num_entries(Source);
+	while (NumEntries && !string_store_size(Source, NumEntries - 1)) --NumEntries;
+	uint64_t DataSize = 0;
+	for (size_t I = 0; I < NumEntries; ++I) DataSize += string_store_size(Source, I);
+	size_t Width = 1;
+	while (Width < 56 && (DataSize >> Width)) ++Width;
+	size_t OffsetsSize = ((NumEntries + 1) * Width + 7) / 8 + sizeof(uint64_t);
+	uint64_t DataOffset = (sizeof(packed_header_t) + OffsetsSize + 7) & ~7;
+	size_t HeaderSize = DataOffset + DataSize;
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.packed", Prefix);
+	int HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	if (HeaderFd < 0) return RADB_WRITE_FAILED;
+	if (ftruncate(HeaderFd, HeaderSize)) {
+		close(HeaderFd);
+		return RADB_WRITE_FAILED;
+	}
+	packed_header_t *Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, HeaderFd, 0);
+	if (Header == MAP_FAILED) {
+		close(HeaderFd);
+		return RADB_WRITE_FAILED;
+	}
+	Header->Signature = PACKED_STORE_SIGNATURE;
+	Header->Version = PACKED_STORE_VERSION;
+	Header->NumEntries = NumEntries;
+	Header->Width = Width;
+	Header->DataOffset = DataOffset;
+	Header->DataSize = DataSize;
+	unsigned char *Offsets = (unsigned char *)(Header + 1);
+	unsigned char *Data = (unsigned char *)Header + DataOffset;
+	uint64_t Offset = 0;
+	for (size_t I = 0; I <= NumEntries; ++I) {
+		size_t Bit = I * Width;
+		uint64_t Word;
+		memcpy(&Word, Offsets + Bit / 8, sizeof(uint64_t));
+		Word |= Offset << (Bit % 8);
+		memcpy(Offsets + Bit / 8, &Word, sizeof(uint64_t));
+		if (I == NumEntries) break;
+		size_t Length = string_store_size(Source, I);
+		if (!Length) continue;
+		string_store_get(Source, I, Data + Offset, Length);
+		Offset += Length;
+	}
+	radb_error_t Error = msync(Header, HeaderSize, MS_SYNC) ? RADB_WRITE_FAILED : RADB_SUCCESS;
+	munmap(Header, HeaderSize);
+	close(HeaderFd);
+	return Error;
+}
+
+packed_store_open_t packed_store_open2(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.packed", Prefix);
+	if (stat(FileName, Stat)) return (packed_store_open_t){NULL, RADB_FILE_NOT_FOUND};
+#if defined(RADB_MEM_MALLOC)
+	packed_store_t *Store = malloc(sizeof(packed_store_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	packed_store_t *Store = GC_malloc(sizeof(packed_store_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	packed_store_t *Store = alloc(Allocator, sizeof(packed_store_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	Store->HeaderFd = open(FileName, O_RDONLY, 0777);
+	Store->HeaderSize = Stat->st_size;
+	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ, MAP_SHARED, Store->HeaderFd, 0);
+	if (Store->HeaderSize < sizeof(packed_header_t) || Store->Header->Signature != PACKED_STORE_SIGNATURE) {
+		packed_store_close(Store);
+		return (packed_store_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+	if (Store->Header->DataOffset + Store->Header->DataSize > Store->HeaderSize) {
+		packed_store_close(Store);
+		return (packed_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+	}
+	Store->Offsets = (const unsigned char *)(Store->Header + 1);
+	Store->Data = (const unsigned char *)Store->Header + Store->Header->DataOffset;
+	Store->Mask = (1ULL << Store->Header->Width) - 1;
+	return (packed_store_open_t){Store, RADB_SUCCESS};
+}
+
+packed_store_t *packed_store_open(const char *Prefix RADB_MEM_PARAMS) {
+	return packed_store_open2(Prefix RADB_MEM_ARGS).Store;
+}
+
+void packed_store_close(packed_store_t *Store) {
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Store->Prefix);
+	free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+	Store->free(Store->Allocator, (void *)Store->Prefix);
+	Store->free(Store->Allocator, Store);
+#endif
+}
+
+size_t packed_store_num_entries(packed_store_t *Store) {
+	return Store->Header->NumEntries;
+}
+
+packed_store_view_t packed_store_view(packed_store_t *Store, size_t Index) {
+	if (Index >= Store->Header->NumEntries) return (packed_store_view_t){NULL, 0};
+	size_t Width = Store->Header->Width;
+	uint64_t Start = packed_offset(Store->Offsets, Width, Store->Mask, Index);
+	uint64_t End = packed_offset(Store->Offsets, Width, Store->Mask, Index + 1);
+	return (packed_store_view_t){Store->Data + Start, End - Start};
+}
+
+size_t packed_store_size(packed_store_t *Store, size_t Index) {
+	return packed_store_view(Store, Index).Length;
+}
+
+size_t packed_store_get(packed_store_t *Store, size_t Index, void *Buffer, size_t Space) {
+	packed_store_view_t View = packed_store_view(Store, Index);
+	if (View.Length < Space) Space = View.Length;
+	memcpy(Buffer, View.Value, Space);
+	return Space;
+}
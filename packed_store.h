@@ -0,0 +1,34 @@
+#ifndef PACKED_STORE_H
+#define PACKED_STORE_H
+
+#include "config.h"
+#include "common.h"
+#include "string_store.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+typedef struct packed_store_t packed_store_t;
+
+radb_error_t packed_store_build(string_store_t *Source, const char *Prefix);
+packed_store_t *packed_store_open(const char *Prefix RADB_MEM_PARAMS);
+void packed_store_close(packed_store_t *Store);
+
+typedef struct {
+	packed_store_t *Store;
+	radb_error_t Error;
+} packed_store_open_t;
+
+packed_store_open_t packed_store_open2(const char *Prefix RADB_MEM_PARAMS);
+
+size_t packed_store_num_entries(packed_store_t *Store);
+size_t packed_store_size(packed_store_t *Store, size_t Index);
+size_t packed_store_get(packed_store_t *Store, size_t Index, void *Buffer, size_t Space);
+
+typedef struct {
+	const void *Value;
+	size_t Length;
+} packed_store_view_t;
+
+packed_store_view_t packed_store_view(packed_store_t *Store, size_t Index);
+
+#endif
@@ -0,0 +1,91 @@
+#include "pages.h"
+#include "trace.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define RADB_PAGES_SIGNATURE 0x47504152
+#define RADB_PAGES_VERSION MAKE_VERSION(1, 0)
+
+static size_t radb_pages_size(size_t NumDirectory, size_t NumTables) {
+	return sizeof(radb_pages_header_t) + (NumDirectory + NumTables * RADB_PAGES_TABLE_SIZE) * sizeof(uint32_t);
+}
+
+// The directory covers every page of the 32 bit index space, tables are appended as they are needed.
+void radb_pages_create(radb_pages_t *Pages, const char *FileName, size_t PageShift) {
+	size_t NumPages = ((size_t)1 << 32) >> PageShift;
+	size_t NumDirectory = (NumPages + RADB_PAGES_TABLE_SIZE - 1) / RADB_PAGES_TABLE_SIZE;
+	Pages->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Pages->HeaderSize = radb_pages_size(NumDirectory, 0);
+	ftruncate(Pages->HeaderFd, Pages->HeaderSize);
+	Pages->Header = mmap(NULL, Pages->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Pages->HeaderFd, 0);
+	Pages->Header->Signature = RADB_PAGES_SIGNATURE;
+	Pages->Header->Version = RADB_PAGES_VERSION;
+	Pages->Header->PageShift = PageShift;
+	Pages->Header->NumPages = 0;
+	Pages->Header->NumDirectory = NumDirectory;
+	Pages->Header->NumTables = 0;
+}
+
+int radb_pages_open(radb_pages_t *Pages, const char *FileName) {
+	struct stat Stat[1];
+	Pages->Header = NULL;
+	if (stat(FileName, Stat)) return -1;
+	Pages->HeaderFd = open(FileName, O_RDWR, 0777);
+	Pages->HeaderSize = Stat->st_size;
+	Pages->Header = mmap(NULL, Pages->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Pages->HeaderFd, 0);
+	radb_pages_header_t *Header = Pages->Header;
+	if (Pages->HeaderSize < sizeof(radb_pages_header_t) || Header->Signature != RADB_PAGES_SIGNATURE
+		|| Pages->HeaderSize < radb_pages_size(Header->NumDirectory, Header->NumTables)) {
+		munmap(Pages->Header, Pages->HeaderSize);
+		close(Pages->HeaderFd);
+		Pages->Header = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+void radb_pages_close(radb_pages_t *Pages) {
+	radb_sync(Pages->Header, Pages->HeaderSize);
+	munmap(Pages->Header, Pages->HeaderSize);
+	close(Pages->HeaderFd);
+	Pages->Header = NULL;
+}
+
+// Returns the physical page of Page, allocating the next one if it has not been touched. The caller
+// grows its data file to cover Header->NumPages pages.
+size_t radb_pages_map(radb_pages_t *Pages, radb_stats_t *Stats, size_t Page) {
+	size_t Physical = radb_pages_find(Pages, Page);
+	if (Physical != INVALID_INDEX) return Physical;
+	size_t Table = Page / RADB_PAGES_TABLE_SIZE;
+	if (!Pages->Header->Directory[Table]) {
+		size_t HeaderSize = radb_pages_size(Pages->Header->NumDirectory, Pages->Header->NumTables + 1);
+		radb_truncate(Stats, Pages->HeaderFd, HeaderSize);
+		Pages->Header = radb_remap(Stats, Pages->HeaderFd, Pages->Header, Pages->HeaderSize, HeaderSize);
+		Pages->HeaderSize = HeaderSize;
+		Pages->Header->Directory[Table] = ++Pages->Header->NumTables;
+	}
+	radb_pages_header_t *Header = Pages->Header;
+	uint32_t *Slots = Header->Directory + Header->NumDirectory + (Header->Directory[Table] - 1) * RADB_PAGES_TABLE_SIZE;
+	Slots[Page % RADB_PAGES_TABLE_SIZE] = ++Header->NumPages;
+	return Header->NumPages - 1;
+}
+
+// Returns the lowest touched page from Page, or INVALID_INDEX if there is none.
+size_t radb_pages_next(radb_pages_t *Pages, size_t Page) {
+	radb_pages_header_t *Header = Pages->Header;
+	for (size_t Table = Page / RADB_PAGES_TABLE_SIZE; Table < Header->NumDirectory; ++Table) {
+		if (!Header->Directory[Table]) continue;
+		uint32_t *Slots = Header->Directory + Header->NumDirectory + (Header->Directory[Table] - 1) * RADB_PAGES_TABLE_SIZE;
+		size_t Slot = Table == Page / RADB_PAGES_TABLE_SIZE ? Page % RADB_PAGES_TABLE_SIZE : 0;
+		for (; Slot < RADB_PAGES_TABLE_SIZE; ++Slot) {
+			if (Slots[Slot]) return Table * RADB_PAGES_TABLE_SIZE + Slot;
+		}
+	}
+	return INVALID_INDEX;
+}
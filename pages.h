@@ -0,0 +1,43 @@
+#ifndef RADB_PAGES_H
+#define RADB_PAGES_H
+
+#include "common.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+#define RADB_PAGES_TABLE_SIZE 1024
+
+// A persistent two level page table mapping the pages of a sparse index space to physical pages
+// which are numbered in the order they were first touched. Directory and table slots hold the
+// table or page number plus one, so the zero filled space of a new file reads as absent.
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t PageShift, NumPages;
+	uint32_t NumDirectory, NumTables;
+	uint32_t Directory[];
+} radb_pages_header_t;
+
+typedef struct {
+	radb_pages_header_t *Header;
+	size_t HeaderSize;
+	int HeaderFd;
+} radb_pages_t;
+
+void radb_pages_create(radb_pages_t *Pages, const char *FileName, size_t PageShift);
+int radb_pages_open(radb_pages_t *Pages, const char *FileName);
+void radb_pages_close(radb_pages_t *Pages);
+
+size_t radb_pages_map(radb_pages_t *Pages, radb_stats_t *Stats, size_t Page);
+size_t radb_pages_next(radb_pages_t *Pages, size_t Page);
+
+// Returns the physical page of Page, or INVALID_INDEX if it has not been touched.
+static inline size_t radb_pages_find(radb_pages_t *Pages, size_t Page) {
+	radb_pages_header_t *Header = Pages->Header;
+	size_t Table = Page / RADB_PAGES_TABLE_SIZE;
+	if (Table >= Header->NumDirectory || !Header->Directory[Table]) return INVALID_INDEX;
+	uint32_t *Slots = Header->Directory + Header->NumDirectory + (Header->Directory[Table] - 1) * RADB_PAGES_TABLE_SIZE;
+	uint32_t Slot = Slots[Page % RADB_PAGES_TABLE_SIZE];
+	return Slot ? Slot - 1 : INVALID_INDEX;
+}
+
+#endif
@@ -7,5 +7,13 @@
 #include "fixed_index.h"
 #include "string_index2.h"
 #include "string_index0.h"
+#include "frozen_index.h"
+#include "packed_store.h"
+#include "ordered_index.h"
+#include "radix_index.h"
+#include "int_index.h"
+#include "kv_map.h"
+#include "column_store.h"
+#include "ordered_store.h"
 
 #endif
@@ -0,0 +1,547 @@
+#include "radix_index.h"
+#include "string_store.h"
+#include "fixed_store.h"
+#include "trace.h"
+#include "kernel.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// References to children pack the node or key index with the node type in the lowest 3 bits.
+#define RADIX_EMPTY 0
+#define RADIX_LEAF 1
+#define RADIX_NODE4 4
+#define RADIX_NODE16 5
+#define RADIX_NODE48 6
+#define RADIX_NODE256 7
+
+#define RADIX_REF(INDEX, TYPE) (((uint64_t)(INDEX) << 3) | (TYPE))
+#define RADIX_TYPE(REF) ((REF) & 7)
+#define RADIX_INDEX(REF) ((REF) >> 3)
+
+#define RADIX_CHUNK_SIZE 65536
+
+// Every key below a node shares its first Depth bytes, the byte at Depth selects the child.
+// Compressed paths are not stored, they are checked against the key store instead.
+// Terminal is the key of exactly Depth bytes (if any), Leaf is any key below the node.
+typedef struct {
+	uint32_t Depth, Terminal, Leaf;
+	uint16_t Count, Reserved;
+} radix_node_t;
+
+typedef struct {
+	radix_node_t Node;
+	uint8_t Keys[4];
+	uint32_t Padding;
+	uint64_t Children[4];
+} radix_node4_t;
+
+typedef struct {
+	radix_node_t Node;
+	uint8_t Keys[16];
+	uint64_t Children[16];
+} radix_node16_t;
+
+typedef struct {
+	radix_node_t Node;
+	uint8_t Slots[256];
+	uint64_t Children[48];
+} radix_node48_t;
+
+typedef struct {
+	radix_node_t Node;
+	uint64_t Children[256];
+} radix_node256_t;
+
+static const size_t RadixNodeSizes[4] = {
+	sizeof(radix_node4_t), sizeof(radix_node16_t), sizeof(radix_node48_t), sizeof(radix_node256_t)
+};
+
+static const size_t RadixNodeCapacities[4] = {4, 16, 48, 256};
+
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t Count, Reserved;
+	uint64_t Root;
+} radix_header_t;
+
+struct radix_index_t {
+#ifdef RADB_MEM_PER_STORE
+	void *Allocator;
+	void *(*alloc)(void *, size_t);
+	void *(*alloc_atomic)(void *, size_t);
+	void (*free)(void *, void *);
+#endif
+	const char *Prefix;
+	radix_header_t *Header;
+	string_store_t *Keys;
+	fixed_store_t *Nodes[4];
+	size_t HeaderSize;
+	int HeaderFd;
+};
+
+#ifdef RADB_MEM_GC
+#include <gc/gc.h>
+#endif
+
+#ifdef RADB_MEM_PER_STORE
+static inline const char *radb_strdup(const char *String, void *Allocator, void *(*alloc_atomic)(void *, size_t)) {
+	size_t Length = strlen(String);
+	char *Copy = alloc_atomic(Allocator, Length + 1);
+	strcpy(Copy, String);
+	return Copy;
+}
+#endif
+
+#define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
+
+#define RADIX_INDEX_SIGNATURE 0x58494452
+#define RADIX_INDEX_VERSION MAKE_VERSION(1, 0)
+
+radix_index_t *radix_index_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
+#if defined(RADB_MEM_MALLOC)
+	radix_index_t *Store = malloc(sizeof(radix_index_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	radix_index_t *Store = GC_malloc(sizeof(radix_index_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	radix_index_t *Store = alloc(Allocator, sizeof(radix_index_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.radix", Prefix);
+	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Store->HeaderSize = sizeof(radix_header_t);
+	ftruncate(Store->HeaderFd, Store->HeaderSize);
+	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
+	Store->Header->Signature = RADIX_INDEX_SIGNATURE;
+	Store->Header->Version = RADIX_INDEX_VERSION;
+	Store->Header->Count = 0;
+	Store->Header->Root = RADIX_EMPTY;
+	// The keys have their own suffix so a string_index2_t at the same prefix keeps its key store.
+	sprintf(FileName, "%s.keys", Prefix);
+	Store->Keys = string_store_create(FileName, KeySize, ChunkSize RADB_MEM_ARGS);
+	for (int I = 0; I < 4; ++I) {
+		sprintf(FileName, "%s.node%d", Prefix, (int)RadixNodeCapacities[I]);
+		Store->Nodes[I] = fixed_store_create(FileName, RadixNodeSizes[I], RADIX_CHUNK_SIZE RADB_MEM_ARGS);
+	}
+	return Store;
+}
+
+radix_index_open_t radix_index_open2(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.radix", Prefix);
+	if (stat(FileName, Stat)) return (radix_index_open_t){NULL, RADB_FILE_NOT_FOUND};
+	if (Stat->st_size < sizeof(radix_header_t)) return (radix_index_open_t){NULL, RADB_HEADER_CORRUPTED};
+	sprintf(FileName, "%s.keys", Prefix);
+	string_store_open_t KeysOpen = string_store_open2(FileName RADB_MEM_ARGS);
+	if (!KeysOpen.Store) return (radix_index_open_t){NULL, KeysOpen.Error + 3};
+	fixed_store_t *Nodes[4];
+	for (int I = 0; I < 4; ++I) {
+		sprintf(FileName, "%s.node%d", Prefix, (int)RadixNodeCapacities[I]);
+		fixed_store_open_t NodesOpen = fixed_store_open2(FileName RADB_MEM_ARGS);
+		if (!NodesOpen.Store) {
+			while (--I >= 0) fixed_store_close(Nodes[I]);
+			string_store_close(KeysOpen.Store);
+			return (radix_index_open_t){NULL, NodesOpen.Error + 3};
+		}
+		Nodes[I] = NodesOpen.Store;
+	}
+#if defined(RADB_MEM_MALLOC)
+	radix_index_t *Store = malloc(sizeof(radix_index_t));
+	Store->Prefix = strdup(Prefix);
+#elif defined(RADB_MEM_GC)
+	radix_index_t *Store = GC_malloc(sizeof(radix_index_t));
+	Store->Prefix = GC_strdup(Prefix);
+#else
+	radix_index_t *Store = alloc(Allocator, sizeof(radix_index_t));
+	Store->Prefix = radb_strdup(Prefix, Allocator, alloc_atomic);
+	Store->Allocator = Allocator;
+	Store->alloc = alloc;
+	Store->alloc_atomic = alloc_atomic;
+	Store->free = free;
+#endif
+	sprintf(FileName, "%s.radix", Prefix);
+	Store->HeaderFd = open(FileName, O_RDWR, 0777);
+	Store->HeaderSize = Stat->st_size;
+	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
+	Store->Keys = KeysOpen.Store;
+	memcpy(Store->Nodes, Nodes, sizeof(Nodes));
+	if (Store->Header->Signature != RADIX_INDEX_SIGNATURE) {
+		radix_index_close(Store);
+		return (radix_index_open_t){NULL, RADB_HEADER_MISMATCH};
+	}
+	return (radix_index_open_t){Store, RADB_SUCCESS};
+}
+
+radix_index_t *radix_index_open(const char *Prefix RADB_MEM_PARAMS) {
+	return radix_index_open2(Prefix RADB_MEM_ARGS).Index;
+}
+
+size_t radix_index_num_entries(radix_index_t *Store) {
+	return Store->Header->Count;
+}
+
+void radix_index_close(radix_index_t *Store) {
+	string_store_close(Store->Keys);
+	for (int I = 0; I < 4; ++I) fixed_store_close(Store->Nodes[I]);
+	radb_sync(Store->Header, Store->HeaderSize);
+	munmap(Store->Header, Store->HeaderSize);
+	close(Store->HeaderFd);
+#if defined(RADB_MEM_MALLOC)
+	free((void *)Store->Prefix);
+	free(Store);
+#elif defined(RADB_MEM_GC)
+#else
+	Store->free(Store->Allocator, (void *)Store->Prefix);
+	Store->free(Store->Allocator, Store);
+#endif
+}
+
+size_t radix_index_size(radix_index_t *Store, size_t Index) {
+	return string_store_size(Store->Keys, Index);
+}
+
+size_t radix_index_get(radix_index_t *Store, size_t Index, void *Buffer, size_t Space) {
+	return string_store_get(Store->Keys, Index, Buffer, Space);
+}
+
+static inline radix_node_t *radix_node(radix_index_t *Store, uint64_t Ref) {
+	return (radix_node_t *)fixed_store_get(Store->Nodes[RADIX_TYPE(Ref) - RADIX_NODE4], RADIX_INDEX(Ref));
+}
+
+static uint64_t *radix_child(radix_node_t *Node, int Type, unsigned char Byte) {
+	switch (Type) {
+	case RADIX_NODE4: {
+		radix_node4_t *Node4 = (radix_node4_t *)Node;
+		for (int I = 0; I < Node->Count; ++I) if (Node4->Keys[I] == Byte) return Node4->Children + I;
+		return NULL;
+	}
+	case RADIX_NODE16: {
+		radix_node16_t *Node16 = (radix_node16_t *)Node;
+		size_t I = radb_find16(Node16->Keys, Node->Count, Byte);
+		return I < Node->Count ? Node16->Children + I : NULL;
+	}
+	case RADIX_NODE48: {
+		radix_node48_t *Node48 = (radix_node48_t *)Node;
+		int Slot = Node48->Slots[Byte];
+		return Slot ? Node48->Children + Slot - 1 : NULL;
+	}
+	default: {
+		radix_node256_t *Node256 = (radix_node256_t *)Node;
+		return Node256->Children[Byte] ? Node256->Children + Byte : NULL;
+	}
+	}
+}
+
+// Returns the slot refering to a node, which may have moved if a node was allocated since it was found.
+static uint64_t *radix_slot(radix_index_t *Store, uint64_t Parent, unsigned char Byte) {
+	if (Parent == RADIX_EMPTY) return &Store->Header->Root;
+	return radix_child(radix_node(Store, Parent), RADIX_TYPE(Parent), Byte);
+}
+
+static fixed_store_alloc_t radix_node_alloc(radix_index_t *Store, int Type) {
+	fixed_store_alloc_t Alloc = fixed_store_alloc2(Store->Nodes[Type - RADIX_NODE4]);
+	memset(Alloc.Value, 0, RadixNodeSizes[Type - RADIX_NODE4]);
+	return Alloc;
+}
+
+static void radix_node_add(radix_node_t *Node, int Type, unsigned char Byte, uint64_t Child) {
+	switch (Type) {
+	case RADIX_NODE4:
+	case RADIX_NODE16: {
+		uint8_t *Keys = (Type == RADIX_NODE4) ? ((radix_node4_t *)Node)->Keys : ((radix_node16_t *)Node)->Keys;
+		uint64_t *Children = (Type == RADIX_NODE4) ? ((radix_node4_t *)Node)->Children : ((radix_node16_t *)Node)->Children;
+		int Position = Node->Count;
+		while (Position > 0 && Keys[Position - 1] > Byte) --Position;
+		memmove(Keys + Position + 1, Keys + Position, Node->Count - Position);
+		memmove(Children + Position + 1, Children + Position, (Node->Count - Position) * sizeof(uint64_t));
+		Keys[Position] = Byte;
+		Children[Position] = Child;
+		break;
+	}
+	case RADIX_NODE48: {
+		radix_node48_t *Node48 = (radix_node48_t *)Node;
+		Node48->Children[Node->Count] = Child;
+		Node48->Slots[Byte] = Node->Count + 1;
+		break;
+	}
+	default:
+		((radix_node256_t *)Node)->Children[Byte] = Child;
+		break;
+	}
+	++Node->Count;
+}
+
+static void radix_node_grow(radix_node_t *Target, radix_node_t *Source, int Type) {
+	*Target = *Source;
+	switch (Type) {
+	case RADIX_NODE4: {
+		radix_node4_t *Node4 = (radix_node4_t *)Source;
+		radix_node16_t *Node16 = (radix_node16_t *)Target;
+		memcpy(Node16->Keys, Node4->Keys, Source->Count);
+		memcpy(Node16->Children, Node4->Children, Source->Count * sizeof(uint64_t));
+		break;
+	}
+	case RADIX_NODE16: {
+		radix_node16_t *Node16 = (radix_node16_t *)Source;
+		radix_node48_t *Node48 = (radix_node48_t *)Target;
+		for (int I = 0; I < Source->Count; ++I) {
+			Node48->Slots[Node16->Keys[I]] = I + 1;
+			Node48->Children[I] = Node16->Children[I];
+		}
+		break;
+	}
+	case RADIX_NODE48: {
+		radix_node48_t *Node48 = (radix_node48_t *)Source;
+		radix_node256_t *Node256 = (radix_node256_t *)Target;
+		for (int I = 0; I < 256; ++I) {
+			if (Node48->Slots[I]) Node256->Children[I] = Node48->Children[Node48->Slots[I] - 1];
+		}
+		break;
+	}
+	}
+}
+
+static void radix_add_child(radix_index_t *Store, uint64_t Parent, unsigned char ParentByte, uint64_t Ref, unsigned char Byte, uint64_t Child) {
+	int Type = RADIX_TYPE(Ref);
+	radix_node_t *Node = radix_node(Store, Ref);
+	if (Node->Count < RadixNodeCapacities[Type - RADIX_NODE4]) {
+		radix_node_add(Node, Type, Byte, Child);
+		return;
+	}
+	fixed_store_alloc_t Alloc = radix_node_alloc(Store, Type + 1);
+	Node = radix_node(Store, Ref);
+	radix_node_grow(Alloc.Value, Node, Type);
+	radix_node_add(Alloc.Value, Type + 1, Byte, Child);
+	fixed_store_free(Store->Nodes[Type - RADIX_NODE4], RADIX_INDEX(Ref));
+	*radix_slot(Store, Parent, ParentByte) = RADIX_REF(Alloc.Index, Type + 1);
+}
+
+// Returns the number of leading bytes shared by Key and the stored key, setting Next to the following byte of the stored key (or -1).
+static size_t radix_common(radix_index_t *Store, size_t Index, const unsigned char *Key, size_t Length, int *Next) {
+	string_store_reader_t Reader[1];
+	string_store_reader_open(Reader, Store->Keys, Index);
+	unsigned char Buffer[64];
+	size_t Common = 0;
+	for (;;) {
+		size_t Read = string_store_reader_read(Reader, Buffer, sizeof(Buffer));
+		if (!Read) {
+			*Next = -1;
+			return Common;
+		}
+		for (size_t I = 0; I < Read; ++I) {
+			if (Common == Length || Buffer[I] != Key[Common]) {
+				*Next = Buffer[I];
+				return Common;
+			}
+			++Common;
+		}
+	}
+}
+
+// Finds a key sharing the longest possible prefix with Key, without checking the compressed paths.
+static size_t radix_representative(radix_index_t *Store, const unsigned char *Key, size_t Length) {
+	uint64_t Ref = Store->Header->Root;
+	for (;;) {
+		if (RADIX_TYPE(Ref) == RADIX_LEAF) return RADIX_INDEX(Ref);
+		radix_node_t *Node = radix_node(Store, Ref);
+		if (Length <= Node->Depth) {
+			if (Length == Node->Depth && Node->Terminal != INVALID_INDEX) return Node->Terminal;
+			return Node->Leaf;
+		}
+		uint64_t *Child = radix_child(Node, RADIX_TYPE(Ref), Key[Node->Depth]);
+		if (!Child) return Node->Leaf;
+		Ref = *Child;
+	}
+}
+
+index_result_t radix_index_insert2(radix_index_t *Store, const char *Key0, size_t Length) {
+	if (!Length) Length = strlen(Key0);
+	const unsigned char *Key = (const unsigned char *)Key0;
+	size_t Index;
+	if (Store->Header->Root == RADIX_EMPTY) {
+		Index = string_store_alloc(Store->Keys);
+		string_store_set(Store->Keys, Index, Key, Length);
+		Store->Header->Root = RADIX_REF(Index, RADIX_LEAF);
+		++Store->Header->Count;
+		return (index_result_t){Index, 1};
+	}
+	size_t Other = radix_representative(Store, Key, Length);
+	size_t OtherLength = string_store_size(Store->Keys, Other);
+	int OtherNext;
+	size_t Common = radix_common(Store, Other, Key, Length, &OtherNext);
+	if (Common == Length && Common == OtherLength) return (index_result_t){Other, 0};
+	Index = string_store_alloc(Store->Keys);
+	string_store_set(Store->Keys, Index, Key, Length);
+	uint64_t Parent = RADIX_EMPTY, Ref = Store->Header->Root;
+	unsigned char ParentByte = 0;
+	for (;;) {
+		if (RADIX_TYPE(Ref) != RADIX_LEAF) {
+			radix_node_t *Node = radix_node(Store, Ref);
+			if (Node->Depth <= Common) {
+				if (Node->Depth == Length) {
+					Node->Terminal = Index;
+					break;
+				}
+				unsigned char Byte = Key[Node->Depth];
+				uint64_t *Child = radix_child(Node, RADIX_TYPE(Ref), Byte);
+				if (!Child) {
+					radix_add_child(Store, Parent, ParentByte, Ref, Byte, RADIX_REF(Index, RADIX_LEAF));
+					break;
+				}
+				Parent = Ref;
+				ParentByte = Byte;
+				Ref = *Child;
+				continue;
+			}
+		}
+		// The new key leaves the path at Common, so a node is inserted above Ref.
+		fixed_store_alloc_t Alloc = radix_node_alloc(Store, RADIX_NODE4);
+		radix_node_t *Node = Alloc.Value;
+		Node->Depth = Common;
+		Node->Leaf = Index;
+		Node->Terminal = INVALID_INDEX;
+		if (OtherNext < 0) {
+			Node->Terminal = Other;
+		} else {
+			radix_node_add(Node, RADIX_NODE4, OtherNext, Ref);
+		}
+		if (Length == Common) {
+			Node->Terminal = Index;
+		} else {
+			radix_node_add(Node, RADIX_NODE4, Key[Common], RADIX_REF(Index, RADIX_LEAF));
+		}
+		*radix_slot(Store, Parent, ParentByte) = RADIX_REF(Alloc.Index, RADIX_NODE4);
+		break;
+	}
+	++Store->Header->Count;
+	return (index_result_t){Index, 1};
+}
+
+size_t radix_index_insert(radix_index_t *Store, const char *Key, size_t Length) {
+	return radix_index_insert2(Store, Key, Length).Index;
+}
+
+size_t radix_index_search(radix_index_t *Store, const char *Key, size_t Length) {
+	if (!Length) Length = strlen(Key);
+	uint64_t Ref = Store->Header->Root;
+	while (Ref != RADIX_EMPTY) {
+		if (RADIX_TYPE(Ref) == RADIX_LEAF) {
+			size_t Index = RADIX_INDEX(Ref);
+			return string_store_compare(Store->Keys, Key, Length, Index) ? INVALID_INDEX : Index;
+		}
+		radix_node_t *Node = radix_node(Store, Ref);
+		if (Length < Node->Depth) return INVALID_INDEX;
+		if (Length == Node->Depth) {
+			size_t Index = Node->Terminal;
+			if (Index == INVALID_INDEX) return INVALID_INDEX;
+			return string_store_compare(Store->Keys, Key, Length, Index) ? INVALID_INDEX : Index;
+		}
+		uint64_t *Child = radix_child(Node, RADIX_TYPE(Ref), ((const unsigned char *)Key)[Node->Depth]);
+		if (!Child) return INVALID_INDEX;
+		Ref = *Child;
+	}
+	return INVALID_INDEX;
+}
+
+// Keys ending at nodes on the path to Key are prefixes of each other, so only the deepest needs to be compared with Key.
+static size_t radix_deepest(radix_index_t *Store, const unsigned char *Key, size_t Length, size_t Limit) {
+	size_t Found = INVALID_INDEX;
+	uint64_t Ref = Store->Header->Root;
+	while (Ref != RADIX_EMPTY) {
+		if (RADIX_TYPE(Ref) == RADIX_LEAF) {
+			size_t Index = RADIX_INDEX(Ref);
+			if (string_store_size(Store->Keys, Index) <= Limit) Found = Index;
+			break;
+		}
+		radix_node_t *Node = radix_node(Store, Ref);
+		if (Node->Depth > Limit) break;
+		if (Node->Terminal != INVALID_INDEX) Found = Node->Terminal;
+		if (Node->Depth == Length) break;
+		uint64_t *Child = radix_child(Node, RADIX_TYPE(Ref), Key[Node->Depth]);
+		if (!Child) break;
+		Ref = *Child;
+	}
+	return Found;
+}
+
+size_t radix_index_longest_prefix(radix_index_t *Store, const char *Key0, size_t Length) {
+	if (!Length) Length = strlen(Key0);
+	const unsigned char *Key = (const unsigned char *)Key0;
+	size_t Index = radix_deepest(Store, Key, Length, Length);
+	if (Index == INVALID_INDEX) return INVALID_INDEX;
+	int Next;
+	size_t Common = radix_common(Store, Index, Key, Length, &Next);
+	if (Next < 0) return Index;
+	return radix_deepest(Store, Key, Length, Common);
+}
+
+static int radix_foreach(radix_index_t *Store, uint64_t Ref, void *Data, radix_index_foreach_fn Callback) {
+	if (RADIX_TYPE(Ref) == RADIX_LEAF) return Callback(RADIX_INDEX(Ref), Data);
+	radix_node_t *Node = radix_node(Store, Ref);
+	if (Node->Terminal != INVALID_INDEX) if (Callback(Node->Terminal, Data)) return 1;
+	switch (RADIX_TYPE(Ref)) {
+	case RADIX_NODE4:
+		for (int I = 0; I < Node->Count; ++I) {
+			if (radix_foreach(Store, ((radix_node4_t *)Node)->Children[I], Data, Callback)) return 1;
+		}
+		break;
+	case RADIX_NODE16:
+		for (int I = 0; I < Node->Count; ++I) {
+			if (radix_foreach(Store, ((radix_node16_t *)Node)->Children[I], Data, Callback)) return 1;
+		}
+		break;
+	case RADIX_NODE48: {
+		radix_node48_t *Node48 = (radix_node48_t *)Node;
+		for (int I = 0; I < 256; ++I) {
+			if (Node48->Slots[I]) if (radix_foreach(Store, Node48->Children[Node48->Slots[I] - 1], Data, Callback)) return 1;
+		}
+		break;
+	}
+	default: {
+		radix_node256_t *Node256 = (radix_node256_t *)Node;
+		for (int I = 0; I < 256; ++I) {
+			if (Node256->Children[I]) if (radix_foreach(Store, Node256->Children[I], Data, Callback)) return 1;
+		}
+		break;
+	}
+	}
+	return 0;
+}
+
+int radix_index_prefix_foreach(radix_index_t *Store, const char *Prefix, size_t Length, void *Data, radix_index_foreach_fn Callback) {
+	if (!Length) Length = strlen(Prefix);
+	const unsigned char *Key = (const unsigned char *)Prefix;
+	uint64_t Ref = Store->Header->Root;
+	if (Ref == RADIX_EMPTY) return 0;
+	size_t Other;
+	for (;;) {
+		if (RADIX_TYPE(Ref) == RADIX_LEAF) {
+			Other = RADIX_INDEX(Ref);
+			break;
+		}
+		radix_node_t *Node = radix_node(Store, Ref);
+		if (Node->Depth >= Length) {
+			Other = Node->Leaf;
+			break;
+		}
+		uint64_t *Child = radix_child(Node, RADIX_TYPE(Ref), Key[Node->Depth]);
+		if (!Child) return 0;
+		Ref = *Child;
+	}
+	int Next;
+	if (radix_common(Store, Other, Key, Length, &Next) < Length) return 0;
+	return radix_foreach(Store, Ref, Data, Callback);
+}
@@ -0,0 +1,36 @@
+#ifndef RADIX_INDEX_H
+#define RADIX_INDEX_H
+
+#include "config.h"
+#include "common.h"
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+typedef struct radix_index_t radix_index_t;
+
+radix_index_t *radix_index_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS);
+radix_index_t *radix_index_open(const char *Prefix RADB_MEM_PARAMS);
+size_t radix_index_num_entries(radix_index_t *Store);
+#define radix_index_count radix_index_num_entries
+void radix_index_close(radix_index_t *Store);
+
+typedef struct {
+	radix_index_t *Index;
+	radb_error_t Error;
+} radix_index_open_t;
+
+radix_index_open_t radix_index_open2(const char *Prefix RADB_MEM_PARAMS);
+
+size_t radix_index_insert(radix_index_t *Store, const char *Key, size_t Length);
+size_t radix_index_search(radix_index_t *Store, const char *Key, size_t Length);
+size_t radix_index_longest_prefix(radix_index_t *Store, const char *Key, size_t Length);
+
+index_result_t radix_index_insert2(radix_index_t *Store, const char *Key, size_t Length);
+
+size_t radix_index_size(radix_index_t *Store, size_t Index);
+size_t radix_index_get(radix_index_t *Store, size_t Index, void *Buffer, size_t Space);
+
+typedef int (*radix_index_foreach_fn)(size_t Index, void *Data);
+int radix_index_prefix_foreach(radix_index_t *Store, const char *Prefix, size_t Length, void *Data, radix_index_foreach_fn Callback);
+
+#endif
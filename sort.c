@@ -0,0 +1,96 @@
+#include "sort.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+#define RADIX_PASSES ((32 + RADIX_BITS - 1) / RADIX_BITS)
+
+// Below this many slots the threads cost more than they save.
+#define PARALLEL_THRESHOLD (1 << 16)
+
+typedef struct {
+	const radb_hash_t *Source;
+	radb_hash_t *Target;
+	size_t Count;
+	uint32_t Limit;
+	int Shift;
+	size_t (*Offsets)[RADIX_SIZE];
+} radix_pass_t;
+
+// Digits are inverted so that the result is in descending hash order.
+#define RADIX_DIGIT(HASH, SHIFT) (RADIX_MASK - (((HASH) >> (SHIFT)) & RADIX_MASK))
+
+static void radix_count(radix_pass_t *Pass, int Thread, int NumThreads) {
+	size_t *Counts = Pass->Offsets[Thread];
+	memset(Counts, 0, RADIX_SIZE * sizeof(size_t));
+	size_t Start = Pass->Count * Thread / NumThreads;
+	size_t End = Pass->Count * (Thread + 1) / NumThreads;
+	const radb_hash_t *Source = Pass->Source;
+	uint32_t Limit = Pass->Limit;
+	int Shift = Pass->Shift;
+	for (size_t I = Start; I < End; ++I) {
+		if (Source[I].Link < Limit) ++Counts[RADIX_DIGIT(Source[I].Hash, Shift)];
+	}
+}
+
+static void radix_scatter(radix_pass_t *Pass, int Thread, int NumThreads) {
+	size_t *Offsets = Pass->Offsets[Thread];
+	size_t Start = Pass->Count * Thread / NumThreads;
+	size_t End = Pass->Count * (Thread + 1) / NumThreads;
+	const radb_hash_t *Source = Pass->Source;
+	radb_hash_t *Target = Pass->Target;
+	uint32_t Limit = Pass->Limit;
+	int Shift = Pass->Shift;
+	for (size_t I = Start; I < End; ++I) {
+		if (Source[I].Link < Limit) Target[Offsets[RADIX_DIGIT(Source[I].Hash, Shift)]++] = Source[I];
+	}
+}
+
+radb_hash_t *radb_sort_hashes(const radb_hash_t *Hashes, size_t Size, uint32_t Limit, size_t *Count, void *Keys, radb_hash_compare_t Compare) {
+	int NumThreads = Size < PARALLEL_THRESHOLD ? 1 : radb_get_threads();
+	size_t (*Offsets)[RADIX_SIZE] = malloc(NumThreads * sizeof(size_t[RADIX_SIZE]));
+	radb_hash_t *Buffers[2] = {NULL, NULL};
+	// The first pass reads directly from the table, skipping empty and deleted slots.
+	radix_pass_t Pass = {Hashes, NULL, Size, Limit, 0, Offsets};
+	size_t NumLive = 0;
+	for (int I = 0; I < RADIX_PASSES; ++I) {
+		Pass.Shift = I * RADIX_BITS;
+		radb_parallel((radb_task_t)radix_count, &Pass, NumThreads);
+		size_t Offset = 0;
+		for (int Digit = 0; Digit < RADIX_SIZE; ++Digit) {
+			for (int Thread = 0; Thread < NumThreads; ++Thread) {
+				size_t Count = Offsets[Thread][Digit];
+				Offsets[Thread][Digit] = Offset;
+				Offset += Count;
+			}
+		}
+		if (!I) {
+			NumLive = Offset;
+			Buffers[0] = malloc(NumLive * sizeof(radb_hash_t));
+			Buffers[1] = malloc(NumLive * sizeof(radb_hash_t));
+		}
+		Pass.Target = Buffers[I % 2];
+		radb_parallel((radb_task_t)radix_scatter, &Pass, NumThreads);
+		Pass.Source = Pass.Target;
+		Pass.Count = NumLive;
+		Pass.Limit = 0xFFFFFFFF;
+	}
+	free(Offsets);
+	radb_hash_t *Sorted = Buffers[(RADIX_PASSES - 1) % 2];
+	free(Buffers[RADIX_PASSES % 2]);
+	// Equal hashes keep their previous relative order, sort each run by key.
+	for (size_t I = 1; I < NumLive; ++I) {
+		if (Sorted[I].Hash != Sorted[I - 1].Hash) continue;
+		radb_hash_t Entry = Sorted[I];
+		size_t J = I;
+		while (J > 0 && Sorted[J - 1].Hash == Entry.Hash && Compare(Keys, Entry.Link, Sorted[J - 1].Link) > 0) {
+			Sorted[J] = Sorted[J - 1];
+			--J;
+		}
+		Sorted[J] = Entry;
+	}
+	*Count = NumLive;
+	return Sorted;
+}
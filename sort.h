@@ -0,0 +1,15 @@
+#ifndef RADB_SORT_H
+#define RADB_SORT_H
+
+#include "common.h"
+
+typedef struct {
+	uint32_t Hash;
+	uint32_t Link;
+} radb_hash_t;
+
+typedef int (*radb_hash_compare_t)(void *Keys, uint32_t Link1, uint32_t Link2);
+
+radb_hash_t *radb_sort_hashes(const radb_hash_t *Hashes, size_t Size, uint32_t Limit, size_t *Count, void *Keys, radb_hash_compare_t Compare);
+
+#endif
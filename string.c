@@ -1,5 +1,10 @@
 #include "string_store.h"
 #include "string_index.h"
+#include "trace.h"
+#include "kernel.h"
+#include "bitmap.h"
+#include "pages.h"
+#include "sort.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -25,7 +30,13 @@ static inline const char *radb_strdup(const char *String, void *Allocator, void
 #define MAKE_VERSION(MAJOR, MINOR) (0xFF000000 + (MAJOR << 16) + (MINOR << 8))
 
 #define STRING_STORE_SIGNATURE 0x53534152
+#define STRING_STORE_BITMAP_SIGNATURE 0x42534152
+#define STRING_STORE_SPARSE_SIGNATURE 0x50534152
 #define STRING_STORE_VERSION MAKE_VERSION(1, 0)
+#define STRING_STORE_TAILS_SIGNATURE 0x54534152
+#define STRING_STORE_TAILS_VERSION MAKE_VERSION(1, 0)
+#define STRING_STORE_JUMPS_SIGNATURE 0x4A534152
+#define STRING_STORE_JUMPS_VERSION MAKE_VERSION(1, 0)
 
 typedef struct {
 	uint32_t Link, Length;
@@ -39,6 +50,24 @@ typedef struct {
 	entry_t Entries[];
 } string_store_header_t;
 
+// The last node of each chain of more than one node, indexed by the first node of the chain so that
+// moving entries does not touch it. Slots of single node and freed chains are stale.
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumNodes, Reserved;
+	uint32_t Tails[];
+} string_store_tails_t;
+
+// The root of the jump table of each chain of more than Stride nodes, indexed by the first node of the
+// chain. A jump table holds the node of every Stride-th block of the chain in a radix tree of nodes from
+// the data file, each with NodeSize / 4 slots, deep enough for its number of jumps which follows from
+// the length of the value. Slots of shorter and freed chains are stale.
+typedef struct {
+	uint32_t Signature, Version;
+	uint32_t NumNodes, Stride;
+	uint32_t Tables[];
+} string_store_jumps_t;
+
 struct string_store_t {
 #ifdef RADB_MEM_PER_STORE
 	void *Allocator;
@@ -49,13 +78,80 @@ struct string_store_t {
 	const char *Prefix;
 	string_store_header_t *Header;
 	void *Data;
+	// Bitmap stores track allocated entries in a separate *bitmap* file instead of a free chain.
+	radb_bitmap_t Bitmap[1];
+	// Sparse stores map pages of entries through a *pages* file and keep only touched pages after the header.
+	radb_pages_t Pages[1];
+	// Tail pointers in a *tails* file, built by string_store_tails_build() and kept current by writes.
+	string_store_tails_t *Tails;
+	size_t TailsSize;
+	int TailsFd;
+	// Jump tables indexed through a *jumps* file, built by string_store_jumps_build() and kept current by writes.
+	string_store_jumps_t *Jumps;
+	size_t JumpsSize;
+	int JumpsFd;
 	size_t HeaderSize;
 	int HeaderFd, DataFd;
+	radb_stats_t Stats[1];
 };
 
 #define NODE_LINK(Node) (*(uint32_t *)(Node + NodeSize - 4))
 
-string_store_t *string_store_create(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+#define STRING_STORE_BITMAP 1
+#define STRING_STORE_SPARSE 2
+
+// Sparse entry pages are 4KB, the space between touched pages is never mapped.
+#define STRING_STORE_PAGE_SHIFT 9
+
+// Seeking walks at most STRING_STORE_JUMP_STRIDE - 1 links from the nearest jump.
+#define STRING_STORE_JUMP_STRIDE 8
+
+static const entry_t EmptyEntry = {INVALID_INDEX, 0};
+
+static inline size_t string_store_num_blocks(size_t Length, size_t NodeSize) {
+	return (Length > NodeSize) ? 1 + (Length - 5) / (NodeSize - 4) : (Length != 0);
+}
+
+static void string_store_init_entries(entry_t *Entries, size_t Count) {
+	for (size_t I = 0; I < Count; ++I) {
+		Entries[I].Link = INVALID_INDEX;
+		Entries[I].Length = 0;
+	}
+}
+
+// Maps a page on first touch, the entries file grows by at least half so that remapping stays amortized.
+static entry_t *string_store_touch_entry(string_store_t *Store, size_t Index) {
+	size_t Page = radb_pages_map(Store->Pages, Store->Stats, Index >> STRING_STORE_PAGE_SHIFT);
+	size_t PageSize = sizeof(entry_t) << STRING_STORE_PAGE_SHIFT;
+	size_t HeaderSize = sizeof(string_store_header_t) + (Page + 1) * PageSize;
+	if (HeaderSize > Store->HeaderSize) {
+		size_t NumPages = (Store->HeaderSize - sizeof(string_store_header_t)) / PageSize;
+		if (Page + 1 < NumPages + NumPages / 2) HeaderSize = sizeof(string_store_header_t) + (NumPages + NumPages / 2) * PageSize;
+		radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+		Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
+		Store->HeaderSize = HeaderSize;
+	}
+	entry_t *Entries = Store->Header->Entries + (Page << STRING_STORE_PAGE_SHIFT);
+	string_store_init_entries(Entries, (size_t)1 << STRING_STORE_PAGE_SHIFT);
+	return Entries + (Index & (((size_t)1 << STRING_STORE_PAGE_SHIFT) - 1));
+}
+
+static inline entry_t *string_store_entry(string_store_t *Store, size_t Index) {
+	if (!Store->Pages->Header) return Store->Header->Entries + Index;
+	size_t Page = radb_pages_find(Store->Pages, Index >> STRING_STORE_PAGE_SHIFT);
+	if (Page == INVALID_INDEX) return string_store_touch_entry(Store, Index);
+	return Store->Header->Entries + (Page << STRING_STORE_PAGE_SHIFT) + (Index & (((size_t)1 << STRING_STORE_PAGE_SHIFT) - 1));
+}
+
+// Reads of entries on untouched pages see an empty entry instead of mapping the page.
+static inline const entry_t *string_store_lookup_entry(string_store_t *Store, size_t Index) {
+	if (!Store->Pages->Header) return Store->Header->Entries + Index;
+	size_t Page = radb_pages_find(Store->Pages, Index >> STRING_STORE_PAGE_SHIFT);
+	if (Page == INVALID_INDEX) return &EmptyEntry;
+	return Store->Header->Entries + (Page << STRING_STORE_PAGE_SHIFT) + (Index & (((size_t)1 << STRING_STORE_PAGE_SHIFT) - 1));
+}
+
+static string_store_t *string_store_create_mode(const char *Prefix, size_t RequestedSize, size_t ChunkSize, int Mode RADB_MEM_PARAMS) {
 #if defined(RADB_MEM_MALLOC)
 	string_store_t *Store = malloc(sizeof(string_store_t));
 	Store->Prefix = strdup(Prefix);
@@ -73,15 +169,16 @@ string_store_t *string_store_create(const char *Prefix, size_t RequestedSize, si
 	size_t NodeSize = 8;
 	while (NodeSize < RequestedSize) NodeSize *= 2;
 	if (!ChunkSize) ChunkSize = 512;
-	int NumEntries = (512 - sizeof(string_store_header_t)) / sizeof(entry_t);
+	int NumEntries = Mode == STRING_STORE_SPARSE ? 0 : (512 - sizeof(string_store_header_t)) / sizeof(entry_t);
 	int NumNodes = (ChunkSize + NodeSize - 1) / NodeSize;
 	char FileName[strlen(Prefix) + 10];
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	sprintf(FileName, "%s.entries", Prefix);
 	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
 	Store->HeaderSize = sizeof(string_store_header_t) + NumEntries * sizeof(entry_t);
 	ftruncate(Store->HeaderFd, Store->HeaderSize);
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-	Store->Header->Signature = STRING_STORE_SIGNATURE;
+	Store->Header->Signature = Mode == STRING_STORE_SPARSE ? STRING_STORE_SPARSE_SIGNATURE : Mode ? STRING_STORE_BITMAP_SIGNATURE : STRING_STORE_SIGNATURE;
 	Store->Header->Version = STRING_STORE_VERSION;
 	Store->Header->NodeSize = NodeSize;
 	Store->Header->ChunkSize = NumNodes;
@@ -90,10 +187,7 @@ string_store_t *string_store_create(const char *Prefix, size_t RequestedSize, si
 	Store->Header->NumFreeNodes = NumNodes;
 	Store->Header->FreeNode = 0;
 	Store->Header->FreeEntry = 0;
-	for (int I = 0; I < NumEntries; ++I) {
-		Store->Header->Entries[I].Link = INVALID_INDEX;
-		Store->Header->Entries[I].Length = 0;
-	}
+	string_store_init_entries(Store->Header->Entries, NumEntries);
 	sprintf(FileName, "%s.data", Prefix);
 	Store->DataFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
 	ftruncate(Store->DataFd, NumNodes * NodeSize);
@@ -101,11 +195,219 @@ string_store_t *string_store_create(const char *Prefix, size_t RequestedSize, si
 	for (int I = 1; I <= NumNodes; ++I) {
 		*(uint32_t *)(Store->Data + I * NodeSize - 4) = I;
 	}
+	Store->Bitmap->Header = NULL;
+	Store->Pages->Header = NULL;
+	Store->Tails = NULL;
+	Store->Jumps = NULL;
+	sprintf(FileName, "%s.tails", Prefix);
+	unlink(FileName);
+	sprintf(FileName, "%s.jumps", Prefix);
+	unlink(FileName);
+	if (Mode == STRING_STORE_SPARSE) {
+		sprintf(FileName, "%s.pages", Prefix);
+		radb_pages_create(Store->Pages, FileName, STRING_STORE_PAGE_SHIFT);
+		Store->Header->NumEntries = (size_t)1 << STRING_STORE_PAGE_SHIFT;
+	} else if (Mode) {
+		sprintf(FileName, "%s.bitmap", Prefix);
+		radb_bitmap_create(Store->Bitmap, FileName, NumEntries);
+	}
 	//msync(Store->Header, Store->HeaderSize, MS_ASYNC);
 	//msync(Store->Data, Store->Header->NumNodes * NodeSize, MS_ASYNC);
 	return Store;
 }
 
+string_store_t *string_store_create(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return string_store_create_mode(Prefix, RequestedSize, ChunkSize, 0 RADB_MEM_ARGS);
+}
+
+string_store_t *string_store_create_bitmap(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return string_store_create_mode(Prefix, RequestedSize, ChunkSize, STRING_STORE_BITMAP RADB_MEM_ARGS);
+}
+
+string_store_t *string_store_create_sparse(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return string_store_create_mode(Prefix, RequestedSize, ChunkSize, STRING_STORE_SPARSE RADB_MEM_ARGS);
+}
+
+// A tails file which does not cover the data file is ignored.
+static void string_store_open_tails(string_store_t *Store) {
+	struct stat Stat[1];
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.tails", Store->Prefix);
+	Store->Tails = NULL;
+	if (stat(FileName, Stat) || Stat->st_size < sizeof(string_store_tails_t)) return;
+	Store->TailsFd = open(FileName, O_RDWR, 0777);
+	Store->TailsSize = Stat->st_size;
+	Store->Tails = mmap(NULL, Store->TailsSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->TailsFd, 0);
+	string_store_tails_t *Tails = Store->Tails;
+	if (Tails->Signature != STRING_STORE_TAILS_SIGNATURE || Tails->NumNodes != Store->Header->NumNodes
+		|| Store->TailsSize != sizeof(string_store_tails_t) + Tails->NumNodes * sizeof(uint32_t)) {
+		munmap(Store->Tails, Store->TailsSize);
+		close(Store->TailsFd);
+		Store->Tails = NULL;
+	}
+}
+
+// A jumps file which does not cover the data file is ignored.
+static void string_store_open_jumps(string_store_t *Store) {
+	struct stat Stat[1];
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.jumps", Store->Prefix);
+	Store->Jumps = NULL;
+	if (stat(FileName, Stat) || Stat->st_size < sizeof(string_store_jumps_t)) return;
+	Store->JumpsFd = open(FileName, O_RDWR, 0777);
+	Store->JumpsSize = Stat->st_size;
+	Store->Jumps = mmap(NULL, Store->JumpsSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->JumpsFd, 0);
+	string_store_jumps_t *Jumps = Store->Jumps;
+	if (Jumps->Signature != STRING_STORE_JUMPS_SIGNATURE || Jumps->NumNodes != Store->Header->NumNodes || Jumps->Stride < 2
+		|| Store->JumpsSize != sizeof(string_store_jumps_t) + Jumps->NumNodes * sizeof(uint32_t)) {
+		munmap(Store->Jumps, Store->JumpsSize);
+		close(Store->JumpsFd);
+		Store->Jumps = NULL;
+	}
+}
+
+// Called whenever the data file has grown, the tails and jumps files have a slot for every node.
+static void string_store_grow_chains(string_store_t *Store) {
+	if (Store->Tails) {
+		size_t TailsSize = sizeof(string_store_tails_t) + Store->Header->NumNodes * sizeof(uint32_t);
+		radb_truncate(Store->Stats, Store->TailsFd, TailsSize);
+		Store->Tails = radb_remap(Store->Stats, Store->TailsFd, Store->Tails, Store->TailsSize, TailsSize);
+		Store->TailsSize = TailsSize;
+		Store->Tails->NumNodes = Store->Header->NumNodes;
+	}
+	if (Store->Jumps) {
+		size_t JumpsSize = sizeof(string_store_jumps_t) + Store->Header->NumNodes * sizeof(uint32_t);
+		radb_truncate(Store->Stats, Store->JumpsFd, JumpsSize);
+		Store->Jumps = radb_remap(Store->Stats, Store->JumpsFd, Store->Jumps, Store->JumpsSize, JumpsSize);
+		Store->JumpsSize = JumpsSize;
+		Store->Jumps->NumNodes = Store->Header->NumNodes;
+	}
+}
+
+static inline size_t string_store_node_alloc(string_store_t *Store, size_t NodeSize) {
+	if (!Store->Header->NumFreeNodes) {
+		size_t NumNodes = Store->Header->ChunkSize;
+		size_t DataSize = (Store->Header->NumNodes + NumNodes) * NodeSize;
+		RADB_PROBE2(string_store_grow, Store->Header->NumNodes, Store->Header->NumNodes + NumNodes);
+		RADB_LATENCY(RADB_OP_STRING_STORE_GROW);
+		//msync(Store->Data, Store->Header->NumNodes * NodeSize, MS_SYNC);
+		radb_truncate(Store->Stats, Store->DataFd, DataSize);
+		Store->Data = radb_remap(Store->Stats, Store->DataFd, Store->Data, Store->Header->NumNodes * NodeSize, DataSize);
+		size_t Index = Store->Header->NumNodes;
+		size_t FreeEnd = Store->Header->FreeNode = Store->Header->NumNodes + 1;
+		Store->Header->NumNodes += NumNodes;
+		Store->Header->NumFreeNodes += --NumNodes ;
+		while (--NumNodes > 0) FreeEnd = NODE_LINK(Store->Data + FreeEnd * NodeSize) = FreeEnd + 1;
+		string_store_grow_chains(Store);
+		return Index;
+	} else {
+		--Store->Header->NumFreeNodes;
+		size_t Index = Store->Header->FreeNode;
+		Store->Header->FreeNode = NODE_LINK(Store->Data + NodeSize * Index);
+		return Index;
+	}
+}
+
+static size_t string_store_jumps_depth(size_t Count, size_t Fanout) {
+	size_t Depth = 1;
+	for (size_t Capacity = Fanout; Capacity < Count; Capacity *= Fanout) ++Depth;
+	return Depth;
+}
+
+// Returns the Jump-th jump of the chain starting at Head, which has Count jumps.
+static size_t string_store_jump(string_store_t *Store, size_t Head, size_t Jump, size_t Count) {
+	size_t NodeSize = Store->Header->NodeSize, Fanout = NodeSize / 4;
+	size_t Span = 1;
+	for (size_t Depth = string_store_jumps_depth(Count, Fanout); --Depth > 0;) Span *= Fanout;
+	size_t Table = Store->Jumps->Tables[Head];
+	for (; Span > 1; Span /= Fanout) Table = ((uint32_t *)(Store->Data + Table * NodeSize))[(Jump / Span) % Fanout];
+	return ((uint32_t *)(Store->Data + Table * NodeSize))[Jump % Fanout];
+}
+
+// Adds Node as the Count-th jump, adding a level above the root when the tree is full.
+static void string_store_push_jump(string_store_t *Store, size_t Head, size_t Count, size_t Node) {
+	size_t NodeSize = Store->Header->NodeSize, Fanout = NodeSize / 4;
+	if (!Count) {
+		size_t Table = string_store_node_alloc(Store, NodeSize);
+		Store->Jumps->Tables[Head] = Table;
+		((uint32_t *)(Store->Data + Table * NodeSize))[0] = Node;
+		return;
+	}
+	size_t Span = 1;
+	for (size_t Depth = string_store_jumps_depth(Count, Fanout); Depth-- > 0;) Span *= Fanout;
+	if (Count == Span) {
+		size_t Table = string_store_node_alloc(Store, NodeSize);
+		((uint32_t *)(Store->Data + Table * NodeSize))[0] = Store->Jumps->Tables[Head];
+		Store->Jumps->Tables[Head] = Table;
+		Span *= Fanout;
+	}
+	size_t Table = Store->Jumps->Tables[Head];
+	for (Span /= Fanout; Span > 1; Span /= Fanout) {
+		size_t Digit = (Count / Span) % Fanout;
+		if (!(Count % Span)) {
+			size_t Child = string_store_node_alloc(Store, NodeSize);
+			((uint32_t *)(Store->Data + Table * NodeSize))[Digit] = Child;
+		}
+		Table = ((uint32_t *)(Store->Data + Table * NodeSize))[Digit];
+	}
+	((uint32_t *)(Store->Data + Table * NodeSize))[Count % Fanout] = Node;
+}
+
+// Returns the nodes of the subtree at Table, which holds Count jumps with Span of them below each slot,
+// to the free list.
+static void string_store_free_jumps(string_store_t *Store, size_t Table, size_t Span, size_t Count) {
+	size_t NodeSize = Store->Header->NodeSize, Fanout = NodeSize / 4;
+	if (Span > 1) {
+		for (size_t I = 0; I * Span < Count; ++I) {
+			size_t Remain = Count - I * Span;
+			size_t Child = ((uint32_t *)(Store->Data + Table * NodeSize))[I];
+			string_store_free_jumps(Store, Child, Span / Fanout, Remain < Span ? Remain : Span);
+		}
+	}
+	NODE_LINK(Store->Data + Table * NodeSize) = Store->Header->FreeNode;
+	Store->Header->FreeNode = Table;
+	++Store->Header->NumFreeNodes;
+}
+
+// Brings the jump table of the chain starting at Head from OldNumBlocks to NewNumBlocks blocks. Growing
+// chains keep their jumps and walk on from the last one, shrinking chains have theirs rebuilt.
+static void string_store_update_jumps(string_store_t *Store, size_t Head, size_t OldNumBlocks, size_t NewNumBlocks) {
+	size_t NodeSize = Store->Header->NodeSize, Fanout = NodeSize / 4;
+	size_t Stride = Store->Jumps->Stride;
+	size_t OldCount = OldNumBlocks > Stride ? (OldNumBlocks + Stride - 1) / Stride : 0;
+	size_t NewCount = NewNumBlocks > Stride ? (NewNumBlocks + Stride - 1) / Stride : 0;
+	if (NewCount == OldCount) return;
+	if (NewCount < OldCount) {
+		size_t Span = 1;
+		for (size_t Depth = string_store_jumps_depth(OldCount, Fanout); Depth-- > 0;) Span *= Fanout;
+		string_store_free_jumps(Store, Store->Jumps->Tables[Head], Span / Fanout, OldCount);
+		OldCount = 0;
+	}
+	size_t Block = 0, Node = Head;
+	if (OldCount) {
+		Block = (OldCount - 1) * Stride;
+		Node = string_store_jump(Store, Head, OldCount - 1, OldCount);
+	}
+	for (size_t Jump = OldCount; Jump < NewCount; ++Jump) {
+		for (; Block < Jump * Stride; ++Block) Node = NODE_LINK(Store->Data + Node * NodeSize);
+		string_store_push_jump(Store, Head, Jump, Node);
+	}
+}
+
+// Returns the node holding the Block-th block of the chain starting at Head.
+static size_t string_store_block_node(string_store_t *Store, size_t Head, size_t Block, size_t NumBlocks) {
+	size_t NodeSize = Store->Header->NodeSize;
+	if (Store->Tails && NumBlocks > 1 && Block == NumBlocks - 1) return Store->Tails->Tails[Head];
+	size_t Node = Head;
+	size_t Stride = Store->Jumps ? Store->Jumps->Stride : 0;
+	if (Stride && NumBlocks > Stride) {
+		Node = string_store_jump(Store, Head, Block / Stride, (NumBlocks + Stride - 1) / Stride);
+		Block %= Stride;
+	}
+	while (Block--) Node = NODE_LINK(Store->Data + Node * NodeSize);
+	return Node;
+}
+
 string_store_open_t string_store_open2(const char *Prefix RADB_MEM_PARAMS) {
 	struct stat Stat[1];
 	char FileName[strlen(Prefix) + 10];
@@ -125,17 +427,48 @@ string_store_open_t string_store_open2(const char *Prefix RADB_MEM_PARAMS) {
 	Store->alloc_atomic = alloc_atomic;
 	Store->free = free;
 #endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR, 0777);
 	Store->HeaderSize = Stat->st_size;
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-	if (Store->Header->Signature != STRING_STORE_SIGNATURE) {
+	uint32_t Signature = Store->Header->Signature;
+	if (Signature != STRING_STORE_SIGNATURE && Signature != STRING_STORE_BITMAP_SIGNATURE && Signature != STRING_STORE_SPARSE_SIGNATURE) {
 		munmap(Store->Header, Store->HeaderSize);
 		close(Store->HeaderFd);
 		return (string_store_open_t){NULL, RADB_HEADER_MISMATCH};
 	}
+	Store->Bitmap->Header = NULL;
+	if (Store->Header->Signature == STRING_STORE_BITMAP_SIGNATURE) {
+		sprintf(FileName, "%s.bitmap", Prefix);
+		if (radb_bitmap_open(Store->Bitmap, Store->Stats, FileName, Store->Header->NumEntries)) {
+			munmap(Store->Header, Store->HeaderSize);
+			close(Store->HeaderFd);
+			return (string_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+		}
+	}
+	Store->Pages->Header = NULL;
+	if (Signature == STRING_STORE_SPARSE_SIGNATURE) {
+		sprintf(FileName, "%s.pages", Prefix);
+		if (radb_pages_open(Store->Pages, FileName)) {
+			munmap(Store->Header, Store->HeaderSize);
+			close(Store->HeaderFd);
+			return (string_store_open_t){NULL, RADB_HEADER_CORRUPTED};
+		}
+		// The entries file may not have been grown after the last pages were mapped.
+		size_t HeaderSize = sizeof(string_store_header_t) + ((size_t)Store->Pages->Header->NumPages << STRING_STORE_PAGE_SHIFT) * sizeof(entry_t);
+		if (HeaderSize > Store->HeaderSize) {
+			size_t OldEntries = (Store->HeaderSize - sizeof(string_store_header_t)) / sizeof(entry_t);
+			radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+			Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
+			Store->HeaderSize = HeaderSize;
+			string_store_init_entries(Store->Header->Entries + OldEntries, (HeaderSize - sizeof(string_store_header_t)) / sizeof(entry_t) - OldEntries);
+		}
+	}
 	sprintf(FileName, "%s.data", Prefix);
 	Store->DataFd = open(FileName, O_RDWR, 0777);
 	Store->Data = mmap(NULL, Store->Header->NumNodes * Store->Header->NodeSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->DataFd, 0);
+	string_store_open_tails(Store);
+	string_store_open_jumps(Store);
 	return (string_store_open_t){Store, RADB_SUCCESS};
 }
 
@@ -144,8 +477,20 @@ string_store_t *string_store_open(const char *Prefix RADB_MEM_PARAMS) {
 }
 
 void string_store_close(string_store_t *Store) {
-	msync(Store->Data, Store->Header->NumNodes * Store->Header->NodeSize, MS_SYNC);
-	msync(Store->Header, Store->HeaderSize, MS_SYNC);
+	if (Store->Bitmap->Header) radb_bitmap_close(Store->Bitmap);
+	if (Store->Pages->Header) radb_pages_close(Store->Pages);
+	if (Store->Tails) {
+		radb_sync(Store->Tails, Store->TailsSize);
+		munmap(Store->Tails, Store->TailsSize);
+		close(Store->TailsFd);
+	}
+	if (Store->Jumps) {
+		radb_sync(Store->Jumps, Store->JumpsSize);
+		munmap(Store->Jumps, Store->JumpsSize);
+		close(Store->JumpsFd);
+	}
+	radb_sync(Store->Data, Store->Header->NumNodes * Store->Header->NodeSize);
+	radb_sync(Store->Header, Store->HeaderSize);
 	munmap(Store->Data, Store->Header->NumNodes * Store->Header->NodeSize);
 	munmap(Store->Header, Store->HeaderSize);
 	close(Store->DataFd);
@@ -166,45 +511,48 @@ size_t string_store_num_entries(string_store_t *Store) {
 
 size_t string_store_size(string_store_t *Store, size_t Index) {
 	if (Index >= Store->Header->NumEntries) return 0;
-	size_t Link = Store->Header->Entries[Index].Link;
-	if (Link == INVALID_INDEX) return 0;
-	return Store->Header->Entries[Index].Length;
+	const entry_t *Entry = string_store_lookup_entry(Store, Index);
+	if (Entry->Link == INVALID_INDEX) return 0;
+	return Entry->Length;
 }
 
 size_t string_store_get(string_store_t *Store, size_t Index, void *Buffer, size_t Space) {
+	RADB_LATENCY(RADB_OP_STRING_STORE_GET);
 	if (Index >= Store->Header->NumEntries) return 0;
-	size_t Link = Store->Header->Entries[Index].Link;
+	const entry_t *Entry = string_store_lookup_entry(Store, Index);
+	size_t Link = Entry->Link;
 	if (Link == INVALID_INDEX) return 0;
-	size_t Length = Store->Header->Entries[Index].Length;
+	size_t Length = Entry->Length;
 	if (!Length) return Length;
 	size_t NodeSize = Store->Header->NodeSize;
 	void *Node = Store->Data + Link * NodeSize;
 	size_t Total = (Space < Length) ? Space : Length;
 	while (Length > NodeSize) {
 		if (Space < NodeSize - 4) {
-			memcpy(Buffer, Node, Space);
+			radb_copy(Buffer, Node, Space);
 			return Total;
 		}
-		memcpy(Buffer, Node, NodeSize - 4);
+		radb_copy(Buffer, Node, NodeSize - 4);
 		Buffer += NodeSize - 4;
 		Length -= NodeSize - 4;
 		Space -= NodeSize - 4;
 		Node = Store->Data + NodeSize * NODE_LINK(Node);
 	}
-	memcpy(Buffer, Node, (Space < Length) ? Space : Length);
+	radb_copy(Buffer, Node, (Space < Length) ? Space : Length);
 	return Total;
 }
 
 static int string_store_compare_unchecked(string_store_t *Store, const void *Other, size_t Length, size_t Index) {
-	size_t Length2 = Store->Header->Entries[Index].Length;
-	size_t Link = Store->Header->Entries[Index].Link;
+	const entry_t *Entry = string_store_lookup_entry(Store, Index);
+	size_t Length2 = Entry->Length;
+	size_t Link = Entry->Link;
 	size_t NodeSize = Store->Header->NodeSize;
 	void *Node = Store->Data + Link * NodeSize;
 	while (Length2 > NodeSize) {
 		if (Length < NodeSize - 4) {
-			return memcmp(Other, Node, Length) ?: -1;
+			return radb_compare(Other, Node, Length) ?: -1;
 		}
-		int Cmp = memcmp(Other, Node, NodeSize - 4);
+		int Cmp = radb_compare(Other, Node, NodeSize - 4);
 		if (Cmp) return Cmp;
 		Other += NodeSize - 4;
 		Length2 -= NodeSize - 4;
@@ -212,11 +560,11 @@ static int string_store_compare_unchecked(string_store_t *Store, const void *Oth
 		Node = Store->Data + NodeSize * NODE_LINK(Node);
 	}
 	if (Length < Length2) {
-		return memcmp(Other, Node, Length) ?: -1;
+		return radb_compare(Other, Node, Length) ?: -1;
 	} else if (Length > Length2) {
-		return memcmp(Other, Node, Length2) ?: 1;
+		return radb_compare(Other, Node, Length2) ?: 1;
 	} else {
-		return memcmp(Other, Node, Length);
+		return radb_compare(Other, Node, Length);
 	}
 }
 
@@ -226,15 +574,17 @@ int string_store_compare(string_store_t *Store, const void *Other, size_t Length
 }
 
 static int string_store_compare2_unchecked(string_store_t *Store, size_t Index1, size_t Index2) {
-	size_t Length1 = Store->Header->Entries[Index1].Length;
-	size_t Length2 = Store->Header->Entries[Index2].Length;
-	size_t Link1 = Store->Header->Entries[Index1].Link;
-	size_t Link2 = Store->Header->Entries[Index2].Link;
+	const entry_t *Entry1 = string_store_lookup_entry(Store, Index1);
+	const entry_t *Entry2 = string_store_lookup_entry(Store, Index2);
+	size_t Length1 = Entry1->Length;
+	size_t Length2 = Entry2->Length;
+	size_t Link1 = Entry1->Link;
+	size_t Link2 = Entry2->Link;
 	size_t NodeSize = Store->Header->NodeSize;
 	void *Node1 = Store->Data + Link1 * NodeSize;
 	void *Node2 = Store->Data + Link2 * NodeSize;
 	while (Length1 > NodeSize && Length2 > NodeSize) {
-		int Cmp = memcmp(Node1, Node2, NodeSize - 4);
+		int Cmp = radb_compare(Node1, Node2, NodeSize - 4);
 		if (Cmp) return Cmp;
 		Length1 -= NodeSize - 4;
 		Length2 -= NodeSize - 4;
@@ -243,32 +593,32 @@ static int string_store_compare2_unchecked(string_store_t *Store, size_t Index1,
 	}
 	if (Length1 > NodeSize) {
 		if (Length2 > NodeSize - 4) {
-			int Cmp = memcmp(Node1, Node2, NodeSize - 4);
+			int Cmp = radb_compare(Node1, Node2, NodeSize - 4);
 			if (Cmp) return Cmp;
 			Length1 -= NodeSize - 4;
 			Length2 -= NodeSize - 4;
 			Node1 = Store->Data + NodeSize * NODE_LINK(Node1);
-			return memcmp(Node1, Node2 + NodeSize - 4, Length2) ?: 1;
+			return radb_compare(Node1, Node2 + NodeSize - 4, Length2) ?: 1;
 		} else {
-			return memcmp(Node1, Node2, Length2) ?: 1;
+			return radb_compare(Node1, Node2, Length2) ?: 1;
 		}
 	} else if (Length2 > NodeSize) {
 		if (Length1 > NodeSize - 4) {
-			int Cmp = memcmp(Node1, Node2, NodeSize - 4);
+			int Cmp = radb_compare(Node1, Node2, NodeSize - 4);
 			if (Cmp) return Cmp;
 			Length1 -= NodeSize - 4;
 			Length2 -= NodeSize - 4;
 			Node2 = Store->Data + NodeSize * NODE_LINK(Node2);
-			return memcmp(Node1 + NodeSize - 4, Node2, Length1) ?: -1;
+			return radb_compare(Node1 + NodeSize - 4, Node2, Length1) ?: -1;
 		} else {
-			return memcmp(Node1, Node2, Length1) ?: -1;
+			return radb_compare(Node1, Node2, Length1) ?: -1;
 		}
 	} else if (Length1 > Length2) {
-		return memcmp(Node1, Node2, Length2) ?: 1;
+		return radb_compare(Node1, Node2, Length2) ?: 1;
 	} else if (Length2 > Length1) {
-		return memcmp(Node1, Node2, Length1) ?: -1;
+		return radb_compare(Node1, Node2, Length1) ?: -1;
 	} else {
-		return memcmp(Node1, Node2, Length1);
+		return radb_compare(Node1, Node2, Length1);
 	}
 }
 
@@ -278,45 +628,48 @@ int string_store_compare2(string_store_t *Store, size_t Index1, size_t Index2) {
 	return string_store_compare2_unchecked(Store, Index1, Index2);
 }
 
-void string_store_set(string_store_t *Store, size_t Index, const void *Buffer, size_t Length) {
-	if (Index >= Store->Header->NumEntries) {
-		size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
-		NumEntries += 512 - 1;
-		NumEntries /= 512;
-		NumEntries *= 512;
-		size_t HeaderSize = Store->HeaderSize + NumEntries * sizeof(entry_t);
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-		entry_t *Entries = Store->Header->Entries;
-		for (int I = Store->Header->NumEntries; I < Store->Header->NumEntries + NumEntries; ++I) {
-			Entries[I].Link = INVALID_INDEX;
-			Entries[I].Length = 0;
-		}
-		Store->Header->NumEntries += NumEntries;
-		Store->HeaderSize = HeaderSize;
+static void string_store_grow_entries(string_store_t *Store, size_t Index) {
+	if (Store->Pages->Header) {
+		// Sparse stores only extend the index space, pages are mapped when they are touched.
+		size_t NumEntries = ((Index >> STRING_STORE_PAGE_SHIFT) + 1) << STRING_STORE_PAGE_SHIFT;
+		Store->Header->NumEntries = NumEntries < INVALID_INDEX ? NumEntries : INVALID_INDEX;
+		return;
 	}
-	size_t OldLength = Store->Header->Entries[Index].Length;
-	Store->Header->Entries[Index].Length = Length;
+	size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
+	NumEntries += 512 - 1;
+	NumEntries /= 512;
+	NumEntries *= 512;
+	size_t HeaderSize = Store->HeaderSize + NumEntries * sizeof(entry_t);
+	radb_truncate(Store->Stats, Store->HeaderFd, HeaderSize);
+	Store->Header = radb_remap(Store->Stats, Store->HeaderFd, Store->Header, Store->HeaderSize, HeaderSize);
+	string_store_init_entries(Store->Header->Entries + Store->Header->NumEntries, NumEntries);
+	Store->Header->NumEntries += NumEntries;
+	Store->HeaderSize = HeaderSize;
+	if (Store->Bitmap->Header) radb_bitmap_grow(Store->Bitmap, Store->Stats, Store->Header->NumEntries);
+}
+
+void string_store_set(string_store_t *Store, size_t Index, const void *Buffer, size_t Length) {
+	RADB_LATENCY(RADB_OP_STRING_STORE_SET);
+	if (Index >= Store->Header->NumEntries) string_store_grow_entries(Store, Index);
+	if (Store->Bitmap->Header) radb_bitmap_set(Store->Bitmap, Index);
+	size_t OldLength = string_store_entry(Store, Index)->Length;
+	string_store_entry(Store, Index)->Length = Length;
 	size_t NodeSize = Store->Header->NodeSize;
 	size_t OldNumBlocks = (OldLength > NodeSize) ? 1 + (OldLength - 5) / (NodeSize - 4) : (OldLength != 0);
 	size_t NewNumBlocks = (Length > NodeSize) ? 1 + (Length - 5) / (NodeSize - 4) : (Length != 0);
 	if (OldNumBlocks > NewNumBlocks) {
-		size_t FreeStart = Store->Header->Entries[Index].Link;
+		size_t FreeStart = string_store_entry(Store, Index)->Link;
 		if (NewNumBlocks) {
 			void *Node = Store->Data + FreeStart * NodeSize;
 			while (Length > NodeSize) {
-				memcpy(Node, Buffer, NodeSize - 4);
+				radb_copy(Node, Buffer, NodeSize - 4);
 				Buffer += NodeSize - 4;
 				Length -= NodeSize - 4;
 				Node = Store->Data + NodeSize * NODE_LINK(Node);
 			}
 			FreeStart = NODE_LINK(Node);
-			memcpy(Node, Buffer, Length);
+			radb_copy(Node, Buffer, Length);
+			if (Store->Tails) Store->Tails->Tails[string_store_entry(Store, Index)->Link] = (Node - Store->Data) / NodeSize;
 		}
 		void *FreeEnd = Store->Data + FreeStart * NodeSize;
 		size_t NumFree = OldNumBlocks - NewNumBlocks;
@@ -333,14 +686,11 @@ void string_store_set(string_store_t *Store, size_t Index, const void *Buffer, s
 			NumNodes /= Store->Header->ChunkSize;
 			NumNodes *= Store->Header->ChunkSize;
 			size_t DataSize = (Store->Header->NumNodes + NumNodes) * NodeSize;
+			RADB_PROBE2(string_store_grow, Store->Header->NumNodes, Store->Header->NumNodes + NumNodes);
+			RADB_LATENCY(RADB_OP_STRING_STORE_GROW);
 			//msync(Store->Data, Store->Header->NumNodes * NodeSize, MS_SYNC);
-			ftruncate(Store->DataFd, DataSize);
-#ifdef Linux
-			Store->Data = mremap(Store->Data, Store->Header->NumNodes * NodeSize, DataSize, MREMAP_MAYMOVE);
-#else
-			munmap(Store->Data, Store->Header->NumNodes * NodeSize);
-			Store->Data = mmap(NULL, DataSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->DataFd, 0);
-#endif
+			radb_truncate(Store->Stats, Store->DataFd, DataSize);
+			Store->Data = radb_remap(Store->Stats, Store->DataFd, Store->Data, Store->Header->NumNodes * NodeSize, DataSize);
 			size_t FreeEnd;
 			if (NumFree > 0) {
 				FreeEnd = Store->Header->FreeNode;
@@ -352,70 +702,53 @@ void string_store_set(string_store_t *Store, size_t Index, const void *Buffer, s
 			Store->Header->NumNodes += NumNodes;
 			Store->Header->NumFreeNodes += NumNodes - NumRequired;
 			while (--NumNodes > 0) FreeEnd = NODE_LINK(Store->Data + FreeEnd * NodeSize) = FreeEnd + 1;
+			string_store_grow_chains(Store);
 		} else {
 			Store->Header->NumFreeNodes -= NumRequired;
 		}
 		if (OldNumBlocks) {
-			void *Node = Store->Data + Store->Header->Entries[Index].Link * NodeSize;
+			void *Node = Store->Data + string_store_entry(Store, Index)->Link * NodeSize;
 			for (int I = OldNumBlocks; --I > 0;) {
-				memcpy(Node, Buffer, NodeSize - 4);
+				radb_copy(Node, Buffer, NodeSize - 4);
 				Buffer += NodeSize - 4;
 				Length -= NodeSize - 4;
 				Node = Store->Data + NodeSize * NODE_LINK(Node);
 			}
-			memcpy(Node, Buffer, NodeSize - 4);
+			radb_copy(Node, Buffer, NodeSize - 4);
 			Buffer += NodeSize - 4;
 			Length -= NodeSize - 4;
 			NODE_LINK(Node) = Store->Header->FreeNode;
 		} else {
-			Store->Header->Entries[Index].Link = Store->Header->FreeNode;
+			string_store_entry(Store, Index)->Link = Store->Header->FreeNode;
 		}
 		void *Node = Store->Data + Store->Header->FreeNode * NodeSize;
 		while (Length > NodeSize) {
-			memcpy(Node, Buffer, NodeSize - 4);
+			radb_copy(Node, Buffer, NodeSize - 4);
 			Buffer += NodeSize - 4;
 			Length -= NodeSize - 4;
 			Node = Store->Data + NodeSize * NODE_LINK(Node);
 		}
 		Store->Header->FreeNode = NODE_LINK(Node);
-		memcpy(Node, Buffer, Length);
+		radb_copy(Node, Buffer, Length);
+		if (Store->Tails) Store->Tails->Tails[string_store_entry(Store, Index)->Link] = (Node - Store->Data) / NodeSize;
 	} else {
-		void *Node = Store->Data + Store->Header->Entries[Index].Link * NodeSize;
+		void *Node = Store->Data + string_store_entry(Store, Index)->Link * NodeSize;
 		while (Length > NodeSize) {
-			memcpy(Node, Buffer, NodeSize - 4);
+			radb_copy(Node, Buffer, NodeSize - 4);
 			Buffer += NodeSize - 4;
 			Length -= NodeSize - 4;
 			Node = Store->Data + NodeSize * NODE_LINK(Node);
 		}
-		memcpy(Node, Buffer, Length);
+		radb_copy(Node, Buffer, Length);
 	}
+	if (Store->Jumps) string_store_update_jumps(Store, string_store_entry(Store, Index)->Link, OldNumBlocks, NewNumBlocks);
 	//msync(Store->Header, Store->HeaderSize, MS_ASYNC);
 	//msync(Store->Data, Store->Header->NumNodes * NodeSize, MS_ASYNC);
 }
 
 void string_store_shift(string_store_t *Store, size_t Source, size_t Count, size_t Destination) {
 	size_t Index = (Source > Destination ? Source : Destination) + Count;
-	if (Index >= Store->Header->NumEntries) {
-		size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
-		NumEntries += 512 - 1;
-		NumEntries /= 512;
-		NumEntries *= 512;
-		size_t HeaderSize = Store->HeaderSize + NumEntries * sizeof(entry_t);
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-		entry_t *Entries = Store->Header->Entries;
-		for (int I = Store->Header->NumEntries; I < Store->Header->NumEntries + NumEntries; ++I) {
-			Entries[I].Link = INVALID_INDEX;
-			Entries[I].Length = 0;
-		}
-		Store->Header->NumEntries += NumEntries;
-		Store->HeaderSize = HeaderSize;
-	}
+	if (Index >= Store->Header->NumEntries) string_store_grow_entries(Store, Index);
 	size_t LargeSource, LargeDest, LargeCount;
 	size_t SmallSource, SmallDest, SmallCount;
 	if (Source < Destination) {
@@ -453,6 +786,19 @@ void string_store_shift(string_store_t *Store, size_t Source, size_t Count, size
 	} else {
 		return;
 	}
+	if (Store->Pages->Header) {
+		// Sparse pages are not contiguous, entries are moved one at a time in the direction of the move.
+		entry_t *SmallSaved = malloc(SmallCount * sizeof(entry_t));
+		for (size_t I = 0; I < SmallCount; ++I) SmallSaved[I] = *string_store_entry(Store, SmallSource + I);
+		if (LargeDest < LargeSource) {
+			for (size_t I = 0; I < LargeCount; ++I) *string_store_entry(Store, LargeDest + I) = *string_store_entry(Store, LargeSource + I);
+		} else {
+			for (size_t I = LargeCount; I-- > 0;) *string_store_entry(Store, LargeDest + I) = *string_store_entry(Store, LargeSource + I);
+		}
+		for (size_t I = 0; I < SmallCount; ++I) *string_store_entry(Store, SmallDest + I) = SmallSaved[I];
+		free(SmallSaved);
+		return;
+	}
 	entry_t *Entries = Store->Header->Entries;
 	if (SmallCount <= 64) {
 		entry_t *SmallSaved = alloca(SmallCount * sizeof(entry_t));
@@ -469,80 +815,111 @@ void string_store_shift(string_store_t *Store, size_t Source, size_t Count, size
 }
 
 size_t string_store_alloc(string_store_t *Store) {
+	if (Store->Bitmap->Header) {
+		size_t Index = radb_bitmap_find(Store->Bitmap, 0);
+		if (Index >= Store->Header->NumEntries) string_store_grow_entries(Store, Index);
+		radb_bitmap_set(Store->Bitmap, Index);
+		return Index;
+	}
 	size_t FreeEntry = Store->Header->FreeEntry;
-	size_t Index = Store->Header->Entries[FreeEntry].Link;
+	size_t Index = string_store_entry(Store, FreeEntry)->Link;
 	if (Index == INVALID_INDEX) {
 		Index = FreeEntry + 1;
-		if (Index >= Store->Header->NumEntries) {
-			size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
-			NumEntries += 512 - 1;
-			NumEntries /= 512;
-			NumEntries *= 512;
-			size_t HeaderSize = Store->HeaderSize + NumEntries * sizeof(entry_t);
-			ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-			Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-			munmap(Store->Header, Store->HeaderSize);
-			Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-			entry_t *Entries = Store->Header->Entries;
-			for (int I = Store->Header->NumEntries; I < Store->Header->NumEntries + NumEntries; ++I) {
-				Entries[I].Link = INVALID_INDEX;
-				Entries[I].Length = 0;
-			}
-			Store->Header->NumEntries += NumEntries;
-			Store->HeaderSize = HeaderSize;
-		}
+		if (Index >= Store->Header->NumEntries) string_store_grow_entries(Store, Index);
 	}
 	Store->Header->FreeEntry = Index;
 	return FreeEntry;
 }
 
 void string_store_free(string_store_t *Store, size_t Index) {
-	size_t OldLength = Store->Header->Entries[Index].Length;
-	Store->Header->Entries[Index].Length = 0;
+	size_t OldLength = string_store_entry(Store, Index)->Length;
+	string_store_entry(Store, Index)->Length = 0;
 	size_t NodeSize = Store->Header->NodeSize;
 	size_t OldNumBlocks = (OldLength > NodeSize) ? 1 + (OldLength - 5) / (NodeSize - 4) : (OldLength != 0);
 	if (OldNumBlocks > 0) {
-		size_t FreeStart = Store->Header->Entries[Index].Link;
+		size_t FreeStart = string_store_entry(Store, Index)->Link;
+		if (Store->Jumps) string_store_update_jumps(Store, FreeStart, OldNumBlocks, 0);
 		void *FreeEnd = Store->Data + FreeStart * NodeSize;
 		Store->Header->NumFreeNodes += OldNumBlocks;
 		for (int I = OldNumBlocks; --I > 0;) FreeEnd = Store->Data + NodeSize * NODE_LINK(FreeEnd);
 		NODE_LINK(FreeEnd) = Store->Header->FreeNode;
 		Store->Header->FreeNode = FreeStart;
 	}
-	Store->Header->Entries[Index].Link = Store->Header->FreeEntry;
+	if (Store->Bitmap->Header) {
+		string_store_entry(Store, Index)->Link = INVALID_INDEX;
+		radb_bitmap_clear(Store->Bitmap, Index);
+		return;
+	}
+	string_store_entry(Store, Index)->Link = Store->Header->FreeEntry;
 	Store->Header->FreeEntry = Index;
 }
 
-void string_store_writer_open(string_store_writer_t *Writer, string_store_t *Store, size_t Index) {
-	if (Index >= Store->Header->NumEntries) {
-		size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
-		NumEntries += 512 - 1;
-		NumEntries /= 512;
-		NumEntries *= 512;
-		size_t HeaderSize = Store->HeaderSize + NumEntries * sizeof(entry_t);
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-		entry_t *Entries = Store->Header->Entries;
-		for (int I = Store->Header->NumEntries; I < Store->Header->NumEntries + NumEntries; ++I) {
-			Entries[I].Link = INVALID_INDEX;
-			Entries[I].Length = 0;
+size_t string_store_alloc_run(string_store_t *Store, size_t Count) {
+	if (!Store->Bitmap->Header || !Count) return INVALID_INDEX;
+	size_t Index = radb_bitmap_find_run(Store->Bitmap, 0, Count);
+	if (Index + Count > Store->Header->NumEntries) string_store_grow_entries(Store, Index + Count - 1);
+	radb_bitmap_set_run(Store->Bitmap, Index, Count);
+	return Index;
+}
+
+static size_t string_store_cursor_next(radb_cursor_t *Cursor) {
+	string_store_t *Store = (string_store_t *)Cursor->Store;
+	size_t Index = radb_bitmap_next(Store->Bitmap, Cursor->Position, Cursor->Limit);
+	if (Index >= Cursor->Limit) {
+		Cursor->Position = Cursor->Limit;
+		return INVALID_INDEX;
+	}
+	Cursor->Position = Index + 1;
+	return Index;
+}
+
+void string_store_cursor_open(radb_cursor_t *Cursor, string_store_t *Store) {
+	Cursor->Store = Store;
+	Cursor->next = string_store_cursor_next;
+	Cursor->Position = 0;
+	Cursor->Limit = Store->Bitmap->Header ? Store->Header->NumEntries : 0;
+}
+
+void string_store_stats(string_store_t *Store, string_store_stats_t *Stats) {
+	memset(Stats, 0, sizeof(string_store_stats_t));
+	size_t NodeSize = Stats->NodeSize = Store->Header->NodeSize;
+	size_t NumEntries = Stats->NumEntries = Store->Header->NumEntries;
+	size_t NumNodes = Stats->NumNodes = Store->Header->NumNodes;
+	size_t NumFreeNodes = Stats->NumFreeNodes = Store->Header->NumFreeNodes;
+	Stats->MappingSize = Store->HeaderSize + NumNodes * NodeSize;
+	Stats->Events = Store->Stats[0];
+	if (Store->Pages->Header) Stats->MappingSize += Store->Pages->HeaderSize;
+	for (size_t I = 0; I < NumEntries; ++I) {
+		if (Store->Pages->Header && !(I & (((size_t)1 << STRING_STORE_PAGE_SHIFT) - 1))) {
+			// Untouched pages are skipped without mapping them.
+			size_t Page = radb_pages_next(Store->Pages, I >> STRING_STORE_PAGE_SHIFT);
+			if (Page == INVALID_INDEX) break;
+			I = Page << STRING_STORE_PAGE_SHIFT;
 		}
-		Store->Header->NumEntries += NumEntries;
-		Store->HeaderSize = HeaderSize;
+		size_t Length = string_store_lookup_entry(Store, I)->Length;
+		if (!Length) continue;
+		size_t NumBlocks = (Length > NodeSize) ? 1 + (Length - 5) / (NodeSize - 4) : 1;
+		Stats->WastedBytes += NumBlocks * (NodeSize - 4) + 4 - Length;
+		radb_stats_histogram(Stats->ChainLengths, NumBlocks);
+		++Stats->NumValues;
+	}
+	size_t Node = Store->Header->FreeNode, Previous = INVALID_INDEX;
+	for (size_t I = 0; I < NumFreeNodes && Node < NumNodes; ++I) {
+		if (Node != Previous + 1) ++Stats->NumFreeRuns;
+		Previous = Node;
+		Node = NODE_LINK(Store->Data + Node * NodeSize);
 	}
-	size_t OldLength = Store->Header->Entries[Index].Length;
+}
+
+void string_store_writer_open(string_store_writer_t *Writer, string_store_t *Store, size_t Index) {
+	if (Index >= Store->Header->NumEntries) string_store_grow_entries(Store, Index);
+	if (Store->Bitmap->Header) radb_bitmap_set(Store->Bitmap, Index);
+	size_t OldLength = string_store_entry(Store, Index)->Length;
 	size_t NodeSize = Store->Header->NodeSize;
 	size_t OldNumBlocks = (OldLength > NodeSize) ? 1 + (OldLength - 5) / (NodeSize - 4) : (OldLength != 0);
 	if (OldNumBlocks > 0) {
-		size_t FreeStart = Store->Header->Entries[Index].Link;
+		size_t FreeStart = string_store_entry(Store, Index)->Link;
+		if (Store->Jumps) string_store_update_jumps(Store, FreeStart, OldNumBlocks, 0);
 		void *FreeEnd = Store->Data + FreeStart * NodeSize;
 		Store->Header->NumFreeNodes += OldNumBlocks;
 		for (int I = OldNumBlocks; --I > 0;) FreeEnd = Store->Data + NodeSize * NODE_LINK(FreeEnd);
@@ -552,44 +929,23 @@ void string_store_writer_open(string_store_writer_t *Writer, string_store_t *Sto
 	Writer->Store = Store;
 	Writer->Node = INVALID_INDEX;
 	Writer->Index = Index;
-	Store->Header->Entries[Index].Length = 0;
-	Store->Header->Entries[Index].Link = INVALID_INDEX;
+	string_store_entry(Store, Index)->Length = 0;
+	string_store_entry(Store, Index)->Link = INVALID_INDEX;
 }
 
 void string_store_writer_append(string_store_writer_t *Writer, string_store_t *Store, size_t Index) {
-	if (Index >= Store->Header->NumEntries) {
-		size_t NumEntries = (Index + 1) - Store->Header->NumEntries;
-		NumEntries += 512 - 1;
-		NumEntries /= 512;
-		NumEntries *= 512;
-		size_t HeaderSize = Store->HeaderSize + NumEntries * sizeof(entry_t);
-		ftruncate(Store->HeaderFd, HeaderSize);
-#ifdef Linux
-		Store->Header = mremap(Store->Header, Store->HeaderSize, HeaderSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Header, Store->HeaderSize);
-		Store->Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
-#endif
-		entry_t *Entries = Store->Header->Entries;
-		for (int I = Store->Header->NumEntries; I < Store->Header->NumEntries + NumEntries; ++I) {
-			Entries[I].Link = INVALID_INDEX;
-			Entries[I].Length = 0;
-		}
-		Store->Header->NumEntries += NumEntries;
-		Store->HeaderSize = HeaderSize;
-	}
+	if (Index >= Store->Header->NumEntries) string_store_grow_entries(Store, Index);
+	if (Store->Bitmap->Header) radb_bitmap_set(Store->Bitmap, Index);
 	Writer->Store = Store;
 	Writer->Index = Index;
-	size_t NodeIndex = Store->Header->Entries[Index].Link;
-	if (NodeIndex != INVALID_INDEX) {
+	size_t NodeIndex = string_store_entry(Store, Index)->Link;
+	// An emptied value may keep a stale link.
+	if (string_store_entry(Store, Index)->Length) {
 		size_t NodeSize = Store->Header->NodeSize;
-		size_t Offset = Store->Header->Entries[Index].Length;
-		while (Offset > NodeSize) {
-			void *Node = Store->Data + NodeSize * NodeIndex;
-			NodeIndex = NODE_LINK(Node);
-			Offset -= (NodeSize - 4);
-		}
-		Writer->Node = NodeIndex;
+		size_t Offset = string_store_entry(Store, Index)->Length;
+		size_t NumBlocks = string_store_num_blocks(Offset, NodeSize);
+		Offset -= (NumBlocks - 1) * (NodeSize - 4);
+		Writer->Node = string_store_block_node(Store, NodeIndex, NumBlocks - 1, NumBlocks);
 		Writer->Remain = NodeSize - Offset;
 	} else {
 		Writer->Node = INVALID_INDEX;
@@ -597,42 +953,57 @@ void string_store_writer_append(string_store_writer_t *Writer, string_store_t *S
 }
 
 
-static inline size_t string_store_node_alloc(string_store_t *Store, size_t NodeSize) {
-	if (!Store->Header->NumFreeNodes) {
-		size_t NumNodes = Store->Header->ChunkSize;
-		size_t DataSize = (Store->Header->NumNodes + NumNodes) * NodeSize;
-		//msync(Store->Data, Store->Header->NumNodes * NodeSize, MS_SYNC);
-		ftruncate(Store->DataFd, DataSize);
-#ifdef Linux
-		Store->Data = mremap(Store->Data, Store->Header->NumNodes * NodeSize, DataSize, MREMAP_MAYMOVE);
-#else
-		munmap(Store->Data, Store->Header->NumNodes * NodeSize);
-		Store->Data = mmap(NULL, DataSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->DataFd, 0);
-#endif
-		size_t Index = Store->Header->NumNodes;
-		size_t FreeEnd = Store->Header->FreeNode = Store->Header->NumNodes + 1;
-		Store->Header->NumNodes += NumNodes;
-		Store->Header->NumFreeNodes += --NumNodes ;
-		while (--NumNodes > 0) FreeEnd = NODE_LINK(Store->Data + FreeEnd * NodeSize) = FreeEnd + 1;
-		return Index;
-	} else {
-		--Store->Header->NumFreeNodes;
-		size_t Index = Store->Header->FreeNode;
-		Store->Header->FreeNode = NODE_LINK(Store->Data + NodeSize * Index);
-		return Index;
-	}
+// Makes sure the next Count node allocations come from the head of the free list without growing
+// the data file. If the free list is too short, the file is grown once and the new nodes are
+// threaded in order in front of it, so the chain allocated from them is sequential.
+static void string_store_node_reserve(string_store_t *Store, size_t Count) {
+	if (Count <= Store->Header->NumFreeNodes) return;
+	size_t NodeSize = Store->Header->NodeSize;
+	size_t NumNodes = Count + Store->Header->ChunkSize - 1;
+	NumNodes /= Store->Header->ChunkSize;
+	NumNodes *= Store->Header->ChunkSize;
+	size_t DataSize = (Store->Header->NumNodes + NumNodes) * NodeSize;
+	RADB_PROBE2(string_store_grow, Store->Header->NumNodes, Store->Header->NumNodes + NumNodes);
+	RADB_LATENCY(RADB_OP_STRING_STORE_GROW);
+	radb_truncate(Store->Stats, Store->DataFd, DataSize);
+	Store->Data = radb_remap(Store->Stats, Store->DataFd, Store->Data, Store->Header->NumNodes * NodeSize, DataSize);
+	size_t FreeEnd = Store->Header->NumNodes;
+	for (size_t I = NumNodes; --I > 0; ++FreeEnd) NODE_LINK(Store->Data + FreeEnd * NodeSize) = FreeEnd + 1;
+	NODE_LINK(Store->Data + FreeEnd * NodeSize) = Store->Header->FreeNode;
+	Store->Header->FreeNode = Store->Header->NumNodes;
+	Store->Header->NumNodes += NumNodes;
+	Store->Header->NumFreeNodes += NumNodes;
+	string_store_grow_chains(Store);
+}
+
+void string_store_reserve(string_store_t *Store, size_t Index, size_t ExpectedLength) {
+	if (Index >= Store->Header->NumEntries) string_store_grow_entries(Store, Index);
+	size_t NodeSize = Store->Header->NodeSize;
+	size_t OldNumBlocks = string_store_num_blocks(string_store_lookup_entry(Store, Index)->Length, NodeSize);
+	size_t NewNumBlocks = string_store_num_blocks(ExpectedLength, NodeSize);
+	if (NewNumBlocks > OldNumBlocks) string_store_node_reserve(Store, NewNumBlocks - OldNumBlocks);
+}
+
+void string_store_writer_reserve(string_store_writer_t *Writer, size_t Length) {
+	string_store_t *Store = Writer->Store;
+	size_t NodeSize = Store->Header->NodeSize;
+	size_t OldLength = string_store_lookup_entry(Store, Writer->Index)->Length;
+	size_t Count = string_store_num_blocks(OldLength + Length, NodeSize) - string_store_num_blocks(OldLength, NodeSize);
+	if (Count) string_store_node_reserve(Store, Count);
 }
 
 size_t string_store_writer_write(string_store_writer_t *Writer, const void *Buffer, size_t Length) {
 	if (Length == 0) return Length;
+	RADB_LATENCY(RADB_OP_STRING_STORE_WRITE);
 	string_store_t *Store = Writer->Store;
-	Store->Header->Entries[Writer->Index].Length += Length;
+	size_t OldLength = string_store_entry(Store, Writer->Index)->Length;
+	string_store_entry(Store, Writer->Index)->Length += Length;
 	size_t NodeSize = Store->Header->NodeSize;
 	size_t NodeIndex = Writer->Node;
 	size_t Remain = Length, Offset, Space;
 	if (NodeIndex == INVALID_INDEX) {
 		NodeIndex = string_store_node_alloc(Store, NodeSize);
-		Store->Header->Entries[Writer->Index].Link = NodeIndex;
+		string_store_entry(Store, Writer->Index)->Link = NodeIndex;
 		Space = NodeSize;
 		Offset = 0;
 	} else {
@@ -653,7 +1024,7 @@ size_t string_store_writer_write(string_store_writer_t *Writer, const void *Buff
 			Space = NodeSize - Offset;
 		}
 		while (Remain > Space) {
-			memcpy(Node + Offset, Buffer, Space - 4);
+			radb_copy(Node + Offset, Buffer, Space - 4);
 			Buffer += Space - 4;
 			Remain -= Space - 4;
 			size_t NewIndex = string_store_node_alloc(Store, NodeSize);
@@ -665,25 +1036,131 @@ size_t string_store_writer_write(string_store_writer_t *Writer, const void *Buff
 			Space = NodeSize;
 		}
 	}
-	memcpy(Node + Offset, Buffer, Remain);
+	radb_copy(Node + Offset, Buffer, Remain);
 	Writer->Node = NodeIndex;
 	Writer->Remain = Space - Remain;
+	if (Store->Tails) Store->Tails->Tails[string_store_entry(Store, Writer->Index)->Link] = NodeIndex;
+	if (Store->Jumps) {
+		size_t OldNumBlocks = string_store_num_blocks(OldLength, NodeSize);
+		size_t NewNumBlocks = string_store_num_blocks(OldLength + Length, NodeSize);
+		if (NewNumBlocks > OldNumBlocks) string_store_update_jumps(Store, string_store_entry(Store, Writer->Index)->Link, OldNumBlocks, NewNumBlocks);
+	}
 	return Length;
 }
 
+void string_store_tails_build(string_store_t *Store) {
+	char FileName2[strlen(Store->Prefix) + 20];
+	sprintf(FileName2, "%s.tails.temp", Store->Prefix);
+	int TailsFd = open(FileName2, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	size_t TailsSize = sizeof(string_store_tails_t) + Store->Header->NumNodes * sizeof(uint32_t);
+	ftruncate(TailsFd, TailsSize);
+	string_store_tails_t *Tails = mmap(NULL, TailsSize, PROT_READ | PROT_WRITE, MAP_SHARED, TailsFd, 0);
+	Tails->Signature = STRING_STORE_TAILS_SIGNATURE;
+	Tails->Version = STRING_STORE_TAILS_VERSION;
+	Tails->NumNodes = Store->Header->NumNodes;
+	size_t NodeSize = Store->Header->NodeSize;
+	size_t NumEntries = Store->Header->NumEntries;
+	for (size_t I = 0; I < NumEntries; ++I) {
+		if (Store->Pages->Header && !(I & (((size_t)1 << STRING_STORE_PAGE_SHIFT) - 1))) {
+			size_t Page = radb_pages_next(Store->Pages, I >> STRING_STORE_PAGE_SHIFT);
+			if (Page == INVALID_INDEX) break;
+			I = Page << STRING_STORE_PAGE_SHIFT;
+		}
+		const entry_t *Entry = string_store_lookup_entry(Store, I);
+		if (Entry->Length <= NodeSize) continue;
+		size_t Node = Entry->Link;
+		for (size_t J = string_store_num_blocks(Entry->Length, NodeSize); --J > 0;) Node = NODE_LINK(Store->Data + Node * NodeSize);
+		Tails->Tails[Entry->Link] = Node;
+	}
+	radb_sync(Tails, TailsSize);
+
+	if (Store->Tails) {
+		munmap(Store->Tails, Store->TailsSize);
+		close(Store->TailsFd);
+	}
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.tails", Store->Prefix);
+	rename(FileName2, FileName);
+
+	Store->Tails = Tails;
+	Store->TailsSize = TailsSize;
+	Store->TailsFd = TailsFd;
+}
+
+void string_store_jumps_build(string_store_t *Store) {
+	if (Store->Jumps) return;
+	char FileName2[strlen(Store->Prefix) + 20];
+	sprintf(FileName2, "%s.jumps.temp", Store->Prefix);
+	Store->JumpsFd = open(FileName2, O_RDWR | O_CREAT | O_TRUNC, 0777);
+	Store->JumpsSize = sizeof(string_store_jumps_t) + Store->Header->NumNodes * sizeof(uint32_t);
+	ftruncate(Store->JumpsFd, Store->JumpsSize);
+	Store->Jumps = mmap(NULL, Store->JumpsSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->JumpsFd, 0);
+	Store->Jumps->Signature = STRING_STORE_JUMPS_SIGNATURE;
+	Store->Jumps->Version = STRING_STORE_JUMPS_VERSION;
+	Store->Jumps->NumNodes = Store->Header->NumNodes;
+	Store->Jumps->Stride = STRING_STORE_JUMP_STRIDE;
+	// Tables of long values are allocated as if the values had just been written, growing the file as needed.
+	size_t NodeSize = Store->Header->NodeSize;
+	size_t NumEntries = Store->Header->NumEntries;
+	for (size_t I = 0; I < NumEntries; ++I) {
+		if (Store->Pages->Header && !(I & (((size_t)1 << STRING_STORE_PAGE_SHIFT) - 1))) {
+			size_t Page = radb_pages_next(Store->Pages, I >> STRING_STORE_PAGE_SHIFT);
+			if (Page == INVALID_INDEX) break;
+			I = Page << STRING_STORE_PAGE_SHIFT;
+		}
+		const entry_t *Entry = string_store_lookup_entry(Store, I);
+		size_t NumBlocks = string_store_num_blocks(Entry->Length, NodeSize);
+		if (NumBlocks > STRING_STORE_JUMP_STRIDE) string_store_update_jumps(Store, Entry->Link, 0, NumBlocks);
+	}
+	radb_sync(Store->Jumps, Store->JumpsSize);
+	char FileName[strlen(Store->Prefix) + 10];
+	sprintf(FileName, "%s.jumps", Store->Prefix);
+	rename(FileName2, FileName);
+}
+
 void string_store_reader_open(string_store_reader_t *Reader, string_store_t *Store, size_t Index) {
 	Reader->Store = Store;
+	Reader->Index = Index;
 	Reader->Offset = 0;
 	if (Index >= Store->Header->NumEntries) {
 		Reader->Node = INVALID_INDEX;
 		Reader->Remain = 0;
 	} else {
-		Reader->Node = Store->Header->Entries[Index].Link;
-		Reader->Remain = Store->Header->Entries[Index].Length;
+		const entry_t *Entry = string_store_lookup_entry(Store, Index);
+		Reader->Node = Entry->Link;
+		Reader->Remain = Entry->Length;
 	}
 }
 
+void string_store_reader_seek(string_store_reader_t *Reader, size_t Offset) {
+	string_store_t *Store = Reader->Store;
+	Reader->Node = INVALID_INDEX;
+	Reader->Offset = 0;
+	Reader->Remain = 0;
+	if (Reader->Index >= Store->Header->NumEntries) return;
+	const entry_t *Entry = string_store_lookup_entry(Store, Reader->Index);
+	size_t Length = Entry->Length;
+	if (!Length) return;
+	if (Offset > Length) Offset = Length;
+	size_t NodeSize = Store->Header->NodeSize;
+	size_t NumBlocks = string_store_num_blocks(Length, NodeSize);
+	// Every block but the last holds NodeSize - 4 bytes, the last one may use its link as well.
+	size_t Block = Offset / (NodeSize - 4);
+	if (Block > NumBlocks - 1) Block = NumBlocks - 1;
+	Reader->Node = string_store_block_node(Store, Entry->Link, Block, NumBlocks);
+	Reader->Offset = Offset - Block * (NodeSize - 4);
+	Reader->Remain = Length - Offset;
+}
+
+size_t string_store_read_at(string_store_t *Store, size_t Index, size_t Offset, void *Buffer, size_t Length) {
+	string_store_reader_t Reader[1];
+	string_store_reader_open(Reader, Store, Index);
+	string_store_reader_seek(Reader, Offset);
+	return string_store_reader_read(Reader, Buffer, Length);
+}
+
 size_t string_store_reader_read(string_store_reader_t *Reader, void *Buffer, size_t Length) {
+	RADB_LATENCY(RADB_OP_STRING_STORE_READ);
 	string_store_t *Store = Reader->Store;
 	size_t NodeSize = Store->Header->NodeSize;
 	size_t NodeIndex = Reader->Node;
@@ -696,26 +1173,26 @@ size_t string_store_reader_read(string_store_reader_t *Reader, void *Buffer, siz
 		if (Offset + Remain <= NodeSize) {
 			// Last node
 			if (Length <= Remain) {
-				memcpy(Buffer, Node + Offset, Length);
+				radb_copy(Buffer, Node + Offset, Length);
 				Reader->Node = NodeIndex;
 				Reader->Offset = Offset + Length;
 				Reader->Remain = Remain - Length;
 				return Copied + Length;
 			} else {
-				memcpy(Buffer, Node + Offset, Remain);
+				radb_copy(Buffer, Node + Offset, Remain);
 				Reader->Node = INVALID_INDEX;
 				return Copied + Remain;
 			}
 		} else {
 			size_t Available = NodeSize - Offset - 4;
 			if (Length <= Available) {
-				memcpy(Buffer, Node + Offset, Length);
+				radb_copy(Buffer, Node + Offset, Length);
 				Reader->Node = NodeIndex;
 				Reader->Offset = Offset + Length;
 				Reader->Remain = Remain - Length;
 				return Copied + Length;
 			} else {
-				memcpy(Buffer, Node + Offset, Available);
+				radb_copy(Buffer, Node + Offset, Available);
 				NodeIndex = NODE_LINK(Node);
 				Offset = 0;
 				Remain -= Available;
@@ -730,10 +1207,7 @@ size_t string_store_reader_read(string_store_reader_t *Reader, void *Buffer, siz
 #define STRING_INDEX_SIGNATURE 0x49534152
 #define STRING_INDEX_VERSION MAKE_VERSION(1, 1)
 
-typedef struct {
-	uint32_t Hash;
-	uint32_t Link;
-} hash_t;
+typedef radb_hash_t hash_t;
 
 typedef struct {
 	uint32_t Signature, Version;
@@ -755,6 +1229,7 @@ struct string_index_t {
 	size_t HeaderSize;
 	int HeaderFd;
 	int SyncCounter;
+	radb_stats_t Stats[1];
 };
 
 string_index_t *string_index_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
@@ -775,6 +1250,7 @@ string_index_t *string_index_create(const char *Prefix, size_t KeySize, size_t C
 	if (!ChunkSize) ChunkSize = 512;
 	char FileName[strlen(Prefix) + 10];
 	Store->SyncCounter = 32;
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	sprintf(FileName, "%s.index", Prefix);
 	Store->HeaderFd = open(FileName, O_RDWR | O_CREAT | O_TRUNC, 0777);
 	Store->HeaderSize = sizeof(string_index_header_t) + 64 * sizeof(hash_t);
@@ -817,6 +1293,7 @@ string_index_open_t string_index_open2(const char *Prefix RADB_MEM_PARAMS) {
 	Store->alloc_atomic = alloc_atomic;
 	Store->free = free;
 #endif
+	memset(Store->Stats, 0, sizeof(radb_stats_t));
 	Store->HeaderFd = open(FileName, O_RDWR, 0777);
 	Store->HeaderSize = Stat->st_size;
 	Store->Header = mmap(NULL, Store->HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, Store->HeaderFd, 0);
@@ -857,7 +1334,7 @@ string_index_t *string_index_open(const char *Prefix RADB_MEM_PARAMS) {
 
 void string_index_close(string_index_t *Store) {
 	string_store_close(Store->Keys);
-	msync(Store->Header, Store->HeaderSize, MS_SYNC);
+	radb_sync(Store->Header, Store->HeaderSize);
 	munmap(Store->Header, Store->HeaderSize);
 	close(Store->HeaderFd);
 #if defined(RADB_MEM_MALLOC)
@@ -871,10 +1348,7 @@ void string_index_close(string_index_t *Store) {
 }
 
 static uint32_t hash(const char *Key, int Length) {
-	uint32_t Hash = 5381;
-	unsigned char *P = (unsigned char *)(Key);
-	for (int I = Length; --I >= 0;) Hash = ((Hash << 5) + Hash) + P++[0];
-	return Hash;
+	return radb_hash(5381, Key, Length);
 }
 
 size_t string_index_num_entries(string_index_t *Store) {
@@ -893,44 +1367,12 @@ size_t string_index_get(string_index_t *Store, size_t Index, void *Buffer, size_
 	return string_store_get(Store->Keys, Index, Buffer, Space);
 }
 
-static void sort_hashes(string_index_t *Store, hash_t *First, hash_t *Last) {
-	hash_t *A = First;
-	hash_t *B = Last;
-	hash_t T = *A;
-	hash_t P = *B;
-	while (P.Link >= DELETED_INDEX) {
-		--B;
-		--Last;
-		if (A == B) return;
-		P = *B;
-	}
-	while (A != B) {
-		int Cmp;
-		if (T.Link < DELETED_INDEX) {
-			if (T.Hash < P.Hash) {
-				Cmp = -1;
-			} else if (T.Hash > P.Hash) {
-				Cmp = 1;
-			} else {
-				Cmp = string_store_compare2_unchecked(Store->Keys, T.Link, P.Link);
-			}
-		} else {
-			Cmp = -1;
-		}
-		if (Cmp > 0) {
-			*A = T;
-			T = *++A;
-		} else {
-			*B = T;
-			T = *--B;
-		}
-	}
-	*A = P;
-	if (First < A - 1) sort_hashes(Store, First, A - 1);
-	if (A + 1 < Last) sort_hashes(Store, A + 1, Last);
+static int string_index_compare_links(string_store_t *Keys, uint32_t Link1, uint32_t Link2) {
+	return string_store_compare2_unchecked(Keys, Link1, Link2);
 }
 
 index_result_t string_index_insert2(string_index_t *Store, const char *Key, size_t Length) {
+	RADB_LATENCY(RADB_OP_STRING_INDEX_INSERT);
 	if (!Length) Length = strlen(Key);
 	uint32_t Hash = hash(Key, Length);
 	unsigned int Mask = Store->Header->Size - 1;
@@ -988,13 +1430,16 @@ index_result_t string_index_insert2(string_index_t *Store, const char *Key, size
 		size_t HashSize = Store->Header->Size * 2;
 		if (Space + Store->Header->Deleted > Store->Header->Size >> 3) HashSize = Store->Header->Size;
 		Mask = HashSize - 1;
+		RADB_PROBE3(string_index_rebuild_start, Store->Prefix, Store->Header->Size, HashSize);
+		RADB_LATENCY(RADB_OP_STRING_INDEX_REBUILD);
+		uint64_t Start = radb_time();
 
 		char FileName2[strlen(Store->Prefix) + 10];
 		sprintf(FileName2, "%s.temp", Store->Prefix);
 
 		size_t HeaderSize = sizeof(string_index_header_t) + HashSize * sizeof(hash_t);
 		int HeaderFd = open(FileName2, O_RDWR | O_CREAT | O_TRUNC, 0777);
-		ftruncate(HeaderFd, HeaderSize);
+		radb_truncate(Store->Stats, HeaderFd, HeaderSize);
 		string_index_header_t *Header = mmap(NULL, HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, HeaderFd, 0);
 		Header->Signature = STRING_INDEX_SIGNATURE;
 		Header->Version = STRING_INDEX_VERSION;
@@ -1003,8 +1448,9 @@ index_result_t string_index_insert2(string_index_t *Store, const char *Key, size
 		Header->Deleted = 0;
 		for (int I = 0; I < HashSize; ++I) Header->Hashes[I].Link = INVALID_INDEX;
 
-		sort_hashes(Store, Hashes, Hashes + Store->Header->Size - 1);
-		for (hash_t *Old = Hashes; Old->Link < DELETED_INDEX; ++Old) {
+		size_t Count;
+		hash_t *Sorted = radb_sort_hashes(Hashes, Store->Header->Size, DELETED_INDEX, &Count, Store->Keys, (radb_hash_compare_t)string_index_compare_links);
+		for (hash_t *Old = Sorted, *Limit = Sorted + Count; Old < Limit; ++Old) {
 			unsigned long NewHash = Old->Hash;
 			unsigned int NewIncr = ((NewHash >> 8) | 1) & Mask;
 			unsigned int NewIndex = NewHash & Mask;
@@ -1014,6 +1460,7 @@ index_result_t string_index_insert2(string_index_t *Store, const char *Key, size
 			}
 			Header->Hashes[NewIndex] = Old[0];
 		}
+		free(Sorted);
 
 		munmap(Store->Header, Store->HeaderSize);
 		close(Store->HeaderFd);
@@ -1026,6 +1473,9 @@ index_result_t string_index_insert2(string_index_t *Store, const char *Key, size
 		Store->Header = Header;
 		Store->HeaderFd = HeaderFd;
 
+		Store->Stats->Rebuilds.Time += radb_time() - Start;
+		++Store->Stats->Rebuilds.Count;
+		RADB_PROBE3(string_index_rebuild_done, Store->Prefix, Store->Header->Size, Store->Header->Space);
 		//msync(Store->Header, Store->HeaderSize, MS_ASYNC);
 	}
 
@@ -1037,6 +1487,7 @@ size_t string_index_insert(string_index_t *Store, const char *Key, size_t Length
 }
 
 size_t string_index_search(string_index_t *Store, const char *Key, size_t Length) {
+	RADB_LATENCY(RADB_OP_STRING_INDEX_SEARCH);
 	if (!Length) Length = strlen(Key);
 	uint32_t Hash = hash(Key, Length);
 	unsigned int Mask = Store->Header->Size - 1;
@@ -1058,6 +1509,7 @@ size_t string_index_search(string_index_t *Store, const char *Key, size_t Length
 }
 
 size_t string_index_delete(string_index_t *Store, const char *Key, size_t Length) {
+	RADB_LATENCY(RADB_OP_STRING_INDEX_DELETE);
 	if (!Length) Length = strlen(Key);
 	uint32_t Hash = hash(Key, Length);
 	unsigned int Mask = Store->Header->Size - 1;
@@ -1088,8 +1540,57 @@ int string_index_foreach(string_index_t *Store, void *Data, string_index_foreach
 	hash_t *Hash = Store->Header->Hashes;
 	hash_t *Limit = Hash + Store->Header->Size;
 	while (Hash < Limit) {
-		if (Hash->Link != INVALID_INDEX) if (Callback(Hash->Link, Data)) return 1;
+		if (Hash->Link < DELETED_INDEX) if (Callback(Hash->Link, Data)) return 1;
 		++Hash;
 	}
 	return 0;
 }
+
+static size_t string_index_cursor_next(radb_cursor_t *Cursor) {
+	string_index_t *Store = (string_index_t *)Cursor->Store;
+	hash_t *Hashes = Store->Header->Hashes;
+	size_t Limit = Cursor->Limit < Store->Header->Size ? Cursor->Limit : Store->Header->Size;
+	while (Cursor->Position < Limit) {
+		uint32_t Link = Hashes[Cursor->Position++].Link;
+		if (Link < DELETED_INDEX) return Link;
+	}
+	return INVALID_INDEX;
+}
+
+void string_index_cursor_open(radb_cursor_t *Cursor, string_index_t *Store) {
+	Cursor->Store = Store;
+	Cursor->next = string_index_cursor_next;
+	Cursor->Position = 0;
+	Cursor->Limit = Store->Header->Size;
+}
+
+void string_index_stats(string_index_t *Store, string_index_stats_t *Stats) {
+	memset(Stats, 0, sizeof(string_index_stats_t));
+	size_t Size = Stats->Size = Store->Header->Size;
+	Stats->NumEntries = string_index_num_entries(Store);
+	Stats->NumDeleted = Store->Header->Deleted;
+	Stats->TombstoneRatio = (double)Stats->NumDeleted / Size;
+	Stats->MappingSize = Store->HeaderSize;
+	Stats->Events = Store->Stats[0];
+	unsigned int Mask = Size - 1;
+	hash_t *Hashes = Store->Header->Hashes;
+	size_t Total = 0, Count = 0;
+	for (unsigned int I = 0; I < Size; ++I) {
+		if (Hashes[I].Link >= DELETED_INDEX) continue;
+		uint32_t Hash = Hashes[I].Hash;
+		unsigned int Incr = ((Hash >> 8) | 1) & Mask;
+		unsigned int Index = Hash & Mask;
+		size_t Probe = 1;
+		while (Index != I && Probe < Size) {
+			Index += Incr;
+			Index &= Mask;
+			++Probe;
+		}
+		radb_stats_histogram(Stats->ProbeLengths, Probe);
+		if (Stats->MaxProbe < Probe) Stats->MaxProbe = Probe;
+		Total += Probe;
+		++Count;
+	}
+	if (Count) Stats->AverageProbe = (double)Total / Count;
+	string_store_stats(Store->Keys, Stats->Keys);
+}
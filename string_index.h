@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include "common.h"
+#include "string_store.h"
 
 #define INVALID_INDEX 0xFFFFFFFF
 #define DELETED_INDEX 0xFFFFFFFE
@@ -34,5 +35,18 @@ size_t string_index_delete(string_index_t *Store, const char *Key, size_t Length
 
 typedef int (*string_index_foreach_fn)(size_t Index, void *Data);
 int string_index_foreach(string_index_t *Store, void *Data, string_index_foreach_fn Callback);
+void string_index_cursor_open(radb_cursor_t *Cursor, string_index_t *Store);
+
+typedef struct {
+	size_t Size, NumEntries, NumDeleted;
+	double TombstoneRatio, AverageProbe;
+	size_t MaxProbe;
+	size_t ProbeLengths[RADB_STATS_HISTOGRAM_SIZE];
+	size_t MappingSize;
+	radb_stats_t Events;
+	string_store_stats_t Keys[1];
+} string_index_stats_t;
+
+void string_index_stats(string_index_t *Store, string_index_stats_t *Stats);
 
 #endif
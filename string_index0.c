@@ -1,7 +1,12 @@
 #include "string_index0.h"
 #include "string_index.h"
 #include "string_store.h"
+#include "trace.h"
+#include "kernel.h"
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/stat.h>
 
 typedef struct {
 	const char *String;
@@ -27,7 +32,7 @@ string_index0_t *string_index0_create(const char *Prefix, size_t KeySize, size_t
 }
 
 static int migrate_compare_string(string_store_t *Store, size_t *Original, uint32_t Index) {
-	return 1;
+	return *Original != Index;
 }
 
 static size_t migrate_insert_string(string_store_t *Store, size_t *Original) {
@@ -35,22 +40,77 @@ static size_t migrate_insert_string(string_store_t *Store, size_t *Original) {
 }
 
 typedef struct {
+	radb_migration_t Base[1];
 	linear_index0_t *Index;
 	string_store_t *Store;
 } migration_t;
 
-static int migrate(size_t Index, migration_t *Migration) {
-	string_store_reader_t Reader;
-	string_store_reader_open(&Reader, Migration->Store, Index);
-	uint32_t Hash = 5381;
-	unsigned char Buffer[16];
-	size_t Read;
-	do {
-		Read = string_store_reader_read(&Reader, Buffer, 16);
-		for (int I = 0; I < Read; ++I) Hash = ((Hash << 5) + Hash) + Buffer[I];
-	} while (Read == 16);
-	linear_index0_insert(Migration->Index, Hash, &Index);
-	return 0;
+static void migrate_hash(migration_t *Migration, size_t Start, size_t End) {
+	unsigned char Buffer[256];
+	for (size_t I = Start; I < End; ++I) {
+		string_store_reader_t Reader;
+		string_store_reader_open(&Reader, Migration->Store, Migration->Base->Indices[I]);
+		uint32_t Hash = 5381;
+		size_t Read;
+		do {
+			Read = string_store_reader_read(&Reader, Buffer, sizeof(Buffer));
+			Hash = radb_hash(Hash, Buffer, Read);
+		} while (Read == sizeof(Buffer));
+		Migration->Base->Hashes[I] = Hash;
+	}
+}
+
+static void migrate_insert(migration_t *Migration, size_t Count) {
+	for (size_t I = 0; I < Count; ++I) {
+		size_t Index = Migration->Base->Indices[I];
+		linear_index0_insert(Migration->Index, Migration->Base->Hashes[I], &Index);
+	}
+}
+
+static void migrate_keys(linear_index0_t *NewIndex, string_store_t *Keys, string_index_t *OldIndex, const char *Prefix) {
+	migration_t *Migration = malloc(sizeof(migration_t));
+	Migration->Base->hash = (radb_migration_hash_t)migrate_hash;
+	Migration->Base->insert = (radb_migration_insert_t)migrate_insert;
+	Migration->Index = NewIndex;
+	Migration->Store = Keys;
+	radb_migration_init(Migration->Base, Prefix, linear_index0_count(NewIndex), string_index_count(OldIndex));
+	string_index_foreach(OldIndex, Migration->Base, (void *)radb_migration_add);
+	radb_migration_flush(Migration->Base);
+	free(Migration);
+}
+
+static radb_error_t migrate_index(const char *Prefix, string_store_t *Keys RADB_MEM_PARAMS) {
+	int Lock;
+	radb_error_t Error = radb_migrate_start(Prefix, &Lock);
+	if (Error != RADB_SUCCESS || Lock < 0) return Error;
+	string_index_open_t OldOpen = string_index_open2(Prefix RADB_MEM_ARGS);
+	if (OldOpen.Error != RADB_SUCCESS) return radb_migrate_finish(Prefix, Lock, OldOpen.Error);
+	RADB_PROBE1(migrate_start, Prefix);
+	RADB_LATENCY(RADB_OP_MIGRATE);
+	// Keys are inserted in the same order each time, an interrupted migration resumes after the last inserted key.
+	char TempPrefix[strlen(Prefix) + 10];
+	sprintf(TempPrefix, "%s.migrate", Prefix);
+	linear_index0_t *NewIndex = linear_index0_open(TempPrefix, Keys RADB_MEM_ARGS);
+	if (!NewIndex) NewIndex = linear_index0_create(TempPrefix, Keys RADB_MEM_ARGS);
+	linear_index0_set_compare(NewIndex, (linear_compare_t)migrate_compare_string);
+	linear_index0_set_insert(NewIndex, (linear_insert_t)migrate_insert_string);
+	migrate_keys(NewIndex, Keys, OldOpen.Index, Prefix);
+	string_index_close(OldOpen.Index);
+	RADB_PROBE2(migrate_done, Prefix, linear_index0_count(NewIndex));
+	linear_index0_close(NewIndex);
+	return radb_migrate_finish(Prefix, Lock, RADB_SUCCESS);
+}
+
+radb_error_t string_index0_migrate(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.index2", Prefix);
+	if (!stat(FileName, Stat)) return RADB_SUCCESS;
+	string_store_open_t KeysOpen = string_store_open2(Prefix RADB_MEM_ARGS);
+	if (!KeysOpen.Store) return KeysOpen.Error + 3;
+	radb_error_t Error = migrate_index(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+	string_store_close(KeysOpen.Store);
+	return Error;
 }
 
 linear_index0_open_t string_index0_open2(const char *Prefix RADB_MEM_PARAMS) {
@@ -58,19 +118,12 @@ linear_index0_open_t string_index0_open2(const char *Prefix RADB_MEM_PARAMS) {
 	if (!KeysOpen.Store) return (linear_index0_open_t){NULL, KeysOpen.Error + 3};
 	linear_index0_open_t IndexOpen = linear_index0_open2(Prefix, KeysOpen.Store RADB_MEM_ARGS);
 	if (IndexOpen.Error == RADB_FILE_NOT_FOUND) {
-		string_index_open_t OldOpen = string_index_open2(Prefix RADB_MEM_ARGS);
-		if (OldOpen.Error != RADB_SUCCESS) {
+		IndexOpen.Error = migrate_index(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+		if (IndexOpen.Error != RADB_SUCCESS) {
 			string_store_close(KeysOpen.Store);
 			return IndexOpen;
 		}
-		linear_index0_t *NewIndex = linear_index0_create(Prefix, KeysOpen.Store RADB_MEM_ARGS);
-		linear_index0_set_compare(NewIndex, (linear_compare_t)migrate_compare_string);
-		linear_index0_set_insert(NewIndex, (linear_insert_t)migrate_insert_string);
-		migration_t Migration = {NewIndex, KeysOpen.Store};
-		string_index_foreach(OldOpen.Index, &Migration, (void *)migrate);
-		string_index_close(OldOpen.Index);
-		IndexOpen.Index = NewIndex;
-		IndexOpen.Error = RADB_SUCCESS;
+		IndexOpen = linear_index0_open2(Prefix, KeysOpen.Store RADB_MEM_ARGS);
 	}
 	if (IndexOpen.Error != RADB_SUCCESS) string_store_close(KeysOpen.Store);
 	linear_index0_set_compare(IndexOpen.Index, (linear_compare_t)linear_compare_string);
@@ -92,10 +145,7 @@ void string_index0_close(string_index0_t *Store) {
 }
 
 static uint32_t string_hash(const char *String, size_t Length) {
-	const unsigned char *Bytes = (const unsigned char *)String;
-	uint32_t Hash = 5381;
-	for (int I = 0; I < Length; ++I) Hash = ((Hash << 5) + Hash) + Bytes[I];
-	return Hash;
+	return radb_hash(5381, String, Length);
 }
 
 size_t string_index0_insert(string_index0_t *Store, const char *String, size_t Length) {
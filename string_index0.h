@@ -9,10 +9,13 @@ string_index0_t *string_index0_create(const char *Prefix, size_t KeySize, size_t
 string_index0_t *string_index0_open(const char *Prefix RADB_MEM_PARAMS);
 size_t string_index0_num_entries(string_index0_t *Store);
 #define string_index0_count string_index0_num_entries
+#define string_index0_cursor_open linear_index0_cursor_open
+#define string_index0_set_filter linear_index0_set_filter
 size_t string_index0_num_deleted(string_index0_t *Store);
 void string_index0_close(string_index0_t *Store);
 
 linear_index0_open_t string_index0_open2(const char *Prefix RADB_MEM_PARAMS);
+radb_error_t string_index0_migrate(const char *Prefix RADB_MEM_PARAMS);
 
 size_t string_index0_insert(string_index0_t *Store, const char *Key, size_t Length);
 size_t string_index0_search(string_index0_t *Store, const char *Key, size_t Length);
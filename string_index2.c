@@ -1,34 +1,136 @@
 #include "string_index2.h"
 #include "string_index.h"
 #include "string_store.h"
+#include "linear_index_inline.h"
+#include "kernel.h"
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/stat.h>
 
 typedef struct {
 	const char *String;
 	size_t Length;
 } string_key_t;
 
-static int linear_compare_string(string_store_t *Store, string_key_t *Full, uint32_t Index) {
+static inline int linear_compare_string(void *Store, const void *Key, uint32_t Index) {
+	const string_key_t *Full = (const string_key_t *)Key;
 	if (Full->Length < sizeof(linear_key_t)) return 0;
 	return string_store_compare(Store, Full->String, Full->Length, Index);
 }
 
-static size_t linear_insert_string(string_store_t *Store, string_key_t *Full) {
+static inline size_t linear_insert_string(void *Store, const void *Key) {
+	const string_key_t *Full = (const string_key_t *)Key;
 	size_t Index = string_store_alloc(Store);
 	string_store_set(Store, Index, Full->String, Full->Length);
 	return Index;
 }
 
-string_index2_t *string_index2_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
+// Builds the 16 byte signature stored in each node, short keys are always stored in full.
+// The signature mode is stored in the index header, the original mode (0) stores the first 15 bytes of longer keys.
+// Signature is always constant, so only one case remains after inlining.
+LINEAR_INDEX_INLINE uint32_t string_signature(string_index2_signature_t Signature, const char *String, size_t Length, linear_key_t Key) {
+	const unsigned char *Bytes = (const unsigned char *)String;
+	uint32_t Hash = 5381;
+	memset(Key, 0, sizeof(linear_key_t));
+	switch (Signature) {
+	case STRING_INDEX2_SUFFIX:
+		Hash = radb_hash(Hash, Bytes, Length);
+		if (Length >= sizeof(linear_key_t)) {
+			memcpy(Key, Bytes + Length - (sizeof(linear_key_t) - 1), sizeof(linear_key_t) - 1);
+			Key[sizeof(linear_key_t) - 1] = 0xFF;
+		} else {
+			memcpy(Key, Bytes, Length);
+			Key[sizeof(linear_key_t) - 1] = Length;
+		}
+		break;
+	case STRING_INDEX2_FINGERPRINT: {
+		uint64_t Fingerprint = 0xCBF29CE484222325;
+		for (int I = 0; I < Length; ++I) {
+			Hash = ((Hash << 5) + Hash) + Bytes[I];
+			Fingerprint = (Fingerprint ^ Bytes[I]) * 0x100000001B3;
+		}
+		if (Length >= sizeof(linear_key_t)) {
+			uint32_t Length32 = Length;
+			memcpy(Key, &Fingerprint, sizeof(uint64_t));
+			memcpy(Key + sizeof(uint64_t), &Length32, sizeof(uint32_t));
+			Key[sizeof(linear_key_t) - 1] = 0xFF;
+		} else {
+			memcpy(Key, Bytes, Length);
+			Key[sizeof(linear_key_t) - 1] = Length;
+		}
+		break;
+	}
+	default:
+		Hash = radb_hash(Hash, Bytes, Length);
+		if (Length >= sizeof(linear_key_t)) {
+			memcpy(Key, Bytes, sizeof(linear_key_t) - 1);
+			Key[sizeof(linear_key_t) - 1] = 1;
+		} else {
+			memcpy(Key, Bytes, Length);
+		}
+		break;
+	}
+	return Hash;
+}
+
+typedef struct {
+	size_t (*search)(string_index2_t *Store, const char *String, size_t Length);
+	index_result_t (*insert2)(string_index2_t *Store, const char *String, size_t Length);
+} string_methods_t;
+
+#define STRING_METHODS(SIGNATURE) \
+\
+static size_t string_search_ ## SIGNATURE(string_index2_t *Store, const char *String, size_t Length) { \
+	string_key_t Full = {String, Length}; \
+	linear_key_t Key; \
+	uint32_t Hash = string_signature(SIGNATURE, String, Length, Key); \
+	return linear_index_search_inline(Store, Hash, Key, &Full, linear_compare_string); \
+} \
+\
+static index_result_t string_insert2_ ## SIGNATURE(string_index2_t *Store, const char *String, size_t Length) { \
+	string_key_t Full = {String, Length}; \
+	linear_key_t Key; \
+	uint32_t Hash = string_signature(SIGNATURE, String, Length, Key); \
+	return linear_index_insert_inline(Store, Hash, Key, &Full, linear_compare_string, linear_insert_string); \
+}
+
+STRING_METHODS(STRING_INDEX2_PREFIX)
+STRING_METHODS(STRING_INDEX2_SUFFIX)
+STRING_METHODS(STRING_INDEX2_FINGERPRINT)
+
+static const string_methods_t StringMethods[] = {
+	{string_search_STRING_INDEX2_PREFIX, string_insert2_STRING_INDEX2_PREFIX},
+	{string_search_STRING_INDEX2_SUFFIX, string_insert2_STRING_INDEX2_SUFFIX},
+	{string_search_STRING_INDEX2_FINGERPRINT, string_insert2_STRING_INDEX2_FINGERPRINT}
+};
+
+static void string_set_methods(string_index2_t *Store) {
+	size_t Signature = linear_index_get_extra(Store);
+	if (Signature > STRING_INDEX2_FINGERPRINT) Signature = STRING_INDEX2_PREFIX;
+	Store->Methods = StringMethods + Signature;
+}
+
+string_index2_t *string_index2_create_engine(const char *Prefix, size_t KeySize, size_t ChunkSize, string_index2_signature_t Signature, linear_index_engine_t Engine RADB_MEM_PARAMS) {
 	string_store_t *Keys = string_store_create(Prefix, KeySize, ChunkSize RADB_MEM_ARGS);
-	linear_index_t *Index = linear_index_create(Prefix, Keys RADB_MEM_ARGS);
-	linear_index_set_compare(Index, (linear_compare_t)linear_compare_string);
-	linear_index_set_insert(Index, (linear_insert_t)linear_insert_string);
+	linear_index_t *Index = linear_index_create_engine(Prefix, Keys, Engine RADB_MEM_ARGS);
+	linear_index_set_compare(Index, linear_compare_string);
+	linear_index_set_insert(Index, linear_insert_string);
+	linear_index_set_extra(Index, Signature);
+	string_set_methods(Index);
 	return Index;
 }
 
+string_index2_t *string_index2_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS) {
+	return string_index2_create_engine(Prefix, KeySize, ChunkSize, STRING_INDEX2_PREFIX, LINEAR_INDEX_LINEAR RADB_MEM_ARGS);
+}
+
+string_index2_t *string_index2_create_signature(const char *Prefix, size_t KeySize, size_t ChunkSize, string_index2_signature_t Signature RADB_MEM_PARAMS) {
+	return string_index2_create_engine(Prefix, KeySize, ChunkSize, Signature, LINEAR_INDEX_LINEAR RADB_MEM_ARGS);
+}
+
 static int migrate_compare_string(string_store_t *Store, size_t *Original, uint32_t Index) {
-	return 1;
+	return *Original != Index;
 }
 
 static size_t migrate_insert_string(string_store_t *Store, size_t *Original) {
@@ -36,27 +138,83 @@ static size_t migrate_insert_string(string_store_t *Store, size_t *Original) {
 }
 
 typedef struct {
+	radb_migration_t Base[1];
 	linear_index_t *Index;
 	string_store_t *Store;
+	linear_key_t Keys[RADB_MIGRATION_BATCH_SIZE];
 } migration_t;
 
-static int migrate(size_t Index, migration_t *Migration) {
-	linear_key_t Key = {0,};
-	string_store_reader_t Reader;
-	string_store_reader_open(&Reader, Migration->Store, Index);
-	size_t Read = string_store_reader_read(&Reader, Key, sizeof(linear_key_t));
-	uint32_t Hash = 5381;
-	for (int I = 0; I < Read; ++I) Hash = ((Hash << 5) + Hash) + Key[I];
-	if (Read == sizeof(linear_key_t)) {
-		Key[sizeof(linear_key_t) - 1] = 1;
-		unsigned char Buffer[16];
-		do {
-			Read = string_store_reader_read(&Reader, Buffer, 16);
-			for (int I = 0; I < Read; ++I) Hash = ((Hash << 5) + Hash) + Buffer[I];
-		} while (Read == 16);
+static void migrate_hash(migration_t *Migration, size_t Start, size_t End) {
+	unsigned char Buffer[256];
+	for (size_t I = Start; I < End; ++I) {
+		uint8_t *Key = Migration->Keys[I];
+		memset(Key, 0, sizeof(linear_key_t));
+		string_store_reader_t Reader;
+		string_store_reader_open(&Reader, Migration->Store, Migration->Base->Indices[I]);
+		size_t Read = string_store_reader_read(&Reader, Key, sizeof(linear_key_t));
+		uint32_t Hash = radb_hash(5381, Key, Read);
+		if (Read == sizeof(linear_key_t)) {
+			Key[sizeof(linear_key_t) - 1] = 1;
+			do {
+				Read = string_store_reader_read(&Reader, Buffer, sizeof(Buffer));
+				Hash = radb_hash(Hash, Buffer, Read);
+			} while (Read == sizeof(Buffer));
+		}
+		Migration->Base->Hashes[I] = Hash;
+	}
+}
+
+static void migrate_insert(migration_t *Migration, size_t Count) {
+	for (size_t I = 0; I < Count; ++I) {
+		size_t Index = Migration->Base->Indices[I];
+		linear_index_insert(Migration->Index, Migration->Base->Hashes[I], Migration->Keys[I], &Index);
 	}
-	linear_index_insert(Migration->Index, Hash, Key, &Index);
-	return 0;
+}
+
+static void migrate_keys(linear_index_t *NewIndex, string_store_t *Keys, string_index_t *OldIndex, const char *Prefix) {
+	migration_t *Migration = malloc(sizeof(migration_t));
+	Migration->Base->hash = (radb_migration_hash_t)migrate_hash;
+	Migration->Base->insert = (radb_migration_insert_t)migrate_insert;
+	Migration->Index = NewIndex;
+	Migration->Store = Keys;
+	radb_migration_init(Migration->Base, Prefix, linear_index_count(NewIndex), string_index_count(OldIndex));
+	string_index_foreach(OldIndex, Migration->Base, (void *)radb_migration_add);
+	radb_migration_flush(Migration->Base);
+	free(Migration);
+}
+
+static radb_error_t migrate_index(const char *Prefix, string_store_t *Keys RADB_MEM_PARAMS) {
+	int Lock;
+	radb_error_t Error = radb_migrate_start(Prefix, &Lock);
+	if (Error != RADB_SUCCESS || Lock < 0) return Error;
+	string_index_open_t OldOpen = string_index_open2(Prefix RADB_MEM_ARGS);
+	if (OldOpen.Error != RADB_SUCCESS) return radb_migrate_finish(Prefix, Lock, OldOpen.Error);
+	RADB_PROBE1(migrate_start, Prefix);
+	RADB_LATENCY(RADB_OP_MIGRATE);
+	// Keys are inserted in the same order each time, an interrupted migration resumes after the last inserted key.
+	char TempPrefix[strlen(Prefix) + 10];
+	sprintf(TempPrefix, "%s.migrate", Prefix);
+	linear_index_t *NewIndex = linear_index_open(TempPrefix, Keys RADB_MEM_ARGS);
+	if (!NewIndex) NewIndex = linear_index_create(TempPrefix, Keys RADB_MEM_ARGS);
+	linear_index_set_compare(NewIndex, (linear_compare_t)migrate_compare_string);
+	linear_index_set_insert(NewIndex, (linear_insert_t)migrate_insert_string);
+	migrate_keys(NewIndex, Keys, OldOpen.Index, Prefix);
+	string_index_close(OldOpen.Index);
+	RADB_PROBE2(migrate_done, Prefix, linear_index_count(NewIndex));
+	linear_index_close(NewIndex);
+	return radb_migrate_finish(Prefix, Lock, RADB_SUCCESS);
+}
+
+radb_error_t string_index2_migrate(const char *Prefix RADB_MEM_PARAMS) {
+	struct stat Stat[1];
+	char FileName[strlen(Prefix) + 10];
+	sprintf(FileName, "%s.index2", Prefix);
+	if (!stat(FileName, Stat)) return RADB_SUCCESS;
+	string_store_open_t KeysOpen = string_store_open2(Prefix RADB_MEM_ARGS);
+	if (!KeysOpen.Store) return KeysOpen.Error + 3;
+	radb_error_t Error = migrate_index(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+	string_store_close(KeysOpen.Store);
+	return Error;
 }
 
 linear_index_open_t string_index2_open2(const char *Prefix RADB_MEM_PARAMS) {
@@ -64,23 +222,20 @@ linear_index_open_t string_index2_open2(const char *Prefix RADB_MEM_PARAMS) {
 	if (!KeysOpen.Store) return (linear_index_open_t){NULL, KeysOpen.Error + 3};
 	linear_index_open_t IndexOpen = linear_index_open2(Prefix, KeysOpen.Store RADB_MEM_ARGS);
 	if (IndexOpen.Error == RADB_FILE_NOT_FOUND) {
-		string_index_open_t OldOpen = string_index_open2(Prefix RADB_MEM_ARGS);
-		if (OldOpen.Error != RADB_SUCCESS) {
+		IndexOpen.Error = migrate_index(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+		if (IndexOpen.Error != RADB_SUCCESS) {
 			string_store_close(KeysOpen.Store);
 			return IndexOpen;
 		}
-		linear_index_t *NewIndex = linear_index_create(Prefix, KeysOpen.Store RADB_MEM_ARGS);
-		linear_index_set_compare(NewIndex, (linear_compare_t)migrate_compare_string);
-		linear_index_set_insert(NewIndex, (linear_insert_t)migrate_insert_string);
-		migration_t Migration = {NewIndex, KeysOpen.Store};
-		string_index_foreach(OldOpen.Index, &Migration, (void *)migrate);
-		string_index_close(OldOpen.Index);
-		IndexOpen.Index = NewIndex;
-		IndexOpen.Error = RADB_SUCCESS;
+		IndexOpen = linear_index_open2(Prefix, KeysOpen.Store RADB_MEM_ARGS);
+	}
+	if (IndexOpen.Error != RADB_SUCCESS) {
+		string_store_close(KeysOpen.Store);
+		return IndexOpen;
 	}
-	if (IndexOpen.Error != RADB_SUCCESS) string_store_close(KeysOpen.Store);
-	linear_index_set_compare(IndexOpen.Index, (linear_compare_t)linear_compare_string);
-	linear_index_set_insert(IndexOpen.Index, (linear_insert_t)linear_insert_string);
+	linear_index_set_compare(IndexOpen.Index, linear_compare_string);
+	linear_index_set_insert(IndexOpen.Index, linear_insert_string);
+	string_set_methods(IndexOpen.Index);
 	return IndexOpen;
 }
 
@@ -97,53 +252,19 @@ void string_index2_close(string_index2_t *Store) {
 	linear_index_close(Store);
 }
 
-static uint32_t string_hash(const char *String, size_t Length) {
-	const unsigned char *Bytes = (const unsigned char *)String;
-	uint32_t Hash = 5381;
-	for (int I = 0; I < Length; ++I) Hash = ((Hash << 5) + Hash) + Bytes[I];
-	return Hash;
-}
-
 size_t string_index2_insert(string_index2_t *Store, const char *String, size_t Length) {
 	if (!Length) Length = strlen(String);
-	uint32_t Hash = string_hash(String, Length);
-	string_key_t Full = {String, Length};
-	linear_key_t Key = {0,};
-	if (Length >= sizeof(linear_key_t)) {
-		memcpy(Key, String, sizeof(linear_key_t) - 1);
-		Key[sizeof(linear_key_t) - 1] = 1;
-	} else {
-		memcpy(Key, String, Length);
-	}
-	return linear_index_insert(Store, Hash, Key, &Full);
+	return ((const string_methods_t *)Store->Methods)->insert2(Store, String, Length).Index;
 }
 
 size_t string_index2_search(string_index2_t *Store, const char *String, size_t Length) {
 	if (!Length) Length = strlen(String);
-	uint32_t Hash = string_hash(String, Length);
-	string_key_t Full = {String, Length};
-	linear_key_t Key = {0,};
-	if (Length >= sizeof(linear_key_t)) {
-		memcpy(Key, String, sizeof(linear_key_t) - 1);
-		Key[sizeof(linear_key_t) - 1] = 1;
-	} else {
-		memcpy(Key, String, Length);
-	}
-	return linear_index_search(Store, Hash, Key, &Full);
+	return ((const string_methods_t *)Store->Methods)->search(Store, String, Length);
 }
 
 index_result_t string_index2_insert2(string_index2_t *Store, const char *String, size_t Length) {
 	if (!Length) Length = strlen(String);
-	uint32_t Hash = string_hash(String, Length);
-	string_key_t Full = {String, Length};
-	linear_key_t Key = {0,};
-	if (Length >= sizeof(linear_key_t)) {
-		memcpy(Key, String, sizeof(linear_key_t) - 1);
-		Key[sizeof(linear_key_t) - 1] = 1;
-	} else {
-		memcpy(Key, String, Length);
-	}
-	return linear_index_insert2(Store, Hash, Key, &Full);
+	return ((const string_methods_t *)Store->Methods)->insert2(Store, String, Length);
 }
 
 size_t string_index2_size(string_index2_t *Store, size_t Index) {
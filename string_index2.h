@@ -5,14 +5,25 @@
 
 typedef struct linear_index_t string_index2_t;
 
+typedef enum {
+	STRING_INDEX2_PREFIX,
+	STRING_INDEX2_SUFFIX,
+	STRING_INDEX2_FINGERPRINT
+} string_index2_signature_t;
+
 string_index2_t *string_index2_create(const char *Prefix, size_t KeySize, size_t ChunkSize RADB_MEM_PARAMS);
+string_index2_t *string_index2_create_signature(const char *Prefix, size_t KeySize, size_t ChunkSize, string_index2_signature_t Signature RADB_MEM_PARAMS);
+string_index2_t *string_index2_create_engine(const char *Prefix, size_t KeySize, size_t ChunkSize, string_index2_signature_t Signature, linear_index_engine_t Engine RADB_MEM_PARAMS);
 string_index2_t *string_index2_open(const char *Prefix RADB_MEM_PARAMS);
 size_t string_index2_num_entries(string_index2_t *Store);
 #define string_index2_count string_index2_num_entries
+#define string_index2_cursor_open linear_index_cursor_open
+#define string_index2_set_filter linear_index_set_filter
 size_t string_index2_num_deleted(string_index2_t *Store);
 void string_index2_close(string_index2_t *Store);
 
 linear_index_open_t string_index2_open2(const char *Prefix RADB_MEM_PARAMS);
+radb_error_t string_index2_migrate(const char *Prefix RADB_MEM_PARAMS);
 
 size_t string_index2_insert(string_index2_t *Store, const char *Key, size_t Length);
 size_t string_index2_search(string_index2_t *Store, const char *Key, size_t Length);
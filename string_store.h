@@ -11,6 +11,8 @@ typedef struct string_store_writer_t string_store_writer_t;
 typedef struct string_store_reader_t string_store_reader_t;
 
 string_store_t *string_store_create(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS);
+string_store_t *string_store_create_bitmap(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS);
+string_store_t *string_store_create_sparse(const char *Prefix, size_t RequestedSize, size_t ChunkSize RADB_MEM_PARAMS);
 string_store_t *string_store_open(const char *Prefix RADB_MEM_PARAMS);
 void string_store_close(string_store_t *Store);
 
@@ -26,6 +28,7 @@ size_t string_store_num_entries(string_store_t *Store);
 size_t string_store_size(string_store_t *Store, size_t Index);
 size_t string_store_get(string_store_t *Store, size_t Index, void *Buffer, size_t Space);
 void string_store_set(string_store_t *Store, size_t Index, const void *Buffer, size_t Length);
+void string_store_reserve(string_store_t *Store, size_t Index, size_t ExpectedLength);
 
 void string_store_shift(string_store_t *Store, size_t Source, size_t Count, size_t Destination);
 
@@ -35,6 +38,9 @@ int string_store_compare2(string_store_t *Store, size_t Index1, size_t Index2);
 size_t string_store_alloc(string_store_t *Store);
 void string_store_free(string_store_t *Store, size_t Index);
 
+size_t string_store_alloc_run(string_store_t *Store, size_t Count);
+void string_store_cursor_open(radb_cursor_t *Cursor, string_store_t *Store);
+
 struct string_store_writer_t {
 	string_store_t *Store;
 	size_t Node, Index, Remain;
@@ -42,14 +48,32 @@ struct string_store_writer_t {
 
 void string_store_writer_open(string_store_writer_t *Writer, string_store_t *Store, size_t Index);
 void string_store_writer_append(string_store_writer_t *Writer, string_store_t *Store, size_t Index);
+void string_store_writer_reserve(string_store_writer_t *Writer, size_t Length);
+
+void string_store_tails_build(string_store_t *Store);
+void string_store_jumps_build(string_store_t *Store);
 size_t string_store_writer_write(string_store_writer_t *Writer, const void *Buffer, size_t Length);
 
 struct string_store_reader_t {
 	string_store_t *Store;
-	size_t Node, Offset, Remain;
+	size_t Node, Index, Offset, Remain;
 };
 
 void string_store_reader_open(string_store_reader_t *Reader, string_store_t *Store, size_t Index);
 size_t string_store_reader_read(string_store_reader_t *Reader, void *Buffer, size_t Length);
+void string_store_reader_seek(string_store_reader_t *Reader, size_t Offset);
+
+size_t string_store_read_at(string_store_t *Store, size_t Index, size_t Offset, void *Buffer, size_t Length);
+
+typedef struct {
+	size_t NumEntries, NumValues, NodeSize;
+	size_t NumNodes, NumFreeNodes, NumFreeRuns;
+	size_t WastedBytes;
+	size_t ChainLengths[RADB_STATS_HISTOGRAM_SIZE];
+	size_t MappingSize;
+	radb_stats_t Events;
+} string_store_stats_t;
+
+void string_store_stats(string_store_t *Store, string_store_stats_t *Stats);
 
 #endif
@@ -0,0 +1,158 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_INITIAL 10000
+#define NUM_OPERATIONS 20000
+#define MAX_ENTRIES (NUM_INITIAL + NUM_OPERATIONS * 20)
+
+typedef struct {
+	fixed_store_t *Fixed;
+	string_store_t *String;
+	size_t ValueSize;
+} test_store_t;
+
+static char Live[MAX_ENTRIES];
+static size_t Top;
+
+static size_t model_alloc_run(size_t Count) {
+	for (size_t Start = 0;; ++Start) {
+		size_t Length = 0;
+		while (Length < Count && !Live[Start + Length]) ++Length;
+		if (Length == Count) {
+			memset(Live + Start, 1, Count);
+			if (Top < Start + Count) Top = Start + Count;
+			return Start;
+		}
+		Start += Length;
+	}
+}
+
+static void test_write(test_store_t *Store, size_t Index) {
+	char Value[32];
+	if (Store->Fixed) {
+		memset(Value, 0, sizeof(Value));
+		sprintf(Value, "%zu", Index);
+		memcpy(fixed_store_get(Store->Fixed, Index), Value, Store->ValueSize);
+	} else {
+		string_store_set(Store->String, Index, Value, sprintf(Value, "value-%zu", Index));
+	}
+}
+
+static size_t test_alloc_run(test_store_t *Store, size_t Count) {
+	if (Count == 1) return Store->Fixed ? fixed_store_alloc(Store->Fixed) : string_store_alloc(Store->String);
+	return Store->Fixed ? fixed_store_alloc_run(Store->Fixed, Count) : string_store_alloc_run(Store->String, Count);
+}
+
+static void check_store(test_store_t *Store, const char *Stage) {
+	radb_cursor_t Cursor[1];
+	if (Store->Fixed) {
+		fixed_store_cursor_open(Cursor, Store->Fixed);
+	} else {
+		string_store_cursor_open(Cursor, Store->String);
+	}
+	size_t Expected = 0, NumLive = 0;
+	for (size_t Index; (Index = radb_cursor_next(Cursor)) != INVALID_INDEX;) {
+		while (Expected < MAX_ENTRIES && !Live[Expected]) ++Expected;
+		TEST_CHECK(Index == Expected, "%s: cursor returned %zu expected %zu", Stage, Index, Expected);
+		if (Index != Expected) break;
+		++Expected;
+	}
+	while (Expected < MAX_ENTRIES && !Live[Expected]) ++Expected;
+	TEST_CHECK(Expected == MAX_ENTRIES, "%s: cursor missed %zu", Stage, Expected);
+	char Value[32], Stored[32];
+	for (size_t Index = 0; Index < MAX_ENTRIES; ++Index) {
+		if (!Live[Index]) continue;
+		++NumLive;
+		if (Store->Fixed) {
+			memset(Value, 0, sizeof(Value));
+			sprintf(Value, "%zu", Index);
+			TEST_CHECK(!memcmp(fixed_store_get(Store->Fixed, Index), Value, Store->ValueSize), "%s: value %zu", Stage, Index);
+		} else {
+			size_t Length = sprintf(Value, "value-%zu", Index);
+			TEST_CHECK(string_store_get(Store->String, Index, Stored, sizeof(Stored)) == Length && !memcmp(Stored, Value, Length), "%s: value %zu", Stage, Index);
+		}
+	}
+	if (Store->Fixed) {
+		fixed_store_stats_t Stats[1];
+		fixed_store_stats(Store->Fixed, Stats);
+		TEST_CHECK(Stats->NumEntries - Stats->NumFree == NumLive, "%s: %zu entries %zu free expected %zu live", Stage, Stats->NumEntries, Stats->NumFree, NumLive);
+	}
+}
+
+// Allocations must return the lowest free index or run, which the model finds by scanning. Runs longer than a bitmap word
+// and string values set at unallocated indices are mixed in, and the bitmap must survive reopening.
+static void test_bitmap(test_store_t *Store, const char *Stage) {
+	memset(Live, 0, sizeof(Live));
+	Top = 0;
+	for (size_t I = 0; I < NUM_INITIAL; ++I) {
+		size_t Index = test_alloc_run(Store, 1);
+		TEST_CHECK(Index == model_alloc_run(1), "%s: initial alloc returned %zu expected %zu", Stage, Index, I);
+		test_write(Store, I);
+	}
+	for (size_t I = 0; I < NUM_OPERATIONS; ++I) {
+		int Operation = rand() % 8;
+		if (Operation < 4) {
+			size_t Index = rand() % Top;
+			while (Index < Top && !Live[Index]) ++Index;
+			if (Index == Top) continue;
+			if (Store->Fixed) {
+				fixed_store_free(Store->Fixed, Index);
+			} else {
+				string_store_free(Store->String, Index);
+			}
+			Live[Index] = 0;
+		} else if (Operation == 7 && !Store->Fixed) {
+			size_t Index = rand() % (NUM_INITIAL * 2);
+			Live[Index] = 1;
+			if (Top <= Index) Top = Index + 1;
+			test_write(Store, Index);
+		} else {
+			size_t Count = Operation == 6 ? 1 + rand() % 150 : 1;
+			size_t Expected = model_alloc_run(Count);
+			size_t Index = test_alloc_run(Store, Count);
+			TEST_CHECK(Index == Expected, "%s: alloc of %zu returned %zu expected %zu", Stage, Count, Index, Expected);
+			if (Index != Expected) break;
+			for (size_t J = 0; J < Count; ++J) test_write(Store, Index + J);
+		}
+	}
+	check_store(Store, Stage);
+}
+
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "bitmap_store_test";
+	char StoreName[strlen(Prefix) + 10];
+	srand(1);
+
+	for (int Packed = 0; Packed < 2; ++Packed) {
+		sprintf(StoreName, "%s.%s", Prefix, Packed ? "packed" : "fixed");
+		test_store_t Store[1] = {{NULL, NULL, Packed ? 5 : 8}};
+		Store->Fixed = (Packed ? fixed_store_create_packed : fixed_store_create_bitmap)(StoreName, Store->ValueSize, 0 TEST_MEM);
+		test_bitmap(Store, StoreName);
+		fixed_store_close(Store->Fixed);
+		Store->Fixed = fixed_store_open(StoreName TEST_MEM);
+		TEST_CHECK(Store->Fixed != NULL, "%s: reopen failed", StoreName);
+		if (Store->Fixed) {
+			check_store(Store, StoreName);
+			size_t Expected = model_alloc_run(1);
+			TEST_CHECK(fixed_store_alloc(Store->Fixed) == Expected, "%s: alloc after reopening", StoreName);
+			fixed_store_close(Store->Fixed);
+		}
+	}
+
+	sprintf(StoreName, "%s.string", Prefix);
+	test_store_t Store[1] = {{NULL, NULL, 0}};
+	Store->String = string_store_create_bitmap(StoreName, 16, 0 TEST_MEM);
+	test_bitmap(Store, StoreName);
+	string_store_close(Store->String);
+	Store->String = string_store_open(StoreName TEST_MEM);
+	TEST_CHECK(Store->String != NULL, "%s: reopen failed", StoreName);
+	if (Store->String) {
+		check_store(Store, StoreName);
+		size_t Expected = model_alloc_run(1);
+		TEST_CHECK(string_store_alloc(Store->String) == Expected, "%s: alloc after reopening", StoreName);
+		string_store_close(Store->String);
+	}
+
+	if (TestFailures) fprintf(stderr, "bitmap_store_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
@@ -0,0 +1,166 @@
+#include "test.h"
+#include <string.h>
+#include <math.h>
+
+#define NUM_ROWS 100000
+#define NUM_COLUMNS 7
+
+static const column_type_t Types[NUM_COLUMNS] = {
+	COLUMN_UINT8, COLUMN_UINT16, COLUMN_UINT32, COLUMN_UINT64, COLUMN_INT32, COLUMN_INT64, COLUMN_DOUBLE
+};
+
+static uint64_t random64(void) {
+	return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ rand();
+}
+
+// The model keeps every value widened to a column_value_t.
+static column_value_t random_value(column_type_t Type) {
+	uint64_t Random = random64();
+	column_value_t Value;
+	switch (Type) {
+	case COLUMN_UINT8: Value.Uint = (uint8_t)Random; break;
+	case COLUMN_UINT16: Value.Uint = (uint16_t)Random; break;
+	case COLUMN_UINT32: Value.Uint = (uint32_t)Random; break;
+	case COLUMN_UINT64: Value.Uint = Random; break;
+	case COLUMN_INT32: Value.Int = (int32_t)Random; break;
+	case COLUMN_INT64: Value.Int = (int64_t)Random; break;
+	default: Value.Double = ((int64_t)Random % 2000000) / 1000.0; break;
+	}
+	return Value;
+}
+
+static void store_value(void *Target, column_type_t Type, column_value_t Value) {
+	switch (Type) {
+	case COLUMN_UINT8: *(uint8_t *)Target = Value.Uint; break;
+	case COLUMN_UINT16: *(uint16_t *)Target = Value.Uint; break;
+	case COLUMN_UINT32: *(uint32_t *)Target = Value.Uint; break;
+	case COLUMN_UINT64: *(uint64_t *)Target = Value.Uint; break;
+	case COLUMN_INT32: *(int32_t *)Target = Value.Int; break;
+	case COLUMN_INT64: *(int64_t *)Target = Value.Int; break;
+	default: *(double *)Target = Value.Double; break;
+	}
+}
+
+static int model_between(column_type_t Type, column_value_t Value, column_value_t Min, column_value_t Max) {
+	if (Type == COLUMN_DOUBLE) return Value.Double >= Min.Double && Value.Double <= Max.Double;
+	if (Type == COLUMN_INT32 || Type == COLUMN_INT64) return Value.Int >= Min.Int && Value.Int <= Max.Int;
+	return Value.Uint >= Min.Uint && Value.Uint <= Max.Uint;
+}
+
+static int model_less(column_type_t Type, column_value_t A, column_value_t B) {
+	if (Type == COLUMN_DOUBLE) return A.Double < B.Double;
+	if (Type == COLUMN_INT32 || Type == COLUMN_INT64) return A.Int < B.Int;
+	return A.Uint < B.Uint;
+}
+
+#define SELECTED(SELECTION, I) (((SELECTION)[(I) / 64] >> ((I) % 64)) & 1)
+
+// Each scan is checked for ranges starting and ending inside a selection word, with the scalar kernels and every
+// vector kernel set the machine supports.
+static void check_scans(column_store_t *Store, column_value_t **Model, const char *Kernels) {
+	uint64_t *Selection = malloc((NUM_ROWS / 64 + 1) * sizeof(uint64_t));
+	uint64_t *Expected = malloc((NUM_ROWS / 64 + 1) * sizeof(uint64_t));
+	uint32_t *Indices = malloc(NUM_ROWS * sizeof(uint32_t));
+	for (int Trial = 0; Trial < 40; ++Trial) {
+		size_t Start = Trial < 2 ? 0 : rand() % NUM_ROWS;
+		size_t Count = Trial < 1 ? NUM_ROWS : rand() % (NUM_ROWS - Start + 1);
+		memset(Expected, 0, (NUM_ROWS / 64 + 1) * sizeof(uint64_t));
+		for (size_t Column = 0; Column < NUM_COLUMNS; ++Column) {
+			column_type_t Type = Types[Column];
+			column_value_t Min = Model[Column][rand() % NUM_ROWS], Max = Model[Column][rand() % NUM_ROWS];
+			if (model_less(Type, Max, Min)) {
+				column_value_t Temp = Min;
+				Min = Max;
+				Max = Temp;
+			}
+			column_combine_t Combine = Column == 0 ? COLUMN_SET : Column % 2 ? COLUMN_OR : COLUMN_AND;
+			column_store_filter(Store, Column, Start, Count, Min, Max, Selection, Combine);
+			size_t NumSelected = 0;
+			for (size_t I = 0; I < Count; ++I) {
+				int Between = model_between(Type, Model[Column][Start + I], Min, Max);
+				if (Combine == COLUMN_SET) {
+					Expected[I / 64] = (Expected[I / 64] & ~(1UL << (I % 64))) | ((uint64_t)Between << (I % 64));
+				} else if (Combine == COLUMN_OR) {
+					Expected[I / 64] |= (uint64_t)Between << (I % 64);
+				} else if (!Between) {
+					Expected[I / 64] &= ~(1UL << (I % 64));
+				}
+				NumSelected += SELECTED(Expected, I);
+			}
+			size_t Mismatch = Count;
+			for (size_t I = 0; I < Count && Mismatch == Count; ++I) if (SELECTED(Selection, I) != SELECTED(Expected, I)) Mismatch = I;
+			TEST_CHECK(Mismatch == Count, "%s: filter %zu of %zu rows from %zu differs at %zu", Kernels, Column, Count, Start, Mismatch);
+			TEST_CHECK(column_store_count(Selection, Count) == NumSelected, "%s: count %zu", Kernels, Column);
+			size_t NumIndices = column_store_select(Selection, Start, Count, Indices);
+			TEST_CHECK(NumIndices == NumSelected, "%s: select %zu returned %zu indices expected %zu", Kernels, Column, NumIndices, NumSelected);
+			for (size_t I = 0, J = 0; I < Count && J < NumIndices; ++I) {
+				if (SELECTED(Expected, I)) {
+					TEST_CHECK(Indices[J] == Start + I, "%s: select %zu index %zu", Kernels, Column, J);
+					++J;
+				}
+			}
+			// The selection is reused for the sums so they are checked with a partial selection and without one.
+			for (int Selected = 0; Selected < 2; ++Selected) {
+				column_value_t Sum = column_store_sum(Store, Column, Start, Count, Selected ? Selection : NULL);
+				column_value_t ModelSum = {0};
+				for (size_t I = 0; I < Count; ++I) {
+					if (Selected && !SELECTED(Expected, I)) continue;
+					if (Type == COLUMN_DOUBLE) {
+						ModelSum.Double += Model[Column][Start + I].Double;
+					} else {
+						ModelSum.Uint += Model[Column][Start + I].Uint;
+					}
+				}
+				if (Type == COLUMN_DOUBLE) {
+					TEST_CHECK(fabs(Sum.Double - ModelSum.Double) <= 1e-9 * Count * 1000, "%s: sum %zu is %f expected %f", Kernels, Column, Sum.Double, ModelSum.Double);
+				} else {
+					TEST_CHECK(Sum.Uint == ModelSum.Uint, "%s: sum %zu of %zu rows from %zu", Kernels, Column, Count, Start);
+				}
+			}
+		}
+	}
+	free(Selection);
+	free(Expected);
+	free(Indices);
+}
+
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "column_store_test";
+	const char *KernelNames[] = {"scalar", "sse4.2", "avx2"};
+	column_value_t *Model[NUM_COLUMNS];
+	srand(1);
+
+	column_store_t *Store = column_store_create(Prefix, NUM_COLUMNS, Types, 0 TEST_MEM);
+	for (size_t Column = 0; Column < NUM_COLUMNS; ++Column) {
+		Model[Column] = malloc(NUM_ROWS * sizeof(column_value_t));
+		// Integer models are kept sign extended so that integer sums wrap in the same way as the store's.
+		for (size_t I = 0; I < NUM_ROWS; ++I) {
+			Model[Column][I] = random_value(Types[Column]);
+			store_value(column_store_get(Store, Column, I), Types[Column], Model[Column][I]);
+		}
+	}
+	TEST_CHECK(column_store_num_rows(Store) == NUM_ROWS, "%zu rows", column_store_num_rows(Store));
+	for (size_t Column = 0; Column < NUM_COLUMNS; ++Column) {
+		TEST_CHECK(column_store_type(Store, Column) == Types[Column], "type of column %zu", Column);
+	}
+
+	const char *DefaultKernels = radb_get_kernels();
+	for (int I = 0; I < sizeof(KernelNames) / sizeof(KernelNames[0]); ++I) {
+		if (radb_set_kernels(KernelNames[I])) continue;
+		check_scans(Store, Model, KernelNames[I]);
+	}
+	radb_set_kernels(DefaultKernels);
+	column_store_close(Store);
+
+	column_store_open_t StoreOpen = column_store_open2(Prefix TEST_MEM);
+	TEST_CHECK(StoreOpen.Error == RADB_SUCCESS, "reopen failed: %s", radb_error_string(StoreOpen.Error));
+	if (StoreOpen.Store) {
+		TEST_CHECK(column_store_num_rows(StoreOpen.Store) == NUM_ROWS, "%zu rows after reopening", column_store_num_rows(StoreOpen.Store));
+		check_scans(StoreOpen.Store, Model, "reopened");
+		column_store_close(StoreOpen.Store);
+	}
+
+	for (size_t Column = 0; Column < NUM_COLUMNS; ++Column) free(Model[Column]);
+	if (TestFailures) fprintf(stderr, "column_store_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
@@ -0,0 +1,48 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 1000
+
+static size_t expected_lower_bound(uint64_t *Keys, size_t Count, uint64_t Key) {
+	size_t Position = 0;
+	while (Position < Count && Keys[Position] < Key) ++Position;
+	return Position;
+}
+
+static void check_lower_bound(fixed_store_t *Store, uint64_t *Keys, size_t Count, const char *Stage) {
+	for (size_t I = 0; I < 3000; ++I) {
+		uint64_t Key = I < 2 ? (I ? Keys[Count - 1] + 1 : 0) : (uint64_t)rand() * 7;
+		size_t Found = fixed_store_lower_bound(Store, Count, &Key, 0, 8);
+		size_t Expected = expected_lower_bound(Keys, Count, Key);
+		TEST_CHECK(Found == Expected, "%s: lower bound of %lu in %zu returned %zu expected %zu", Stage, (unsigned long)Key, Count, Found, Expected);
+	}
+}
+
+// The store has room for more entries than it holds, the unused entries are zero and must not be searched.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "fixed_store_test";
+	srand(1);
+	fixed_store_t *Store = fixed_store_create(Prefix, 8, 0 TEST_MEM);
+	uint64_t *Keys = malloc(NUM_KEYS * sizeof(uint64_t));
+	for (size_t I = 0; I < NUM_KEYS; ++I) Keys[I] = (uint64_t)rand() * 7;
+	for (size_t I = 1; I < NUM_KEYS; ++I) {
+		for (size_t J = I; J > 0 && Keys[J - 1] > Keys[J]; --J) {
+			uint64_t Swap = Keys[J];
+			Keys[J] = Keys[J - 1];
+			Keys[J - 1] = Swap;
+		}
+	}
+	for (size_t I = 0; I < NUM_KEYS; ++I) *(uint64_t *)fixed_store_get(Store, I) = Keys[I];
+	TEST_CHECK(fixed_store_num_entries(Store) > NUM_KEYS, "capacity %zu", fixed_store_num_entries(Store));
+	check_lower_bound(Store, Keys, NUM_KEYS, "binary search");
+	fixed_store_search_build(Store, NUM_KEYS, 0, 8);
+	check_lower_bound(Store, Keys, NUM_KEYS, "accelerated");
+	check_lower_bound(Store, Keys, NUM_KEYS / 2, "prefix");
+	fixed_store_close(Store);
+	Store = fixed_store_open(Prefix TEST_MEM);
+	check_lower_bound(Store, Keys, NUM_KEYS, "reopened");
+	fixed_store_close(Store);
+	free(Keys);
+	if (TestFailures) fprintf(stderr, "fixed_store_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
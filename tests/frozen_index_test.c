@@ -0,0 +1,89 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 50000
+#define NUM_MISSES 20000
+
+static size_t string_key(char *Buffer, size_t I) {
+	return sprintf(Buffer, I % 3 ? "%zu" : "a-longer-key-with-a-shared-prefix-%zu", I);
+}
+
+static void fixed_key(unsigned char *Buffer, size_t I) {
+	memset(Buffer, 0, 12);
+	memcpy(Buffer, &I, 4);
+	Buffer[11] = I * 3;
+}
+
+static void check_string(frozen_index_t *Frozen, size_t *Indices, const char *Stage) {
+	char Key[64];
+	TEST_CHECK(frozen_index_num_entries(Frozen) == NUM_KEYS, "%s: count %zu", Stage, frozen_index_num_entries(Frozen));
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t Length = string_key(Key, I);
+		size_t Found = frozen_index_search(Frozen, Key, I % 2 ? Length : 0);
+		TEST_CHECK(Found == Indices[I], "%s: search %zu returned %zu expected %zu", Stage, I, Found, Indices[I]);
+	}
+	for (size_t I = 0; I < NUM_MISSES; ++I) {
+		size_t Length = sprintf(Key, "missing-%zu", I);
+		TEST_CHECK(frozen_index_search(Frozen, Key, Length) == INVALID_INDEX, "%s: found missing key %zu", Stage, I);
+	}
+}
+
+static void check_fixed(frozen_index_t *Frozen, size_t *Indices, const char *Stage) {
+	unsigned char Key[12];
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		fixed_key(Key, I);
+		size_t Found = frozen_index_search(Frozen, Key, 0);
+		TEST_CHECK(Found == Indices[I], "%s: search %zu returned %zu expected %zu", Stage, I, Found, Indices[I]);
+	}
+	for (size_t I = NUM_KEYS; I < NUM_KEYS + NUM_MISSES; ++I) {
+		fixed_key(Key, I);
+		TEST_CHECK(frozen_index_search(Frozen, Key, 0) == INVALID_INDEX, "%s: found missing key %zu", Stage, I);
+	}
+}
+
+// The frozen index lives at its own prefix and searches the key store of the source index.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "frozen_index_test";
+	char SourceName[strlen(Prefix) + 10], FrozenName[strlen(Prefix) + 10];
+	size_t *Indices = malloc(NUM_KEYS * sizeof(size_t));
+	char Key[64];
+
+	sprintf(SourceName, "%s.string", Prefix);
+	sprintf(FrozenName, "%s.sfrozen", Prefix);
+	string_index2_t *Strings = string_index2_create(SourceName, 16, 0 TEST_MEM);
+	for (size_t I = 0; I < NUM_KEYS; ++I) Indices[I] = string_index2_insert(Strings, Key, string_key(Key, I));
+	frozen_index_t *Frozen = frozen_index_create_string(FrozenName, Strings TEST_MEM);
+	TEST_CHECK(Frozen != NULL, "string build failed");
+	if (Frozen) {
+		check_string(Frozen, Indices, "string");
+		frozen_index_close(Frozen);
+	}
+	string_index2_close(Strings);
+	string_store_t *StringKeys = string_store_open(SourceName TEST_MEM);
+	Frozen = frozen_index_open(FrozenName, StringKeys TEST_MEM);
+	TEST_CHECK(Frozen != NULL, "string reopen failed");
+	if (Frozen) {
+		check_string(Frozen, Indices, "string reopened");
+		frozen_index_close(Frozen);
+	}
+	string_store_close(StringKeys);
+
+	sprintf(SourceName, "%s.fixed", Prefix);
+	sprintf(FrozenName, "%s.ffrozen", Prefix);
+	fixed_index2_t *Fixed = fixed_index2_create(SourceName, 12, 0 TEST_MEM);
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		fixed_key((unsigned char *)Key, I);
+		Indices[I] = fixed_index2_insert(Fixed, Key);
+	}
+	Frozen = frozen_index_create_fixed(FrozenName, Fixed TEST_MEM);
+	TEST_CHECK(Frozen != NULL, "fixed build failed");
+	if (Frozen) {
+		check_fixed(Frozen, Indices, "fixed");
+		frozen_index_close(Frozen);
+	}
+	fixed_index2_close(Fixed);
+
+	free(Indices);
+	if (TestFailures) fprintf(stderr, "frozen_index_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
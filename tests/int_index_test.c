@@ -0,0 +1,97 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 100000
+#define NUM_ROUNDS 6
+
+static uint64_t *Keys;
+static size_t *Indices;
+static char *Seen;
+
+static void check_index(int_index_t *Index, size_t KeySize, const char *Stage) {
+	size_t NumLive = 0;
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		if (Indices[I] != INVALID_INDEX) ++NumLive;
+		TEST_CHECK(int_index_search(Index, Keys[I]) == Indices[I], "%d %s: search %zu returned %zu expected %zu", (int)KeySize, Stage, I, int_index_search(Index, Keys[I]), Indices[I]);
+		uint64_t Other = Keys[I] ^ (1UL << 40);
+		size_t Expected = KeySize == 4 ? Indices[I] : INVALID_INDEX;
+		TEST_CHECK(int_index_search(Index, Other) == Expected, "%d %s: search of modified key %zu", (int)KeySize, Stage, I);
+	}
+	TEST_CHECK(int_index_num_entries(Index) == NumLive, "%d %s: count %zu expected %zu", (int)KeySize, Stage, int_index_num_entries(Index), NumLive);
+	radb_cursor_t Cursor[1];
+	int_index_cursor_open(Cursor, Index);
+	memset(Seen, 0, NUM_KEYS * NUM_ROUNDS);
+	size_t NumVisited = 0;
+	for (size_t Value; (Value = radb_cursor_next(Cursor)) != INVALID_INDEX; ++NumVisited) {
+		if (Value < NUM_KEYS * NUM_ROUNDS) ++Seen[Value];
+	}
+	TEST_CHECK(NumVisited == NumLive, "%d %s: cursor visited %zu expected %zu", (int)KeySize, Stage, NumVisited, NumLive);
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		if (Indices[I] != INVALID_INDEX) TEST_CHECK(Seen[Indices[I]] == 1, "%d %s: cursor visited %zu %d times", (int)KeySize, Stage, I, Seen[Indices[I]]);
+	}
+}
+
+// Each round deletes a third of the keys and inserts the ones deleted in the previous round, so inserts reuse deleted
+// slots and rebuilds drop them. Indices are never reused, the model tracks the next one.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "int_index_test";
+	char IndexName[strlen(Prefix) + 10];
+	Keys = malloc(NUM_KEYS * sizeof(uint64_t));
+	Indices = malloc(NUM_KEYS * sizeof(size_t));
+	Seen = malloc(NUM_KEYS * NUM_ROUNDS);
+	srand(1);
+
+	// The low 32 bits are distinct so keys stay unique in an index with 4 byte keys.
+	for (size_t I = 0; I < NUM_KEYS; ++I) Keys[I] = ((uint64_t)rand() << 32) | (uint32_t)(I * 2654435761U);
+
+	for (size_t KeySize = 4; KeySize <= 8; KeySize += 4) {
+		sprintf(IndexName, "%s.%zu", Prefix, KeySize);
+		int_index_t *Index = int_index_create(IndexName, KeySize TEST_MEM);
+		TEST_CHECK(int_index_key_size(Index) == KeySize, "%d: key size %u", (int)KeySize, int_index_key_size(Index));
+		size_t NextIndex = 0;
+		for (size_t I = 0; I < NUM_KEYS; ++I) {
+			index_result_t Result = int_index_insert2(Index, Keys[I]);
+			TEST_CHECK(Result.Created && Result.Index == NextIndex, "%d: insert %zu returned %zu", (int)KeySize, I, Result.Index);
+			Indices[I] = NextIndex++;
+		}
+		for (size_t I = 0; I < NUM_KEYS; I += 7) {
+			index_result_t Result = int_index_insert2(Index, Keys[I]);
+			TEST_CHECK(!Result.Created && Result.Index == Indices[I], "%d: reinsert %zu", (int)KeySize, I);
+		}
+		check_index(Index, KeySize, "inserted");
+
+		for (int Round = 0; Round < NUM_ROUNDS - 1; ++Round) {
+			for (size_t I = 0; I < NUM_KEYS; ++I) {
+				if ((I + Round) % 3 == 0) {
+					TEST_CHECK(int_index_delete(Index, Keys[I]) == Indices[I], "%d: delete %zu in round %d", (int)KeySize, I, Round);
+					Indices[I] = INVALID_INDEX;
+				} else if (Indices[I] == INVALID_INDEX) {
+					TEST_CHECK(int_index_insert(Index, Keys[I]) == NextIndex, "%d: insert %zu in round %d", (int)KeySize, I, Round);
+					Indices[I] = NextIndex++;
+				}
+			}
+			size_t First = (3 - Round % 3) % 3;
+			TEST_CHECK(int_index_delete(Index, Keys[First]) == INVALID_INDEX, "%d: deleted key %zu twice", (int)KeySize, First);
+			check_index(Index, KeySize, "churned");
+		}
+		int_index_close(Index);
+
+		int_index_open_t IndexOpen = int_index_open2(IndexName TEST_MEM);
+		TEST_CHECK(IndexOpen.Error == RADB_SUCCESS, "%d: reopen failed: %s", (int)KeySize, radb_error_string(IndexOpen.Error));
+		if (IndexOpen.Index) {
+			check_index(IndexOpen.Index, KeySize, "reopened");
+			index_result_t Result = int_index_insert2(IndexOpen.Index, 0xFFFFFFFFFFULL);
+			TEST_CHECK(Result.Created && Result.Index == NextIndex, "%d: next index after reopening", (int)KeySize);
+			int_index_close(IndexOpen.Index);
+		}
+	}
+
+	sprintf(IndexName, "%s.missing", Prefix);
+	TEST_CHECK(int_index_open2(IndexName TEST_MEM).Error == RADB_FILE_NOT_FOUND, "missing index opened");
+
+	free(Keys);
+	free(Indices);
+	free(Seen);
+	if (TestFailures) fprintf(stderr, "int_index_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
@@ -0,0 +1,78 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 100000
+#define VALUE_SIZE 12
+
+typedef struct {
+	uint32_t Key, Count, Check;
+} test_value_t;
+
+static size_t test_key(char *Buffer, size_t I) {
+	return sprintf(Buffer, I % 2 ? "%zu" : "a-longer-key-with-a-shared-prefix-%zu", I);
+}
+
+static void check_map(kv_map_t *Map, size_t *Indices, uint32_t *Counts, const char *Stage) {
+	char Key[64], Stored[64];
+	TEST_CHECK(kv_map_num_entries(Map) == NUM_KEYS, "%s: count %zu", Stage, kv_map_num_entries(Map));
+	TEST_CHECK(kv_map_value_size(Map) == VALUE_SIZE, "%s: value size %zu", Stage, kv_map_value_size(Map));
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t Length = test_key(Key, I);
+		const test_value_t *Value = kv_map_get(Map, Key, I % 3 ? Length : 0);
+		TEST_CHECK(Value && Value->Key == I && Value->Count == Counts[I] && Value->Check == (uint32_t)~I, "%s: get %zu", Stage, I);
+		TEST_CHECK(kv_map_key_get(Map, Indices[I], Stored, sizeof(Stored)) == Length && !memcmp(Stored, Key, Length), "%s: key %zu", Stage, I);
+	}
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t Length = sprintf(Key, "missing-%zu", I);
+		TEST_CHECK(kv_map_get(Map, Key, Length) == NULL, "%s: found missing key %zu", Stage, I);
+	}
+}
+
+// Values are checked after every bucket split has moved them, and after updates through the pointer from kv_map_update_inplace().
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "kv_map_test";
+	size_t *Indices = malloc(NUM_KEYS * sizeof(size_t));
+	uint32_t *Counts = calloc(NUM_KEYS, sizeof(uint32_t));
+	char Key[64];
+
+	kv_map_t *Map = kv_map_create(Prefix, VALUE_SIZE, 16, 0 TEST_MEM);
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t Length = test_key(Key, I);
+		test_value_t Value = {I, 0, ~I};
+		index_result_t Result = kv_map_put(Map, Key, I % 5 ? Length : 0, &Value);
+		TEST_CHECK(Result.Created && Result.Index == I, "put %zu returned %zu", I, Result.Index);
+		Indices[I] = Result.Index;
+		if (I % 1000 == 999) {
+			size_t J = rand() % I;
+			const test_value_t *Old = kv_map_get(Map, Key, test_key(Key, J));
+			TEST_CHECK(Old && Old->Key == J && Old->Check == (uint32_t)~J, "get %zu after %zu puts", J, I + 1);
+		}
+	}
+	for (size_t I = 0; I < NUM_KEYS; I += 3) {
+		size_t Length = test_key(Key, I);
+		test_value_t *Value = kv_map_update_inplace(Map, Key, Length);
+		Value->Count += 2;
+		Counts[I] += 2;
+		test_value_t Replacement = {I, Counts[I] + 1, ~I};
+		index_result_t Result = kv_map_put(Map, Key, 0, &Replacement);
+		TEST_CHECK(!Result.Created && Result.Index == Indices[I], "put %zu again", I);
+		Counts[I] += 1;
+	}
+	check_map(Map, Indices, Counts, "created");
+	kv_map_close(Map);
+
+	kv_map_open_t MapOpen = kv_map_open2(Prefix TEST_MEM);
+	TEST_CHECK(MapOpen.Error == RADB_SUCCESS, "reopen failed: %s", radb_error_string(MapOpen.Error));
+	if (MapOpen.Map) {
+		check_map(MapOpen.Map, Indices, Counts, "reopened");
+		test_value_t *Value = kv_map_update_inplace(MapOpen.Map, "new", 0);
+		TEST_CHECK(Value && Value->Key == 0 && Value->Count == 0 && Value->Check == 0, "new value is not zeroed");
+		TEST_CHECK(kv_map_num_entries(MapOpen.Map) == NUM_KEYS + 1, "count after adding a key");
+		kv_map_close(MapOpen.Map);
+	}
+
+	free(Indices);
+	free(Counts);
+	if (TestFailures) fprintf(stderr, "kv_map_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
@@ -0,0 +1,128 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 60000
+#define NUM_ROUNDS 8
+#define NUM_TOTAL (NUM_KEYS + NUM_ROUNDS * NUM_KEYS / 2)
+
+typedef struct {
+	uint64_t *Keys;
+	size_t Count;
+} test_keys_t;
+
+static int test_compare(test_keys_t *Keys, const uint64_t *Full, uint32_t Index) {
+	return Keys->Keys[Index] != *Full;
+}
+
+static size_t test_insert(test_keys_t *Keys, const uint64_t *Full) {
+	Keys->Keys[Keys->Count] = *Full;
+	return Keys->Count++;
+}
+
+// The hash has 12 bits, so the swiss engine has full groups which leave deleted slots, and the signature only holds the low 32 bits of the key, so both collide and the full key is compared.
+static uint32_t test_hash(uint64_t Key, linear_key_t Signature) {
+	memset(Signature, 0, sizeof(linear_key_t));
+	memcpy(Signature, &Key, 4);
+	return (uint32_t)((Key * 0x9E3779B97F4A7C15) >> 52);
+}
+
+static uint64_t test_key(size_t I) {
+	return (I % 2 ? (uint64_t)(I / 2 + 1) << 32 : 0) | (I / 2);
+}
+
+static void check_index(linear_index_t *Index, test_keys_t *Keys, size_t *Indices, const char *Stage) {
+	size_t NumLive = 0;
+	linear_key_t Signature;
+	for (size_t I = 0; I < NUM_TOTAL; ++I) {
+		uint64_t Key = test_key(I);
+		uint32_t Hash = test_hash(Key, Signature);
+		if (Indices[I] != INVALID_INDEX) ++NumLive;
+		TEST_CHECK(linear_index_search(Index, Hash, Signature, &Key) == Indices[I], "%s: search %zu", Stage, I);
+	}
+	TEST_CHECK(linear_index_count(Index) == NumLive, "%s: count %zu expected %zu", Stage, linear_index_count(Index), NumLive);
+	radb_cursor_t Cursor[1];
+	linear_index_cursor_open(Cursor, Index);
+	size_t NumVisited = 0;
+	for (size_t Value; (Value = radb_cursor_next(Cursor)) != INVALID_INDEX; ++NumVisited) {
+		uint64_t Key = Keys->Keys[Value];
+		TEST_CHECK(linear_index_search(Index, test_hash(Key, Signature), Signature, &Key) == Value, "%s: cursor returned stale %zu", Stage, Value);
+	}
+	TEST_CHECK(NumVisited == NumLive, "%s: cursor visited %zu expected %zu", Stage, NumVisited, NumLive);
+}
+
+static linear_index_t *test_open(const char *Prefix, test_keys_t *Keys) {
+	linear_index_t *Index = linear_index_open(Prefix, Keys TEST_MEM);
+	if (!Index) return NULL;
+	linear_index_set_compare(Index, (linear_compare_t)test_compare);
+	linear_index_set_insert(Index, (linear_insert_t)test_insert);
+	return Index;
+}
+
+// Each round deletes the oldest half of the keys and inserts as many new ones, so the number of keys stays the same
+// and the tables must reuse deleted slots and holes rather than keep growing.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "linear_index_test";
+	const char *Names[] = {"linear", "swiss"};
+	char IndexName[strlen(Prefix) + 10];
+	size_t *Indices = malloc(NUM_TOTAL * sizeof(size_t));
+	test_keys_t Keys[1];
+	Keys->Keys = malloc(NUM_TOTAL * sizeof(uint64_t));
+	linear_key_t Signature;
+
+	for (int Engine = LINEAR_INDEX_LINEAR; Engine <= LINEAR_INDEX_SWISS; ++Engine) {
+		sprintf(IndexName, "%s.%s", Prefix, Names[Engine]);
+		Keys->Count = 0;
+		linear_index_t *Index = linear_index_create_engine(IndexName, Keys, Engine TEST_MEM);
+		linear_index_set_compare(Index, (linear_compare_t)test_compare);
+		linear_index_set_insert(Index, (linear_insert_t)test_insert);
+		TEST_CHECK(linear_index_engine(Index) == Engine, "%s: engine %d", Names[Engine], linear_index_engine(Index));
+		for (size_t I = 0; I < NUM_TOTAL; ++I) Indices[I] = INVALID_INDEX;
+		for (size_t I = 0; I < NUM_KEYS; ++I) {
+			uint64_t Key = test_key(I);
+			index_result_t Result = linear_index_insert2(Index, test_hash(Key, Signature), Signature, &Key);
+			TEST_CHECK(Result.Created && Result.Index == I, "%s: insert %zu returned %zu", Names[Engine], I, Result.Index);
+			Indices[I] = Result.Index;
+		}
+		check_index(Index, Keys, Indices, Names[Engine]);
+
+		linear_index_stats_t Before[1], After[1];
+		linear_index_stats(Index, Before);
+		for (size_t Round = 0; Round < NUM_ROUNDS; ++Round) {
+			size_t Oldest = Round * NUM_KEYS / 2, Newest = Oldest + NUM_KEYS;
+			for (size_t I = 0; I < NUM_KEYS / 2; ++I) {
+				uint64_t Key = test_key(Oldest + I);
+				uint32_t Hash = test_hash(Key, Signature);
+				index_result_t Result = linear_index_delete2(Index, Hash, Signature, &Key);
+				TEST_CHECK(Result.Created && Result.Index == Indices[Oldest + I], "%s: delete %zu", Names[Engine], Oldest + I);
+				Indices[Oldest + I] = INVALID_INDEX;
+				TEST_CHECK(linear_index_delete(Index, Hash, Signature, &Key) == INVALID_INDEX, "%s: deleted %zu twice", Names[Engine], Oldest + I);
+				Key = test_key(Newest + I);
+				size_t Expected = Keys->Count;
+				TEST_CHECK(linear_index_insert(Index, test_hash(Key, Signature), Signature, &Key) == Expected, "%s: insert %zu", Names[Engine], Newest + I);
+				Indices[Newest + I] = Expected;
+			}
+			check_index(Index, Keys, Indices, Names[Engine]);
+		}
+		linear_index_stats(Index, After);
+		TEST_CHECK(After->NumSlots <= 2 * Before->NumSlots, "%s: grew from %zu to %zu slots", Names[Engine], Before->NumSlots, After->NumSlots);
+		if (Engine == LINEAR_INDEX_SWISS) {
+			TEST_CHECK(Before->Events.Rebuilds.Count > 0, "swiss: no rebuild while inserting");
+			TEST_CHECK(After->NumHoles > 0, "swiss: no deleted slots");
+			TEST_CHECK(After->NumSlots == Before->NumSlots, "swiss: grew from %zu to %zu slots with the same number of keys", Before->NumSlots, After->NumSlots);
+		}
+		linear_index_close(Index);
+
+		Index = test_open(IndexName, Keys);
+		TEST_CHECK(Index != NULL, "%s: reopen failed", Names[Engine]);
+		if (Index) {
+			TEST_CHECK(linear_index_engine(Index) == Engine, "%s: reopened engine %d", Names[Engine], linear_index_engine(Index));
+			check_index(Index, Keys, Indices, "reopened");
+			linear_index_close(Index);
+		}
+	}
+
+	free(Keys->Keys);
+	free(Indices);
+	if (TestFailures) fprintf(stderr, "linear_index_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
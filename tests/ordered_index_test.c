@@ -0,0 +1,90 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 60000
+#define MAX_LENGTH 24
+
+typedef struct {
+	unsigned char Bytes[MAX_LENGTH];
+	size_t Length, Index, Order;
+	int Created;
+} test_key_t;
+
+static int key_compare(const void *A, const void *B) {
+	const test_key_t *KeyA = A, *KeyB = B;
+	size_t Length = KeyA->Length < KeyB->Length ? KeyA->Length : KeyB->Length;
+	int Cmp = memcmp(KeyA->Bytes, KeyB->Bytes, Length);
+	if (Cmp) return Cmp;
+	return (KeyA->Length > KeyB->Length) - (KeyA->Length < KeyB->Length);
+}
+
+static int key_order_compare(const void *A, const void *B) {
+	int Cmp = key_compare(A, B);
+	if (Cmp) return Cmp;
+	return ((const test_key_t *)A)->Order > ((const test_key_t *)B)->Order ? 1 : -1;
+}
+
+static void key_random(test_key_t *Key, size_t Bound) {
+	Key->Length = 1 + rand() % MAX_LENGTH;
+	for (size_t I = 0; I < Key->Length; ++I) Key->Bytes[I] = rand();
+	Key->Bytes[0] = rand() % Bound;
+}
+
+// Random binary keys drifting downwards keep splitting the leftmost subtree, which adds separators
+// smaller than any key present when the root was first split.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "ordered_index_test";
+	srand(1);
+	ordered_index_t *Index = ordered_index_create(Prefix, 16, 0 TEST_MEM);
+	test_key_t *Keys = malloc(NUM_KEYS * sizeof(test_key_t));
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		test_key_t *Key = Keys + I;
+		key_random(Key, 256 - I * 255 / NUM_KEYS);
+		index_result_t Result = ordered_index_insert2(Index, (const char *)Key->Bytes, Key->Length);
+		Key->Index = Result.Index;
+		Key->Created = Result.Created;
+		Key->Order = I;
+	}
+	// Only the first insert of each key creates it, later ones return the same index.
+	qsort(Keys, NUM_KEYS, sizeof(test_key_t), key_order_compare);
+	size_t NumKeys = 0;
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		if (NumKeys && !key_compare(Keys + I, Keys + NumKeys - 1)) {
+			TEST_CHECK(!Keys[I].Created && Keys[I].Index == Keys[NumKeys - 1].Index, "duplicate %zu created %d", Keys[I].Order, Keys[I].Created);
+		} else {
+			TEST_CHECK(Keys[I].Created, "insert %zu not created", Keys[I].Order);
+			Keys[NumKeys++] = Keys[I];
+		}
+	}
+	TEST_CHECK(ordered_index_num_entries(Index) == NumKeys, "count %zu expected %zu", ordered_index_num_entries(Index), NumKeys);
+	for (size_t I = 0; I < NumKeys; ++I) {
+		test_key_t *Key = Keys + I;
+		size_t Found = ordered_index_search(Index, (const char *)Key->Bytes, Key->Length);
+		TEST_CHECK(Found == Key->Index, "search %zu returned %zu expected %zu", I, Found, Key->Index);
+		index_result_t Result = ordered_index_insert2(Index, (const char *)Key->Bytes, Key->Length);
+		TEST_CHECK(!Result.Created && Result.Index == Key->Index, "duplicate insert %zu created %d", I, Result.Created);
+	}
+	TEST_CHECK(ordered_index_num_entries(Index) == NumKeys, "count %zu after duplicates", ordered_index_num_entries(Index));
+	qsort(Keys, NumKeys, sizeof(test_key_t), key_compare);
+	for (size_t I = 0; I < 2000; ++I) {
+		test_key_t Probe[1];
+		key_random(Probe, 256);
+		size_t Lo = 0, Hi = NumKeys;
+		while (Lo < Hi) {
+			size_t Mid = (Lo + Hi) / 2;
+			if (key_compare(Keys + Mid, Probe) < 0) Lo = Mid + 1; else Hi = Mid;
+		}
+		ordered_index_cursor_t Cursor[1];
+		size_t Found = ordered_index_seek(Cursor, Index, (const char *)Probe->Bytes, Probe->Length);
+		size_t Expected = Lo < NumKeys ? Keys[Lo].Index : INVALID_INDEX;
+		TEST_CHECK(Found == Expected, "seek %zu returned %zu expected %zu", I, Found, Expected);
+		if (Lo + 1 < NumKeys) {
+			size_t Next = ordered_index_next(Cursor);
+			TEST_CHECK(Next == Keys[Lo + 1].Index, "next %zu returned %zu expected %zu", I, Next, Keys[Lo + 1].Index);
+		}
+	}
+	ordered_index_close(Index);
+	free(Keys);
+	if (TestFailures) fprintf(stderr, "ordered_index_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
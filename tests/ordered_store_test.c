@@ -0,0 +1,117 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_OPERATIONS 60000
+#define MAX_VALUES NUM_OPERATIONS
+#define VALUE_SIZE 12
+
+typedef struct {
+	uint32_t Key, Check, Inserted;
+} test_value_t;
+
+static test_value_t Model[MAX_VALUES];
+static size_t NumValues;
+
+static test_value_t test_value(uint32_t Key, size_t Inserted) {
+	return (test_value_t){Key, ~Key, Inserted};
+}
+
+static int test_compare(void *Data, const void *Key, const void *Value) {
+	uint32_t A = *(const uint32_t *)Key, B = ((const test_value_t *)Value)->Key;
+	return (A > B) - (A < B);
+}
+
+static void model_insert_at(size_t Rank, test_value_t Value) {
+	if (Rank > NumValues) Rank = NumValues;
+	memmove(Model + Rank + 1, Model + Rank, (NumValues - Rank) * sizeof(test_value_t));
+	Model[Rank] = Value;
+	++NumValues;
+}
+
+static void model_remove_at(size_t Rank) {
+	memmove(Model + Rank, Model + Rank + 1, (NumValues - Rank - 1) * sizeof(test_value_t));
+	--NumValues;
+}
+
+static void check_store(ordered_store_t *Store, const char *Stage) {
+	TEST_CHECK(ordered_store_count(Store) == NumValues, "%s: count %zu expected %zu", Stage, ordered_store_count(Store), NumValues);
+	TEST_CHECK(ordered_store_value_size(Store) == VALUE_SIZE, "%s: value size %zu", Stage, ordered_store_value_size(Store));
+	for (size_t Rank = 0; Rank < NumValues; ++Rank) {
+		const test_value_t *Value = ordered_store_select(Store, Rank);
+		TEST_CHECK(Value && !memcmp(Value, Model + Rank, VALUE_SIZE), "%s: select %zu", Stage, Rank);
+	}
+	TEST_CHECK(ordered_store_select(Store, NumValues) == NULL, "%s: select past the end", Stage);
+	// Iterators start at random ranks and must skip the gaps between segments.
+	for (int Trial = 0; Trial < 20; ++Trial) {
+		size_t Rank = Trial ? rand() % (NumValues + 1) : 0;
+		ordered_store_iterator_t Iterator[1];
+		const test_value_t *Value = ordered_store_seek(Iterator, Store, Rank);
+		for (; Rank < NumValues; ++Rank) {
+			TEST_CHECK(Value && !memcmp(Value, Model + Rank, VALUE_SIZE), "%s: iterator at %zu", Stage, Rank);
+			if (!Value) break;
+			Value = ordered_store_next(Iterator);
+		}
+		if (Rank == NumValues) TEST_CHECK(Value == NULL, "%s: iterator past the end", Stage);
+	}
+}
+
+// Values are inserted and removed at random ranks while the model array is shifted in the same way, with segments of
+// 16 values so that segments fill up, windows are rebalanced and the store grows. A second store is kept sorted
+// with ordered_store_rank(), with runs of equal keys.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "ordered_store_test";
+	char StoreName[strlen(Prefix) + 10];
+	srand(1);
+
+	sprintf(StoreName, "%s.random", Prefix);
+	ordered_store_t *Store = ordered_store_create(StoreName, VALUE_SIZE, 16 * VALUE_SIZE TEST_MEM);
+	for (size_t I = 0; I < NUM_OPERATIONS; ++I) {
+		if (NumValues && rand() % 3 == 0) {
+			size_t Rank = rand() % NumValues;
+			ordered_store_remove_at(Store, Rank);
+			model_remove_at(Rank);
+		} else {
+			// Inserts past the end append, and inserts at the front and back are common in practice.
+			int Where = rand() % 8;
+			size_t Rank = Where == 0 ? 0 : Where == 1 ? NumValues + rand() % 3 : rand() % (NumValues + 1);
+			test_value_t Value = test_value(rand(), I);
+			ordered_store_insert_at(Store, Rank, &Value);
+			model_insert_at(Rank, Value);
+		}
+		if (I % 10000 == 9999) check_store(Store, "random");
+	}
+	ordered_store_remove_at(Store, NumValues);
+	check_store(Store, "random");
+	ordered_store_close(Store);
+
+	ordered_store_open_t StoreOpen = ordered_store_open2(StoreName TEST_MEM);
+	TEST_CHECK(StoreOpen.Error == RADB_SUCCESS, "random: reopen failed: %s", radb_error_string(StoreOpen.Error));
+	if (StoreOpen.Store) {
+		check_store(StoreOpen.Store, "random reopened");
+		// Removing everything from the front empties the segments one after another.
+		while (NumValues) {
+			ordered_store_remove_at(StoreOpen.Store, 0);
+			model_remove_at(0);
+		}
+		check_store(StoreOpen.Store, "emptied");
+		ordered_store_close(StoreOpen.Store);
+	}
+
+	sprintf(StoreName, "%s.sorted", Prefix);
+	Store = ordered_store_create(StoreName, VALUE_SIZE, 0 TEST_MEM);
+	for (size_t I = 0; I < NUM_OPERATIONS / 2; ++I) {
+		uint32_t Key = rand() % (NUM_OPERATIONS / 4);
+		size_t Expected = 0;
+		while (Expected < NumValues && Model[Expected].Key < Key) ++Expected;
+		size_t Rank = ordered_store_rank(Store, &Key, test_compare, NULL);
+		TEST_CHECK(Rank == Expected, "sorted: rank of %u is %zu expected %zu", Key, Rank, Expected);
+		test_value_t Value = test_value(Key, I);
+		ordered_store_insert_at(Store, Rank, &Value);
+		model_insert_at(Rank, Value);
+	}
+	check_store(Store, "sorted");
+	ordered_store_close(Store);
+
+	if (TestFailures) fprintf(stderr, "ordered_store_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
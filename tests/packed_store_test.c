@@ -0,0 +1,79 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_VALUES 5000
+#define MAX_LENGTH 3000
+
+static void check_packed(packed_store_t *Packed, char **Values, size_t *Lengths, size_t NumEntries, const char *Stage) {
+	TEST_CHECK(packed_store_num_entries(Packed) == NumEntries, "%s: %zu entries expected %zu", Stage, packed_store_num_entries(Packed), NumEntries);
+	char *Buffer = malloc(MAX_LENGTH);
+	for (size_t I = 0; I < NumEntries; ++I) {
+		packed_store_view_t View = packed_store_view(Packed, I);
+		TEST_CHECK(View.Length == Lengths[I], "%s: value %zu has length %zu expected %zu", Stage, I, View.Length, Lengths[I]);
+		TEST_CHECK(packed_store_size(Packed, I) == Lengths[I], "%s: size %zu", Stage, I);
+		if (View.Length == Lengths[I]) TEST_CHECK(!memcmp(View.Value, Values[I], Lengths[I]), "%s: value %zu differs", Stage, I);
+		size_t Space = Lengths[I] / 2;
+		TEST_CHECK(packed_store_get(Packed, I, Buffer, Space) == Space && !memcmp(Buffer, Values[I], Space), "%s: partial get %zu", Stage, I);
+	}
+	TEST_CHECK(packed_store_view(Packed, NumEntries).Length == 0, "%s: value past the end", Stage);
+	free(Buffer);
+}
+
+// Values are random with some empty and freed entries, the source store also has unused entries after the last value.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "packed_store_test";
+	char SourceName[strlen(Prefix) + 10], PackedName[strlen(Prefix) + 10];
+	sprintf(SourceName, "%s.source", Prefix);
+	sprintf(PackedName, "%s.packed", Prefix);
+	srand(1);
+
+	string_store_t *Source = string_store_create(SourceName, 16, 0 TEST_MEM);
+	TEST_CHECK(packed_store_build(Source, PackedName) == RADB_SUCCESS, "empty build failed");
+	packed_store_t *Packed = packed_store_open(PackedName TEST_MEM);
+	TEST_CHECK(Packed && packed_store_num_entries(Packed) == 0, "empty store has entries");
+	if (Packed) packed_store_close(Packed);
+
+	char **Values = malloc(NUM_VALUES * sizeof(char *));
+	size_t *Lengths = malloc(NUM_VALUES * sizeof(size_t));
+	for (size_t I = 0; I < NUM_VALUES; ++I) {
+		Lengths[I] = I % 7 ? rand() % MAX_LENGTH : 0;
+		Values[I] = malloc(Lengths[I] + 1);
+		for (size_t J = 0; J < Lengths[I]; ++J) Values[I][J] = rand();
+		string_store_set(Source, I, Values[I], Lengths[I]);
+	}
+	for (size_t I = 5; I < NUM_VALUES; I += 11) {
+		string_store_free(Source, I);
+		Lengths[I] = 0;
+	}
+	Lengths[NUM_VALUES - 1] = 0;
+	string_store_set(Source, NUM_VALUES - 1, NULL, 0);
+	size_t NumEntries = NUM_VALUES;
+	while (NumEntries && !Lengths[NumEntries - 1]) --NumEntries;
+	TEST_CHECK(string_store_num_entries(Source) > NumEntries, "source has %zu entries", string_store_num_entries(Source));
+
+	TEST_CHECK(packed_store_build(Source, PackedName) == RADB_SUCCESS, "build failed");
+	Packed = packed_store_open(PackedName TEST_MEM);
+	TEST_CHECK(Packed != NULL, "open failed");
+	if (Packed) {
+		check_packed(Packed, Values, Lengths, NumEntries, "built");
+		packed_store_close(Packed);
+	}
+	string_store_close(Source);
+	Packed = packed_store_open(PackedName TEST_MEM);
+	if (Packed) {
+		check_packed(Packed, Values, Lengths, NumEntries, "reopened");
+		packed_store_close(Packed);
+	}
+
+	char MissingName[strlen(Prefix) + 20];
+	sprintf(MissingName, "%s.missing/packed", Prefix);
+	Source = string_store_open(SourceName TEST_MEM);
+	TEST_CHECK(packed_store_build(Source, MissingName) == RADB_WRITE_FAILED, "build into a missing directory succeeded");
+	string_store_close(Source);
+
+	for (size_t I = 0; I < NUM_VALUES; ++I) free(Values[I]);
+	free(Values);
+	free(Lengths);
+	if (TestFailures) fprintf(stderr, "packed_store_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
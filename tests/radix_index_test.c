@@ -0,0 +1,111 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 100000
+#define NUM_QUERIES 20000
+
+typedef struct {
+	radix_index_t *Index;
+	const char *Prefix;
+	size_t Length, Count;
+	int Limit, Mismatches;
+} foreach_state_t;
+
+static int foreach_callback(size_t Index, void *Data) {
+	foreach_state_t *State = (foreach_state_t *)Data;
+	char Key[32];
+	size_t Length = radix_index_get(State->Index, Index, Key, sizeof(Key));
+	if (Length < State->Length || memcmp(Key, State->Prefix, State->Length)) ++State->Mismatches;
+	return ++State->Count == State->Limit;
+}
+
+// The keys are the decimal numbers below NUM_KEYS, so a query has a key as a prefix exactly when its leading digits form one.
+static size_t model_longest_prefix(const char *Query, size_t Length) {
+	for (size_t I = Length; I > 0; --I) {
+		if (I > 1 && Query[0] == '0') continue;
+		size_t Value = 0;
+		for (size_t J = 0; J < I; ++J) Value = Value * 10 + (Query[J] - '0');
+		if (Value < NUM_KEYS) return Value;
+	}
+	return INVALID_INDEX;
+}
+
+static void check_radix(radix_index_t *Radix, size_t *Indices, const char *Stage) {
+	char Key[32];
+	TEST_CHECK(radix_index_num_entries(Radix) == NUM_KEYS, "%s: count %zu", Stage, radix_index_num_entries(Radix));
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t Length = sprintf(Key, "%zu", I);
+		TEST_CHECK(radix_index_search(Radix, Key, I % 2 ? Length : 0) == Indices[I], "%s: search %zu", Stage, I);
+		TEST_CHECK(radix_index_size(Radix, Indices[I]) == Length, "%s: size %zu", Stage, I);
+	}
+	for (size_t I = 0; I < NUM_QUERIES; ++I) {
+		size_t Length = sprintf(Key, "%u%s", (unsigned)rand(), I % 3 ? "x" : "");
+		size_t Digits = strspn(Key, "0123456789");
+		size_t Expected = model_longest_prefix(Key, Digits);
+		if (Expected != INVALID_INDEX) Expected = Indices[Expected];
+		TEST_CHECK(radix_index_longest_prefix(Radix, Key, Length) == Expected, "%s: longest prefix of %s", Stage, Key);
+		size_t Exact = Digits == Length && strtoul(Key, NULL, 10) < NUM_KEYS ? Indices[strtoul(Key, NULL, 10)] : INVALID_INDEX;
+		TEST_CHECK(radix_index_search(Radix, Key, Length) == Exact, "%s: search %s", Stage, Key);
+	}
+	TEST_CHECK(radix_index_longest_prefix(Radix, "x", 1) == INVALID_INDEX, "%s: longest prefix without a match", Stage);
+	const char *Prefixes[] = {"1", "12", "999", "5000", "99999", "100000", "7x"};
+	for (int I = 0; I < sizeof(Prefixes) / sizeof(Prefixes[0]); ++I) {
+		size_t Expected = 0;
+		for (size_t J = 0; J < NUM_KEYS; ++J) {
+			size_t Length = sprintf(Key, "%zu", J);
+			if (Length >= strlen(Prefixes[I]) && !memcmp(Key, Prefixes[I], strlen(Prefixes[I]))) ++Expected;
+		}
+		foreach_state_t State = {Radix, Prefixes[I], strlen(Prefixes[I]), 0, -1, 0};
+		TEST_CHECK(radix_index_prefix_foreach(Radix, Prefixes[I], 0, &State, foreach_callback) == 0, "%s: foreach %s stopped", Stage, Prefixes[I]);
+		TEST_CHECK(State.Count == Expected && !State.Mismatches, "%s: foreach %s visited %zu expected %zu", Stage, Prefixes[I], State.Count, Expected);
+	}
+	foreach_state_t State = {Radix, "1", 1, 0, 5, 0};
+	TEST_CHECK(radix_index_prefix_foreach(Radix, "1", 1, &State, foreach_callback) == 1 && State.Count == 5, "%s: foreach did not stop", Stage);
+}
+
+// A string index at the same prefix must keep its keys when the radix index is created next to it.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "radix_index_test";
+	size_t *Indices = malloc(NUM_KEYS * sizeof(size_t));
+	char Key[32];
+	srand(1);
+
+	string_index2_t *Strings = string_index2_create(Prefix, 16, 0 TEST_MEM);
+	for (size_t I = 0; I < 100; ++I) string_index2_insert(Strings, Key, sprintf(Key, "string-%zu", I));
+	string_index2_close(Strings);
+
+	radix_index_t *Radix = radix_index_create(Prefix, 16, 0 TEST_MEM);
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t J = (I * 7919) % NUM_KEYS;
+		Indices[J] = radix_index_insert(Radix, Key, sprintf(Key, "%zu", J));
+	}
+	for (size_t I = 0; I < NUM_KEYS; I += 97) {
+		index_result_t Result = radix_index_insert2(Radix, Key, sprintf(Key, "%zu", I));
+		TEST_CHECK(Result.Index == Indices[I] && !Result.Created, "insert2 %zu created a duplicate", I);
+	}
+	check_radix(Radix, Indices, "created");
+	radix_index_close(Radix);
+	Radix = radix_index_open(Prefix TEST_MEM);
+	TEST_CHECK(Radix != NULL, "reopen failed");
+	if (Radix) {
+		check_radix(Radix, Indices, "reopened");
+		radix_index_close(Radix);
+	}
+
+	Strings = string_index2_open(Prefix TEST_MEM);
+	TEST_CHECK(Strings != NULL, "string index reopen failed");
+	if (Strings) {
+		TEST_CHECK(string_index2_num_entries(Strings) == 100, "string index has %zu entries", string_index2_num_entries(Strings));
+		char Stored[32];
+		for (size_t I = 0; I < 100; ++I) {
+			size_t Length = sprintf(Key, "string-%zu", I);
+			TEST_CHECK(string_index2_search(Strings, Key, Length) == I, "string index lost key %zu", I);
+			TEST_CHECK(string_index2_get(Strings, I, Stored, sizeof(Stored)) == Length && !memcmp(Stored, Key, Length), "string index key %zu was overwritten", I);
+		}
+		string_index2_close(Strings);
+	}
+
+	free(Indices);
+	if (TestFailures) fprintf(stderr, "radix_index_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
@@ -0,0 +1,132 @@
+#include "test.h"
+#include <string.h>
+#include <sys/stat.h>
+
+#define NUM_VALUES 3000
+#define WINDOW_SIZE 2000
+#define WINDOW_START (0x80000000UL - 700)
+
+static size_t Indices[NUM_VALUES];
+static uint64_t Window[WINDOW_SIZE];
+
+// Indices are spread over the whole 32 bit range, those that would land in the shift window are moved below it.
+static void make_indices(void) {
+	for (size_t I = 0; I < NUM_VALUES; ++I) {
+		Indices[I] = (uint32_t)((I + 1) * 2654435761U) & 0xFFFFFFF0;
+		if (Indices[I] >= WINDOW_START - 8 && Indices[I] < WINDOW_START + WINDOW_SIZE) Indices[I] = I;
+	}
+}
+
+static size_t file_size(const char *Prefix, const char *Suffix) {
+	char FileName[strlen(Prefix) + 20];
+	sprintf(FileName, "%s.%s", Prefix, Suffix);
+	struct stat Stat[1];
+	return stat(FileName, Stat) ? 0 : Stat->st_size;
+}
+
+static void check_fixed(fixed_store_t *Store, const char *Stage) {
+	size_t MaxIndex = WINDOW_START + WINDOW_SIZE;
+	for (size_t I = 0; I < NUM_VALUES; ++I) {
+		uint64_t Value = *(uint64_t *)fixed_store_get(Store, Indices[I]);
+		TEST_CHECK(Value == Indices[I] * 3 + 1, "%s: value at %zu", Stage, Indices[I]);
+		if (MaxIndex < Indices[I]) MaxIndex = Indices[I];
+	}
+	for (size_t I = 0; I < WINDOW_SIZE; ++I) {
+		TEST_CHECK(*(uint64_t *)fixed_store_get(Store, WINDOW_START + I) == Window[I], "%s: window value %zu", Stage, I);
+	}
+	TEST_CHECK(fixed_store_num_entries(Store) > MaxIndex, "%s: %zu entries", Stage, fixed_store_num_entries(Store));
+}
+
+// Shifts rotate the entries between Source and Destination, as in the model.
+static void model_shift(size_t Source, size_t Count, size_t Destination) {
+	uint64_t Moved[WINDOW_SIZE];
+	memcpy(Moved, Window + Source, Count * sizeof(uint64_t));
+	if (Source < Destination) {
+		memmove(Window + Source, Window + Source + Count, (Destination - Source) * sizeof(uint64_t));
+	} else {
+		memmove(Window + Destination + Count, Window + Destination, (Source - Destination) * sizeof(uint64_t));
+	}
+	memcpy(Window + Destination, Moved, Count * sizeof(uint64_t));
+}
+
+static void test_fixed(const char *Prefix) {
+	fixed_store_t *Store = fixed_store_create_sparse(Prefix, 8, 0 TEST_MEM);
+	for (size_t I = 0; I < NUM_VALUES; ++I) *(uint64_t *)fixed_store_get(Store, Indices[I]) = Indices[I] * 3 + 1;
+	for (size_t I = 0; I < WINDOW_SIZE; ++I) *(uint64_t *)fixed_store_get(Store, WINDOW_START + I) = Window[I] = rand();
+	TEST_CHECK(file_size(Prefix, "entries") + file_size(Prefix, "pages") < 64 << 20, "fixed: files use %zu bytes", file_size(Prefix, "entries") + file_size(Prefix, "pages"));
+	// The window crosses page boundaries, so shifts move entries between pages.
+	for (int I = 0; I < 200; ++I) {
+		size_t Count = 1 + rand() % 600;
+		size_t Source = rand() % (WINDOW_SIZE - Count + 1), Destination = rand() % (WINDOW_SIZE - Count + 1);
+		fixed_store_shift(Store, WINDOW_START + Source, Count, WINDOW_START + Destination);
+		model_shift(Source, Count, Destination);
+	}
+	uint64_t Untouched = *(uint64_t *)fixed_store_get(Store, 0xFFFFFF00);
+	TEST_CHECK(Untouched == 0, "fixed: untouched entry is %lu", (unsigned long)Untouched);
+	check_fixed(Store, "fixed");
+	fixed_store_close(Store);
+
+	fixed_store_open_t StoreOpen = fixed_store_open2(Prefix TEST_MEM);
+	TEST_CHECK(StoreOpen.Error == RADB_SUCCESS, "fixed: reopen failed: %s", radb_error_string(StoreOpen.Error));
+	if (StoreOpen.Store) {
+		check_fixed(StoreOpen.Store, "fixed reopened");
+		fixed_store_close(StoreOpen.Store);
+	}
+}
+
+static size_t string_value(char *Buffer, size_t Index) {
+	size_t Length = sprintf(Buffer, "value-%zu-", Index);
+	size_t Repeat = Index % 97;
+	for (size_t I = 0; I < Repeat; ++I) Buffer[Length++] = 'a' + I % 26;
+	return Length;
+}
+
+static void check_string(string_store_t *Store, size_t NumEntries, const char *Stage) {
+	char Value[256], Stored[256];
+	for (size_t I = 0; I < NUM_VALUES; ++I) {
+		size_t Length = I % 5 ? string_value(Value, Indices[I]) : 0;
+		TEST_CHECK(string_store_size(Store, Indices[I]) == Length, "%s: size at %zu", Stage, Indices[I]);
+		TEST_CHECK(string_store_get(Store, Indices[I], Stored, sizeof(Stored)) == Length && !memcmp(Stored, Value, Length), "%s: value at %zu", Stage, Indices[I]);
+	}
+	// Reading untouched pages does not map them.
+	TEST_CHECK(string_store_size(Store, WINDOW_START) == 0, "%s: untouched value", Stage);
+	TEST_CHECK(string_store_num_entries(Store) == NumEntries, "%s: %zu entries expected %zu", Stage, string_store_num_entries(Store), NumEntries);
+}
+
+static void test_string(const char *Prefix) {
+	char Value[256];
+	string_store_t *Store = string_store_create_sparse(Prefix, 16, 0 TEST_MEM);
+	size_t MaxIndex = 0;
+	for (size_t I = 0; I < NUM_VALUES; ++I) {
+		string_store_set(Store, Indices[I], Value, string_value(Value, Indices[I]));
+		if (MaxIndex < Indices[I]) MaxIndex = Indices[I];
+	}
+	for (size_t I = 0; I < NUM_VALUES; I += 5) string_store_free(Store, Indices[I]);
+	size_t NumEntries = string_store_num_entries(Store);
+	TEST_CHECK(NumEntries > MaxIndex, "string: %zu entries", NumEntries);
+	TEST_CHECK(file_size(Prefix, "entries") + file_size(Prefix, "pages") < 64 << 20, "string: files use %zu bytes", file_size(Prefix, "entries") + file_size(Prefix, "pages"));
+	check_string(Store, NumEntries, "string");
+	string_store_close(Store);
+
+	string_store_open_t StoreOpen = string_store_open2(Prefix TEST_MEM);
+	TEST_CHECK(StoreOpen.Error == RADB_SUCCESS, "string: reopen failed: %s", radb_error_string(StoreOpen.Error));
+	if (StoreOpen.Store) {
+		check_string(StoreOpen.Store, NumEntries, "string reopened");
+		string_store_close(StoreOpen.Store);
+	}
+}
+
+// Values are written at indices far apart so that only their pages are mapped, and a dense window across page
+// boundaries is shifted against an array model. Untouched indices must read as empty and everything must survive reopening.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "sparse_store_test";
+	char StoreName[strlen(Prefix) + 10];
+	srand(1);
+	make_indices();
+	sprintf(StoreName, "%s.fixed", Prefix);
+	test_fixed(StoreName);
+	sprintf(StoreName, "%s.string", Prefix);
+	test_string(StoreName);
+	if (TestFailures) fprintf(stderr, "sparse_store_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
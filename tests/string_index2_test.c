@@ -0,0 +1,76 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_KEYS 30000
+
+// Long keys share a 40 byte prefix or suffix, short keys differ only by their trailing zero bytes.
+static size_t test_key(char *Buffer, size_t I) {
+	switch (I % 4) {
+	case 0: return sprintf(Buffer, "https://example.com/a/long/shared/path/%zu", I);
+	case 1: return sprintf(Buffer, "%zu/with/a/long/shared/suffix/after/the/id", I);
+	case 2: return sprintf(Buffer, "%zu", I);
+	default:
+		memset(Buffer, 0, 16);
+		sprintf(Buffer, "z%zu", I / 8);
+		return strlen(Buffer) + 1 + (I / 4) % 2;
+	}
+}
+
+// The prefix mode does not distinguish trailing zero bytes, so it only uses the shorter of each pair of keys.
+static size_t model_key(int Mode, size_t I) {
+	return Mode == STRING_INDEX2_PREFIX && I % 4 == 3 ? I & ~4 : I;
+}
+
+static void check_index(string_index2_t *Index, size_t *Indices, size_t NumKeys, int Mode, const char *Stage) {
+	char Key[64], Stored[64];
+	TEST_CHECK(string_index2_num_entries(Index) == NumKeys, "%s: count %zu", Stage, string_index2_num_entries(Index));
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t Length = test_key(Key, model_key(Mode, I));
+		TEST_CHECK(string_index2_search(Index, Key, Length) == Indices[I], "%s: search %zu", Stage, I);
+		TEST_CHECK(string_index2_get(Index, Indices[I], Stored, sizeof(Stored)) == Length && !memcmp(Stored, Key, Length), "%s: get %zu", Stage, I);
+	}
+	for (size_t I = 0; I < NUM_KEYS; ++I) {
+		size_t Length = test_key(Key, model_key(Mode, I));
+		if (I % 4 == 3 && Mode != STRING_INDEX2_PREFIX) Length += 2;
+		else Key[Length / 2] ^= 0x40;
+		TEST_CHECK(string_index2_search(Index, Key, Length) == INVALID_INDEX, "%s: found missing key %zu", Stage, I);
+	}
+}
+
+// Each signature mode is checked on keys that defeat the prefix signature, and must survive reopening the index.
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "string_index2_test";
+	const char *Names[] = {"prefix", "suffix", "fingerprint"};
+	char IndexName[strlen(Prefix) + 20], Key[64];
+	size_t *Indices = malloc(NUM_KEYS * sizeof(size_t));
+
+	for (int Mode = STRING_INDEX2_PREFIX; Mode <= STRING_INDEX2_FINGERPRINT; ++Mode) {
+		sprintf(IndexName, "%s.%s", Prefix, Names[Mode]);
+		string_index2_t *Index = string_index2_create_signature(IndexName, 16, 0, Mode TEST_MEM);
+		size_t NumKeys = 0;
+		for (size_t I = 0; I < NUM_KEYS; ++I) {
+			size_t Length = test_key(Key, model_key(Mode, I));
+			index_result_t Result = string_index2_insert2(Index, Key, Length);
+			if (Result.Created) {
+				TEST_CHECK(Result.Index == NumKeys, "%s: insert %zu returned %zu", Names[Mode], I, Result.Index);
+				++NumKeys;
+			}
+			Indices[I] = Result.Index;
+		}
+		for (size_t I = 0; I < NUM_KEYS; I += 13) {
+			TEST_CHECK(string_index2_insert(Index, Key, test_key(Key, model_key(Mode, I))) == Indices[I], "%s: reinsert %zu", Names[Mode], I);
+		}
+		check_index(Index, Indices, NumKeys, Mode, Names[Mode]);
+		string_index2_close(Index);
+		Index = string_index2_open(IndexName TEST_MEM);
+		TEST_CHECK(Index != NULL, "%s: reopen failed", Names[Mode]);
+		if (Index) {
+			check_index(Index, Indices, NumKeys, Mode, Names[Mode]);
+			string_index2_close(Index);
+		}
+	}
+
+	free(Indices);
+	if (TestFailures) fprintf(stderr, "string_index2_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
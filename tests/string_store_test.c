@@ -0,0 +1,257 @@
+#include "test.h"
+#include <string.h>
+
+#define NUM_VALUES 64
+#define MAX_LENGTH (1 << 20)
+
+typedef struct {
+	char *Data;
+	size_t Length;
+} test_value_t;
+
+static test_value_t Model[NUM_VALUES];
+static char Buffer[MAX_LENGTH];
+
+static void random_bytes(char *Target, size_t Length) {
+	for (size_t I = 0; I < Length; ++I) Target[I] = rand();
+}
+
+static void model_reset(void) {
+	for (size_t I = 0; I < NUM_VALUES; ++I) {
+		if (!Model[I].Data) Model[I].Data = malloc(MAX_LENGTH);
+		Model[I].Length = 0;
+	}
+}
+
+static void test_set(string_store_t *Store, size_t Index, size_t Length) {
+	random_bytes(Model[Index].Data, Length);
+	Model[Index].Length = Length;
+	string_store_set(Store, Index, Model[Index].Data, Length);
+}
+
+static void test_clear(string_store_t *Store, size_t Index) {
+	string_store_free(Store, Index);
+	Model[Index].Length = 0;
+}
+
+// Writes Length more bytes through Writer in pieces of up to Piece bytes.
+static void test_stream(string_store_writer_t *Writer, size_t Index, size_t Length, size_t Piece) {
+	char *Target = Model[Index].Data + Model[Index].Length;
+	random_bytes(Target, Length);
+	Model[Index].Length += Length;
+	for (size_t Done = 0; Done < Length;) {
+		size_t Size = Length - Done < Piece ? Length - Done : Piece;
+		TEST_CHECK(string_store_writer_write(Writer, Target + Done, Size) == Size, "write of %zu bytes to %zu", Size, Index);
+		Done += Size;
+	}
+}
+
+// Reads are checked at the start, at the end and at random offsets, which start and end inside nodes.
+static void check_value(string_store_t *Store, size_t Index, const char *Stage) {
+	size_t Length = Model[Index].Length;
+	TEST_CHECK(string_store_size(Store, Index) == Length, "%s: size of %zu is %zu expected %zu", Stage, Index, string_store_size(Store, Index), Length);
+	TEST_CHECK(string_store_get(Store, Index, Buffer, MAX_LENGTH) == Length && !memcmp(Buffer, Model[Index].Data, Length), "%s: get %zu", Stage, Index);
+	TEST_CHECK(string_store_read_at(Store, Index, Length, Buffer, 16) == 0, "%s: read past the end of %zu", Stage, Index);
+	for (int Trial = 0; Trial < 8 && Length; ++Trial) {
+		size_t Offset = Trial == 0 ? 0 : Trial == 1 ? Length - 1 : rand() % Length;
+		size_t Size = 1 + rand() % 5000, Expected = Length - Offset < Size ? Length - Offset : Size;
+		size_t Read = string_store_read_at(Store, Index, Offset, Buffer, Size);
+		TEST_CHECK(Read == Expected && !memcmp(Buffer, Model[Index].Data + Offset, Expected), "%s: read %zu bytes of %zu at %zu", Stage, Size, Index, Offset);
+	}
+}
+
+// One reader is moved back and forth over the value, reading a few pieces after each seek.
+static void check_seek(string_store_t *Store, size_t Index, const char *Stage) {
+	size_t Length = Model[Index].Length;
+	string_store_reader_t Reader[1];
+	string_store_reader_open(Reader, Store, Index);
+	for (int Trial = 0; Trial < 6; ++Trial) {
+		size_t Offset = Trial == 0 ? Length + rand() % 100 : rand() % (Length + 1);
+		string_store_reader_seek(Reader, Offset);
+		if (Offset > Length) Offset = Length;
+		for (int Piece = 0; Piece < 3; ++Piece) {
+			size_t Size = 1 + rand() % 300, Expected = Length - Offset < Size ? Length - Offset : Size;
+			size_t Read = string_store_reader_read(Reader, Buffer, Size);
+			TEST_CHECK(Read == Expected && !memcmp(Buffer, Model[Index].Data + Offset, Expected), "%s: read %zu bytes of %zu after seeking to %zu", Stage, Size, Index, Offset);
+			Offset += Expected;
+		}
+	}
+}
+
+// Shifts rotate the entries between Source and Destination, the model rotates its values in the same way.
+static void test_shift(string_store_t *Store, size_t Source, size_t Count, size_t Destination) {
+	test_value_t Moved[NUM_VALUES];
+	string_store_shift(Store, Source, Count, Destination);
+	memcpy(Moved, Model + Source, Count * sizeof(test_value_t));
+	if (Source < Destination) {
+		memmove(Model + Source, Model + Source + Count, (Destination - Source) * sizeof(test_value_t));
+	} else {
+		memmove(Model + Destination + Count, Model + Destination, (Source - Destination) * sizeof(test_value_t));
+	}
+	memcpy(Model + Destination, Moved, Count * sizeof(test_value_t));
+}
+
+static void check_store(string_store_t *Store, const char *Stage) {
+	for (size_t Index = 0; Index < NUM_VALUES; ++Index) check_value(Store, Index, Stage);
+}
+
+// Values are set and freed to fragment the free list, then values reserved with either API are written in one set or
+// in 4KB pieces. Writing a reserved value must not grow the data file, and no value may be corrupted by the
+// reserved nodes being threaded into the free list.
+static void test_reserve(const char *Prefix) {
+	string_store_t *Store = string_store_create(Prefix, 32, 256 TEST_MEM);
+	model_reset();
+	for (size_t Index = 0; Index < NUM_VALUES; ++Index) test_set(Store, Index, rand() % 2000);
+	for (size_t Index = 0; Index < NUM_VALUES; Index += 3) test_clear(Store, Index);
+	check_store(Store, "reserve fragmented");
+
+	string_store_stats_t Before[1], After[1];
+	for (int Round = 0; Round < 40; ++Round) {
+		size_t Index = rand() % NUM_VALUES, Length = 1 + rand() % (MAX_LENGTH / 4);
+		if (Round % 2) {
+			string_store_reserve(Store, Index, Length);
+			string_store_stats(Store, Before);
+			test_set(Store, Index, Length);
+		} else {
+			string_store_writer_t Writer[1];
+			// Alternate between replacing and appending to the value.
+			if (Round % 4) {
+				string_store_writer_open(Writer, Store, Index);
+				Model[Index].Length = 0;
+			} else {
+				string_store_writer_append(Writer, Store, Index);
+				if (Length > MAX_LENGTH - Model[Index].Length) Length = MAX_LENGTH - Model[Index].Length;
+			}
+			string_store_writer_reserve(Writer, Length);
+			string_store_stats(Store, Before);
+			test_stream(Writer, Index, Length, 4096);
+		}
+		string_store_stats(Store, After);
+		TEST_CHECK(After->NumNodes == Before->NumNodes && After->Events.Truncates.Count == Before->Events.Truncates.Count, "reserve: writing %zu bytes to %zu grew the data file", Length, Index);
+		check_value(Store, Index, "reserve");
+		if (Round % 5 == 0) test_clear(Store, rand() % NUM_VALUES);
+	}
+	// A reservation which is not used stays on the free list for other values.
+	string_store_reserve(Store, 0, MAX_LENGTH);
+	string_store_stats(Store, Before);
+	for (size_t Index = 1; Index < NUM_VALUES; Index += 2) test_set(Store, Index, rand() % 10000);
+	string_store_stats(Store, After);
+	TEST_CHECK(After->NumNodes == Before->NumNodes, "reserve: unused reservation was not reused");
+	check_store(Store, "reserve");
+	string_store_close(Store);
+
+	string_store_open_t StoreOpen = string_store_open2(Prefix TEST_MEM);
+	TEST_CHECK(StoreOpen.Error == RADB_SUCCESS, "reserve: reopen failed: %s", radb_error_string(StoreOpen.Error));
+	if (StoreOpen.Store) {
+		check_store(StoreOpen.Store, "reserve reopened");
+		string_store_close(StoreOpen.Store);
+	}
+}
+
+// Appends go straight to the tail node from the tails file, so a tail which is not updated by a set, free, reservation,
+// shift or growth of the data file would put the appended bytes into the wrong node. Tails are built over existing
+// values and must be opened with the store.
+static void test_tails(const char *Prefix) {
+	string_store_t *Store = string_store_create(Prefix, 32, 256 TEST_MEM);
+	model_reset();
+	for (size_t Index = 0; Index < NUM_VALUES; ++Index) test_set(Store, Index, rand() % 3000);
+	string_store_tails_build(Store);
+	check_store(Store, "tails built");
+	for (int Reopen = 0; Reopen < 2; ++Reopen) {
+		for (int Round = 0; Round < 3000; ++Round) {
+			size_t Index = rand() % NUM_VALUES;
+			int Operation = rand() % 16;
+			if (Operation < 10) {
+				string_store_writer_t Writer[1];
+				string_store_writer_append(Writer, Store, Index);
+				size_t Length = 1 + rand() % (Operation ? 100 : 5000);
+				if (Length > MAX_LENGTH / 4 - Model[Index].Length) continue;
+				if (Operation == 1) string_store_writer_reserve(Writer, Length);
+				test_stream(Writer, Index, Length, 1 + rand() % 64);
+			} else if (Operation < 13) {
+				test_set(Store, Index, rand() % (Operation == 10 ? 40 : 3000));
+			} else if (Operation < 14) {
+				test_clear(Store, Index);
+			} else if (Operation < 15) {
+				size_t Count = 1 + rand() % 8;
+				test_shift(Store, rand() % (NUM_VALUES - Count + 1), Count, rand() % (NUM_VALUES - Count + 1));
+			} else {
+				string_store_reserve(Store, Index, Model[Index].Length + rand() % 10000);
+			}
+			check_value(Store, Index, "tails");
+		}
+		check_store(Store, "tails");
+		string_store_close(Store);
+
+		string_store_open_t StoreOpen = string_store_open2(Prefix TEST_MEM);
+		TEST_CHECK(StoreOpen.Error == RADB_SUCCESS, "tails: reopen failed: %s", radb_error_string(StoreOpen.Error));
+		if (!StoreOpen.Store) return;
+		Store = StoreOpen.Store;
+		check_store(Store, "tails reopened");
+	}
+	string_store_close(Store);
+}
+
+// Jump tables are built over existing values and then kept current while values grow through sets, appends and
+// reservations, shrink below the 8 nodes which need a table and are freed and shifted. Values reach 1MB, which is a
+// jump tree of several levels, and a tails file is built half way as appends use both.
+static void test_jumps(const char *Prefix) {
+	string_store_t *Store = string_store_create(Prefix, 32, 0 TEST_MEM);
+	model_reset();
+	for (size_t Index = 0; Index < NUM_VALUES; ++Index) test_set(Store, Index, rand() % (Index % 4 ? 2000 : MAX_LENGTH / 2));
+	string_store_jumps_build(Store);
+	check_store(Store, "jumps built");
+	for (int Reopen = 0; Reopen < 2; ++Reopen) {
+		for (int Round = 0; Round < 1000; ++Round) {
+			size_t Index = rand() % NUM_VALUES;
+			int Operation = rand() % 15;
+			if (Round == 500 && !Reopen) string_store_tails_build(Store);
+			if (Operation < 8) {
+				string_store_writer_t Writer[1];
+				string_store_writer_append(Writer, Store, Index);
+				size_t Length = 1 + rand() % (Operation ? 500 : 50000);
+				if (Length > MAX_LENGTH - Model[Index].Length) continue;
+				if (Operation == 1) string_store_writer_reserve(Writer, Length);
+				test_stream(Writer, Index, Length, 1 + rand() % 4096);
+			} else if (Operation < 12) {
+				// Values shorter than 8 nodes drop their table, values of a few hundred nodes need a two level tree.
+				size_t Limits[] = {100, 300, 20000, MAX_LENGTH};
+				test_set(Store, Index, rand() % Limits[Operation - 8]);
+			} else if (Operation < 13) {
+				test_clear(Store, Index);
+			} else if (Operation < 14) {
+				size_t Count = 1 + rand() % 8;
+				test_shift(Store, rand() % (NUM_VALUES - Count + 1), Count, rand() % (NUM_VALUES - Count + 1));
+			} else {
+				string_store_reserve(Store, Index, Model[Index].Length + rand() % 100000);
+			}
+			check_value(Store, Index, "jumps");
+			check_seek(Store, Index, "jumps");
+		}
+		check_store(Store, "jumps");
+		string_store_close(Store);
+
+		string_store_open_t StoreOpen = string_store_open2(Prefix TEST_MEM);
+		TEST_CHECK(StoreOpen.Error == RADB_SUCCESS, "jumps: reopen failed: %s", radb_error_string(StoreOpen.Error));
+		if (!StoreOpen.Store) return;
+		Store = StoreOpen.Store;
+		check_store(Store, "jumps reopened");
+		for (size_t Index = 0; Index < NUM_VALUES; ++Index) check_seek(Store, Index, "jumps reopened");
+	}
+	string_store_close(Store);
+}
+
+int main(int Argc, char **Argv) {
+	const char *Prefix = Argc > 1 ? Argv[1] : "string_store_test";
+	char StoreName[strlen(Prefix) + 10];
+	srand(1);
+	sprintf(StoreName, "%s.reserve", Prefix);
+	test_reserve(StoreName);
+	sprintf(StoreName, "%s.tails", Prefix);
+	test_tails(StoreName);
+	sprintf(StoreName, "%s.jumps", Prefix);
+	test_jumps(StoreName);
+	for (size_t I = 0; I < NUM_VALUES; ++I) free(Model[I].Data);
+	if (TestFailures) fprintf(stderr, "string_store_test: %d failures\n", TestFailures);
+	return TestFailures != 0;
+}
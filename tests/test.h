@@ -0,0 +1,34 @@
+#ifndef RADB_TEST_H
+#define RADB_TEST_H
+
+#include "radb.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef RADB_MEM_PER_STORE
+static void *test_alloc(void *Allocator, size_t Size) {
+	return malloc(Size);
+}
+
+static void test_free(void *Allocator, void *Pointer) {
+	free(Pointer);
+}
+
+#define TEST_MEM , NULL, test_alloc, test_alloc, test_free
+#else
+#define TEST_MEM
+#endif
+
+static int TestFailures = 0;
+
+#define TEST_CHECK(CONDITION, ...) do { \
+	if (!(CONDITION)) { \
+		if (++TestFailures <= 10) { \
+			fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+			fprintf(stderr, __VA_ARGS__); \
+			fputc('\n', stderr); \
+		} \
+	} \
+} while (0)
+
+#endif
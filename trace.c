@@ -0,0 +1,144 @@
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static const char *OpNames[RADB_OP_COUNT] = {
+	[RADB_OP_STRING_STORE_GET] = "string_store_get",
+	[RADB_OP_STRING_STORE_SET] = "string_store_set",
+	[RADB_OP_STRING_STORE_WRITE] = "string_store_writer_write",
+	[RADB_OP_STRING_STORE_READ] = "string_store_reader_read",
+	[RADB_OP_STRING_STORE_GROW] = "string_store_grow",
+	[RADB_OP_STRING_INDEX_SEARCH] = "string_index_search",
+	[RADB_OP_STRING_INDEX_INSERT] = "string_index_insert",
+	[RADB_OP_STRING_INDEX_DELETE] = "string_index_delete",
+	[RADB_OP_STRING_INDEX_REBUILD] = "string_index_rebuild",
+	[RADB_OP_FIXED_INDEX_SEARCH] = "fixed_index_search",
+	[RADB_OP_FIXED_INDEX_INSERT] = "fixed_index_insert",
+	[RADB_OP_FIXED_INDEX_DELETE] = "fixed_index_delete",
+	[RADB_OP_FIXED_INDEX_REBUILD] = "fixed_index_rebuild",
+	[RADB_OP_LINEAR_INDEX_SEARCH] = "linear_index_search",
+	[RADB_OP_LINEAR_INDEX_INSERT] = "linear_index_insert",
+	[RADB_OP_LINEAR_INDEX_DELETE] = "linear_index_delete",
+	[RADB_OP_LINEAR_INDEX_SPLIT] = "linear_index_split",
+	[RADB_OP_SYNC] = "msync",
+	[RADB_OP_MIGRATE] = "migrate"
+};
+
+const char *radb_op_name(radb_op_t Op) {
+	if (Op >= RADB_OP_COUNT) return "invalid op";
+	return OpNames[Op];
+}
+
+void radb_sync(void *Address, size_t Size) {
+	RADB_PROBE2(sync_start, Address, Size);
+	RADB_LATENCY(RADB_OP_SYNC);
+	msync(Address, Size, MS_SYNC);
+	RADB_PROBE2(sync_done, Address, Size);
+}
+
+#ifdef RADB_TRACE
+
+// Log-linear buckets: 16 sub-buckets per power of 2, relative error at most 1/16.
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_SIZE (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_SIZE ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_SIZE)
+
+typedef struct {
+	uint64_t Count, Sum, Max;
+	uint64_t Buckets[HISTOGRAM_SIZE];
+} histogram_t;
+
+static histogram_t Histograms[RADB_OP_COUNT];
+
+static inline int histogram_bucket(uint64_t Value) {
+	if (Value < HISTOGRAM_SUB_SIZE) return Value;
+	int Shift = 63 - HISTOGRAM_SUB_BITS - __builtin_clzl(Value);
+	return (Shift + 1) * HISTOGRAM_SUB_SIZE + ((Value >> Shift) & (HISTOGRAM_SUB_SIZE - 1));
+}
+
+static inline uint64_t histogram_value(int Bucket) {
+	if (Bucket < HISTOGRAM_SUB_SIZE) return Bucket;
+	int Shift = Bucket / HISTOGRAM_SUB_SIZE - 1;
+	return (uint64_t)(HISTOGRAM_SUB_SIZE + Bucket % HISTOGRAM_SUB_SIZE) << Shift;
+}
+
+void radb_latency_record(radb_op_t Op, uint64_t Time) {
+	histogram_t *Histogram = Histograms + Op;
+	__atomic_fetch_add(Histogram->Buckets + histogram_bucket(Time), 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&Histogram->Count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&Histogram->Sum, Time, __ATOMIC_RELAXED);
+	uint64_t Max = __atomic_load_n(&Histogram->Max, __ATOMIC_RELAXED);
+	while (Time > Max) {
+		if (__atomic_compare_exchange_n(&Histogram->Max, &Max, Time, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+	}
+}
+
+uint64_t radb_trace_count(radb_op_t Op) {
+	return Histograms[Op].Count;
+}
+
+uint64_t radb_trace_percentile(radb_op_t Op, double Percentile) {
+	histogram_t *Histogram = Histograms + Op;
+	if (!Histogram->Count) return 0;
+	uint64_t Target = Percentile * Histogram->Count / 100.0;
+	if (Target >= Histogram->Count) return Histogram->Max;
+	uint64_t Total = 0;
+	for (int I = 0; I < HISTOGRAM_SIZE; ++I) {
+		Total += Histogram->Buckets[I];
+		if (Total > Target) {
+			uint64_t Value = histogram_value(I + 1) - 1;
+			return Value < Histogram->Max ? Value : Histogram->Max;
+		}
+	}
+	return Histogram->Max;
+}
+
+int radb_trace_dump(const char *FileName) {
+	FILE *File = fopen(FileName, "w");
+	if (!File) return -1;
+	fprintf(File, "%-28s %12s %12s %12s %12s %12s %12s %12s\n", "op", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+	for (radb_op_t Op = 0; Op < RADB_OP_COUNT; ++Op) {
+		histogram_t *Histogram = Histograms + Op;
+		if (!Histogram->Count) continue;
+		fprintf(File, "%-28s %12lu %12lu %12lu %12lu %12lu %12lu %12lu\n",
+			OpNames[Op], Histogram->Count, Histogram->Sum / Histogram->Count,
+			radb_trace_percentile(Op, 50), radb_trace_percentile(Op, 90),
+			radb_trace_percentile(Op, 99), radb_trace_percentile(Op, 99.9),
+			Histogram->Max
+		);
+	}
+	for (radb_op_t Op = 0; Op < RADB_OP_COUNT; ++Op) {
+		histogram_t *Histogram = Histograms + Op;
+		if (!Histogram->Count) continue;
+		fprintf(File, "\n%s\n", OpNames[Op]);
+		for (int I = 0; I < HISTOGRAM_SIZE; ++I) {
+			if (Histogram->Buckets[I]) fprintf(File, "%12lu %12lu\n", histogram_value(I), Histogram->Buckets[I]);
+		}
+	}
+	fclose(File);
+	return 0;
+}
+
+void radb_trace_reset(void) {
+	memset(Histograms, 0, sizeof(Histograms));
+}
+
+#else
+
+uint64_t radb_trace_count(radb_op_t Op) {
+	return 0;
+}
+
+uint64_t radb_trace_percentile(radb_op_t Op, double Percentile) {
+	return 0;
+}
+
+int radb_trace_dump(const char *FileName) {
+	return -1;
+}
+
+void radb_trace_reset(void) {
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef RADB_TRACE_H
+#define RADB_TRACE_H
+
+#include "common.h"
+
+typedef enum {
+	RADB_OP_STRING_STORE_GET,
+	RADB_OP_STRING_STORE_SET,
+	RADB_OP_STRING_STORE_WRITE,
+	RADB_OP_STRING_STORE_READ,
+	RADB_OP_STRING_STORE_GROW,
+	RADB_OP_STRING_INDEX_SEARCH,
+	RADB_OP_STRING_INDEX_INSERT,
+	RADB_OP_STRING_INDEX_DELETE,
+	RADB_OP_STRING_INDEX_REBUILD,
+	RADB_OP_FIXED_INDEX_SEARCH,
+	RADB_OP_FIXED_INDEX_INSERT,
+	RADB_OP_FIXED_INDEX_DELETE,
+	RADB_OP_FIXED_INDEX_REBUILD,
+	RADB_OP_LINEAR_INDEX_SEARCH,
+	RADB_OP_LINEAR_INDEX_INSERT,
+	RADB_OP_LINEAR_INDEX_DELETE,
+	RADB_OP_LINEAR_INDEX_SPLIT,
+	RADB_OP_SYNC,
+	RADB_OP_MIGRATE,
+	RADB_OP_COUNT
+} radb_op_t;
+
+const char *radb_op_name(radb_op_t Op);
+
+uint64_t radb_trace_count(radb_op_t Op);
+uint64_t radb_trace_percentile(radb_op_t Op, double Percentile);
+int radb_trace_dump(const char *FileName);
+void radb_trace_reset(void);
+
+void radb_sync(void *Address, size_t Size);
+
+#ifdef RADB_TRACE
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define RADB_SDT
+#endif
+#endif
+
+#ifdef RADB_SDT
+#define RADB_PROBE0(NAME) DTRACE_PROBE(radb, NAME)
+#define RADB_PROBE1(NAME, A) DTRACE_PROBE1(radb, NAME, A)
+#define RADB_PROBE2(NAME, A, B) DTRACE_PROBE2(radb, NAME, A, B)
+#define RADB_PROBE3(NAME, A, B, C) DTRACE_PROBE3(radb, NAME, A, B, C)
+#else
+#define RADB_PROBE0(NAME)
+#define RADB_PROBE1(NAME, A)
+#define RADB_PROBE2(NAME, A, B)
+#define RADB_PROBE3(NAME, A, B, C)
+#endif
+
+typedef struct {
+	radb_op_t Op;
+	uint64_t Start;
+} radb_latency_t;
+
+void radb_latency_record(radb_op_t Op, uint64_t Time);
+
+static inline void radb_latency_stop(radb_latency_t *Latency) {
+	radb_latency_record(Latency->Op, radb_time() - Latency->Start);
+}
+
+#define RADB_LATENCY(OP) radb_latency_t RadbLatency __attribute__((cleanup(radb_latency_stop))) = {OP, radb_time()}
+
+#else
+
+#define RADB_PROBE0(NAME)
+#define RADB_PROBE1(NAME, A)
+#define RADB_PROBE2(NAME, A, B)
+#define RADB_PROBE3(NAME, A, B, C)
+#define RADB_LATENCY(OP)
+
+#endif
+
+#endif